@@ -0,0 +1,82 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+// Compares the swscale and native scalers on the common broadcast conversions, from YUV422P10 so that only the
+// scaling is timed. Run with an optional number of frames: node bench/scaleConvert.js 200
+
+const codecadon = require('../../codecadon');
+
+const numFrames = +process.argv[2] || 100;
+const conversions = [
+  { name: '1080i -> 720p', src: [1920, 1080, 'tff'], dst: [1280, 720, 'prog'] },
+  { name: '2160p -> 1080p', src: [3840, 2160, 'prog'], dst: [1920, 1080, 'prog'] },
+  { name: '1080p -> 540p', src: [1920, 1080, 'prog'], dst: [960, 540, 'prog'] },
+  { name: '1080i -> 576i', src: [1920, 1080, 'tff'], dst: [720, 576, 'bff'] },
+  { name: '576i -> 1080i', src: [720, 576, 'bff'], dst: [1920, 1080, 'tff'] }
+];
+
+function makeTags(size) {
+  return { format: 'video', width: size[0], height: size[1], packing: 'YUV422P10', depth: 10, interlace: size[2] };
+}
+
+// a picture with detail in both directions, so that no scaler can take a short cut
+function makeSrcBuf(width, height) {
+  var buf = Buffer.alloc(width * height * 4);
+  for (var i = 0; i < buf.length / 2; ++i)
+    buf.writeUInt16LE(0x40 + ((i * 7 + (i / width | 0) * 13) % 0x380), i * 2);
+  return buf;
+}
+
+function runScaler(conv, scaler) {
+  return new Promise((resolve, reject) => {
+    var scaleConverter = new codecadon.ScaleConverter(() => {});
+    scaleConverter.on('error', reject);
+    var paramTags = { scale: [1.0, 1.0], dstOffset: [0.0, 0.0], scaler: scaler };
+    var dstBufLen = scaleConverter.setInfo(makeTags(conv.src), makeTags(conv.dst), paramTags, 1);
+    var srcBuf = makeSrcBuf(conv.src[0], conv.src[1]);
+    var dstBuf = Buffer.alloc(dstBufLen);
+    var framesDone = 0;
+    var start;
+    var next = () => {
+      scaleConverter.scaleConvert([srcBuf], dstBuf, err => {
+        if (err)
+          return reject(err);
+        // the first frame is not timed, as it warms up the caches and the buffer pool
+        if (0 === framesDone++)
+          start = process.hrtime();
+        if (framesDone <= numFrames)
+          return next();
+        var elapsed = process.hrtime(start);
+        scaleConverter.quit(() => resolve((elapsed[0] * 1e3 + elapsed[1] / 1e6) / numFrames));
+      });
+    };
+    next();
+  });
+}
+
+console.log(`ScaleConverter, ${numFrames} frames, ms per frame`);
+conversions.reduce((prev, conv) => prev.then(() => {
+  var swscaleMs;
+  return runScaler(conv, 'swscale')
+    .then(ms => {
+      swscaleMs = ms;
+      return runScaler(conv, 'native');
+    })
+    .then(nativeMs => {
+      console.log(`${conv.name.padEnd(16)} swscale ${swscaleMs.toFixed(2).padStart(7)}  native ${nativeMs.toFixed(2).padStart(7)}  ` +
+                  `(x${(swscaleMs / nativeMs).toFixed(2)})`);
+    });
+}), Promise.resolve())
+  .catch(err => console.log(err));
@@ -10,10 +10,13 @@
                    "src/Decoder.cc",
                    "src/Encoder.cc",
                    "src/Stamper.cc",
+                   "src/Pipeline.cc",
                    "src/ScaleConverterFF.cc",
+                   "src/PolyphaseScaler.cc",
                    "src/DecoderFF.cc",
                    "src/EncoderFF.cc",
-                   "src/Packers.cc" ],
+                   "src/Packers.cc",
+                   "src/PackersSimd.cc" ],
       "include_dirs": [ "<!(node -e \"require('nan')\")", "ffmpeg/include" ],
       'conditions': [
         ['OS=="linux"', {
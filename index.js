@@ -22,6 +22,46 @@ SegfaultHandler.registerHandler('crash.log');
 const util = require('util');
 const EventEmitter = require('events');
 
+// Each object accepts a limited number of frames in flight, set by the queueDepth setInfo parameter.
+// When the limit is reached, submission fails fast: the callback receives a QUEUE_FULL error and false is returned.
+// A 'drain' event is then emitted when a frame completes and the object can accept another.
+function queueFull(obj, cb) {
+  obj.needDrain = true;
+  let err = new Error('Processing queue full');
+  err.code = 'QUEUE_FULL';
+  cb(err);
+  return false;
+}
+
+// Frames may be given a deadline, in nanoseconds on the process.hrtime.bigint() clock, for use with the
+// dropLate policy. Dropped frames are not processed and their callbacks receive a FRAME_DROPPED error.
+// A BigInt deadline is passed on as a decimal string, as a Number is only exact to the nanosecond up to 2^53.
+function toDeadline(deadline) {
+  if ((undefined === deadline) || (typeof deadline === 'number'))
+    return deadline;
+  return String(deadline);
+}
+
+// A batch callback receives an array of result sizes, one for each frame in the order submitted.
+// These are turned into slices of the destination buffers, null for frames that were dropped.
+function batchResults(dstBufs, resultBytes) {
+  return resultBytes ? resultBytes.map((bytes, i) => bytes?dstBufs[i].slice(0,bytes):null) : null;
+}
+
+// Passing null as the destination buffer to flip, pack, scaleConvert, decode or encode asks for the result
+// in a buffer from the native frame pool, which saves allocating and zero-filling a new Buffer for every frame.
+// The pool buffer is passed back as outBuf, exactly the length of the result, and returns to the pool when collected.
+function frameResult(dstBuf, resultBytes, outBuf) {
+  return resultBytes ? (outBuf || dstBuf.slice(0,resultBytes)) : null;
+}
+
+function frameDone(obj) {
+  if (obj.needDrain) {
+    obj.needDrain = false;
+    obj.emit('drain');
+  }
+}
+
 function Concater(cb) {
   this.concaterAdon = new codecAdon.Concater(cb);
   EventEmitter.call(this);
@@ -39,12 +79,25 @@ Concater.prototype.setInfo = function(srcTags, logLevel) {
   }
 };
 
-Concater.prototype.concat = function(srcBufArray, dstBuf, cb) {
+Concater.prototype.concat = function(srcBufArray, dstBuf, cb, deadline) {
   try {
     var numQueued = this.concaterAdon.concat(srcBufArray, dstBuf, (err, resultBytes) => {
       cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
+  } catch (err) {
+    cb(err);
+  }
+};
+
+Concater.prototype.concatBatch = function(srcBufArrays, dstBufs, cb, deadline) {
+  try {
+    var numQueued = this.concaterAdon.concatBatch(srcBufArrays, dstBufs, (err, resultBytes) => {
+      cb(err, batchResults(dstBufs, resultBytes));
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
@@ -78,12 +131,13 @@ Flipper.prototype.setInfo = function(srcTags, flip, logLevel) {
   }
 };
 
-Flipper.prototype.flip = function(srcBufArray, dstBuf, cb) {
+Flipper.prototype.flip = function(srcBufArray, dstBuf, cb, deadline) {
   try {
-    var numQueued = this.flipperAdon.flip(srcBufArray, dstBuf, (err, resultBytes) => {
-      cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+    var numQueued = this.flipperAdon.flip(srcBufArray, dstBuf, (err, resultBytes, outBuf) => {
+      cb(err, frameResult(dstBuf, resultBytes, outBuf));
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
@@ -107,22 +161,55 @@ function Packer(cb) {
 
 util.inherits(Packer, EventEmitter);
 
+// dstTags may be an array of destination tags, to convert each frame to several formats from one read of the source.
+// setInfo then returns an array of destination sizes, and pack takes an array of destination buffers to match.
 Packer.prototype.setInfo = function(srcTags, dstTags, logLevel) {
   let debugLevel = (typeof logLevel === 'number')?logLevel:3;
   try {
-    return this.packerAdon.setInfo(srcTags, dstTags, debugLevel);
+    this.dstBytes = this.packerAdon.setInfo(srcTags, dstTags, debugLevel);
+    return this.dstBytes;
   } catch (err) {
     this.emit('error', err);
     return 0;
   }
 };
 
-Packer.prototype.pack = function(srcBufArray, dstBuf, cb) {
+Packer.prototype.pack = function(srcBufArray, dstBuf, cb, deadline) {
   try {
-    var numQueued = this.packerAdon.pack(srcBufArray, dstBuf, (err, resultBytes) => {
-      cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+    var numQueued = this.packerAdon.pack(srcBufArray, dstBuf, (err, resultBytes, outBuf) => {
+      if (Array.isArray(dstBuf))
+        cb(err, resultBytes ? dstBuf.map((buf, i) => buf.slice(0, this.dstBytes[i])) : null);
+      else
+        cb(err, frameResult(dstBuf, resultBytes, outBuf));
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
+  } catch (err) {
+    cb(err);
+  }
+};
+
+// Converts only the lines from firstLine of a frame whose lines arrive progressively, into a full size destination.
+// The callback receives the line below the range - with ranges submitted from the top down, all lines above it are ready.
+Packer.prototype.packLines = function(srcBufArray, dstBuf, firstLine, numLines, cb, deadline) {
+  try {
+    var numQueued = this.packerAdon.packLines(srcBufArray, dstBuf, firstLine, numLines, (err, linesReady) => {
+      cb(err, err ? null : linesReady);
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
+  } catch (err) {
+    cb(err);
+  }
+};
+
+Packer.prototype.packBatch = function(srcBufArrays, dstBufs, cb, deadline) {
+  try {
+    var numQueued = this.packerAdon.packBatch(srcBufArrays, dstBufs, (err, resultBytes) => {
+      cb(err, batchResults(dstBufs, resultBytes));
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
@@ -160,12 +247,20 @@ ScaleConverter.prototype.setInfo = function(srcTags, dstTags, scaleTags, logLeve
   }
 };
 
-ScaleConverter.prototype.scaleConvert = function(srcBufArray, dstBuf, cb) {
+// paramTags is optional - { scale: [x, y], dstOffset: [x, y] } moves the picture for this frame, in place of the setInfo
+// values, and needs the converter set up with animate: true when the source and destination are the same size
+ScaleConverter.prototype.scaleConvert = function(srcBufArray, dstBuf, paramTags, cb, deadline) {
+  if (typeof paramTags === 'function') {
+    deadline = cb;
+    cb = paramTags;
+    paramTags = {};
+  }
   try {
-    var numQueued = this.scaleConverterAdon.scaleConvert(srcBufArray, dstBuf, (err, resultBytes) => {
-      cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+    var numQueued = this.scaleConverterAdon.scaleConvert(srcBufArray, dstBuf, paramTags || {}, (err, resultBytes, outBuf) => {
+      cb(err, frameResult(dstBuf, resultBytes, outBuf));
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
@@ -201,10 +296,11 @@ Decoder.prototype.setInfo = function(srcTags, dstTags, logLevel) {
 
 Decoder.prototype.decode = function(srcBufArray, dstBuf, cb) {
   try {
-    var numQueued = this.decoderAdon.decode(srcBufArray, dstBuf, (err, resultBytes) => {
-      cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
+    var numQueued = this.decoderAdon.decode(srcBufArray, dstBuf, (err, resultBytes, outBuf) => {
+      cb(err, frameResult(dstBuf, resultBytes, outBuf));
+      frameDone(this);
     });
-    return numQueued;
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
@@ -238,12 +334,25 @@ Encoder.prototype.setInfo = function(srcTags, dstTags, duration, encodeTags, log
   }
 };
 
-Encoder.prototype.encode = function(srcBufArray, dstBuf, cb) {
+Encoder.prototype.encode = function(srcBufArray, dstBuf, cb, deadline) {
   try {
-    var numQueued = this.encoderAdon.encode(srcBufArray, dstBuf, (err, resultBytes) => {
-      cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+    var numQueued = this.encoderAdon.encode(srcBufArray, dstBuf, (err, resultBytes, outBuf) => {
+      cb(err, frameResult(dstBuf, resultBytes, outBuf));
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
+  } catch (err) {
+    cb(err);
+  }
+};
+
+Encoder.prototype.encodeBatch = function(srcBufArrays, dstBufs, cb, deadline) {
+  try {
+    var numQueued = this.encoderAdon.encodeBatch(srcBufArrays, dstBufs, (err, resultBytes) => {
+      cb(err, batchResults(dstBufs, resultBytes));
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
@@ -283,45 +392,49 @@ Stamper.prototype.setInfo = function(srcTags, dstTags, logLevel) {
   }
 };
 
-Stamper.prototype.wipe = function(dstBuf, paramTags, cb) {
+Stamper.prototype.wipe = function(dstBuf, paramTags, cb, deadline) {
   try {
     var numQueued = this.stamperAdon.wipe(dstBuf, paramTags, (err, resultBytes) => {
       cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
 };
 
-Stamper.prototype.copy = function(srcBufArray, dstBuf, paramTags, cb) {
+Stamper.prototype.copy = function(srcBufArray, dstBuf, paramTags, cb, deadline) {
   try {
     var numQueued = this.stamperAdon.copy(srcBufArray, dstBuf, paramTags, (err, resultBytes) => {
       cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
 };
 
-Stamper.prototype.mix = function(srcBufArray, dstBuf, paramTags, cb) {
+Stamper.prototype.mix = function(srcBufArray, dstBuf, paramTags, cb, deadline) {
   try {
     var numQueued = this.stamperAdon.mix(srcBufArray, dstBuf, paramTags, (err, resultBytes) => {
       cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
 };
 
-Stamper.prototype.stamp = function(srcBufArray, dstBuf, paramTags, cb) {
+Stamper.prototype.stamp = function(srcBufArray, dstBuf, paramTags, cb, deadline) {
   try {
     var numQueued = this.stamperAdon.stamp(srcBufArray, dstBuf, paramTags, (err, resultBytes) => {
       cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
-    });
-    return numQueued;
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
   } catch (err) {
     cb(err);
   }
@@ -338,14 +451,117 @@ Stamper.prototype.quit = function(cb) {
 };
 
 
+// Each stage config has a type and the parameters taken by setInfo for that type of object:
+//   { type: 'pack', srcTags, dstTags }
+//   { type: 'scaleConvert', srcTags, dstTags, scaleTags }
+//   { type: 'flip', srcTags, flip }
+//   { type: 'decode', srcTags, dstTags }
+//   { type: 'encode', srcTags, dstTags, duration, encodeTags }
+function makeStage(config, debugLevel, stageAdons) {
+  switch (config.type) {
+  case 'pack':
+    stageAdons.push(new codecAdon.Packer(() => {}));
+    return stageAdons[stageAdons.length-1].setInfo(config.srcTags, config.dstTags, debugLevel);
+  case 'scaleConvert':
+    stageAdons.push(new codecAdon.ScaleConverter(() => {}));
+    return stageAdons[stageAdons.length-1].setInfo(config.srcTags, config.dstTags, 
+      (typeof config.scaleTags === 'object')?config.scaleTags:{ scale:[1.0, 1.0], dstOffset:[0.0, 0.0] }, debugLevel);
+  case 'flip':
+    stageAdons.push(new codecAdon.Flipper(() => {}));
+    return stageAdons[stageAdons.length-1].setInfo(config.srcTags, config.flip, debugLevel);
+  case 'decode':
+    stageAdons.push(new codecAdon.Decoder(() => {}));
+    return stageAdons[stageAdons.length-1].setInfo(config.srcTags, config.dstTags, debugLevel);
+  case 'encode':
+    stageAdons.push(new codecAdon.Encoder(() => {}));
+    return stageAdons[stageAdons.length-1].setInfo(config.srcTags, config.dstTags, config.duration, config.encodeTags, debugLevel);
+  default:
+    throw new Error(`Unsupported pipeline stage type '${config.type}'`);
+  }
+}
+
+function quitStages(stageAdons) {
+  stageAdons.forEach(stageAdon => stageAdon.quit(() => {}));
+}
+
+function Pipeline(cb) {
+  this.pipelineAdon = new codecAdon.Pipeline(cb);
+  this.stageAdons = [];
+  EventEmitter.call(this);
+}
+
+util.inherits(Pipeline, EventEmitter);
+
+// paramTags takes queueDepth, dropPolicy and dropLimit for the pipeline as a whole, and may be left out
+Pipeline.prototype.setInfo = function(stageConfigs, paramTags, logLevel) {
+  if (typeof paramTags !== 'object') {
+    logLevel = paramTags;
+    paramTags = {};
+  }
+  let debugLevel = (typeof logLevel === 'number')?logLevel:3;
+  let stageAdons = [];
+  try {
+    stageConfigs.forEach(config => makeStage(config, debugLevel, stageAdons));
+    var dstBufLen = this.pipelineAdon.setInfo(stageAdons, paramTags || {}, debugLevel);
+    quitStages(this.stageAdons);
+    this.stageAdons = stageAdons;
+    return dstBufLen;
+  } catch (err) {
+    quitStages(stageAdons);
+    this.emit('error', err);
+    return 0;
+  }
+};
+
+Pipeline.prototype.process = function(srcBufArray, dstBuf, cb, deadline) {
+  try {
+    var numQueued = this.pipelineAdon.process(srcBufArray, dstBuf, (err, resultBytes) => {
+      cb(err, resultBytes?dstBuf.slice(0,resultBytes):null);
+      frameDone(this);
+    }, toDeadline(deadline));
+    return (false === numQueued) ? queueFull(this, cb) : numQueued;
+  } catch (err) {
+    cb(err);
+  }
+};
+
+Pipeline.prototype.quit = function(cb) {
+  try {
+    this.pipelineAdon.quit((err, resultBytes) => {
+      quitStages(this.stageAdons);
+      this.stageAdons = [];
+      cb(err, resultBytes);
+    });
+  } catch (err) {
+    this.emit('error', err);
+  }
+};
+
+
+function threadPoolSize(numThreads) {
+  if (typeof numThreads === 'number')
+    return codecAdon.threadPoolSize(numThreads);
+  return codecAdon.threadPoolSize();
+}
+
+// Counts for the native frame pool buffers the size of numBytes: how many have been allocated, how many times
+// a free one has been reused, and how many are free now. Buffers smaller than 128KiB are not pooled.
+function framePoolStats(numBytes) {
+  return codecAdon.framePoolStats(numBytes);
+}
+
+
 var codecadon = {
+  threadPoolSize : threadPoolSize,
+  framePoolStats : framePoolStats,
   Concater : Concater,
   Flipper : Flipper,
   Packer : Packer,
   ScaleConverter : ScaleConverter,
   Decoder : Decoder,
   Encoder : Encoder,
-  Stamper : Stamper
+  Stamper : Stamper,
+  Pipeline : Pipeline
 };
 
 module.exports = codecadon;
@@ -21,6 +21,7 @@
 #include "Memory.h"
 #include "EssenceInfo.h"
 #include "Persist.h"
+#include "ProcessParams.h"
 
 #include <memory>
 
@@ -30,9 +31,17 @@ namespace streampunk {
 
 class ConcatProcessData : public iProcessData {
 public:
-  ConcatProcessData (Local<Array> srcBufArray, Local<Object> dstBuf)
-    : mPersistentSrcBuf(new Persist(srcBufArray)), mPersistentDstBuf(new Persist(dstBuf)),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBuf), (uint32_t)node::Buffer::Length(dstBuf))), mSrcBytes(0) {
+  ConcatProcessData ()
+    : mDstBuf(Memory::makeNew((uint8_t *)NULL, 0)), mSrcBytes(0) {}
+  ~ConcatProcessData() {}
+
+  // the source vector keeps its capacity from frame to frame
+  void set(Local<Array> srcBufArray, Local<Object> dstBuf) {
+    mPersistentSrcBuf.reset(srcBufArray);
+    mPersistentDstBuf.reset(dstBuf);
+    mDstBuf->reset((uint8_t *)node::Buffer::Data(dstBuf), (uint32_t)node::Buffer::Length(dstBuf));
+    mSrcBufVec.clear();
+    mSrcBytes = 0;
     for (uint32_t i = 0; i < srcBufArray->Length(); ++i) {
       Local<Object> bufferObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
       uint32_t bufLen = (uint32_t)node::Buffer::Length(bufferObj);
@@ -40,15 +49,18 @@ public:
       mSrcBytes += bufLen;
     }
   }
-  ~ConcatProcessData() {}
+  void recycle() {
+    mPersistentSrcBuf.reset();
+    mPersistentDstBuf.reset();
+  }
   
-  tBufVec srcBufVec() const { return mSrcBufVec; }
+  const tBufVec &srcBufVec() const { return mSrcBufVec; }
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
   uint32_t srcBytes() const { return mSrcBytes; }
 
 private:
-  std::unique_ptr<Persist> mPersistentSrcBuf;
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  Persist mPersistentSrcBuf;
+  Persist mPersistentDstBuf;
   tBufVec mSrcBufVec;
   std::shared_ptr<Memory> mDstBuf;
   uint32_t mSrcBytes;
@@ -56,17 +68,15 @@ private:
 
 
 Concater::Concater(Nan::Callback *callback) 
-  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mIsVideo(true), mPitchBytes(0), mInterlace(false), mTff(true) {
-  AsyncQueueWorker(mWorker);
-}
+  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mIsVideo(true), mPitchBytes(0), mInterlace(false), mTff(true) {}
 Concater::~Concater() {}
 
 // iProcess
 uint32_t Concater::processFrame (std::shared_ptr<iProcessData> processData) {
   Timer t;
-  std::shared_ptr<ConcatProcessData> cpd = std::dynamic_pointer_cast<ConcatProcessData>(processData);
+  ConcatProcessData *cpd = static_cast<ConcatProcessData *>(processData.get());
 
-  tBufVec srcBufVec = cpd->srcBufVec();
+  const tBufVec &srcBufVec = cpd->srcBufVec();
   std::shared_ptr<Memory> dstBuf = cpd->dstBuf();
   uint32_t totalBytes = 0;
   uint32_t concatBufOffset = 0; 
@@ -133,6 +143,13 @@ NAN_METHOD(Concater::SetInfo) {
 
   obj->mSrcEssInfo = std::make_shared<EssenceInfo>(srcTags); 
   obj->printDebug(eInfo, "Concater EssInfo: %s\n", obj->mSrcEssInfo->toString().c_str());
+  ProcessParams processParams(srcTags);
+  obj->mWorker->setQueueDepth(processParams.queueDepth());
+  obj->mWorker->setParallelFrames(processParams.parallelFrames());
+  if (!obj->mWorker->setDropPolicy(processParams.dropPolicy(), processParams.dropLimit())) {
+    std::string err = std::string("Unsupported drop policy \'") + processParams.dropPolicy() + "\'";
+    return Nan::ThrowError(err.c_str());
+  }
 
   uint32_t sampleBytes = 0;
   obj->mIsVideo = obj->mSrcEssInfo->isVideo();
@@ -156,8 +173,8 @@ NAN_METHOD(Concater::SetInfo) {
 }
 
 NAN_METHOD(Concater::Concat) {
-  if (info.Length() != 3)
-    return Nan::ThrowError("Concater concat expects 3 arguments");
+  if ((info.Length() < 3) || (info.Length() > 4))
+    return Nan::ThrowError("Concater concat expects 3 or 4 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("Concater concat requires a valid source buffer array as the first parameter");
   if (!info[1]->IsObject())
@@ -173,13 +190,60 @@ NAN_METHOD(Concater::Concat) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Concater Concat called with incorrect setup parameters");
 
-  std::shared_ptr<ConcatProcessData> cpd = std::make_shared<ConcatProcessData>(srcBufArray, dstBuf);
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
+  std::shared_ptr<ConcatProcessData> cpd = obj->mProcessDataPool.acquire();
+  cpd->set(srcBufArray, dstBuf);
   if (cpd->srcBytes() > cpd->dstBuf()->numBytes()) {
     std::string err = std::string("Destination buffer too small: ") + std::to_string(cpd->dstBuf()->numBytes()) + 
       ", required: " + std::to_string(cpd->srcBytes());
+    cpd->recycle();
     return Nan::ThrowError(err.c_str());
   }
-  obj->mWorker->doFrame(cpd, obj, new Nan::Callback(callback));
+  obj->mWorker->doFrame(cpd, obj, callback, MyWorker::deadlineArg(info, 3));
+
+  info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
+}
+
+NAN_METHOD(Concater::ConcatBatch) {
+  Concater* obj = Nan::ObjectWrap::Unwrap<Concater>(info.Holder());
+  uint32_t numFrames = obj->mWorker->batchArgs(info, "Concater concatBatch", obj->mSetInfoOK);
+  if (!numFrames)
+    return;
+
+  Local<Array> srcBufArrays = Local<Array>::Cast(info[0]);
+  Local<Array> dstBufArray = Local<Array>::Cast(info[1]);
+  Local<Function> callback = Local<Function>::Cast(info[2]);
+
+  if (!obj->mWorker->hasRoomFor(numFrames))
+    return info.GetReturnValue().Set(Nan::False());
+
+  // check every frame before queueing any, so that a batch is either queued whole or not at all
+  for (uint32_t i = 0; i < numFrames; ++i) {
+    Local<Value> srcBufVal = srcBufArrays->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked();
+    Local<Object> dstBufObj = Local<Object>::Cast(dstBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+    if (!srcBufVal->IsArray() || !node::Buffer::HasInstance(dstBufObj))
+      return Nan::ThrowError("Concater concatBatch requires each source entry to be a buffer array and each destination a buffer");
+    Local<Array> srcBufArray = Local<Array>::Cast(srcBufVal);
+    uint32_t srcBytes = 0;
+    for (uint32_t b = 0; b < srcBufArray->Length(); ++b)
+      srcBytes += (uint32_t)node::Buffer::Length(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), b).ToLocalChecked());
+    if (srcBytes > node::Buffer::Length(dstBufObj)) {
+      std::string err = std::string("Concater concatBatch destination buffer too small - frame ") + std::to_string(i) + ": " +
+        std::to_string(node::Buffer::Length(dstBufObj)) + ", required: " + std::to_string(srcBytes);
+      return Nan::ThrowError(err.c_str());
+    }
+  }
+
+  obj->mWorker->startBatch(callback, numFrames, MyWorker::deadlineArg(info, 3));
+  for (uint32_t i = 0; i < numFrames; ++i) {
+    Local<Array> srcBufArray = Local<Array>::Cast(srcBufArrays->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+    Local<Object> dstBufObj = Local<Object>::Cast(dstBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+    std::shared_ptr<ConcatProcessData> cpd = obj->mProcessDataPool.acquire();
+    cpd->set(srcBufArray, dstBufObj);
+    obj->mWorker->doBatchFrame(cpd, obj);
+  }
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
@@ -205,6 +269,7 @@ NAN_MODULE_INIT(Concater::Init) {
 
   SetPrototypeMethod(tpl, "setInfo", SetInfo);
   SetPrototypeMethod(tpl, "concat", Concat);
+  SetPrototypeMethod(tpl, "concatBatch", ConcatBatch);
   SetPrototypeMethod(tpl, "quit", Quit);
 
   constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
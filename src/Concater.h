@@ -18,12 +18,14 @@
 
 #include "iDebug.h"
 #include "iProcess.h"
+#include "ProcessDataPool.h"
 #include <memory>
 
 namespace streampunk {
 
 class MyWorker;
 class EssenceInfo;
+class ConcatProcessData;
 
 class Concater : public Nan::ObjectWrap, public iProcess, public iDebug {
 public:
@@ -59,6 +61,7 @@ private:
 
   static NAN_METHOD(SetInfo);
   static NAN_METHOD(Concat);
+  static NAN_METHOD(ConcatBatch);
   static NAN_METHOD(Quit);
 
   MyWorker *mWorker;
@@ -68,6 +71,7 @@ private:
   uint32_t mPitchBytes;
   bool mInterlace;
   bool mTff;
+  ProcessDataPool<ConcatProcessData> mProcessDataPool;
 };
 
 } // namespace streampunk
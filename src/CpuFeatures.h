@@ -0,0 +1,85 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CODECADON_X86 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+// Functions using instructions beyond the build's baseline are compiled for them individually
+#if defined(CODECADON_X86) && !defined(_MSC_VER)
+#define CODECADON_TARGET(isa) __attribute__((target(isa)))
+#else
+#define CODECADON_TARGET(isa)
+#endif
+
+namespace streampunk {
+
+// Instruction set extensions available to the SIMD kernels, detected once.
+// CODECADON_SIMD=none runs the scalar code only and CODECADON_SIMD=ssse3 stops short of AVX2,
+// for comparing against the reference implementations.
+class CpuFeatures {
+public:
+  static const CpuFeatures &instance() {
+    static CpuFeatures features;
+    return features;
+  }
+
+  bool ssse3() const { return mSsse3; }
+  bool avx2() const { return mAvx2; }
+
+private:
+  CpuFeatures() : mSsse3(false), mAvx2(false) {
+#ifdef CODECADON_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    mSsse3 = 0 != (info[2] & (1 << 9));
+    bool osAvx = (0 != (info[2] & (1 << 27))) && (6 == (_xgetbv(0) & 6));
+    if (osAvx && (maxLeaf >= 7)) {
+      __cpuidex(info, 7, 0);
+      mAvx2 = 0 != (info[1] & (1 << 5));
+    }
+#else
+    __builtin_cpu_init();
+    mSsse3 = __builtin_cpu_supports("ssse3");
+    mAvx2 = __builtin_cpu_supports("avx2");
+#endif
+#endif
+    const char *env = getenv("CODECADON_SIMD");
+    if (env && (0 == strcmp(env, "none")))
+      mSsse3 = false;
+    if (env && ((0 == strcmp(env, "none")) || (0 == strcmp(env, "ssse3"))))
+      mAvx2 = false;
+  }
+
+  bool mSsse3;
+  bool mAvx2;
+};
+
+} // namespace streampunk
+
+#endif
@@ -21,6 +21,7 @@
 #include "DecoderFactory.h"
 #include "EssenceInfo.h"
 #include "Persist.h"
+#include "ProcessParams.h"
 
 #include <memory>
 
@@ -30,35 +31,50 @@ namespace streampunk {
 
 class DecodeProcessData : public iProcessData {
 public:
-  DecodeProcessData (Local<Object> srcBufObj, Local<Object> dstBufObj)
-    : mPersistentSrcBuf(new Persist(srcBufObj)),
-      mPersistentDstBuf(new Persist(dstBufObj)),
-      mSrcBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj))),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj)))
+  DecodeProcessData ()
+    : mSrcBuf(Memory::makeNew((uint8_t *)NULL, 0)), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0))
+    { }
+  DecodeProcessData (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf)
+    : mSrcBuf(srcBuf), mDstBuf(dstBuf)
     { }
   ~DecodeProcessData() { }
+
+  void set(Local<Object> srcBufObj, Local<Object> dstBufObj) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mPersistentDstBuf.reset(dstBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
+  }
+  // native output mode - the result goes to a pool buffer that is handed to JS with the frame callback
+  void set(Local<Object> srcBufObj, std::shared_ptr<Memory> nativeDstBuf) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset(nativeDstBuf->buf(), nativeDstBuf->numBytes());
+  }
+  void recycle() {
+    mPersistentSrcBuf.reset();
+    mPersistentDstBuf.reset();
+  }
   
   std::shared_ptr<Memory> srcBuf() const { return mSrcBuf; }
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
 
 private:
-  std::unique_ptr<Persist> mPersistentSrcBuf;
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  Persist mPersistentSrcBuf;
+  Persist mPersistentDstBuf;
   std::shared_ptr<Memory> mSrcBuf;
   std::shared_ptr<Memory> mDstBuf;
 };
 
 
 Decoder::Decoder(Nan::Callback *callback) 
-  : mWorker(new MyWorker(callback)), mFrameNum(0), mSetInfoOK(false) {
-  AsyncQueueWorker(mWorker);
-}
+  : mWorker(new MyWorker(callback)), mFrameNum(0), mSetInfoOK(false) {}
 Decoder::~Decoder() {}
 
 // iProcess
 uint32_t Decoder::processFrame (std::shared_ptr<iProcessData> processData) {
   Timer t;
-  std::shared_ptr<DecodeProcessData> dpd = std::dynamic_pointer_cast<DecodeProcessData>(processData);
+  DecodeProcessData *dpd = static_cast<DecodeProcessData *>(processData.get());
 
   // do the decode
   uint32_t dstBytes = 0;
@@ -68,11 +84,26 @@ uint32_t Decoder::processFrame (std::shared_ptr<iProcessData> processData) {
   return dstBytes;
 }
 
+// iPipelineStage
+uint32_t Decoder::stageSrcBytes() const {
+  // compressed frames vary in size
+  return 0;
+}
+
+uint32_t Decoder::stageDstBytes() const {
+  return mSetInfoOK ? mDecoderDriver->bytesReq() : 0;
+}
+
+uint32_t Decoder::processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) {
+  return processFrame(std::make_shared<DecodeProcessData>(srcBuf, dstBuf));
+}
+
 void Decoder::doSetInfo(Local<Object> srcTags, Local<Object> dstTags) {
   mSrcVidInfo = std::make_shared<EssenceInfo>(srcTags); 
   printDebug(eInfo, "Decoder SrcVidInfo: %s\n", mSrcVidInfo->toString().c_str());
   mDstVidInfo = std::make_shared<EssenceInfo>(dstTags); 
   printDebug(eInfo, "Decoder DstVidInfo: %s\n", mDstVidInfo->toString().c_str());
+  mWorker->setQueueDepth(ProcessParams(dstTags).queueDepth());
 
   if (mSrcVidInfo->encodingName().compare("h264") && mSrcVidInfo->encodingName().compare("vp8") && 
       mSrcVidInfo->encodingName().compare("AVCi50") && mSrcVidInfo->encodingName().compare("AVCi100")) {
@@ -86,7 +117,7 @@ void Decoder::doSetInfo(Local<Object> srcTags, Local<Object> dstTags) {
   }
   if ((mSrcVidInfo->width() % 2) || (mDstVidInfo->width() % 2)) {
     std::string err = std::string("Width must be divisible by 2 - src ") + std::to_string(mSrcVidInfo->width()) + ", dst " + std::to_string(mDstVidInfo->width());
-    Nan::ThrowError(err.c_str());
+    return Nan::ThrowError(err.c_str());
   }
 
   try {
@@ -129,13 +160,14 @@ NAN_METHOD(Decoder::Decode) {
     return Nan::ThrowError("Decoder Decode expects 3 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("Decoder Decode requires a valid source buffer array as the first parameter");
-  if (!info[1]->IsObject())
-    return Nan::ThrowError("Decoder Decode requires a valid destination buffer as the second parameter");
+  if (!info[1]->IsObject() && !info[1]->IsNull())
+    return Nan::ThrowError("Decoder Decode requires a valid destination buffer, or null for a pooled output buffer, as the second parameter");
   if (!info[2]->IsFunction())
     return Nan::ThrowError("Decoder Decode requires a valid callback as the third parameter");
 
   Local<Array> srcBufArray = Local<Array>::Cast(info[0]);
-  Local<Object> dstBuf = Local<Object>::Cast(info[1]);
+  // a null destination asks for the result in a pooled buffer, passed to the callback as an external Buffer
+  Local<Object> dstBuf = MyWorker::dstBufArg(info, 1);
   Local<Function> callback = Local<Function>::Cast(info[2]);
 
   Decoder* obj = Nan::ObjectWrap::Unwrap<Decoder>(info.Holder());
@@ -143,14 +175,18 @@ NAN_METHOD(Decoder::Decode) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Decoder decode called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   if (1 != srcBufArray->Length()) {
     std::string err = std::string("Decoder requires single source buffer - received ") + std::to_string(srcBufArray->Length());
     return Nan::ThrowError(err.c_str());
   }
   Local<Object> srcBuf = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
 
-  std::shared_ptr<iProcessData> epd = std::make_shared<DecodeProcessData>(srcBuf, dstBuf);
-  obj->mWorker->doFrame(epd, obj, new Nan::Callback(callback));
+  std::shared_ptr<DecodeProcessData> epd = obj->mProcessDataPool.acquire();
+  std::shared_ptr<Memory> outputBuf = MyWorker::setFrameBufs(*epd, srcBuf, dstBuf, obj->mDecoderDriver->bytesReq());
+  obj->mWorker->doFrame(epd, obj, callback, 0, outputBuf);
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
@@ -18,6 +18,7 @@
 
 #include "iDebug.h"
 #include "iProcess.h"
+#include "ProcessDataPool.h"
 #include <memory>
 
 namespace streampunk {
@@ -25,13 +26,19 @@ namespace streampunk {
 class MyWorker;
 class iDecoderDriver;
 class EssenceInfo;
+class DecodeProcessData;
 
-class Decoder : public Nan::ObjectWrap, public iProcess, public iDebug {
+class Decoder : public Nan::ObjectWrap, public iProcess, public iPipelineStage, public iDebug {
 public:
   static NAN_MODULE_INIT(Init);
 
   // iProcess
   uint32_t processFrame (std::shared_ptr<iProcessData> processData);
+
+  // iPipelineStage
+  uint32_t stageSrcBytes() const;
+  uint32_t stageDstBytes() const;
+  uint32_t processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf);
   
 private:
   explicit Decoder(Nan::Callback *callback);
@@ -70,6 +77,7 @@ private:
   std::shared_ptr<EssenceInfo> mSrcVidInfo;
   std::shared_ptr<EssenceInfo> mDstVidInfo;
   std::shared_ptr<iDecoderDriver> mDecoderDriver;
+  ProcessDataPool<DecodeProcessData> mProcessDataPool;
 };
 
 } // namespace streampunk
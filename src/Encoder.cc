@@ -19,9 +19,11 @@
 #include "Timer.h"
 #include "Packers.h"
 #include "Memory.h"
+#include "FramePool.h"
 #include "EncoderFactory.h"
 #include "EssenceInfo.h"
 #include "Persist.h"
+#include "ProcessParams.h"
 
 #include <memory>
 
@@ -36,22 +38,46 @@ uint32_t beToLe32 (uint32_t be) {
 
 class EncodeProcessData : public iProcessData {
 public:
-  EncodeProcessData (Local<Object> srcBufObj, Local<Object> dstBufObj, std::shared_ptr<Memory> convertDstBuf)
-    : mPersistentSrcBuf(new Persist(srcBufObj)),
-      mPersistentDstBuf(new Persist(dstBufObj)),
-      mSrcBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj))), 
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj))), 
-      mConvertDstBuf(convertDstBuf)
+  EncodeProcessData ()
+    : mSrcBuf(Memory::makeNew((uint8_t *)NULL, 0)), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0))
+    { }
+  EncodeProcessData (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf, std::shared_ptr<Memory> convertDstBuf)
+    : mSrcBuf(srcBuf), mDstBuf(dstBuf), mConvertDstBuf(convertDstBuf)
     { }
   ~EncodeProcessData() {}
+
+  // convertBytes is the size of the buffer needed to repack the source for the encoder, 0 if none -
+  // the buffer is kept for the next frame
+  void set(Local<Object> srcBufObj, Local<Object> dstBufObj, uint32_t convertBytes) {
+    mPersistentDstBuf.reset(dstBufObj);
+    setBufs(srcBufObj, (uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj), convertBytes);
+  }
+  // native output mode - the result goes to a pool buffer that is handed to JS with the frame callback
+  void set(Local<Object> srcBufObj, std::shared_ptr<Memory> nativeDstBuf, uint32_t convertBytes) {
+    setBufs(srcBufObj, nativeDstBuf->buf(), nativeDstBuf->numBytes(), convertBytes);
+  }
+  void recycle() {
+    mPersistentSrcBuf.reset();
+    mPersistentDstBuf.reset();
+  }
   
   std::shared_ptr<Memory> srcBuf() const { return mSrcBuf; }
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
   std::shared_ptr<Memory> convertDstBuf() const { return mConvertDstBuf; }
 
 private:
-  std::unique_ptr<Persist> mPersistentSrcBuf;
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  void setBufs(Local<Object> srcBufObj, uint8_t *dstBuf, uint32_t dstBytes, uint32_t convertBytes) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset(dstBuf, dstBytes);
+    if (!convertBytes)
+      mConvertDstBuf.reset();
+    else if (!mConvertDstBuf || (mConvertDstBuf->numBytes() != convertBytes))
+      mConvertDstBuf = Memory::makeNew(convertBytes);
+  }
+
+  Persist mPersistentSrcBuf;
+  Persist mPersistentDstBuf;
   std::shared_ptr<Memory> mSrcBuf;
   std::shared_ptr<Memory> mDstBuf;
   std::shared_ptr<Memory> mConvertDstBuf;
@@ -59,15 +85,13 @@ private:
 
 
 Encoder::Encoder(Nan::Callback *callback) 
-  : mWorker(new MyWorker(callback)), mFrameNum(0), mSetInfoOK(false) {
-  AsyncQueueWorker(mWorker);
-}
+  : mWorker(new MyWorker(callback)), mFrameNum(0), mSetInfoOK(false) {}
 Encoder::~Encoder() {}
 
 // iProcess
 uint32_t Encoder::processFrame (std::shared_ptr<iProcessData> processData) {
   Timer t;
-  std::shared_ptr<EncodeProcessData> epd = std::dynamic_pointer_cast<EncodeProcessData>(processData);
+  EncodeProcessData *epd = static_cast<EncodeProcessData *>(processData.get());
 
   // do the encode
   uint32_t dstBytes = 0;
@@ -88,6 +112,24 @@ uint32_t Encoder::processFrame (std::shared_ptr<iProcessData> processData) {
   return dstBytes;
 }
 
+// iPipelineStage
+uint32_t Encoder::stageSrcBytes() const {
+  if (!mSetInfoOK || !mSrcInfo->isVideo())
+    return 0;
+  return getFormatBytes(mSrcInfo->packing(), mSrcInfo->width(), mSrcInfo->height());
+}
+
+uint32_t Encoder::stageDstBytes() const {
+  return mSetInfoOK ? mEncoderDriver->bytesReq() : 0;
+}
+
+uint32_t Encoder::processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) {
+  std::shared_ptr<Memory> convertDstBuf;
+  if (mPacker)
+    convertDstBuf = Memory::makeNew(getFormatBytes(mEncoderDriver->packingRequired(), mSrcInfo->width(), mSrcInfo->height()));
+  return processFrame(std::make_shared<EncodeProcessData>(srcBuf, dstBuf, convertDstBuf));
+}
+
 void Encoder::doSetInfo(Local<Object> srcTags, Local<Object> dstTags, const Duration& duration,
                         Local<Object> encodeTags) {
   mSrcInfo = std::make_shared<EssenceInfo>(srcTags); 
@@ -96,6 +138,12 @@ void Encoder::doSetInfo(Local<Object> srcTags, Local<Object> dstTags, const Dura
   printDebug(eInfo, "Encoder DstInfo: %s\n", mDstInfo->toString().c_str());
   std::shared_ptr<EncodeParams> encodeParams = std::make_shared<EncodeParams>(encodeTags, mSrcInfo->isVideo()); 
   printDebug(eInfo, "Encode Params: %s\n", encodeParams->toString().c_str());
+  ProcessParams processParams(encodeTags);
+  mWorker->setQueueDepth(processParams.queueDepth());
+  if (!mWorker->setDropPolicy(processParams.dropPolicy(), processParams.dropLimit())) {
+    std::string err = std::string("Unsupported drop policy \'") + processParams.dropPolicy() + "\'";
+    return Nan::ThrowError(err.c_str());
+  }
 
   if (mSrcInfo->isVideo()) {
     if (mSrcInfo->packing().compare("420P") && mSrcInfo->packing().compare("YUV422P10") && 
@@ -111,7 +159,7 @@ void Encoder::doSetInfo(Local<Object> srcTags, Local<Object> dstTags, const Dura
     }
     if ((mSrcInfo->width() % 2) || (mDstInfo->width() % 2)) {
       std::string err = std::string("Width must be divisible by 2 - src ") + std::to_string(mSrcInfo->width()) + ", dst " + std::to_string(mDstInfo->width());
-      Nan::ThrowError(err.c_str());
+      return Nan::ThrowError(err.c_str());
     }
     if ((mSrcInfo->width() != mDstInfo->width()) || (mSrcInfo->height() != mDstInfo->height())) {
       std::string err = std::string("Unsupported dimensions ") +
@@ -134,7 +182,14 @@ void Encoder::doSetInfo(Local<Object> srcTags, Local<Object> dstTags, const Dura
     return Nan::ThrowError(err.what());
   }
   if (mSrcInfo->isVideo() && mEncoderDriver->packingRequired().compare(mSrcInfo->packing()))
-    mPacker = std::make_shared<Packers>(mSrcInfo->width(), mSrcInfo->height(), mSrcInfo->packing(), mEncoderDriver->packingRequired());
+    mPacker = std::make_shared<Packers>(mSrcInfo->width(), mSrcInfo->height(), mSrcInfo->packing(), mEncoderDriver->packingRequired(),
+                                        0 != mSrcInfo->interlace().compare("prog"), 1,
+                                        processParams.fieldChroma(), processParams.dither());
+
+  // repacking buffers come from the frame pool - with preTouch they are faulted in now rather than by the first frames
+  if (mPacker && processParams.preTouch())
+    FramePool::instance().reserve(getFormatBytes(mEncoderDriver->packingRequired(), mSrcInfo->width(), mSrcInfo->height()),
+                                  mWorker->queueDepth(), true);
 }
 
 NAN_METHOD(Encoder::SetInfo) {
@@ -176,17 +231,18 @@ NAN_METHOD(Encoder::SetInfo) {
 }
 
 NAN_METHOD(Encoder::Encode) {
-  if (info.Length() != 3)
-    return Nan::ThrowError("Encoder Encode expects 3 arguments");
+  if ((info.Length() < 3) || (info.Length() > 4))
+    return Nan::ThrowError("Encoder Encode expects 3 or 4 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("Encoder Encode requires a valid source buffer array as the first parameter");
-  if (!info[1]->IsObject())
-    return Nan::ThrowError("Encoder Encode requires a valid destination buffer as the second parameter");
+  if (!info[1]->IsObject() && !info[1]->IsNull())
+    return Nan::ThrowError("Encoder Encode requires a valid destination buffer, or null for a pooled output buffer, as the second parameter");
   if (!info[2]->IsFunction())
     return Nan::ThrowError("Encoder Encode requires a valid callback as the third parameter");
 
   Local<Array> srcBufArray = Local<Array>::Cast(info[0]);
-  Local<Object> dstBufObj = Local<Object>::Cast(info[1]);
+  // a null destination asks for the result in a pooled buffer, passed to the callback as an external Buffer
+  Local<Object> dstBufObj = MyWorker::dstBufArg(info, 1);
   Local<Function> callback = Local<Function>::Cast(info[2]);
 
   Encoder* obj = Nan::ObjectWrap::Unwrap<Encoder>(info.Holder());
@@ -194,16 +250,60 @@ NAN_METHOD(Encoder::Encode) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Encoder Encode called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   if (1 != srcBufArray->Length()) {
     std::string err = std::string("Encoder requires single source buffer - received ") + std::to_string(srcBufArray->Length());
     return Nan::ThrowError(err.c_str());
   }
   Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
-  std::shared_ptr<Memory> convertDstBuf;
+  uint32_t convertBytes = 0;
   if (obj->mPacker)
-    convertDstBuf = Memory::makeNew(getFormatBytes(obj->mEncoderDriver->packingRequired(), obj->mSrcInfo->width(), obj->mSrcInfo->height()));
-  std::shared_ptr<iProcessData> epd = std::make_shared<EncodeProcessData>(srcBufObj, dstBufObj, convertDstBuf);
-  obj->mWorker->doFrame(epd, obj, new Nan::Callback(callback));
+    convertBytes = getFormatBytes(obj->mEncoderDriver->packingRequired(), obj->mSrcInfo->width(), obj->mSrcInfo->height());
+  std::shared_ptr<EncodeProcessData> epd = obj->mProcessDataPool.acquire();
+  std::shared_ptr<Memory> outputBuf = MyWorker::setFrameBufs(*epd, srcBufObj, dstBufObj, obj->mEncoderDriver->bytesReq(), convertBytes);
+  obj->mWorker->doFrame(epd, obj, callback, MyWorker::deadlineArg(info, 3), outputBuf);
+
+  info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
+}
+
+NAN_METHOD(Encoder::EncodeBatch) {
+  Encoder* obj = Nan::ObjectWrap::Unwrap<Encoder>(info.Holder());
+  uint32_t numFrames = obj->mWorker->batchArgs(info, "Encoder encodeBatch", obj->mSetInfoOK);
+  if (!numFrames)
+    return;
+
+  Local<Array> srcBufArrays = Local<Array>::Cast(info[0]);
+  Local<Array> dstBufArray = Local<Array>::Cast(info[1]);
+  Local<Function> callback = Local<Function>::Cast(info[2]);
+
+  if (!obj->mWorker->hasRoomFor(numFrames))
+    return info.GetReturnValue().Set(Nan::False());
+
+  // check every frame before queueing any, so that a batch is either queued whole or not at all
+  for (uint32_t i=0; i<numFrames; ++i) {
+    Local<Value> srcBufVal = srcBufArrays->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked();
+    if (!srcBufVal->IsArray() || (1 != Local<Array>::Cast(srcBufVal)->Length())) {
+      std::string err = std::string("Encoder encodeBatch requires single source buffer for each frame - frame ") + std::to_string(i) + " does not have one";
+      return Nan::ThrowError(err.c_str());
+    }
+    if (!node::Buffer::HasInstance(dstBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked()))
+      return Nan::ThrowError("Encoder encodeBatch requires each destination to be a buffer");
+  }
+
+  uint32_t convertBytes = 0;
+  if (obj->mPacker)
+    convertBytes = getFormatBytes(obj->mEncoderDriver->packingRequired(), obj->mSrcInfo->width(), obj->mSrcInfo->height());
+  obj->mWorker->startBatch(callback, numFrames, MyWorker::deadlineArg(info, 3));
+  for (uint32_t i=0; i<numFrames; ++i) {
+    Local<Array> srcBufArray = Local<Array>::Cast(srcBufArrays->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+    Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
+    Local<Object> dstBufObj = Local<Object>::Cast(dstBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+    std::shared_ptr<EncodeProcessData> epd = obj->mProcessDataPool.acquire();
+    epd->set(srcBufObj, dstBufObj, convertBytes);
+    obj->mWorker->doBatchFrame(epd, obj);
+  }
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
@@ -229,6 +329,7 @@ NAN_MODULE_INIT(Encoder::Init) {
 
   SetPrototypeMethod(tpl, "setInfo", SetInfo);
   SetPrototypeMethod(tpl, "encode", Encode);
+  SetPrototypeMethod(tpl, "encodeBatch", EncodeBatch);
   SetPrototypeMethod(tpl, "quit", Quit);
 
   constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
@@ -18,6 +18,7 @@
 
 #include "iDebug.h"
 #include "iProcess.h"
+#include "ProcessDataPool.h"
 #include <memory>
 
 namespace streampunk {
@@ -27,13 +28,19 @@ class Packers;
 class iEncoderDriver;
 class Duration;
 class EssenceInfo;
+class EncodeProcessData;
 
-class Encoder : public Nan::ObjectWrap, public iProcess, public iDebug {
+class Encoder : public Nan::ObjectWrap, public iProcess, public iPipelineStage, public iDebug {
 public:
   static NAN_MODULE_INIT(Init);
 
   // iProcess
   uint32_t processFrame (std::shared_ptr<iProcessData> processData);
+
+  // iPipelineStage
+  uint32_t stageSrcBytes() const;
+  uint32_t stageDstBytes() const;
+  uint32_t processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf);
   
 private:
   explicit Encoder(Nan::Callback *callback);
@@ -65,6 +72,7 @@ private:
 
   static NAN_METHOD(SetInfo);
   static NAN_METHOD(Encode);
+  static NAN_METHOD(EncodeBatch);
   static NAN_METHOD(Quit);
 
   MyWorker *mWorker;
@@ -74,6 +82,7 @@ private:
   std::shared_ptr<EssenceInfo> mDstInfo;
   std::shared_ptr<Packers> mPacker;
   std::shared_ptr<iEncoderDriver> mEncoderDriver;
+  ProcessDataPool<EncodeProcessData> mProcessDataPool;
 };
 
 } // namespace streampunk
@@ -20,8 +20,11 @@
 #include "Memory.h"
 #include "EssenceInfo.h"
 #include "Persist.h"
+#include "ProcessParams.h"
+#include "WorkerPool.h"
 
 #include <memory>
+#include <algorithm>
 
 using namespace v8;
 
@@ -29,19 +32,37 @@ namespace streampunk {
 
 class FlipProcessData : public iProcessData {
 public:
-  FlipProcessData (Local<Object> srcBufObj, Local<Object> dstBufObj)
-    : mPersistentSrcBuf(new Persist(srcBufObj)), mPersistentDstBuf(new Persist(dstBufObj)),
-      mSrcBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj))),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj)))
+  FlipProcessData ()
+    : mSrcBuf(Memory::makeNew((uint8_t *)NULL, 0)), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0))
+  {}
+  FlipProcessData (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf)
+    : mSrcBuf(srcBuf), mDstBuf(dstBuf)
   {}
   ~FlipProcessData() {}
+
+  void set(Local<Object> srcBufObj, Local<Object> dstBufObj) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mPersistentDstBuf.reset(dstBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
+  }
+  // native output mode - the result goes to a pool buffer that is handed to JS with the frame callback
+  void set(Local<Object> srcBufObj, std::shared_ptr<Memory> nativeDstBuf) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset(nativeDstBuf->buf(), nativeDstBuf->numBytes());
+  }
+  void recycle() {
+    mPersistentSrcBuf.reset();
+    mPersistentDstBuf.reset();
+  }
   
   std::shared_ptr<Memory> srcBuf() const { return mSrcBuf; }
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
 
 private:
-  std::unique_ptr<Persist> mPersistentSrcBuf;
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  Persist mPersistentSrcBuf;
+  Persist mPersistentDstBuf;
   std::shared_ptr<Memory> mSrcBuf;
   std::shared_ptr<Memory> mDstBuf;
 };
@@ -72,26 +93,71 @@ private:
 };
 
 Flipper::Flipper(Nan::Callback *callback) 
-  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mPitchBytes(0), mInterlace(false), mTff(true) {
-  AsyncQueueWorker(mWorker);
-}
+  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mPitchBytes(0), mInterlace(false), mTff(true) {}
 Flipper::~Flipper() {}
 
 // iProcess
 uint32_t Flipper::processFrame (std::shared_ptr<iProcessData> processData) {
   Timer t;
-  std::shared_ptr<FlipProcessData> fpd = std::dynamic_pointer_cast<FlipProcessData>(processData);
+  FlipProcessData *fpd = static_cast<FlipProcessData *>(processData.get());
+
+  if (fpd->srcBuf()->buf() == fpd->dstBuf()->buf()) {
+    // in place - each line is swapped with its mirror, so the work is shared out as disjoint bands of line pairs
+    uint32_t numPairs = mSrcVidInfo->height() / 2;
+    if (mProcessParams->threads() < 2)
+      swapLines(fpd, 0, numPairs);
+    else
+      WorkerPool::instance().runLines(numPairs, mProcessParams->threads(), 1,
+        std::bind(&Flipper::swapLines, this, fpd, std::placeholders::_1, std::placeholders::_2));
+  }
+  else if (mProcessParams->threads() < 2)
+    flipLines(fpd, 0, mSrcVidInfo->height());
+  else
+    WorkerPool::instance().runLines(mSrcVidInfo->height(), mProcessParams->threads(), mInterlace ? 2 : 1,
+      std::bind(&Flipper::flipLines, this, fpd, std::placeholders::_1, std::placeholders::_2));
+
+  printDebug(eDebug, "flip : %.2fms\n", t.delta());
+  return mSrcFormatBytes;
+}
+
+// iPipelineStage
+uint32_t Flipper::stageSrcBytes() const {
+  return mSetInfoOK ? mSrcFormatBytes : 0;
+}
 
+uint32_t Flipper::stageDstBytes() const {
+  return mSetInfoOK ? mSrcFormatBytes : 0;
+}
+
+uint32_t Flipper::processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) {
+  return processFrame(std::make_shared<FlipProcessData>(srcBuf, dstBuf));
+}
+
+void Flipper::flipLines(const FlipProcessData *fpd, uint32_t firstLine, uint32_t numLines) {
   std::shared_ptr<Memory> srcBuf = fpd->srcBuf();
   std::shared_ptr<Memory> dstBuf = fpd->dstBuf();
-  for (uint32_t dstY=0, srcY=mSrcVidInfo->height()-1; dstY != mSrcVidInfo->height(); ++dstY, --srcY) {
+  for (uint32_t dstY=firstLine, srcY=mSrcVidInfo->height()-1-firstLine; dstY != firstLine+numLines; ++dstY, --srcY) {
     const uint8_t* srcLine = srcBuf->buf() + mPitchBytes * srcY;
     uint8_t* dstLine = dstBuf->buf() + mPitchBytes * dstY;   
     memcpy(dstLine, srcLine, mPitchBytes);
   }
+}
 
-  printDebug(eDebug, "flip : %.2fms\n", t.delta());
-  return mSrcFormatBytes;
+void Flipper::swapLines(const FlipProcessData *fpd, uint32_t firstPair, uint32_t numPairs) {
+  uint8_t *buf = fpd->dstBuf()->buf();
+  // lines are swapped a chunk at a time through the stack, so a band allocates nothing
+  const uint32_t chunkBytes = 4096;
+  uint8_t tmpChunk[chunkBytes];
+  for (uint32_t topY=firstPair, bottomY=mSrcVidInfo->height()-1-firstPair; topY != firstPair+numPairs; ++topY, --bottomY) {
+    uint8_t* topLine = buf + mPitchBytes * topY;
+    uint8_t* bottomLine = buf + mPitchBytes * bottomY;
+    for (uint32_t x=0; x<mPitchBytes; x+=chunkBytes) {
+      uint32_t numBytes = std::min(chunkBytes, mPitchBytes - x);
+      memcpy(tmpChunk, topLine + x, numBytes);
+      memcpy(topLine + x, bottomLine + x, numBytes);
+      memcpy(bottomLine + x, tmpChunk, numBytes);
+    }
+  }
 }
 
 NAN_METHOD(Flipper::SetInfo) {
@@ -111,6 +177,13 @@ NAN_METHOD(Flipper::SetInfo) {
   
   obj->mSrcVidInfo = std::make_shared<EssenceInfo>(srcTags);
   obj->mFlipInfo = std::make_shared<FlipInfo>(flipObj);
+  obj->mProcessParams = std::make_shared<ProcessParams>(flipObj);
+  obj->mWorker->setQueueDepth(obj->mProcessParams->queueDepth());
+  obj->mWorker->setParallelFrames(obj->mProcessParams->parallelFrames());
+  if (!obj->mWorker->setDropPolicy(obj->mProcessParams->dropPolicy(), obj->mProcessParams->dropLimit())) {
+    std::string err = std::string("Unsupported drop policy \'") + obj->mProcessParams->dropPolicy() + "\'";
+    return Nan::ThrowError(err.c_str());
+  }
   obj->printDebug(eInfo, "Flipper SrcVidInfo: %s%s%s\n", obj->mSrcVidInfo->toString().c_str(), obj->mFlipInfo->hflip()?", hflip":"", obj->mFlipInfo->vflip()?", vflip":"");
 
   // Currently supporting only non-planar formats
@@ -137,16 +210,17 @@ NAN_METHOD(Flipper::SetInfo) {
 }
 
 NAN_METHOD(Flipper::Flip) {
-  if (info.Length() != 3)
-    return Nan::ThrowError("Flipper flip expects 3 arguments");
+  if ((info.Length() < 3) || (info.Length() > 4))
+    return Nan::ThrowError("Flipper flip expects 3 or 4 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("Flipper flip requires a valid source buffer array as the first parameter");
-  if (!info[1]->IsObject())
-    return Nan::ThrowError("Flipper flip requires a valid destination buffer as the second parameter");
+  if (!info[1]->IsObject() && !info[1]->IsNull())
+    return Nan::ThrowError("Flipper flip requires a valid destination buffer, or null for a pooled output buffer, as the second parameter");
   if (!info[2]->IsFunction())
     return Nan::ThrowError("Flipper flip requires a valid callback as the third parameter");
   Local<Array> srcBufArray = Local<Array>::Cast(info[0]);
-  Local<Object> dstBufObj = Local<Object>::Cast(info[1]);
+  // a null destination asks for the result in a pooled buffer, passed to the callback as an external Buffer
+  Local<Object> dstBufObj = MyWorker::dstBufArg(info, 1);
   Local<Function> callback = Local<Function>::Cast(info[2]);
 
   Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
@@ -156,15 +230,22 @@ NAN_METHOD(Flipper::Flip) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Flipper flip called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   obj->mSrcFormatBytes = getFormatBytes(obj->mSrcVidInfo->packing(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height());
   if (obj->mSrcFormatBytes > (uint32_t)node::Buffer::Length(srcBufObj))
     return Nan::ThrowError("Insufficient source buffer for conversion");
 
-  if (obj->mSrcFormatBytes > node::Buffer::Length(dstBufObj))
+  if (!dstBufObj.IsEmpty() && (obj->mSrcFormatBytes > node::Buffer::Length(dstBufObj)))
     return Nan::ThrowError("Insufficient destination buffer for specified format");
+  // the same buffer as source and destination flips in place, which must be asked for when setting up
+  if (!dstBufObj.IsEmpty() && (node::Buffer::Data(srcBufObj) == node::Buffer::Data(dstBufObj)) && !obj->mProcessParams->inPlace())
+    return Nan::ThrowError("Flipper flip requires separate source and destination buffers unless set up with inPlace");
 
-  std::shared_ptr<FlipProcessData> fpd = std::make_shared<FlipProcessData>(srcBufObj, dstBufObj);
-  obj->mWorker->doFrame(fpd, obj, new Nan::Callback(callback));
+  std::shared_ptr<FlipProcessData> fpd = obj->mProcessDataPool.acquire();
+  std::shared_ptr<Memory> outputBuf = MyWorker::setFrameBufs(*fpd, srcBufObj, dstBufObj, obj->mSrcFormatBytes);
+  obj->mWorker->doFrame(fpd, obj, callback, MyWorker::deadlineArg(info, 3), outputBuf);
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
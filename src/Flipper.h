@@ -19,6 +19,7 @@
 #include <nan.h>
 #include "iDebug.h"
 #include "iProcess.h"
+#include "ProcessDataPool.h"
 #include <memory>
 
 namespace streampunk {
@@ -26,18 +27,28 @@ namespace streampunk {
 class MyWorker;
 class EssenceInfo;
 class FlipInfo;
+class FlipProcessData;
+class ProcessParams;
 
-class Flipper : public Nan::ObjectWrap, public iProcess, public iDebug {
+class Flipper : public Nan::ObjectWrap, public iProcess, public iPipelineStage, public iDebug {
 public:
   static NAN_MODULE_INIT(Init);
 
   // iProcess
   uint32_t processFrame (std::shared_ptr<iProcessData> processData);
+
+  // iPipelineStage
+  uint32_t stageSrcBytes() const;
+  uint32_t stageDstBytes() const;
+  uint32_t processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf);
   
 private:
   explicit Flipper(Nan::Callback *callback);
   ~Flipper();
 
+  void flipLines(const FlipProcessData *fpd, uint32_t firstLine, uint32_t numLines);
+  void swapLines(const FlipProcessData *fpd, uint32_t firstPair, uint32_t numPairs);
+
   static NAN_METHOD(New) {
     if (info.IsConstructCall()) {
       if (!((info.Length() == 1) && (info[0]->IsFunction())))
@@ -69,8 +80,10 @@ private:
   uint32_t mSrcFormatBytes;
   std::shared_ptr<EssenceInfo> mSrcVidInfo;
   std::shared_ptr<FlipInfo> mFlipInfo;
+  std::shared_ptr<ProcessParams> mProcessParams;
   bool mInterlace;
   bool mTff;
+  ProcessDataPool<FlipProcessData> mProcessDataPool;
 };
 
 } // namespace streampunk
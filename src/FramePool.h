@@ -0,0 +1,236 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <mutex>
+#include <map>
+#include <vector>
+#include <new>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace streampunk {
+
+// Process-wide pool of frame buffers shared by all processing objects.
+// Buffers are page aligned and kept in size classes, so that a buffer released by one frame is handed out again
+// to the next frame of the same size without an allocation or first-touch page faults.
+// Buffers smaller than kMinPoolBytes are not worth a page each - they are ordinary cache line aligned allocations
+// of the size asked for, which malloc already reuses, and are neither pooled nor counted.
+// On Linux, CODECADON_HUGEPAGES=madvise asks for transparent huge pages and CODECADON_HUGEPAGES=hugetlb maps
+// buffers from the reserved huge page pool, falling back to normal pages when none are free.
+class FramePool {
+public:
+  static const size_t kPageBytes = 4096;
+  static const size_t kHugePageBytes = 2 * 1024 * 1024;
+  // free buffers kept for each size class, beyond which released buffers are returned to the system
+  static const size_t kMaxFreePerClass = 16;
+  // below the default glibc mmap threshold, so that only buffers that would otherwise be fresh pages are pooled
+  static const size_t kMinPoolBytes = 128 * 1024;
+  static const size_t kSmallAlign = 64;
+
+  enum eHugePages { eHugeNone, eHugeMadvise, eHugeTlb };
+
+  static FramePool &instance() {
+    // never destroyed - buffers may still be released by pool threads when static destructors are called at exit
+    static FramePool *pool = new FramePool(hugePagesMode());
+    return *pool;
+  }
+
+  // counts for a size class, for checking that frames are reusing buffers rather than allocating them
+  struct Stats {
+    Stats() : numAllocated(0), numReused(0), numFree(0) {}
+    uint64_t numAllocated;
+    uint64_t numReused;
+    uint32_t numFree;
+  };
+
+  uint8_t *acquire(uint32_t numBytes) {
+    if (numBytes < kMinPoolBytes)
+      return allocateSmall(numBytes);
+    size_t classBytes = sizeClass(numBytes);
+    {
+      std::lock_guard<std::mutex> lk(mMtx);
+      SizeClass &cls = findClass(classBytes);
+      if (!cls.freeBufs.empty()) {
+        uint8_t *buf = cls.freeBufs.back();
+        cls.freeBufs.pop_back();
+        ++cls.numReused;
+        return buf;
+      }
+      ++cls.numAllocated;
+    }
+    return allocate(classBytes);
+  }
+
+  void release(uint8_t *buf, uint32_t numBytes) {
+    if (numBytes < kMinPoolBytes)
+      return deallocateSmall(buf);
+    size_t classBytes = sizeClass(numBytes);
+    {
+      std::lock_guard<std::mutex> lk(mMtx);
+      SizeClass &cls = findClass(classBytes);
+      if (cls.freeBufs.size() < kMaxFreePerClass) {
+        cls.freeBufs.push_back(buf);
+        return;
+      }
+    }
+    deallocate(buf, classBytes);
+  }
+
+  // Makes sure that at least numBufs buffers of numBytes are free, optionally writing to every page of the new ones
+  // so that the first frames to use them take no page faults. For use at setup time rather than per frame.
+  void reserve(uint32_t numBytes, uint32_t numBufs, bool touch) {
+    if (numBytes < kMinPoolBytes)
+      return;
+    size_t classBytes = sizeClass(numBytes);
+    if (numBufs > kMaxFreePerClass)
+      numBufs = kMaxFreePerClass;
+    std::lock_guard<std::mutex> lk(mMtx);
+    SizeClass &cls = findClass(classBytes);
+    while (cls.freeBufs.size() < numBufs) {
+      uint8_t *buf = allocate(classBytes);
+      if (touch)
+        memset(buf, 0, classBytes);
+      cls.freeBufs.push_back(buf);
+      ++cls.numAllocated;
+    }
+  }
+
+  // the counts for the size class holding buffers of numBytes - all zero for buffers too small to be pooled
+  Stats stats(uint32_t numBytes) {
+    Stats stats;
+    if (numBytes < kMinPoolBytes)
+      return stats;
+    std::lock_guard<std::mutex> lk(mMtx);
+    const SizeClass &cls = findClass(sizeClass(numBytes));
+    stats.numAllocated = cls.numAllocated;
+    stats.numReused = cls.numReused;
+    stats.numFree = (uint32_t)cls.freeBufs.size();
+    return stats;
+  }
+
+private:
+  FramePool(eHugePages hugePages)
+    : mHugePages(hugePages), mClassAlign(kPageBytes) {
+    if (eHugeNone != mHugePages)
+      mClassAlign = kHugePageBytes;
+  }
+  ~FramePool() {}
+
+  static eHugePages hugePagesMode() {
+    const char *env = getenv("CODECADON_HUGEPAGES");
+    if (env && (0 == strcmp(env, "madvise")))
+      return eHugeMadvise;
+    if (env && (0 == strcmp(env, "hugetlb")))
+      return eHugeTlb;
+    return eHugeNone;
+  }
+
+  size_t sizeClass(uint32_t numBytes) const {
+    size_t classBytes = numBytes ? numBytes : 1;
+    return (classBytes + mClassAlign - 1) / mClassAlign * mClassAlign;
+  }
+
+  struct SizeClass {
+    SizeClass() : numAllocated(0), numReused(0) {}
+    std::vector<uint8_t *> freeBufs;
+    uint64_t numAllocated;
+    uint64_t numReused;
+  };
+
+  // the list for a class is created with room for all of its free buffers, so that release never allocates
+  SizeClass &findClass(size_t classBytes) {
+    SizeClass &cls = mClasses[classBytes];
+    if (cls.freeBufs.capacity() < kMaxFreePerClass)
+      cls.freeBufs.reserve(kMaxFreePerClass);
+    return cls;
+  }
+
+  static uint8_t *allocateSmall(uint32_t numBytes) {
+    void *buf = NULL;
+#ifdef _WIN32
+    buf = _aligned_malloc(numBytes ? numBytes : 1, kSmallAlign);
+#else
+    if (posix_memalign(&buf, kSmallAlign, numBytes ? numBytes : 1))
+      buf = NULL;
+#endif
+    if (!buf)
+      throw std::bad_alloc();
+    return (uint8_t *)buf;
+  }
+
+  static void deallocateSmall(uint8_t *buf) {
+#ifdef _WIN32
+    _aligned_free(buf);
+#else
+    free(buf);
+#endif
+  }
+
+  uint8_t *allocate(size_t classBytes) {
+    void *buf = NULL;
+#ifdef _WIN32
+    buf = _aligned_malloc(classBytes, mClassAlign);
+#else
+    if (eHugeTlb == mHugePages) {
+#ifdef MAP_HUGETLB
+      buf = mmap(NULL, classBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (MAP_FAILED == buf)
+#endif
+        buf = mmap(NULL, classBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (MAP_FAILED == buf)
+        buf = NULL;
+    } else if (posix_memalign(&buf, mClassAlign, classBytes))
+      buf = NULL;
+#ifdef MADV_HUGEPAGE
+    if (buf && (eHugeMadvise == mHugePages))
+      madvise(buf, classBytes, MADV_HUGEPAGE);
+#endif
+#endif
+    if (!buf)
+      throw std::bad_alloc();
+    return (uint8_t *)buf;
+  }
+
+  void deallocate(uint8_t *buf, size_t classBytes) {
+#ifdef _WIN32
+    _aligned_free(buf);
+#else
+    if (eHugeTlb == mHugePages)
+      munmap(buf, classBytes);
+    else
+      free(buf);
+#endif
+  }
+
+  const eHugePages mHugePages;
+  size_t mClassAlign;
+  std::mutex mMtx;
+  std::map<size_t, SizeClass> mClasses;
+
+  FramePool(const FramePool &);
+};
+
+} // namespace streampunk
+
+#endif
@@ -17,6 +17,7 @@
 #define MEMORY_H
 
 #include <memory>
+#include "FramePool.h"
 
 namespace streampunk {
 
@@ -29,19 +30,35 @@ public:
     return std::make_shared<Memory>(buf, srcBytes);
   }
 
+  // owned memory comes from the frame pool and goes back to it when the last reference is dropped - only frame sized
+  // buffers are pooled and rounded up to whole pages, smaller ones are ordinary allocations
   Memory(uint32_t numBytes) 
-    : mOwnAlloc(true), mNumBytes(numBytes), mBuf(new uint8_t[mNumBytes]) {}
+    : mOwnAlloc(true), mNumBytes(numBytes), mBuf(FramePool::instance().acquire(numBytes)) {}
   Memory(uint8_t *buf, uint32_t numBytes) 
     : mOwnAlloc(false), mNumBytes(numBytes), mBuf(buf) {}
-  ~Memory() { if (mOwnAlloc) delete[] mBuf; }
+  ~Memory() { if (mOwnAlloc) FramePool::instance().release(mBuf, mNumBytes); }
 
   uint32_t numBytes() const { return mNumBytes; }
   uint8_t *buf() const { return mBuf; }
 
+  // gives up ownership of the buffer to the caller, who must return it to the frame pool
+  uint8_t *detach() {
+    mOwnAlloc = false;
+    return mBuf;
+  }
+
+  // re-points a descriptor of memory owned elsewhere, so that it can be reused from frame to frame
+  void reset(uint8_t *buf, uint32_t numBytes) {
+    if (!mOwnAlloc) {
+      mNumBytes = numBytes;
+      mBuf = buf;
+    }
+  }
+
 private:
-  const bool mOwnAlloc;
-  const uint32_t mNumBytes;
-  uint8_t *const mBuf;
+  bool mOwnAlloc;
+  uint32_t mNumBytes;
+  uint8_t *mBuf;
 };
 
 } // namespace streampunk
@@ -17,125 +17,583 @@
 #define MYWORKER_H
 
 #include <nan.h>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
+#include <vector>
+#include <thread>
 #include <memory>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include "WorkerPool.h"
+#include "Memory.h"
 
 using namespace v8;
 
 namespace streampunk {
 
+// Bounded lock-free ring for a single producer thread and a single consumer thread.
+// enqueue and dequeue never block - they return false when the ring is full or empty.
 template <class T>
 class WorkQueue {
 public:
-  WorkQueue() : qu(), m(), cv() {}
+  WorkQueue(uint32_t capacity) : mSlots(capacity + 1), mHead(0), mTail(0) {}
   ~WorkQueue() {}
   
-  void enqueue(T t) {
-    std::lock_guard<std::mutex> lk(m);
-    qu.push(t);
-    cv.notify_one();
+  bool enqueue(T t) {
+    uint32_t tail = mTail.load(std::memory_order_relaxed);
+    uint32_t next = (tail + 1) % mSlots.size();
+    if (next == mHead.load(std::memory_order_acquire))
+      return false;
+    mSlots[tail] = std::move(t);
+    mTail.store(next, std::memory_order_release);
+    return true;
   }
   
-  T dequeue() {
-    std::unique_lock<std::mutex> lk(m);
-    while(qu.empty()) {
-      cv.wait(lk);
-    }
-    T val = qu.front();
-    qu.pop();
-    return val;
+  bool dequeue(T &t) {
+    uint32_t head = mHead.load(std::memory_order_relaxed);
+    if (head == mTail.load(std::memory_order_acquire))
+      return false;
+    t = std::move(mSlots[head]);
+    mHead.store((head + 1) % mSlots.size(), std::memory_order_release);
+    return true;
   }
 
-  size_t size() {
-    std::lock_guard<std::mutex> lk(m);
-    return qu.size();
+  uint32_t size() const {
+    uint32_t head = mHead.load(std::memory_order_acquire);
+    uint32_t tail = mTail.load(std::memory_order_acquire);
+    return (tail + (uint32_t)mSlots.size() - head) % mSlots.size();
   }
 
 private:
-  std::queue<T> qu;
-  std::mutex m;
-  std::condition_variable cv;
+  std::vector<T> mSlots;
+  std::atomic<uint32_t> mHead;
+  std::atomic<uint32_t> mTail;
+
+  WorkQueue(const WorkQueue &);
 };
 
 class iProcess;
 class iProcessData;
-class MyWorker : public Nan::AsyncProgressWorker {
+class MyWorker {
 public:
+  // Upper limit on the queue depth that can be requested - the queues are sized for this
+  // plus a slot for the quit request, so that quit is always accepted.
+  static const uint32_t kMaxQueueDepth = 64;
+  static const uint32_t kDefaultQueueDepth = 16;
+  static const uint32_t kMaxStages = 8;
+  // Frames in flight plus a quit request, the most that can be waiting for their callbacks at once
+  static const uint32_t kMaxOutstanding = kMaxQueueDepth + 1;
+
+  // What to do with frames that are waiting to be processed when the worker falls behind
+  enum eDropPolicy { eDropNone, eDropLate, eDropOldest };
+
   MyWorker (Nan::Callback *callback)
-    : Nan::AsyncProgressWorker(callback), mActive(true) {}
-  ~MyWorker() {}
+    : mCallback(callback), mAsyncResource("codecadon:MyWorker"),
+      mQueueDepth(kDefaultQueueDepth), mNumInFlight(0), mNumStages(1),
+      mParallelFrames(1), mNumRunning(0), mNextSeq(0), mNextDoneSeq(0),
+      mDropPolicy(eDropNone), mDropLimit(1), mOpenBatch(NULL), mQuitRequested(false),
+      mPending(kMaxOutstanding), mReorder(kMaxOutstanding, (WorkParams *)NULL),
+      mDoneQueue(kMaxOutstanding), mActiveTasks(0) {
+    mStages[0].reset(new Stage);
+    // work params are recycled from frame to frame, so that a steady stream of frames makes no allocations here
+    mWorkParams.reserve(kMaxOutstanding);
+    mFreeWorkParams.reserve(kMaxOutstanding);
+    for (uint32_t i = 0; i < kMaxOutstanding; ++i) {
+      mWorkParams.push_back(std::unique_ptr<WorkParams>(new WorkParams));
+      mFreeWorkParams.push_back(mWorkParams.back().get());
+    }
+    uv_async_init(Nan::GetCurrentEventLoop(), &mAsync, asyncCb);
+    mAsync.data = this;
+  }
+  ~MyWorker() {
+    delete mCallback;
+  }
 
   uint32_t numQueued() {
-    return (uint32_t)mWorkQueue.size();
+    return (mParallelFrames > 1) ? mPending.size() : mStages[0]->mWorkQueue.size();
   }
 
-  void doFrame(std::shared_ptr<iProcessData> processData, iProcess *process, Nan::Callback *frameCallback) {
-    mWorkQueue.enqueue (
-      std::make_shared<WorkParams>(processData, process, frameCallback));
+  // The queue depth limits the number of frames that have been submitted but whose callbacks have not yet run.
+  // Called on the main thread only, as are doFrame, quit and the frame callbacks, so mNumInFlight needs no lock.
+  void setQueueDepth(uint32_t queueDepth) {
+    mQueueDepth = queueDepth ? queueDepth : kDefaultQueueDepth;
+    if (mQueueDepth > kMaxQueueDepth)
+      mQueueDepth = kMaxQueueDepth;
+  }
+  bool isFull() const {
+    return mNumInFlight >= mQueueDepth;
+  }
+  uint32_t numInFlight() const {
+    return mNumInFlight;
+  }
+  uint32_t queueDepth() const {
+    return mQueueDepth;
+  }
+  bool hasRoomFor(uint32_t numFrames) const {
+    return mNumInFlight + numFrames <= mQueueDepth;
   }
 
+  // A process split into stages is run as a pipeline - each stage runs one frame at a time, in order,
+  // but successive frames can be in different stages at the same time.
+  // Must only be changed when no frames are in flight.
+  void setNumStages(uint32_t numStages) {
+    mNumStages = numStages ? numStages : 1;
+    if (mNumStages > kMaxStages)
+      mNumStages = kMaxStages;
+    for (uint32_t s = 0; s < mNumStages; ++s)
+      if (!mStages[s])
+        mStages[s].reset(new Stage);
+  }
+
+  // A process that keeps no state between frames can opt in to processing up to numFrames frames
+  // at the same time on separate pool threads. Callbacks are still made in submission order.
+  // Only for single stage processes - the setting is left unchanged while frames are in flight.
+  void setParallelFrames(uint32_t numFrames) {
+    if (mNumInFlight)
+      return;
+    mParallelFrames = numFrames ? numFrames : 1;
+    if (mParallelFrames > kMaxQueueDepth)
+      mParallelFrames = kMaxQueueDepth;
+  }
+
+  // "process" runs every frame, "dropLate" drops a frame whose deadline has passed by the time it would start,
+  // "dropOldest" drops the oldest waiting frames while more than dropLimit frames are waiting.
+  // Dropped frames are not processed and their callbacks receive an error with code FRAME_DROPPED.
+  bool setDropPolicy(const std::string &policy, uint32_t dropLimit) {
+    if (0 == policy.compare("process"))
+      mDropPolicy = eDropNone;
+    else if (0 == policy.compare("dropLate"))
+      mDropPolicy = eDropLate;
+    else if (0 == policy.compare("dropOldest"))
+      mDropPolicy = eDropOldest;
+    else
+      return false;
+    mDropLimit = dropLimit ? dropLimit : 1;
+    return true;
+  }
+
+  // Deadlines are in nanoseconds on the libuv monotonic clock, as returned by process.hrtime.bigint() - 0 means none.
+  // A double only holds whole nanoseconds up to 2^53, about 104 days of uptime, so deadlines also come as decimal
+  // strings, which is how the JS layer passes on a BigInt.
+  static uint64_t deadlineArg(Nan::NAN_METHOD_ARGS_TYPE info, int argIndex) {
+    if (info.Length() <= argIndex)
+      return 0;
+    if (info[argIndex]->IsString()) {
+      Nan::Utf8String deadlineStr(info[argIndex]);
+      return *deadlineStr ? strtoull(*deadlineStr, NULL, 10) : 0;
+    }
+    if (!info[argIndex]->IsNumber())
+      return 0;
+    double deadline = Nan::To<double>(info[argIndex]).FromJust();
+    return (deadline > 0.0) ? (uint64_t)deadline : 0;
+  }
+
+  // A null destination argument asks for the frame's result in a pool buffer - the handle is left empty for it
+  static Local<Object> dstBufArg(Nan::NAN_METHOD_ARGS_TYPE info, int argIndex) {
+    return info[argIndex]->IsNull() ? Local<Object>() : Local<Object>::Cast(info[argIndex]);
+  }
+
+  // Sets the buffers of a frame's process data, with a pool buffer of dstBytes when there is no destination from JS,
+  // which is returned as the outputBuf for doFrame. Any further arguments are passed on to the process data's set.
+  template <class ProcessData, typename... Args>
+  static std::shared_ptr<Memory> setFrameBufs(ProcessData &processData, Local<Object> srcBufObj, Local<Object> dstBufObj,
+                                              uint32_t dstBytes, Args... args) {
+    if (!dstBufObj.IsEmpty()) {
+      processData.set(srcBufObj, dstBufObj, args...);
+      return std::shared_ptr<Memory>();
+    }
+    std::shared_ptr<Memory> outputBuf = Memory::makeNew(dstBytes);
+    processData.set(srcBufObj, outputBuf, args...);
+    return outputBuf;
+  }
+
+  // outputBuf is set when the frame's result goes to a pool buffer rather than one provided from JS - the buffer is
+  // handed to the frame callback as a third argument, an external Buffer that returns the memory to the pool when collected
+  bool doFrame(std::shared_ptr<iProcessData> processData, iProcess *process, Local<Function> frameCallback,
+               uint64_t deadline = 0, std::shared_ptr<Memory> outputBuf = std::shared_ptr<Memory>()) {
+    if (isFull())
+      return false;
+    ++mNumInFlight;
+    WorkParams *wp = acquireWorkParams(processData, process, frameCallback, deadline);
+    wp->mOutputBuf = outputBuf;
+    submit(wp);
+    return true;
+  }
+
+  // Checks the arguments of a batch method - (srcBufArrays, dstBufs, callback[, deadline]) - the same way for every object,
+  // with name, such as "Packer packBatch", as the prefix of each error. Returns the number of frames in the batch,
+  // or 0 once an error has been thrown.
+  uint32_t batchArgs(Nan::NAN_METHOD_ARGS_TYPE info, const std::string &name, bool setInfoOK) const {
+    if ((info.Length() < 3) || (info.Length() > 4))
+      return batchError(name + " expects 3 or 4 arguments");
+    if (!info[0]->IsArray())
+      return batchError(name + " requires a valid array of source buffer arrays as the first parameter");
+    if (!info[1]->IsArray())
+      return batchError(name + " requires a valid array of destination buffers as the second parameter");
+    if (!info[2]->IsFunction())
+      return batchError(name + " requires a valid callback as the third parameter");
+    if (!setInfoOK)
+      return batchError(name + " called with incorrect setup parameters");
+
+    uint32_t numFrames = Local<Array>::Cast(info[0])->Length();
+    if ((0 == numFrames) || (numFrames != Local<Array>::Cast(info[1])->Length()))
+      return batchError(name + " requires matching, non-empty source and destination arrays");
+    if (numFrames > mQueueDepth)
+      return batchError(name + " of " + std::to_string(numFrames) + " frames exceeds the queue depth of " + std::to_string(mQueueDepth));
+    return numFrames;
+  }
+
+  // A batch is a group of frames that share one callback, made once the last of them is done with an array of
+  // the frames' result bytes in submission order. Frames are queued one at a time with doBatchFrame straight after
+  // startBatch - the callback cannot run before control returns to JS, so the batch always completes whole.
+  // A batch is accepted or refused as a whole, so check the numbers with hasRoomFor first.
+  bool startBatch(Local<Function> batchCallback, uint32_t numFrames, uint64_t deadline = 0) {
+    if (!numFrames || !hasRoomFor(numFrames))
+      return false;
+    if (mFreeBatches.empty()) {
+      mBatches.push_back(std::unique_ptr<Batch>(new Batch));
+      mFreeBatches.push_back(mBatches.back().get());
+    }
+    mOpenBatch = mFreeBatches.back();
+    mFreeBatches.pop_back();
+    mOpenBatch->mCallback.Reset(batchCallback);
+    mOpenBatch->mNumFrames = numFrames;
+    mOpenBatch->mNumDropped = 0;
+    mOpenBatch->mDeadline = deadline;
+    mOpenBatch->mResultBytes.clear();
+    return true;
+  }
+
+  void doBatchFrame(std::shared_ptr<iProcessData> processData, iProcess *process) {
+    ++mNumInFlight;
+    WorkParams *wp = acquireWorkParams(processData, process, Local<Function>(), mOpenBatch->mDeadline);
+    wp->mBatch = mOpenBatch;
+    submit(wp);
+  }
+
+  // A quit already under way answers any further quit requests when it completes, rather than queuing another
   void quit(Nan::Callback *callback) {
-    mWorkQueue.enqueue (std::make_shared<WorkParams>(std::shared_ptr<iProcessData>(), (iProcess *)NULL, callback));
+    if (mQuitRequested) {
+      mLateQuitCallbacks.push_back(std::unique_ptr<Nan::Callback>(callback));
+      return;
+    }
+    mQuitRequested = true;
+    submit(acquireWorkParams(std::shared_ptr<iProcessData>(), (iProcess *)NULL, callback->GetFunction(), 0));
+    delete callback;
   }
 
 private:  
-  void Execute(const ExecutionProgress& progress) {
+  struct WorkParams;
+  struct Batch;
+
+  WorkParams *acquireWorkParams(std::shared_ptr<iProcessData> processData, iProcess *process,
+                                Local<Function> callback, uint64_t deadline) {
+    if (mFreeWorkParams.empty())
+      outstandingOverflow();
+    WorkParams *wp = mFreeWorkParams.back();
+    mFreeWorkParams.pop_back();
+    wp->mProcessData = processData;
+    wp->mProcess = process;
+    if (!callback.IsEmpty())
+      wp->mCallback.Reset(callback);
+    wp->mBatch = NULL;
+    wp->mResultBytes = 0;
+    wp->mDeadline = deadline;
+    wp->mDropped = false;
+    return wp;
+  }
+
+  void releaseWorkParams(WorkParams *wp) {
+    if (wp->mProcessData) {
+      wp->mProcessData->recycle();
+      wp->mProcessData.reset();
+    }
+    wp->mCallback.Reset();
+    wp->mOutputBuf.reset();
+    mFreeWorkParams.push_back(wp);
+  }
+
+  // Every queue holds kMaxOutstanding, the most work that the queue depth limit and a single quit request allow,
+  // so a full queue means that bound has been broken - the frame would be lost and its callback never made.
+  static void enqueueChecked(WorkQueue<WorkParams *> &queue, WorkParams *wp) {
+    if (!queue.enqueue(wp))
+      outstandingOverflow();
+  }
+
+  static void outstandingOverflow() {
+    fprintf(stderr, "MyWorker: more than %u frames outstanding\n", kMaxOutstanding);
+    abort();
+  }
+
+  void submit(WorkParams *wp) {
+    wp->mSeq = mNextSeq++;
+    if (mParallelFrames > 1) {
+      enqueueChecked(mPending, wp);
+      dispatchParallel();
+    } else {
+      enqueueChecked(mStages[0]->mWorkQueue, wp);
+      schedule(0);
+    }
+  }
+
+  // Frame-parallel mode - pending frames are started from the main thread whenever fewer than
+  // mParallelFrames are running, and completions are put back into submission order before their callbacks.
+  void dispatchParallel() {
+    // dropped frames are passed straight through to keep their place in the callback order
+    WorkParams *wp;
+    while ((eDropOldest == mDropPolicy) && (mPending.size() > mDropLimit) && mPending.dequeue(wp)) {
+      wp->mDropped = (NULL != wp->mProcess);
+      post(wp);
+    }
+    while ((mNumRunning < mParallelFrames) && mPending.dequeue(wp))
+      post(wp);
+  }
+
+  void post(WorkParams *wp) {
+    ++mNumRunning;
+    // captures are kept small enough for std::function to store them without allocating
+    WorkerPool::instance().post([this, wp]() { ExecuteParallel(wp); });
+  }
+
+  void ExecuteParallel(WorkParams *wp) {
+    ++mActiveTasks;
+    if (wp->mProcess && !wp->mDropped)
+      wp->mDropped = isLate(*wp);
+    if (wp->mProcess && !wp->mDropped)
+      wp->mResultBytes = wp->mProcess->processFrame(wp->mProcessData);
+    {
+      // frames complete on several threads, so the single producer side of the done queue is serialised here
+      std::lock_guard<std::mutex> lk(mDoneMtx);
+      enqueueChecked(mDoneQueue, wp);
+    }
+    uv_async_send(&mAsync);
+    --mActiveTasks;
+  }
+
+  // Frames for one worker stage are run one at a time, in order, as tasks on the shared pool.
+  // A task processes a single frame and then reposts itself if more work is queued,
+  // so that busy workers take turns on the pool threads.
+  void schedule(uint32_t stage) {
+    // the fences here and in Execute order the queue update against the flag change on both sides
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!mStages[stage]->mScheduled.exchange(true))
+      WorkerPool::instance().post([this, stage]() { Execute(stage); });
+  }
+
+  void Execute(uint32_t stage) {
     // Asynchronous, non-V8 work goes here
-    while (mActive) {
-      std::shared_ptr<WorkParams> wp = mWorkQueue.dequeue();
-      if (wp->mProcess)
-        wp->mResultBytes = wp->mProcess->processFrame(wp->mProcessData);
-      else
-        mActive = false;
-      mDoneQueue.enqueue(wp);
-      progress.Send(NULL, 0);
+    // Once the quit request reaches the main thread the worker is deleted as soon as no tasks are active
+    ++mActiveTasks;
+    Stage *thisStage = mStages[stage].get();
+    bool lastStage = (stage + 1 == mNumStages);
+    WorkParams *wp;
+    thisStage->mWorkQueue.dequeue(wp);
+    bool quitting = !wp->mProcess;
+    // the deadline is checked before every stage, so that a frame held up behind a stalled stage is dropped
+    // rather than going on through the later stages to finish late - a stage that has started is not interrupted
+    if (!quitting && !wp->mDropped)
+      wp->mDropped = isLate(*wp) ||
+        ((0 == stage) && (eDropOldest == mDropPolicy) && (thisStage->mWorkQueue.size() >= mDropLimit));
+    if (!quitting && !wp->mDropped)
+      wp->mResultBytes = wp->mProcess->processStage(stage, wp->mProcessData);
+
+    if (lastStage) {
+      enqueueChecked(mDoneQueue, wp);
+      uv_async_send(&mAsync);
+    } else {
+      enqueueChecked(mStages[stage + 1]->mWorkQueue, wp);
+      schedule(stage + 1);
     }
 
-    // wait for quit message to be passed to callback
-    std::unique_lock<std::mutex> lk(mMtx);
-    mCv.wait(lk);
+    if (!quitting) {
+      // clear the flag before checking for more work, so a frame queued in between is not missed
+      thisStage->mScheduled = false;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (thisStage->mWorkQueue.size())
+        schedule(stage);
+    }
+    --mActiveTasks;
   }
-  
-  void HandleProgressCallback(const char *data, size_t size) {
+
+  bool isLate(const WorkParams &wp) const {
+    return (eDropLate == mDropPolicy) && wp.mDeadline && (uv_hrtime() > wp.mDeadline);
+  }
+
+  static void asyncCb(uv_async_t *handle) {
+    static_cast<MyWorker *>(handle->data)->HandleProgressCallback();
+  }
+
+  static void closeCb(uv_handle_t *handle) {
+    delete static_cast<MyWorker *>(handle->data);
+  }
+
+  void HandleProgressCallback() {
     Nan::HandleScope scope;
-    while (mDoneQueue.size() != 0)
-    {
-      std::shared_ptr<WorkParams> wp = mDoneQueue.dequeue();
-      Local<Value> argv[] = { Nan::Null(), Nan::New(wp->mResultBytes) };
-      wp->mCallback->Call(2, argv, async_resource);
+    bool quitDone = false;
+    WorkParams *wp;
+    while (!quitDone && mDoneQueue.dequeue(wp)) {
+      if (mParallelFrames > 1) {
+        // frames may complete out of order - hold them until all earlier frames are done
+        // no more than kMaxOutstanding frames are ever waiting, so each has its own slot
+        --mNumRunning;
+        mReorder[wp->mSeq % kMaxOutstanding] = wp;
+        while (!quitDone && (NULL != (wp = mReorder[mNextDoneSeq % kMaxOutstanding]))) {
+          mReorder[mNextDoneSeq % kMaxOutstanding] = NULL;
+          quitDone = frameDone(wp);
+        }
+      } else
+        quitDone = frameDone(wp);
+    }
 
-      if (!wp->mProcess && !mActive) {
-        // notify the thread to exit
-        std::unique_lock<std::mutex> lk(mMtx);
-        mCv.notify_one();
-      }
+    if (quitDone)
+      HandleOKCallback();
+    else if (mParallelFrames > 1)
+      dispatchParallel();
+  }
+
+  bool frameDone(WorkParams *wp) {
+    ++mNextDoneSeq;
+    // release the slot first so that the callback can submit another frame
+    if (wp->mProcess)
+      --mNumInFlight;
+    if (wp->mBatch) {
+      batchFrameDone(wp);
+      return false;
+    }
+    Local<Value> err = Nan::Null();
+    if (wp->mDropped)
+      err = droppedError("Frame dropped");
+    Local<Value> argv[] = { err, Nan::New(wp->mResultBytes), Nan::Undefined() };
+    int argc = 2;
+    if (wp->mOutputBuf) {
+      if (wp->mResultBytes)
+        argv[2] = outputBuffer(wp->mOutputBuf, wp->mResultBytes);
+      argc = 3;
     }
+    wp->mCallback.Call(argc, argv, &mAsyncResource);
+    bool quitting = !wp->mProcess;
+    if (quitting) {
+      for (auto& lateCallback : mLateQuitCallbacks)
+        lateCallback->Call(argc, argv, &mAsyncResource);
+      mLateQuitCallbacks.clear();
+    }
+    releaseWorkParams(wp);
+    return quitting;
   }
   
+  // batch frames complete in submission order, so the results are just appended
+  void batchFrameDone(WorkParams *wp) {
+    Batch *batch = wp->mBatch;
+    batch->mResultBytes.push_back(wp->mResultBytes);
+    if (wp->mDropped)
+      ++batch->mNumDropped;
+    releaseWorkParams(wp);
+    if (batch->mResultBytes.size() < batch->mNumFrames)
+      return;
+
+    Local<Value> err = Nan::Null();
+    if (batch->mNumDropped) {
+      err = droppedError("Batch frames dropped");
+      Nan::Set(err.As<Object>(), Nan::New("numDropped").ToLocalChecked(), Nan::New(batch->mNumDropped));
+    }
+    Local<Array> results = Nan::New<Array>(batch->mNumFrames);
+    for (uint32_t i = 0; i < batch->mNumFrames; ++i)
+      Nan::Set(results, i, Nan::New(batch->mResultBytes[i]));
+    Local<Value> argv[] = { err, results };
+    batch->mCallback.Call(2, argv, &mAsyncResource);
+    batch->mCallback.Reset();
+    mFreeBatches.push_back(batch);
+  }
+
+  // the external Buffer is the length of the result, but the memory goes back to the pool as the size it was allocated
+  static Local<Value> outputBuffer(std::shared_ptr<Memory> outputBuf, uint32_t resultBytes) {
+    uint32_t allocBytes = outputBuf->numBytes();
+    char *buf = (char *)outputBuf->detach();
+    return Nan::NewBuffer(buf, resultBytes, freeOutputBuffer, (void *)(uintptr_t)allocBytes).ToLocalChecked();
+  }
+
+  static void freeOutputBuffer(char *buf, void *hint) {
+    FramePool::instance().release((uint8_t *)buf, (uint32_t)(uintptr_t)hint);
+  }
+
+  static uint32_t batchError(const std::string &err) {
+    Nan::ThrowError(err.c_str());
+    return 0;
+  }
+
+  static Local<Value> droppedError(const char *msg) {
+    Local<Value> err = Nan::Error(msg);
+    Nan::Set(err.As<Object>(), Nan::New("code").ToLocalChecked(), Nan::New("FRAME_DROPPED").ToLocalChecked());
+    return err;
+  }
+
   void HandleOKCallback() {
-    Nan::HandleScope scope;
-    callback->Call(0, NULL, async_resource);
+    mCallback->Call(0, NULL, &mAsyncResource);
+
+    // wait for the pool threads to let go of this worker before closing
+    while (mActiveTasks)
+      std::this_thread::yield();
+    uv_close((uv_handle_t *)&mAsync, closeCb);
   }
 
-  bool mActive;
   struct WorkParams {
-    WorkParams(std::shared_ptr<iProcessData> processData, iProcess *process, Nan::Callback *callback)
-      : mProcessData(processData), mProcess(process), mCallback(callback), mResultBytes(0) {}
-    ~WorkParams() { 
-      delete mCallback;
-    }
+    WorkParams()
+      : mProcess(NULL), mBatch(NULL), mResultBytes(0), mSeq(0), mDeadline(0), mDropped(false) {}
+    ~WorkParams() {}
 
     std::shared_ptr<iProcessData> mProcessData;
     iProcess *mProcess;
-    Nan::Callback *mCallback;
+    Nan::Callback mCallback;
+    std::shared_ptr<Memory> mOutputBuf;
+    Batch *mBatch;
     uint32_t mResultBytes;
+    uint64_t mSeq;
+    uint64_t mDeadline;
+    bool mDropped;
+  };
+  struct Batch {
+    Batch() : mNumFrames(0), mNumDropped(0), mDeadline(0) {
+      mResultBytes.reserve(kMaxQueueDepth);
+    }
+
+    Nan::Callback mCallback;
+    uint32_t mNumFrames;
+    uint32_t mNumDropped;
+    uint64_t mDeadline;
+    std::vector<uint32_t> mResultBytes;
+  };
+  struct Stage {
+    Stage() : mWorkQueue(kMaxOutstanding), mScheduled(false) {}
+    WorkQueue<WorkParams *> mWorkQueue;
+    std::atomic<bool> mScheduled;
   };
-  WorkQueue<std::shared_ptr<WorkParams> > mWorkQueue;
-  WorkQueue<std::shared_ptr<WorkParams> > mDoneQueue;
-  std::mutex mMtx;
-  std::condition_variable mCv;
+
+  Nan::Callback *mCallback;
+  Nan::AsyncResource mAsyncResource;
+  uv_async_t mAsync;
+  uint32_t mQueueDepth;
+  uint32_t mNumInFlight;
+  uint32_t mNumStages;
+  std::unique_ptr<Stage> mStages[kMaxStages];
+  uint32_t mParallelFrames;
+  uint32_t mNumRunning;
+  uint64_t mNextSeq;
+  uint64_t mNextDoneSeq;
+  eDropPolicy mDropPolicy;
+  uint32_t mDropLimit;
+  std::vector<std::unique_ptr<WorkParams> > mWorkParams;
+  std::vector<WorkParams *> mFreeWorkParams;
+  std::vector<std::unique_ptr<Batch> > mBatches;
+  std::vector<Batch *> mFreeBatches;
+  Batch *mOpenBatch;
+  bool mQuitRequested;
+  std::vector<std::unique_ptr<Nan::Callback> > mLateQuitCallbacks;
+  WorkQueue<WorkParams *> mPending;
+  std::vector<WorkParams *> mReorder;
+  std::mutex mDoneMtx;
+  WorkQueue<WorkParams *> mDoneQueue;
+  std::atomic<uint32_t> mActiveTasks;
 };
 
 } // namespace streampunk
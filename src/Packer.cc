@@ -21,6 +21,7 @@
 #include "Memory.h"
 #include "EssenceInfo.h"
 #include "Persist.h"
+#include "ProcessParams.h"
 
 #include <memory>
 
@@ -30,38 +31,100 @@ namespace streampunk {
 
 class PackerProcessData : public iProcessData {
 public:
-  PackerProcessData (Local<Object> srcBufObj, Local<Object> dstBufObj)
-    : mPersistentSrcBuf(new Persist(srcBufObj)),
-      mPersistentDstBuf(new Persist(dstBufObj)),
-      mSrcBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj))),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj)))
+  PackerProcessData ()
+    : mSrcBuf(Memory::makeNew((uint8_t *)NULL, 0)), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0)), mFirstLine(0), mNumLines(0)
+  { }
+  PackerProcessData (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf)
+    : mSrcBuf(srcBuf), mDstBuf(dstBuf), mFirstLine(0), mNumLines(0)
   { }
   ~PackerProcessData() { }
+
+  void set(Local<Object> srcBufObj, Local<Object> dstBufObj) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mPersistentDstBuf.reset(dstBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
+    mFirstLine = 0;
+    mNumLines = 0;
+  }
+  // native output mode - the result goes to a pool buffer that is handed to JS with the frame callback
+  void set(Local<Object> srcBufObj, std::shared_ptr<Memory> nativeDstBuf) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset(nativeDstBuf->buf(), nativeDstBuf->numBytes());
+    mFirstLine = 0;
+    mNumLines = 0;
+  }
+  // multiple output mode - one destination buffer for each destination format, in an array that is kept alive as a whole
+  void set(Local<Object> srcBufObj, Local<Array> dstBufArray) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mPersistentDstBuf.reset(dstBufArray);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    // the Memory objects are kept from frame to frame, like the source and destination ones
+    while (mDstBufs.size() < dstBufArray->Length())
+      mDstBufs.push_back(Memory::makeNew((uint8_t *)NULL, 0));
+    mDstBufs.resize(dstBufArray->Length());
+    for (uint32_t i = 0; i < dstBufArray->Length(); ++i) {
+      Local<Object> dstBufObj = Local<Object>::Cast(dstBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+      mDstBufs[i]->reset((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
+    }
+    mFirstLine = 0;
+    mNumLines = 0;
+  }
+  // partial frame mode - only the given lines are converted, numLines of 0 means the whole frame
+  void setLines(uint32_t firstLine, uint32_t numLines) {
+    mFirstLine = firstLine;
+    mNumLines = numLines;
+  }
+  void recycle() {
+    mPersistentSrcBuf.reset();
+    mPersistentDstBuf.reset();
+  }
   
   std::shared_ptr<Memory> srcBuf() const { return mSrcBuf; }
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
+  const std::vector<std::shared_ptr<Memory> >& dstBufs() const { return mDstBufs; }
+  uint32_t firstLine() const { return mFirstLine; }
+  uint32_t numLines() const { return mNumLines; }
 
 private:
-  std::unique_ptr<Persist> mPersistentSrcBuf;
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  Persist mPersistentSrcBuf;
+  Persist mPersistentDstBuf;
   std::shared_ptr<Memory> mSrcBuf;
   std::shared_ptr<Memory> mDstBuf;
+  std::vector<std::shared_ptr<Memory> > mDstBufs;
+  uint32_t mFirstLine;
+  uint32_t mNumLines;
 };
 
 Packer::Packer(Nan::Callback *callback) 
-  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mUnityPacking(true), mSrcFormatBytes(0), mDstBytesReq(0) {
-  AsyncQueueWorker(mWorker);
-}
+  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mUnityPacking(true), mSrcFormatBytes(0), mDstBytesReq(0) {}
 Packer::~Packer() {}
 
 // iProcess
 uint32_t Packer::processFrame (std::shared_ptr<iProcessData> processData) {
   Timer t;
-  std::shared_ptr<PackerProcessData> ppd = std::dynamic_pointer_cast<PackerProcessData>(processData);
+  PackerProcessData *ppd = static_cast<PackerProcessData *>(processData.get());
 
-  if (mUnityPacking) {
+  if (mMultiPacker) {
+    mMultiPacker->convert(ppd->srcBuf(), ppd->dstBufs());
+    printDebug(eDebug, "pack to %d formats: %.2fms\n", mMultiPacker->numDsts(), t.delta());
+  }
+  else if (ppd->srcBuf()->buf() == ppd->dstBuf()->buf()) {
+    // in place - the frame is converted line group by line group within the one buffer
+    if (!mUnityPacking)
+      mPacker->convertInPlace(ppd->srcBuf());
+    printDebug(eDebug, "pack in place: %.2fms\n", t.delta());
+  }
+  else if (mUnityPacking) {
     memcpy (ppd->dstBuf()->buf(), ppd->srcBuf()->buf(), ppd->srcBuf()->numBytes());
   }
+  else if (ppd->numLines()) {
+    mPacker->convertRange(ppd->srcBuf(), ppd->dstBuf(), ppd->firstLine(), ppd->numLines());
+    printDebug(eDebug, "pack lines %d-%d: %.2fms\n", ppd->firstLine(), ppd->firstLine() + ppd->numLines() - 1, t.delta());
+    // a partial frame reports the line below the range - with ranges submitted in order, all lines above it are ready
+    return ppd->firstLine() + ppd->numLines();
+  }
   else {
     mPacker->convert(ppd->srcBuf(), ppd->dstBuf()); 
     printDebug(eDebug, "pack: %.2fms\n", t.delta());
@@ -69,32 +132,108 @@ uint32_t Packer::processFrame (std::shared_ptr<iProcessData> processData) {
   return mDstBytesReq;
 }
 
+// iPipelineStage
+uint32_t Packer::stageSrcBytes() const {
+  return mSetInfoOK ? getFormatBytes(mSrcVidInfo->packing(), mSrcVidInfo->width(), mSrcVidInfo->height()) : 0;
+}
+
+// a Packer with several destination formats has no single output to pass on, so it cannot be a pipeline stage
+uint32_t Packer::stageDstBytes() const {
+  return (mSetInfoOK && !mMultiPacker) ? mDstBytesReq : 0;
+}
+
+uint32_t Packer::processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) {
+  return processFrame(std::make_shared<PackerProcessData>(srcBuf, dstBuf));
+}
+
 void Packer::doSetInfo(Local<Object> srcTags, Local<Object> dstTags) {
+  // an array of destination tags asks for the source to be converted to each of the formats, from one read of the source
+  // the processing parameters are taken from the first destination
+  std::vector<std::shared_ptr<EssenceInfo> > dstVidInfos;
+  Local<Object> firstDstTags = dstTags;
+  if (dstTags->IsArray()) {
+    Local<Array> dstTagsArray = Local<Array>::Cast(dstTags);
+    for (uint32_t i = 0; i < dstTagsArray->Length(); ++i) {
+      Local<Value> dstTagsVal = dstTagsArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked();
+      if (!dstTagsVal->IsObject())
+        return Nan::ThrowError("Packer SetInfo requires each entry of a destination info array to be an object");
+      dstVidInfos.push_back(std::make_shared<EssenceInfo>(Local<Object>::Cast(dstTagsVal)));
+    }
+    if (dstVidInfos.empty())
+      return Nan::ThrowError("Packer SetInfo requires at least one destination info object");
+    firstDstTags = Local<Object>::Cast(dstTagsArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
+  } else
+    dstVidInfos.push_back(std::make_shared<EssenceInfo>(dstTags));
+
   mSrcVidInfo = std::make_shared<EssenceInfo>(srcTags); 
   printDebug(eInfo, "Packer SrcVidInfo: %s\n", mSrcVidInfo->toString().c_str());
-  mDstVidInfo = std::make_shared<EssenceInfo>(dstTags); 
-  printDebug(eInfo, "Packer DstVidInfo: %s\n", mDstVidInfo->toString().c_str());
+  mDstVidInfo = dstVidInfos[0]; 
+  for (const std::shared_ptr<EssenceInfo>& dstVidInfo : dstVidInfos)
+    printDebug(eInfo, "Packer DstVidInfo: %s\n", dstVidInfo->toString().c_str());
+  mProcessParams = std::make_shared<ProcessParams>(firstDstTags);
+  printDebug(eInfo, "Packer ProcessParams: %s\n", mProcessParams->toString().c_str());
+  mWorker->setQueueDepth(mProcessParams->queueDepth());
+  mWorker->setParallelFrames(mProcessParams->parallelFrames());
+  if (!mWorker->setDropPolicy(mProcessParams->dropPolicy(), mProcessParams->dropLimit())) {
+    std::string err = std::string("Unsupported drop policy \'") + mProcessParams->dropPolicy() + "\'";
+    return Nan::ThrowError(err.c_str());
+  }
 
   if (mSrcVidInfo->packing().compare("pgroup") && mSrcVidInfo->packing().compare("v210") && 
       mSrcVidInfo->packing().compare("YUV422P10") && mSrcVidInfo->packing().compare("UYVY10") && 
-      mSrcVidInfo->packing().compare("420P")) {
+      mSrcVidInfo->packing().compare("420P") && mSrcVidInfo->packing().compare("NV12") &&
+      mSrcVidInfo->packing().compare("P010") && mSrcVidInfo->packing().compare("Y210") &&
+      mSrcVidInfo->packing().compare("v410") && mSrcVidInfo->packing().compare("RGBA8") &&
+      mSrcVidInfo->packing().compare("BGRA8") && mSrcVidInfo->packing().compare("BGR10-A") &&
+      mSrcVidInfo->packing().compare("BGR10-A-BS")) {
     std::string err = std::string("Unsupported source format \'") + mSrcVidInfo->packing() + "\'";
     return Nan::ThrowError(err.c_str());
   }
-  if (mDstVidInfo->packing().compare("420P") && mDstVidInfo->packing().compare("YUV422P10") && 
-      mDstVidInfo->packing().compare("UYVY10") && mDstVidInfo->packing().compare("pgroup") && mDstVidInfo->packing().compare("v210")) {
-    std::string err = std::string("Unsupported destination packing type \'") + mDstVidInfo->packing() + "\'";
-    Nan::ThrowError(err.c_str());
-  }
-  if ((mSrcVidInfo->width() % 2) || (mDstVidInfo->width() % 2)) {
-    std::string err = std::string("Width must be divisible by 2 - src ") + std::to_string(mSrcVidInfo->width()) + ", dst " + std::to_string(mDstVidInfo->width());
-    Nan::ThrowError(err.c_str());
+  for (const std::shared_ptr<EssenceInfo>& dstVidInfo : dstVidInfos) {
+    if (dstVidInfo->packing().compare("420P") && dstVidInfo->packing().compare("YUV422P10") && 
+        dstVidInfo->packing().compare("UYVY10") && dstVidInfo->packing().compare("pgroup") && dstVidInfo->packing().compare("v210") &&
+        dstVidInfo->packing().compare("NV12") && dstVidInfo->packing().compare("P010") &&
+        dstVidInfo->packing().compare("Y210") && dstVidInfo->packing().compare("v410")) {
+      std::string err = std::string("Unsupported destination packing type \'") + dstVidInfo->packing() + "\'";
+      return Nan::ThrowError(err.c_str());
+    }
+    if ((mSrcVidInfo->width() % 2) || (dstVidInfo->width() % 2)) {
+      std::string err = std::string("Width must be divisible by 2 - src ") + std::to_string(mSrcVidInfo->width()) + ", dst " + std::to_string(dstVidInfo->width());
+      return Nan::ThrowError(err.c_str());
+    }
   }
 
-  mPacker = std::make_shared<Packers>(mSrcVidInfo->width(), mSrcVidInfo->height(), 
-                                      mSrcVidInfo->packing(), mDstVidInfo->packing());
-  mUnityPacking = (mSrcVidInfo->packing() == mDstVidInfo->packing());
-  mDstBytesReq = getFormatBytes(mDstVidInfo->packing(), mDstVidInfo->width(), mDstVidInfo->height());
+  mMultiPacker.reset();
+  mMultiDstBytes.clear();
+  if (dstVidInfos.size() > 1) {
+    std::vector<std::string> dstFmtCodes;
+    for (const std::shared_ptr<EssenceInfo>& dstVidInfo : dstVidInfos) {
+      dstFmtCodes.push_back(dstVidInfo->packing());
+      mMultiDstBytes.push_back(getFormatBytes(dstVidInfo->packing(), dstVidInfo->width(), dstVidInfo->height(), mDstVidInfo->hasAlpha()));
+    }
+    mMultiPacker = std::make_shared<MultiPackers>(mSrcVidInfo->width(), mSrcVidInfo->height(), mSrcVidInfo->packing(), dstFmtCodes,
+                                                  0 != mSrcVidInfo->interlace().compare("prog"), mProcessParams->threads(),
+                                                  mProcessParams->fieldChroma(), mProcessParams->dither(),
+                                                  mSrcVidInfo->colorimetry(), mDstVidInfo->hasAlpha());
+    mUnityPacking = false;
+  } else {
+    mPacker = std::make_shared<Packers>(mSrcVidInfo->width(), mSrcVidInfo->height(), 
+                                        mSrcVidInfo->packing(), mDstVidInfo->packing(),
+                                        0 != mSrcVidInfo->interlace().compare("prog"), mProcessParams->threads(),
+                                        mProcessParams->fieldChroma(), mProcessParams->dither(),
+                                        mSrcVidInfo->colorimetry(), mDstVidInfo->hasAlpha());
+    mUnityPacking = (mSrcVidInfo->packing() == mDstVidInfo->packing());
+  }
+  mDstBytesReq = getFormatBytes(mDstVidInfo->packing(), mDstVidInfo->width(), mDstVidInfo->height(), mDstVidInfo->hasAlpha());
+
+  if (mProcessParams->inPlace()) {
+    if (mMultiPacker)
+      return Nan::ThrowError("In-place conversion is not supported with several destination formats");
+    if (!mUnityPacking && !mPacker->canConvertInPlace()) {
+      std::string err = std::string("In-place conversion from \'") + mSrcVidInfo->packing() + "\' to \'" + mDstVidInfo->packing() + "\' is not supported";
+      return Nan::ThrowError(err.c_str());
+    }
+  }
 }
 
 NAN_METHOD(Packer::SetInfo) {
@@ -121,21 +260,28 @@ NAN_METHOD(Packer::SetInfo) {
   }
 
   obj->mSetInfoOK = true;
-  info.GetReturnValue().Set(Nan::New(obj->mDstBytesReq));
+  if (obj->mMultiPacker) {
+    Local<Array> dstBytesArray = Nan::New<Array>((uint32_t)obj->mMultiDstBytes.size());
+    for (uint32_t i = 0; i < obj->mMultiDstBytes.size(); ++i)
+      Nan::Set(dstBytesArray, i, Nan::New(obj->mMultiDstBytes[i]));
+    info.GetReturnValue().Set(dstBytesArray);
+  } else
+    info.GetReturnValue().Set(Nan::New(obj->mDstBytesReq));
 }
 
 NAN_METHOD(Packer::Pack) {
-  if (info.Length() != 3)
-    return Nan::ThrowError("Packer Pack expects 3 arguments");
+  if ((info.Length() < 3) || (info.Length() > 4))
+    return Nan::ThrowError("Packer Pack expects 3 or 4 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("Packer Pack requires a valid source buffer array as the first parameter");
-  if (!info[1]->IsObject())
-    return Nan::ThrowError("Packer Pack requires a valid destination buffer as the second parameter");
+  if (!info[1]->IsObject() && !info[1]->IsNull())
+    return Nan::ThrowError("Packer Pack requires a valid destination buffer, or null for a pooled output buffer, as the second parameter");
   if (!info[2]->IsFunction())
     return Nan::ThrowError("Packer Pack requires a valid callback as the third parameter");
 
   Local<Array> srcBufArray = Local<Array>::Cast(info[0]);
-  Local<Object> dstBufObj = Local<Object>::Cast(info[1]);
+  // a null destination asks for the result in a pooled buffer, passed to the callback as an external Buffer
+  Local<Object> dstBufObj = MyWorker::dstBufArg(info, 1);
   Local<Function> callback = Local<Function>::Cast(info[2]);
 
   Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
@@ -145,16 +291,147 @@ NAN_METHOD(Packer::Pack) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Pack called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   obj->mSrcFormatBytes = getFormatBytes(obj->mSrcVidInfo->packing(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height());
   if (obj->mSrcFormatBytes > (uint32_t)node::Buffer::Length(srcBufObj))
-    Nan::ThrowError("Insufficient source buffer for conversion\n");
+    return Nan::ThrowError("Insufficient source buffer for conversion");
+
+  if (obj->mMultiPacker) {
+    if (dstBufObj.IsEmpty() || !dstBufObj->IsArray() || (Local<Array>::Cast(dstBufObj)->Length() != obj->mMultiDstBytes.size()))
+      return Nan::ThrowError("Pack requires an array of destination buffers, one for each destination format");
+    Local<Array> dstBufArray = Local<Array>::Cast(dstBufObj);
+    for (uint32_t i = 0; i < dstBufArray->Length(); ++i) {
+      Local<Value> dstBufVal = dstBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked();
+      if (!node::Buffer::HasInstance(dstBufVal) || (obj->mMultiDstBytes[i] > node::Buffer::Length(dstBufVal)))
+        return Nan::ThrowError("Insufficient destination buffer for specified format");
+    }
+
+    std::shared_ptr<PackerProcessData> ppd = obj->mProcessDataPool.acquire();
+    ppd->set(srcBufObj, dstBufArray);
+    obj->mWorker->doFrame(ppd, obj, callback, MyWorker::deadlineArg(info, 3));
+    return info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
+  }
+
+  if (!dstBufObj.IsEmpty() && (obj->mDstBytesReq > node::Buffer::Length(dstBufObj)))
+    return Nan::ThrowError("Insufficient destination buffer for specified format");
+  // the same buffer as source and destination converts in place, which must be asked for when setting up
+  if (!dstBufObj.IsEmpty() && (node::Buffer::Data(srcBufObj) == node::Buffer::Data(dstBufObj)) && !obj->mProcessParams->inPlace())
+    return Nan::ThrowError("Pack requires separate source and destination buffers unless set up with inPlace");
+
+  std::shared_ptr<PackerProcessData> ppd = obj->mProcessDataPool.acquire();
+  std::shared_ptr<Memory> outputBuf = MyWorker::setFrameBufs(*ppd, srcBufObj, dstBufObj, obj->mDstBytesReq);
+  obj->mWorker->doFrame(ppd, obj, callback, MyWorker::deadlineArg(info, 3), outputBuf);
 
+  info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
+}
+
+NAN_METHOD(Packer::PackLines) {
+  if ((info.Length() < 5) || (info.Length() > 6))
+    return Nan::ThrowError("Packer PackLines expects 5 or 6 arguments");
+  if (!info[0]->IsArray())
+    return Nan::ThrowError("Packer PackLines requires a valid source buffer array as the first parameter");
+  if (!info[1]->IsObject())
+    return Nan::ThrowError("Packer PackLines requires a valid destination buffer as the second parameter");
+  if (!info[2]->IsNumber())
+    return Nan::ThrowError("Packer PackLines requires a valid first line as the third parameter");
+  if (!info[3]->IsNumber())
+    return Nan::ThrowError("Packer PackLines requires a valid number of lines as the fourth parameter");
+  if (!info[4]->IsFunction())
+    return Nan::ThrowError("Packer PackLines requires a valid callback as the fifth parameter");
+
+  Local<Array> srcBufArray = Local<Array>::Cast(info[0]);
+  Local<Object> dstBufObj = Local<Object>::Cast(info[1]);
+  uint32_t firstLine = Nan::To<uint32_t>(info[2]).FromJust();
+  uint32_t numLines = Nan::To<uint32_t>(info[3]).FromJust();
+  Local<Function> callback = Local<Function>::Cast(info[4]);
+
+  Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
+
+  Packer* obj = Nan::ObjectWrap::Unwrap<Packer>(info.Holder());
+
+  if (!obj->mSetInfoOK)
+    return Nan::ThrowError("PackLines called with incorrect setup parameters");
+  if (obj->mMultiPacker)
+    return Nan::ThrowError("PackLines is not supported with several destination formats");
+
+  // the lines are converted in place in full size frames, so that successive calls build up a whole frame
+  uint32_t height = obj->mSrcVidInfo->height();
+  uint32_t lineAlign = obj->mPacker->lineAlign();
+  if (!numLines || (firstLine + numLines > height)) {
+    std::string err = std::string("PackLines range of ") + std::to_string(numLines) + " lines from line " + std::to_string(firstLine) + 
+                      " is outside the frame height of " + std::to_string(height);
+    return Nan::ThrowError(err.c_str());
+  }
+  if ((firstLine % lineAlign) || ((numLines % lineAlign) && (firstLine + numLines != height))) {
+    std::string err = std::string("PackLines ranges must be aligned to multiples of ") + std::to_string(lineAlign) + " lines for this conversion";
+    return Nan::ThrowError(err.c_str());
+  }
+
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
+  obj->mSrcFormatBytes = getFormatBytes(obj->mSrcVidInfo->packing(), obj->mSrcVidInfo->width(), height);
+  if (obj->mSrcFormatBytes > (uint32_t)node::Buffer::Length(srcBufObj))
+    return Nan::ThrowError("Insufficient source buffer for conversion");
   if (obj->mDstBytesReq > node::Buffer::Length(dstBufObj))
     return Nan::ThrowError("Insufficient destination buffer for specified format");
+  if (node::Buffer::Data(srcBufObj) == node::Buffer::Data(dstBufObj))
+    return Nan::ThrowError("PackLines requires separate source and destination buffers");
+
+  std::shared_ptr<PackerProcessData> ppd = obj->mProcessDataPool.acquire();
+  ppd->set(srcBufObj, dstBufObj);
+  ppd->setLines(firstLine, numLines);
+  obj->mWorker->doFrame(ppd, obj, callback, MyWorker::deadlineArg(info, 5));
+
+  info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
+}
 
-  std::shared_ptr<iProcessData> ppd = 
-    std::make_shared<PackerProcessData>(srcBufObj, dstBufObj);
-  obj->mWorker->doFrame(ppd, obj, new Nan::Callback(callback));
+NAN_METHOD(Packer::PackBatch) {
+  Packer* obj = Nan::ObjectWrap::Unwrap<Packer>(info.Holder());
+  uint32_t numFrames = obj->mWorker->batchArgs(info, "Packer packBatch", obj->mSetInfoOK);
+  if (!numFrames)
+    return;
+  if (obj->mMultiPacker)
+    return Nan::ThrowError("Packer packBatch is not supported with several destination formats");
+
+  Local<Array> srcBufArrays = Local<Array>::Cast(info[0]);
+  Local<Array> dstBufArray = Local<Array>::Cast(info[1]);
+  Local<Function> callback = Local<Function>::Cast(info[2]);
+
+  if (!obj->mWorker->hasRoomFor(numFrames))
+    return info.GetReturnValue().Set(Nan::False());
+
+  // check every frame before queueing any, so that a batch is either queued whole or not at all
+  uint32_t srcFormatBytes = getFormatBytes(obj->mSrcVidInfo->packing(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height());
+  for (uint32_t i=0; i<numFrames; ++i) {
+    Local<Value> srcBufVal = srcBufArrays->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked();
+    if (!srcBufVal->IsArray())
+      return Nan::ThrowError("Packer packBatch requires each source entry to be a buffer array");
+    Local<Object> srcBufObj = Local<Object>::Cast(Local<Array>::Cast(srcBufVal)->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
+    Local<Object> dstBufObj = Local<Object>::Cast(dstBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+    if (!node::Buffer::HasInstance(srcBufObj) || (srcFormatBytes > (uint32_t)node::Buffer::Length(srcBufObj))) {
+      std::string err = std::string("Packer packBatch has insufficient source buffer for conversion - frame ") + std::to_string(i);
+      return Nan::ThrowError(err.c_str());
+    }
+    if (!node::Buffer::HasInstance(dstBufObj) || (obj->mDstBytesReq > node::Buffer::Length(dstBufObj))) {
+      std::string err = std::string("Packer packBatch has insufficient destination buffer for specified format - frame ") + std::to_string(i);
+      return Nan::ThrowError(err.c_str());
+    }
+    if ((node::Buffer::Data(srcBufObj) == node::Buffer::Data(dstBufObj)) && !obj->mProcessParams->inPlace())
+      return Nan::ThrowError("Packer packBatch requires separate source and destination buffers unless set up with inPlace");
+  }
+
+  obj->mWorker->startBatch(callback, numFrames, MyWorker::deadlineArg(info, 3));
+  for (uint32_t i=0; i<numFrames; ++i) {
+    Local<Array> srcBufArray = Local<Array>::Cast(srcBufArrays->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+    Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
+    Local<Object> dstBufObj = Local<Object>::Cast(dstBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
+    std::shared_ptr<PackerProcessData> ppd = obj->mProcessDataPool.acquire();
+    ppd->set(srcBufObj, dstBufObj);
+    obj->mWorker->doBatchFrame(ppd, obj);
+  }
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
@@ -180,6 +457,8 @@ NAN_MODULE_INIT(Packer::Init) {
 
   SetPrototypeMethod(tpl, "setInfo", SetInfo);
   SetPrototypeMethod(tpl, "pack", Pack);
+  SetPrototypeMethod(tpl, "packLines", PackLines);
+  SetPrototypeMethod(tpl, "packBatch", PackBatch);
   SetPrototypeMethod(tpl, "quit", Quit);
 
   constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
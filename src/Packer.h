@@ -18,20 +18,30 @@
 
 #include "iDebug.h"
 #include "iProcess.h"
+#include "ProcessDataPool.h"
 #include <memory>
+#include <vector>
 
 namespace streampunk {
 
 class MyWorker;
 class Packers;
+class MultiPackers;
 class EssenceInfo;
+class ProcessParams;
+class PackerProcessData;
 
-class Packer : public Nan::ObjectWrap, public iProcess, public iDebug {
+class Packer : public Nan::ObjectWrap, public iProcess, public iPipelineStage, public iDebug {
 public:
   static NAN_MODULE_INIT(Init);
 
   // iProcess
   uint32_t processFrame (std::shared_ptr<iProcessData> processData);
+
+  // iPipelineStage
+  uint32_t stageSrcBytes() const;
+  uint32_t stageDstBytes() const;
+  uint32_t processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf);
   
 private:
   explicit Packer(Nan::Callback *callback);
@@ -62,6 +72,8 @@ private:
 
   static NAN_METHOD(SetInfo);
   static NAN_METHOD(Pack);
+  static NAN_METHOD(PackLines);
+  static NAN_METHOD(PackBatch);
   static NAN_METHOD(Quit);
 
   MyWorker *mWorker;
@@ -71,7 +83,11 @@ private:
   uint32_t mDstBytesReq;
   std::shared_ptr<EssenceInfo> mSrcVidInfo;
   std::shared_ptr<EssenceInfo> mDstVidInfo;
+  std::shared_ptr<ProcessParams> mProcessParams;
   std::shared_ptr<Packers> mPacker;
+  std::shared_ptr<MultiPackers> mMultiPacker;
+  std::vector<uint32_t> mMultiDstBytes;
+  ProcessDataPool<PackerProcessData> mProcessDataPool;
 };
 
 } // namespace streampunk
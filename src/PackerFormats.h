@@ -0,0 +1,96 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef PACKERFORMATS_H
+#define PACKERFORMATS_H
+
+#include <stdint.h>
+#include <string>
+
+namespace streampunk {
+
+// Describes the memory layout of a Packers format.
+// Packed formats have a single plane made of blocks of pixels, and planar formats have one sample per block.
+// Planes after the first are subsampled by the chroma shifts, and semi-planar formats interleave chromaInterleave
+// chroma samples at each position of their one chroma plane. Formats with alphaPlane set can carry a full size
+// alpha plane after the others, as plane numPlanes.
+struct FormatDesc {
+  const char *code;
+  uint32_t bitDepth;
+  uint32_t numPlanes;
+  uint32_t chromaXShift;
+  uint32_t chromaYShift;
+  bool bigEndian;
+  bool alphaPlane;
+  uint32_t blockPixels;
+  uint32_t blockBytes;
+  uint32_t lineAlignPixels;
+  uint32_t chromaInterleave;
+
+  constexpr bool isChroma(uint32_t plane) const {
+    return plane && (plane < numPlanes);
+  }
+  constexpr uint32_t planeWidth(uint32_t width, uint32_t plane) const {
+    return isChroma(plane) ? width >> chromaXShift : width;
+  }
+  constexpr uint32_t planeHeight(uint32_t height, uint32_t plane) const {
+    return isChroma(plane) ? height >> chromaYShift : height;
+  }
+  constexpr uint32_t pitchBytes(uint32_t width, uint32_t plane = 0) const {
+    return (planeWidth(width, plane) + lineAlignPixels - 1) / lineAlignPixels * lineAlignPixels / blockPixels * blockBytes *
+           (isChroma(plane) ? chromaInterleave : 1);
+  }
+  constexpr uint32_t planeBytes(uint32_t width, uint32_t height, uint32_t plane) const {
+    return pitchBytes(width, plane) * planeHeight(height, plane);
+  }
+  // offset of a plane from the start of the frame
+  constexpr uint32_t planeOffset(uint32_t width, uint32_t height, uint32_t plane) const {
+    return plane ? planeOffset(width, height, plane - 1) + planeBytes(width, height, plane - 1) : 0;
+  }
+  constexpr uint32_t frameBytes(uint32_t width, uint32_t height, bool hasAlpha = false) const {
+    return planeOffset(width, height, numPlanes) + ((hasAlpha && alphaPlane) ? planeBytes(width, height, 0) : 0);
+  }
+
+  // the start of a frame line of a plane, which for subsampled chroma is the chroma line covering it
+  uint8_t *line(uint8_t *buf, uint32_t width, uint32_t height, uint32_t plane, uint32_t y) const {
+    return buf + planeOffset(width, height, plane) + pitchBytes(width, plane) * (isChroma(plane) ? y >> chromaYShift : y);
+  }
+  const uint8_t *line(const uint8_t *buf, uint32_t width, uint32_t height, uint32_t plane, uint32_t y) const {
+    return line((uint8_t *)buf, width, height, plane, y);
+  }
+};
+
+//                                  code          bits planes xs ys  BE     alpha  blkPx blkBytes align ilv
+constexpr FormatDesc fmt420P      = { "420P",         8,   3,     1, 1,  false, true,  1,    1,       1,    1 };
+constexpr FormatDesc fmtPGroup    = { "pgroup",       10,  1,     1, 0,  true,  false, 2,    5,       1,    1 };
+constexpr FormatDesc fmtV210      = { "v210",         10,  1,     1, 0,  false, false, 6,    16,      48,   1 };
+constexpr FormatDesc fmtUYVY10    = { "UYVY10",       10,  1,     1, 0,  false, false, 2,    8,       1,    1 };
+constexpr FormatDesc fmtYUV422P10 = { "YUV422P10",    10,  3,     1, 0,  false, true,  1,    2,       1,    1 };
+constexpr FormatDesc fmtNV12      = { "NV12",         8,   2,     1, 1,  false, false, 1,    1,       1,    2 };
+constexpr FormatDesc fmtP010      = { "P010",         10,  2,     1, 1,  false, false, 1,    2,       1,    2 };
+constexpr FormatDesc fmtY210      = { "Y210",         10,  1,     1, 0,  false, false, 2,    8,       1,    1 };
+constexpr FormatDesc fmtV410      = { "v410",         10,  1,     0, 0,  false, false, 1,    4,       1,    1 };
+constexpr FormatDesc fmtRGBA8     = { "RGBA8",        8,   1,     0, 0,  false, false, 1,    4,       1,    1 };
+constexpr FormatDesc fmtBGRA8     = { "BGRA8",        8,   1,     0, 0,  false, false, 1,    4,       1,    1 };
+constexpr FormatDesc fmtBGR10A    = { "BGR10-A",      10,  1,     0, 0,  false, false, 1,    4,       1,    1 };
+constexpr FormatDesc fmtBGR10ABS  = { "BGR10-A-BS",   10,  1,     0, 0,  true,  false, 1,    4,       1,    1 };
+constexpr FormatDesc fmtGBRP16    = { "GBRP16",       16,  3,     0, 0,  false, false, 1,    2,       1,    1 };
+
+// the descriptor for a format code, or NULL if the format is unknown
+const FormatDesc *findFormat(const std::string& fmtCode);
+
+} // namespace streampunk
+
+#endif
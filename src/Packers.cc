@@ -16,6 +16,9 @@
 #include <nan.h>
 #include "Packers.h"
 #include "Memory.h"
+#include "WorkerPool.h"
+#include <map>
+#include <cmath>
 
 // V210: https://developer.apple.com/library/mac/technotes/tn2162/_index.html#//apple_ref/doc/uid/DTS40013070-CH1-TNTAG8-V210__4_2_2_COMPRESSION_TYPE
 // 420P: https://en.wikipedia.org/wiki/YUV
@@ -28,42 +31,25 @@
 
 namespace streampunk {
 
+const FormatDesc *findFormat(const std::string& fmtCode) {
+  static const FormatDesc *const formats[] = {
+    &fmt420P, &fmtPGroup, &fmtV210, &fmtUYVY10, &fmtYUV422P10,
+    &fmtNV12, &fmtP010, &fmtY210, &fmtV410, &fmtRGBA8, &fmtBGRA8, &fmtBGR10A, &fmtBGR10ABS, &fmtGBRP16
+  };
+  for (const FormatDesc *fmt : formats)
+    if (0 == fmtCode.compare(fmt->code))
+      return fmt;
+  return NULL;
+}
+
 uint32_t getFormatBytes(const std::string& fmtCode, uint32_t width, uint32_t height, bool hasAlpha) {
-  uint32_t fmtBytes = 0;
-  if (0 == fmtCode.compare("420P")) {
-    fmtBytes = width * height * (hasAlpha?5:3) / 2;
-  }
-  else if (0 == fmtCode.compare("pgroup")) {
-    uint32_t pitchBytes = width * 5 / 2;
-    fmtBytes = pitchBytes * height;
-  }
-  else if (0 == fmtCode.compare("v210")) {
-    uint32_t pitchBytes = ((width + 47) / 48) * 48 * 8 / 3;
-    fmtBytes = pitchBytes * height;
-  }
-  else if (0 == fmtCode.compare("UYVY10")) {
-    uint32_t pitchBytes = width * 4;
-    fmtBytes = pitchBytes * height;
-  }
-  else if (0 == fmtCode.compare("YUV422P10")) {
-    fmtBytes = width * height * 2 * (hasAlpha?3:2);
-  }
-  else if ((0 == fmtCode.compare("RGBA8")) || (0 == fmtCode.compare("BGRA8"))) {
-    uint32_t pitchBytes = width * 4;
-    fmtBytes = pitchBytes * height;
-  }
-  else if ((0 == fmtCode.compare("BGR10-A")) || (0 == fmtCode.compare("BGR10-A-BS"))) {
-    fmtBytes = width * height * 4;
-  }
-  else if (0 == fmtCode.compare("GBRP16")) {
-    fmtBytes = width * height * 6;
-  }
-  else {
+  const FormatDesc *fmt = findFormat(fmtCode);
+  if (!fmt) {
     std::string err = std::string("Unsupported format \'") + fmtCode.c_str() + "\'\n";
     Nan::ThrowError(err.c_str());
+    return 0;
   }
-
-  return fmtBytes;
+  return fmt->frameBytes(width, height, hasAlpha);
 }
 
 void dumpPGroupRaw (const uint8_t *const pgbuf, uint32_t width, uint32_t numLines) {
@@ -120,102 +106,560 @@ void dumpGBRP16 (const uint8_t *const rgbBuf, uint32_t width, uint32_t height, u
   }
 }
 
-Packers::Packers(uint32_t srcWidth, uint32_t srcHeight, const std::string& srcFmtCode, const std::string& dstFmtCode)
-  : mSrcWidth(srcWidth), mSrcHeight(srcHeight), mSrcFmtCode(srcFmtCode), mDstFmtCode(dstFmtCode), mConvertFn(&Packers::convertNotSupported) {
-
-  if (0 == mDstFmtCode.compare("UYVY10")) {
-    if (0 == mSrcFmtCode.compare("YUV422P10"))
-      mConvertFn = &Packers::convertYUV422P10toUYVY10;
-    else if (0 == mSrcFmtCode.compare("pgroup"))
-      mConvertFn = &Packers::convertPGrouptoUYVY10;
-    else {
-      std::string err = std::string("Unsupported conversion \'") + mSrcFmtCode.c_str() + "\' -> \'" + mDstFmtCode.c_str() + "\'";
-      Nan::ThrowError(err.c_str());
+// Coefficients for full range RGB of the given bit depth to limited range 10-bit YCbCr, with the BT.709, BT.2020 or,
+// for any other colorimetry, BT.601 matrix. Green takes up the rounding, so that greys have no chroma and white is
+// exactly peak luma.
+static RgbToYuvCoeffs rgbToYuvCoeffs(const std::string& colorimetry, uint32_t bitDepth) {
+  double kr = 0.299;
+  double kb = 0.114;
+  if (0 == colorimetry.compare(0, 5, "BT709")) {
+    kr = 0.2126;
+    kb = 0.0722;
+  } else if ((0 == colorimetry.compare(0, 6, "BT2020")) || (0 == colorimetry.compare(0, 6, "BT2100"))) {
+    kr = 0.2627;
+    kb = 0.0593;
+  }
+
+  // luma spans 876 codes and chroma 896, with chroma taken from the sum of a pixel pair
+  const double scale = 8192.0 / ((1 << bitDepth) - 1);
+  RgbToYuvCoeffs k;
+  k.yR = (int16_t)lround(876.0 * scale * kr);
+  k.yB = (int16_t)lround(876.0 * scale * kb);
+  k.yG = (int16_t)(lround(876.0 * scale) - k.yR - k.yB);
+  k.uB = (int16_t)lround(224.0 * scale);
+  k.uR = (int16_t)-lround(224.0 * scale * kr / (1.0 - kb));
+  k.uG = (int16_t)(-k.uB - k.uR);
+  k.vR = (int16_t)lround(224.0 * scale);
+  k.vB = (int16_t)-lround(224.0 * scale * kb / (1.0 - kr));
+  k.vG = (int16_t)(-k.vR - k.vB);
+  return k;
+}
+
+Packers::Packers(uint32_t srcWidth, uint32_t srcHeight, const std::string& srcFmtCode, const std::string& dstFmtCode,
+                 bool interlaced, uint32_t numThreads, bool fieldChroma, bool dither, const std::string& colorimetry, bool hasAlpha)
+  : mSrcWidth(srcWidth), mSrcHeight(srcHeight), mSrcFmtCode(srcFmtCode), mDstFmtCode(dstFmtCode),
+    mSrcFmt(findFormat(srcFmtCode)), mDstFmt(findFormat(dstFmtCode)),
+    mInterlaced(interlaced), mNumThreads(numThreads), mFieldChroma(fieldChroma), mDither(dither),
+    mHasAlpha(hasAlpha && mDstFmt && mDstFmt->alphaPlane), mRgbCoeffs(rgbToYuvCoeffs(colorimetry, mSrcFmt ? mSrcFmt->bitDepth : 8)),
+    mConvertFn(&Packers::convertNotSupported), mLineKernels(packerLineKernels()),
+    mSrcTileLines(0), mDstTileLines(0), mLineAlign(1), mTileLines(0), mTileBytes(0),
+    mInPlaceBottomUp(false), mInPlaceStagedPlanes(0), mInPlaceStagedBytes(0) {
+
+  std::vector<Conversion> plan;
+  if (mSrcFmt && mDstFmt)
+    plan = planConversion(mSrcFmt, mDstFmt, mLineKernels, mHasAlpha);
+  if (plan.empty()) {
+    std::string err = std::string("Unsupported conversion \'") + mSrcFmtCode.c_str() + "\' -> \'" + mDstFmtCode.c_str() + "\'" +
+                      (mHasAlpha ? " with alpha" : "");
+    Nan::ThrowError(err.c_str());
+    return;
+  }
+
+  // chroma subsampled vertically is built from line pairs, and interlaced bands must hold both fields of each pair
+  uint32_t chromaYShift = mSrcFmt->chromaYShift;
+  for (const Conversion &conversion : plan)
+    chromaYShift = std::max(chromaYShift, conversion.dst->chromaYShift);
+  mLineAlign = (1 << chromaYShift) * (mInterlaced ? 2 : 1);
+
+  if (1 == plan.size()) {
+    mConvertFn = plan[0].fn;
+
+    // in place, whichever direction leaves the least to stage, as long as some planes can be written directly
+    const uint32_t numDstPlanes = mDstFmt->numPlanes + ((mHasAlpha && mDstFmt->alphaPlane) ? 1 : 0);
+    uint32_t stagedBytes[2] = { 0, 0 };
+    uint32_t stagedPlanes[2];
+    for (uint32_t d = 0; d < 2; ++d) {
+      stagedPlanes[d] = inPlaceStagedPlanes(1 == d);
+      for (uint32_t p = 0; p < numDstPlanes; ++p)
+        if (stagedPlanes[d] & (1 << p))
+          stagedBytes[d] += mDstFmt->planeBytes(mSrcWidth, mSrcHeight, p);
     }
-  } else if (0 == mDstFmtCode.compare("YUV422P10")) {
-    if (0 == mSrcFmtCode.compare("UYVY10"))
-      mConvertFn = &Packers::convertUYVY10toYUV422P10;
-    else if (0 == mSrcFmtCode.compare("pgroup"))
-      mConvertFn = &Packers::convertPGrouptoYUV422P10;
-    else if (0 == mSrcFmtCode.compare("v210"))
-      mConvertFn = &Packers::convertV210toYUV422P10;
-    else {
-      std::string err = std::string("Unsupported conversion \'") + mSrcFmtCode.c_str() + "\' -> \'" + mDstFmtCode.c_str() + "\'";
-      Nan::ThrowError(err.c_str());
+    uint32_t d = (stagedBytes[1] < stagedBytes[0]) ? 1 : 0;
+    if (stagedPlanes[d] != (1u << numDstPlanes) - 1) {
+      mInPlaceHop = tileConverter(mLineAlign);
+      mInPlaceBottomUp = (1 == d);
+      mInPlaceStagedPlanes = stagedPlanes[d];
+      mInPlaceStagedBytes = stagedBytes[d];
     }
-  } else if (0 == mDstFmtCode.compare("420P")) {
-    if (0 == mSrcFmtCode.compare("UYVY10"))
-      mConvertFn = &Packers::convertUYVY10to420P;
-    else if (0 == mSrcFmtCode.compare("YUV422P10"))
-      mConvertFn = &Packers::convertYUV422P10to420P;
-    else if (0 == mSrcFmtCode.compare("pgroup"))
-      mConvertFn = &Packers::convertPGroupto420P;
-    else if (0 == mSrcFmtCode.compare("v210"))
-      mConvertFn = &Packers::convertV210to420P;
-    else {
-      std::string err = std::string("Unsupported conversion \'") + mSrcFmtCode.c_str() + "\' -> \'" + mDstFmtCode.c_str() + "\'";
-      Nan::ThrowError(err.c_str());
+    return;
+  }
+
+  // tiles are sized so that the largest intermediate tile fits in a typical L2 cache
+  const uint32_t tileTargetBytes = 256 * 1024;
+  uint32_t alignBytes = 0;
+  for (size_t h = 0; h + 1 < plan.size(); ++h)
+    alignBytes = std::max(alignBytes, plan[h].dst->frameBytes(mSrcWidth, mLineAlign, mHasAlpha));
+  mTileLines = std::max<uint32_t>(1, tileTargetBytes / alignBytes) * mLineAlign;
+  mTileBytes = alignBytes * (mTileLines / mLineAlign);
+
+  for (size_t h = 0; h < plan.size(); ++h) {
+    uint32_t srcTileLines = h ? mTileLines : 0;
+    uint32_t dstTileLines = (h + 1 < plan.size()) ? mTileLines : 0;
+    mHops.push_back(std::shared_ptr<Packers>(new Packers(*this, plan[h], srcTileLines, dstTileLines)));
+  }
+  mConvertFn = &Packers::convertHops;
+}
+
+Packers::Packers(const Packers &parent, const Conversion &conversion, uint32_t srcTileLines, uint32_t dstTileLines)
+  : mSrcWidth(parent.mSrcWidth), mSrcHeight(parent.mSrcHeight), mSrcFmtCode(conversion.src->code), mDstFmtCode(conversion.dst->code),
+    mSrcFmt(conversion.src), mDstFmt(conversion.dst),
+    mInterlaced(parent.mInterlaced), mNumThreads(1), mFieldChroma(parent.mFieldChroma), mDither(parent.mDither),
+    mHasAlpha(parent.mHasAlpha), mRgbCoeffs(parent.mRgbCoeffs), mConvertFn(conversion.fn), mLineKernels(parent.mLineKernels),
+    mSrcTileLines(srcTileLines), mDstTileLines(dstTileLines), mLineAlign(parent.mLineAlign), mTileLines(0), mTileBytes(0),
+    mInPlaceBottomUp(false), mInPlaceStagedPlanes(0), mInPlaceStagedBytes(0) {}
+
+std::shared_ptr<Packers> Packers::tileConverter(uint32_t tileLines) const {
+  if (!mHops.empty() || (mConvertFn == &Packers::convertNotSupported))
+    return std::shared_ptr<Packers>();
+  Conversion conversion = { mSrcFmt, mDstFmt, mConvertFn, 0, mHasAlpha };
+  return std::shared_ptr<Packers>(new Packers(*this, conversion, mSrcTileLines, tileLines));
+}
+
+void Packers::convert(std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) const {
+  convertRange(srcBuf, dstBuf, 0, mSrcHeight);
+}
+
+void Packers::convertRange(std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  convertRange(srcBuf->buf(), dstBuf->buf(), firstLine, numLines);
+}
+
+void Packers::convertRange(const uint8_t *const src, uint8_t *const dst, uint32_t firstLine, uint32_t numLines) const {
+  if (mConvertFn == &Packers::convertNotSupported)
+    return;
+  if ((firstLine >= mSrcHeight) || !numLines)
+    return;
+  numLines = std::min(numLines, mSrcHeight - firstLine);
+  if (mNumThreads < 2) {
+    (this->*mConvertFn)(src, dst, firstLine, numLines);
+    return;
+  }
+
+  WorkerPool::instance().runLines(numLines, mNumThreads, mLineAlign, 
+    [this, src, dst, firstLine](uint32_t bandLine, uint32_t bandLines) {
+      (this->*mConvertFn)(src, dst, firstLine + bandLine, bandLines);
+    });
+}
+
+MultiPackers::MultiPackers(uint32_t srcWidth, uint32_t srcHeight, const std::string& srcFmtCode, const std::vector<std::string>& dstFmtCodes,
+                           bool interlaced, uint32_t numThreads, bool fieldChroma, bool dither,
+                           const std::string& colorimetry, bool hasAlpha)
+  : mSrcHeight(srcHeight), mNumThreads(numThreads), mLineAlign(1), mTileLines(0) {
+  // each conversion runs single threaded on the band of lines it is given
+  for (const std::string& dstFmtCode : dstFmtCodes) {
+    mPackers.push_back(std::make_shared<Packers>(srcWidth, srcHeight, srcFmtCode, dstFmtCode, interlaced, 1, fieldChroma, dither,
+                                                 colorimetry, hasAlpha));
+    mLineAlign = std::max(mLineAlign, mPackers.back()->lineAlign());
+  }
+
+  // tiles are sized so that a tile of the source stays in a typical L2 cache while each destination is written
+  const FormatDesc *srcFmt = findFormat(srcFmtCode);
+  const uint32_t tileTargetBytes = 256 * 1024;
+  uint32_t alignBytes = srcFmt ? srcFmt->frameBytes(srcWidth, mLineAlign) : 0;
+  mTileLines = (alignBytes ? std::max<uint32_t>(1, tileTargetBytes / alignBytes) : 1) * mLineAlign;
+}
+
+void MultiPackers::convert(std::shared_ptr<Memory> srcBuf, const std::vector<std::shared_ptr<Memory> >& dstBufs) const {
+  if (dstBufs.size() != mPackers.size())
+    return;
+  if (mNumThreads < 2) {
+    convertTiles(srcBuf, dstBufs, 0, mSrcHeight);
+    return;
+  }
+
+  WorkerPool::instance().runLines(mSrcHeight, mNumThreads, mLineAlign, 
+    [this, srcBuf, &dstBufs](uint32_t firstLine, uint32_t numLines) {
+      convertTiles(srcBuf, dstBufs, firstLine, numLines);
+    });
+}
+
+void MultiPackers::convertTiles(std::shared_ptr<Memory> srcBuf, const std::vector<std::shared_ptr<Memory> >& dstBufs,
+                                uint32_t firstLine, uint32_t numLines) const {
+  for (uint32_t y = firstLine; y < firstLine + numLines; y += mTileLines) {
+    uint32_t tileLines = std::min(mTileLines, firstLine + numLines - y);
+    for (size_t d = 0; d < mPackers.size(); ++d)
+      mPackers[d]->convertRange(srcBuf, dstBufs[d], y, tileLines);
+  }
+}
+
+// private
+// Line access for the conversions generated by convertLines. Each unpacks n pixels, starting at pixel x of a line,
+// to 10-bit 4:2:2 samples or packs them back. x is a multiple of the format block size, and unpacking may fill the
+// samples to the end of the last block. Sources reduced to 420P also unpack with the SIMD kernel where there is one,
+// returning the number of pixels it did.
+struct UYVY10Lines {
+  static const FormatDesc &fmt() { return fmtUYVY10; }
+  static uint32_t unpackKernel(const PackerLineKernels &kernels, const uint8_t *const *lines, uint32_t x, uint32_t n,
+                               uint16_t *y, uint16_t *u, uint16_t *v) {
+    return 0;
+  }
+  static void unpack(const uint8_t *const *lines, uint32_t x, uint32_t n, uint16_t *y, uint16_t *u, uint16_t *v) {
+    const uint32_t *srcInts = (const uint32_t *)lines[0] + x;
+    for (uint32_t i=0; i<n; i+=2) {
+      uint32_t s0 = srcInts[i]; // u0 | y0
+      uint32_t s1 = srcInts[i + 1]; // v0 | y1
+      u[i / 2] = s0 & 0x3ff;
+      y[i] = (s0 >> 16) & 0x3ff;
+      v[i / 2] = s1 & 0x3ff;
+      y[i + 1] = (s1 >> 16) & 0x3ff;
     }
-  } else if (0 == mDstFmtCode.compare("pgroup")) {
-    if (0 == mSrcFmtCode.compare("UYVY10"))
-      mConvertFn = &Packers::convertUYVY10toPGroup;
-    else if (0 == mSrcFmtCode.compare("YUV422P10"))
-      mConvertFn = &Packers::convertYUV422P10toPGroup;
-    else if (0 == mSrcFmtCode.compare("420P"))
-      mConvertFn = &Packers::convert420PtoPGroup;
-    else if (0 == mSrcFmtCode.compare("v210"))
-      mConvertFn = &Packers::convertV210toPGroup;
-    else {
-      std::string err = std::string("Unsupported conversion \'") + mSrcFmtCode.c_str() + "\' -> \'" + mDstFmtCode.c_str() + "\'";
-      Nan::ThrowError(err.c_str());
+  }
+  static void pack(const uint16_t *y, const uint16_t *u, const uint16_t *v, uint8_t *const *lines, uint32_t x, uint32_t n) {
+    uint32_t *dstInts = (uint32_t *)lines[0] + x;
+    for (uint32_t i=0; i<n; i+=2) {
+      dstInts[i] = u[i / 2] | (y[i] << 16);
+      dstInts[i + 1] = v[i / 2] | (y[i + 1] << 16);
     }
-  } else if (0 == mDstFmtCode.compare("v210")) {
-    if (0 == mSrcFmtCode.compare("YUV422P10"))
-      mConvertFn = &Packers::convertYUV422P10toV210;
-    else if (0 == mSrcFmtCode.compare("420P"))
-      mConvertFn = &Packers::convert420PtoV210;
-    else if (0 == mSrcFmtCode.compare("pgroup"))
-      mConvertFn = &Packers::convertPGrouptoV210;
-    else {
-      std::string err = std::string("Unsupported conversion \'") + mSrcFmtCode.c_str() + "\' -> \'" + mDstFmtCode.c_str() + "\'";
-      Nan::ThrowError(err.c_str());
+  }
+};
+
+struct YUV422P10Lines {
+  static const FormatDesc &fmt() { return fmtYUV422P10; }
+  static void unpack(const uint8_t *const *lines, uint32_t x, uint32_t n, uint16_t *y, uint16_t *u, uint16_t *v) {
+    memcpy(y, (const uint16_t *)lines[0] + x, n * 2);
+    memcpy(u, (const uint16_t *)lines[1] + x / 2, n);
+    memcpy(v, (const uint16_t *)lines[2] + x / 2, n);
+  }
+  static void pack(const uint16_t *y, const uint16_t *u, const uint16_t *v, uint8_t *const *lines, uint32_t x, uint32_t n) {
+    memcpy((uint16_t *)lines[0] + x, y, n * 2);
+    memcpy((uint16_t *)lines[1] + x / 2, u, n);
+    memcpy((uint16_t *)lines[2] + x / 2, v, n);
+  }
+};
+
+// unpacking only, as packing 4:2:0 needs a pair of lines
+struct YUV420PLines {
+  static const FormatDesc &fmt() { return fmt420P; }
+  static void unpack(const uint8_t *const *lines, uint32_t x, uint32_t n, uint16_t *y, uint16_t *u, uint16_t *v) {
+    for (uint32_t i=0; i<n; ++i)
+      y[i] = lines[0][x + i] << 2;
+    for (uint32_t i=0; i<n/2; ++i) {
+      u[i] = lines[1][x / 2 + i] << 2;
+      v[i] = lines[2][x / 2 + i] << 2;
     }
-  } else if (0 == mDstFmtCode.compare("GBRP16")) {
-    if ((0 == mSrcFmtCode.compare("BGR10-A")) || (0 == mSrcFmtCode.compare("BGR10-A-BS")))
-      mConvertFn = &Packers::convertBGR10AtoGBRP16;
-    else {
-      std::string err = std::string("Unsupported conversion \'") + mSrcFmtCode.c_str() + "\' -> \'" + mDstFmtCode.c_str() + "\'";
-      Nan::ThrowError(err.c_str());
+  }
+};
+
+// unpacking only, for the reduction to 420P
+struct PGroupLines {
+  static const FormatDesc &fmt() { return fmtPGroup; }
+  static uint32_t unpackKernel(const PackerLineKernels &kernels, const uint8_t *const *lines, uint32_t x, uint32_t n,
+                               uint16_t *y, uint16_t *u, uint16_t *v) {
+    return kernels.pgroupToYUV422P10 ? kernels.pgroupToYUV422P10(lines[0] + x * 5 / 2, y, u, v, n) : 0;
+  }
+  static void unpack(const uint8_t *const *lines, uint32_t x, uint32_t n, uint16_t *y, uint16_t *u, uint16_t *v) {
+    const uint8_t *srcBytes = lines[0] + x * 5 / 2;
+    for (uint32_t i=0; i<n; i+=2) {
+      uint8_t s0 = srcBytes[0];
+      uint8_t s1 = srcBytes[1];
+      uint8_t s2 = srcBytes[2];
+      uint8_t s3 = srcBytes[3];
+      uint8_t s4 = srcBytes[4];
+      srcBytes += 5;
+
+      u[i / 2] = (s0 << 2) | (s1 >> 6);
+      y[i] = ((s1 & 0x3f) << 4) | (s2 >> 4);
+      v[i / 2] = ((s2 & 0x0f) << 6) | (s3 >> 2);
+      y[i + 1] = ((s3 & 0x03) << 8) | s4;
+    }
+  }
+};
+
+// whole 6 pixel blocks are unpacked, but a part block at the end of a line is packed as the hand-written
+// conversions do, zero filled and leaving the last word and the line padding alone
+struct V210Lines {
+  static const FormatDesc &fmt() { return fmtV210; }
+  static uint32_t unpackKernel(const PackerLineKernels &kernels, const uint8_t *const *lines, uint32_t x, uint32_t n,
+                               uint16_t *y, uint16_t *u, uint16_t *v) {
+    return kernels.v210ToYUV422P10 ? kernels.v210ToYUV422P10(lines[0] + x / 6 * 16, y, u, v, n) : 0;
+  }
+  static void unpack(const uint8_t *const *lines, uint32_t x, uint32_t n, uint16_t *y, uint16_t *u, uint16_t *v) {
+    const uint32_t *srcInts = (const uint32_t *)lines[0] + x / 6 * 4;
+    for (uint32_t i=0; i<n; i+=6) {
+      uint32_t s0 = srcInts[0]; // v0 | y0 | u0
+      uint32_t s1 = srcInts[1]; // y2 | u1 | y1
+      uint32_t s2 = srcInts[2]; // u2 | y3 | v1
+      uint32_t s3 = srcInts[3]; // y5 | v2 | y4
+      srcInts += 4;
+
+      y[i] = (s0 >> 10) & 0x3ff;
+      y[i + 1] = s1 & 0x3ff;
+      y[i + 2] = (s1 >> 20) & 0x3ff;
+      y[i + 3] = (s2 >> 10) & 0x3ff;
+      y[i + 4] = s3 & 0x3ff;
+      y[i + 5] = (s3 >> 20) & 0x3ff;
+      u[i / 2] = s0 & 0x3ff;
+      u[i / 2 + 1] = (s1 >> 10) & 0x3ff;
+      u[i / 2 + 2] = (s2 >> 20) & 0x3ff;
+      v[i / 2] = (s0 >> 20) & 0x3ff;
+      v[i / 2 + 1] = s2 & 0x3ff;
+      v[i / 2 + 2] = (s3 >> 10) & 0x3ff;
+    }
+  }
+  static void pack(const uint16_t *y, const uint16_t *u, const uint16_t *v, uint8_t *const *lines, uint32_t x, uint32_t n) {
+    uint32_t *dstInts = (uint32_t *)lines[0] + x / 6 * 4;
+    uint32_t i = 0;
+    for (; i+6<=n; i+=6) {
+      packBlock(y + i, u + i / 2, v + i / 2, dstInts, 4);
+      dstInts += 4;
+    }
+    if (i < n) {
+      uint16_t partY[6] = { 0 };
+      uint16_t partU[3] = { 0 };
+      uint16_t partV[3] = { 0 };
+      memcpy(partY, y + i, (n - i) * 2);
+      memcpy(partU, u + i / 2, n - i);
+      memcpy(partV, v + i / 2, n - i);
+      packBlock(partY, partU, partV, dstInts, (n - i) / 2 + 1);
+    }
+  }
+  static void packBlock(const uint16_t *y, const uint16_t *u, const uint16_t *v, uint32_t *dstInts, uint32_t numInts) {
+    uint32_t d[4];
+    d[0] = (v[0] << 20) | (y[0] << 10) | u[0]; // v0 | y0 | u0
+    d[1] = (y[2] << 20) | (u[1] << 10) | y[1]; // y2 | u1 | y1
+    d[2] = (u[2] << 20) | (y[3] << 10) | v[1]; // u2 | y3 | v1
+    d[3] = (y[5] << 20) | (v[2] << 10) | y[4]; // y5 | v2 | y4
+    memcpy(dstInts, d, numInts * 4);
+  }
+};
+
+// Converts a tile of each line at a time through 10-bit 4:2:2 samples, so that a pair of formats with line access
+// needs only an entry in the conversion table. The tile is a whole number of blocks of every format.
+template <class SrcLines, class DstLines>
+void Packers::convertLines (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  const uint32_t tilePixels = 384;
+  uint16_t tileY[tilePixels];
+  uint16_t tileU[tilePixels / 2];
+  uint16_t tileV[tilePixels / 2];
+
+  const FormatDesc &srcFmt = SrcLines::fmt();
+  const FormatDesc &dstFmt = DstLines::fmt();
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    const uint8_t *srcLines[3];
+    uint8_t *dstLines[3];
+    for (uint32_t p=0; p<srcFmt.numPlanes; ++p)
+      srcLines[p] = srcRow(srcBuf, p, firstLine, y);
+    for (uint32_t p=0; p<dstFmt.numPlanes; ++p)
+      dstLines[p] = dstRow(dstBuf, p, firstLine, y);
+
+    for (uint32_t x=0; x<mSrcWidth; x+=tilePixels) {
+      uint32_t n = std::min(tilePixels, mSrcWidth - x);
+      SrcLines::unpack(srcLines, x, n, tileY, tileU, tileV);
+      DstLines::pack(tileY, tileU, tileV, dstLines, x, n);
     }
-  } else {
-    std::string err = std::string("Unsupported destination packing format \'") + mDstFmtCode.c_str() + "\'";
-    Nan::ThrowError(err.c_str());
   }
 }
 
-void Packers::convert(std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) const {
-  mConvertFn(*this, srcBuf->buf(), dstBuf->buf());
+// Finds the cheapest chain of conversions from the table, preferring fewer hops at equal cost, and using only those
+// that carry the alpha through when it is wanted.
+// Hand-written conversions cost 1 where SIMD kernels back them and 2 otherwise, and generated ones cost 3.
+std::vector<Packers::Conversion> Packers::planConversion(const FormatDesc *srcFmt, const FormatDesc *dstFmt, const PackerLineKernels &kernels,
+                                                         bool alpha) {
+  const uint32_t simd = kernels.pgroupToUYVY10 ? 1 : 2;
+  const Conversion conversions[] = {
+    { &fmtYUV422P10, &fmtUYVY10,    &Packers::convertYUV422P10toUYVY10, 2, false },
+    { &fmtPGroup,    &fmtUYVY10,    &Packers::convertPGrouptoUYVY10, simd, false },
+    { &fmtV210,      &fmtUYVY10,    &Packers::convertLines<V210Lines, UYVY10Lines>, 3, false },
+    { &fmt420P,      &fmtUYVY10,    &Packers::convertLines<YUV420PLines, UYVY10Lines>, 3, false },
+
+    { &fmtUYVY10,    &fmtYUV422P10, &Packers::convertUYVY10toYUV422P10, 2, false },
+    { &fmtPGroup,    &fmtYUV422P10, &Packers::convertPGrouptoYUV422P10, simd, false },
+    { &fmtV210,      &fmtYUV422P10, &Packers::convertV210toYUV422P10, simd, false },
+    { &fmt420P,      &fmtYUV422P10, &Packers::convertLines<YUV420PLines, YUV422P10Lines>, 3, false },
+
+    { &fmtUYVY10,    &fmt420P,      &Packers::convertLinesTo420P<UYVY10Lines>, 2, false },
+    { &fmtYUV422P10, &fmt420P,      &Packers::convertYUV422P10to420P, simd, true },
+    { &fmtPGroup,    &fmt420P,      &Packers::convertLinesTo420P<PGroupLines>, simd, false },
+    { &fmtV210,      &fmt420P,      &Packers::convertLinesTo420P<V210Lines>, simd, false },
+
+    { &fmtUYVY10,    &fmtPGroup,    &Packers::convertUYVY10toPGroup, simd, false },
+    { &fmtYUV422P10, &fmtPGroup,    &Packers::convertYUV422P10toPGroup, simd, false },
+    { &fmt420P,      &fmtPGroup,    &Packers::convert420PtoPGroup, simd, false },
+    { &fmtV210,      &fmtPGroup,    &Packers::convertV210toPGroup, simd, false },
+
+    { &fmtYUV422P10, &fmtV210,      &Packers::convertYUV422P10toV210, simd, false },
+    { &fmt420P,      &fmtV210,      &Packers::convert420PtoV210, simd, false },
+    { &fmtPGroup,    &fmtV210,      &Packers::convertPGrouptoV210, simd, false },
+    { &fmtUYVY10,    &fmtV210,      &Packers::convertLines<UYVY10Lines, V210Lines>, 3, false },
+
+    { &fmtYUV422P10, &fmtY210,      &Packers::convertYUV422P10toY210, simd, false },
+    { &fmtY210,      &fmtYUV422P10, &Packers::convertY210toYUV422P10, simd, false },
+    { &fmtYUV422P10, &fmtV410,      &Packers::convertYUV422P10toV410, simd, false },
+    { &fmtV410,      &fmtYUV422P10, &Packers::convertV410toYUV422P10, simd, false },
+    { &fmtYUV422P10, &fmtP010,      &Packers::convertYUV422P10toP010, simd, false },
+    { &fmtP010,      &fmtYUV422P10, &Packers::convertP010toYUV422P10, simd, false },
+    { &fmt420P,      &fmtNV12,      &Packers::convert420PtoNV12, simd, false },
+    { &fmtNV12,      &fmt420P,      &Packers::convertNV12to420P, simd, false },
+
+    { &fmtBGR10A,    &fmtGBRP16,    &Packers::convertBGR10AtoGBRP16, 2, false },
+    { &fmtBGR10ABS,  &fmtGBRP16,    &Packers::convertBGR10AtoGBRP16, 2, false },
+
+    { &fmtRGBA8,     &fmtYUV422P10, &Packers::convertRGBtoYUV422P10, simd, true },
+    { &fmtBGRA8,     &fmtYUV422P10, &Packers::convertRGBtoYUV422P10, simd, true },
+    { &fmtBGR10A,    &fmtYUV422P10, &Packers::convertRGBtoYUV422P10, simd, true },
+    { &fmtBGR10ABS,  &fmtYUV422P10, &Packers::convertRGBtoYUV422P10, simd, true }
+  };
+  const uint32_t numConversions = sizeof(conversions) / sizeof(conversions[0]);
+
+  // relaxes the best route to each format until nothing improves - there are only a handful of formats
+  struct Route {
+    uint32_t cost;
+    uint32_t hops;
+    int32_t last;
+  };
+  std::map<const FormatDesc *, Route> routes;
+  routes[srcFmt] = { 0, 0, -1 };
+  bool improved = true;
+  while (improved) {
+    improved = false;
+    for (uint32_t i = 0; i < numConversions; ++i) {
+      const Conversion &conversion = conversions[i];
+      auto from = routes.find(conversion.src);
+      if ((from == routes.end()) || (conversion.dst == srcFmt) || (alpha && !conversion.alpha))
+        continue;
+      Route route = { from->second.cost + conversion.cost, from->second.hops + 1, (int32_t)i };
+      auto to = routes.find(conversion.dst);
+      if ((to == routes.end()) || (route.cost < to->second.cost) ||
+          ((route.cost == to->second.cost) && (route.hops < to->second.hops))) {
+        routes[conversion.dst] = route;
+        improved = true;
+      }
+    }
+  }
+
+  std::vector<Conversion> plan;
+  auto to = routes.find(dstFmt);
+  if ((to == routes.end()) || (dstFmt == srcFmt))
+    return plan;
+  for (int32_t i = to->second.last; i >= 0; i = routes[conversions[i].src].last)
+    plan.insert(plan.begin(), conversions[i]);
+  return plan;
+}
+
+// Runs the hops of a planned conversion over the band a tile of lines at a time. The intermediate tiles are reused
+// from one tile to the next, so the intermediate formats are written and read back in cache.
+void Packers::convertHops (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint8_t *tiles[2] = { FramePool::instance().acquire(mTileBytes), NULL };
+  if (mHops.size() > 2)
+    tiles[1] = FramePool::instance().acquire(mTileBytes);
+
+  for (uint32_t y = firstLine; y < firstLine + numLines; y += mTileLines) {
+    uint32_t tileLines = std::min(mTileLines, firstLine + numLines - y);
+    const uint8_t *hopSrc = srcBuf;
+    for (size_t h = 0; h < mHops.size(); ++h) {
+      uint8_t *hopDst = (h + 1 < mHops.size()) ? tiles[h & 1] : dstBuf;
+      const Packers &hop = *mHops[h];
+      (hop.*hop.mConvertFn)(hopSrc, hopDst, y, tileLines);
+      hopSrc = hopDst;
+    }
+  }
+
+  FramePool::instance().release(tiles[0], mTileBytes);
+  if (tiles[1])
+    FramePool::instance().release(tiles[1], mTileBytes);
+}
+
+// A destination plane can be written directly if no group of its lines lands on source lines still to be read, in any
+// plane of the source. The others are staged.
+uint32_t Packers::inPlaceStagedPlanes(bool bottomUp) const {
+  const uint32_t numSrcPlanes = mSrcFmt->numPlanes + ((mHasAlpha && mSrcFmt->alphaPlane) ? 1 : 0);
+  const uint32_t numDstPlanes = mDstFmt->numPlanes + ((mHasAlpha && mDstFmt->alphaPlane) ? 1 : 0);
+  // the byte range of the rows of a plane holding lines [y, endY)
+  auto rows = [this](const FormatDesc *fmt, uint32_t plane, uint32_t y, uint32_t endY, uint32_t &start, uint32_t &end) {
+    uint32_t shift = fmt->isChroma(plane) ? fmt->chromaYShift : 0;
+    uint32_t offset = fmt->planeOffset(mSrcWidth, mSrcHeight, plane);
+    uint32_t pitch = fmt->pitchBytes(mSrcWidth, plane);
+    start = offset + pitch * (y >> shift);
+    end = (endY > y) ? offset + pitch * (((endY - 1) >> shift) + 1) : start;
+  };
+
+  uint32_t staged = 0;
+  for (uint32_t p = 0; p < numDstPlanes; ++p) {
+    for (uint32_t y = 0; y < mSrcHeight; y += mLineAlign) {
+      uint32_t endY = std::min(y + mLineAlign, mSrcHeight);
+      uint32_t dstStart, dstEnd;
+      rows(mDstFmt, p, y, endY, dstStart, dstEnd);
+      bool clash = false;
+      for (uint32_t q = 0; (q < numSrcPlanes) && !clash; ++q) {
+        uint32_t srcStart, srcEnd;
+        if (bottomUp)
+          rows(mSrcFmt, q, 0, y, srcStart, srcEnd);
+        else
+          rows(mSrcFmt, q, endY, mSrcHeight, srcStart, srcEnd);
+        clash = (dstStart < srcEnd) && (srcStart < dstEnd);
+      }
+      if (clash) {
+        staged |= 1 << p;
+        break;
+      }
+    }
+  }
+  return staged;
+}
+
+void Packers::convertInPlace(std::shared_ptr<Memory> buf) const {
+  if (!mInPlaceHop)
+    return;
+  uint8_t *const frame = buf->buf();
+  const uint32_t numDstPlanes = mDstFmt->numPlanes + ((mHasAlpha && mDstFmt->alphaPlane) ? 1 : 0);
+  const uint32_t tileBytes = mDstFmt->frameBytes(mSrcWidth, mLineAlign, mHasAlpha);
+  uint8_t *tile = FramePool::instance().acquire(tileBytes);
+  uint8_t *staged = mInPlaceStagedBytes ? FramePool::instance().acquire(mInPlaceStagedBytes) : NULL;
+
+  const uint32_t numGroups = (mSrcHeight + mLineAlign - 1) / mLineAlign;
+  for (uint32_t g = 0; g < numGroups; ++g) {
+    uint32_t y = (mInPlaceBottomUp ? numGroups - 1 - g : g) * mLineAlign;
+    uint32_t groupLines = std::min(mLineAlign, mSrcHeight - y);
+    (mInPlaceHop.get()->*mInPlaceHop->mConvertFn)(frame, tile, y, groupLines);
+
+    uint32_t stagedOffset = 0;
+    for (uint32_t p = 0; p < numDstPlanes; ++p) {
+      uint32_t shift = mDstFmt->isChroma(p) ? mDstFmt->chromaYShift : 0;
+      uint32_t pitch = mDstFmt->pitchBytes(mSrcWidth, p);
+      uint32_t row = y >> shift;
+      uint32_t numRows = ((y + groupLines - 1) >> shift) + 1 - row;
+      const uint8_t *tileRows = mDstFmt->line(tile, mSrcWidth, mLineAlign, p, 0);
+      if (mInPlaceStagedPlanes & (1 << p)) {
+        memcpy(staged + stagedOffset + pitch * row, tileRows, pitch * numRows);
+        stagedOffset += mDstFmt->planeBytes(mSrcWidth, mSrcHeight, p);
+      } else
+        memcpy(mDstFmt->line(frame, mSrcWidth, mSrcHeight, p, y), tileRows, pitch * numRows);
+    }
+  }
+
+  // the staged planes overwrite source that has all been read by now
+  uint32_t stagedOffset = 0;
+  for (uint32_t p = 0; p < numDstPlanes; ++p) {
+    if (mInPlaceStagedPlanes & (1 << p)) {
+      uint32_t planeBytes = mDstFmt->planeBytes(mSrcWidth, mSrcHeight, p);
+      memcpy(frame + mDstFmt->planeOffset(mSrcWidth, mSrcHeight, p), staged + stagedOffset, planeBytes);
+      stagedOffset += planeBytes;
+    }
+  }
+
+  FramePool::instance().release(tile, tileBytes);
+  if (staged)
+    FramePool::instance().release(staged, mInPlaceStagedBytes);
 }
 
 // private
-void Packers::convertYUV422P10toUYVY10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcLumaPitchBytes = mSrcWidth * 2;
-  uint32_t srcChromaPitchBytes = mSrcWidth;
-  uint32_t srcLumaPlaneBytes = srcLumaPitchBytes * mSrcHeight;
-  uint32_t dstPitchBytes = mSrcWidth * 4;
-
-  const uint8_t *srcYLine = srcBuf;
-  const uint8_t *srcULine = srcBuf + srcLumaPlaneBytes;
-  const uint8_t *srcVLine = srcBuf + srcLumaPlaneBytes + srcLumaPlaneBytes / 2;
-  uint8_t *dstLine = dstBuf;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
+void Packers::convertYUV422P10toUYVY10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcLumaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 0);
+  uint32_t srcChromaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 1);
+  uint32_t dstPitchBytes = fmtUYVY10.pitchBytes(mSrcWidth);
+
+  const uint8_t *srcYLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  const uint8_t *srcULine = srcRow(srcBuf, 1, firstLine, firstLine);
+  const uint8_t *srcVLine = srcRow(srcBuf, 2, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
     const uint32_t *srcYInts = (uint32_t *)srcYLine;
     const uint32_t *srcUInts = (uint32_t *)srcULine;
     const uint32_t *srcVInts = (uint32_t *)srcVLine;
     uint32_t *dstInts = (uint32_t *)dstLine;
 
-    for (uint32_t x=0; x<mSrcWidth; x+=4) {
+    uint32_t x = 0;
+    for (; x+4<=mSrcWidth; x+=4) {
       uint32_t y01 = srcYInts[0];
       uint32_t y23 = srcYInts[1];
       uint32_t u01 = srcUInts[0];
@@ -230,6 +674,14 @@ void Packers::convertYUV422P10toUYVY10 (const uint8_t *const srcBuf, uint8_t *co
       dstInts[3] = ((v01 >> 16) & 0xffff) | (y23 & 0xffff0000); // v1 | y3
       dstInts += 4;
     }
+    // a width of 2 mod 4 leaves a single pixel pair, with one sample in each chroma line
+    if (x<mSrcWidth) {
+      uint32_t y01 = srcYInts[0];
+      uint32_t u0 = *(const uint16_t *)srcUInts;
+      uint32_t v0 = *(const uint16_t *)srcVInts;
+      dstInts[0] = u0 | ((y01 << 16) & 0xffff0000); // u0 | y0
+      dstInts[1] = v0 | (y01 & 0xffff0000); // v0 | y1
+    }
 
     srcYLine += srcLumaPitchBytes;
     srcULine += srcChromaPitchBytes;
@@ -238,18 +690,21 @@ void Packers::convertYUV422P10toUYVY10 (const uint8_t *const srcBuf, uint8_t *co
   }  
 }
 
-void Packers::convertPGrouptoUYVY10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = mSrcWidth * 5 / 2;
-  uint32_t dstPitchBytes = mSrcWidth * 4;
+void Packers::convertPGrouptoUYVY10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcPitchBytes = fmtPGroup.pitchBytes(mSrcWidth);
+  uint32_t dstPitchBytes = fmtUYVY10.pitchBytes(mSrcWidth);
 
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstLine = dstBuf;
+  const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
 
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint8_t *srcBytes = srcLine;
-    uint32_t *dstInts = (uint32_t *)dstLine;
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    uint32_t x = 0;
+    if (mLineKernels.pgroupToUYVY10)
+      x = mLineKernels.pgroupToUYVY10(srcLine, dstLine, mSrcWidth);
+    const uint8_t *srcBytes = srcLine + x * 5 / 2;
+    uint32_t *dstInts = (uint32_t *)dstLine + x;
 
-    for (uint32_t x=0; x<mSrcWidth; x+=2) {
+    for (; x<mSrcWidth; x+=2) {
       uint8_t s0 = srcBytes[0];
       uint8_t s1 = srcBytes[1];
       uint8_t s2 = srcBytes[2];
@@ -258,7 +713,7 @@ void Packers::convertPGrouptoUYVY10 (const uint8_t *const srcBuf, uint8_t *const
       srcBytes += 5;
 
       dstInts[0] = ((s0 << 2) | ((s1 & 0xc0) >> 6)) | (((s1 & 0x3f) << 20) | ((s2 & 0xf0) << 12)); // u0 | y0
-      dstInts[1] = (((s2 & 0x0f) << 6) | ((s3 & 0xfc >> 2))) | (((s3 & 0x03) << 24) | (s4 << 16)); // v0 | y1
+      dstInts[1] = (((s2 & 0x0f) << 6) | ((s3 & 0xfc) >> 2)) | (((s3 & 0x03) << 24) | (s4 << 16)); // v0 | y1
       dstInts += 2;
     }
 
@@ -267,25 +722,27 @@ void Packers::convertPGrouptoUYVY10 (const uint8_t *const srcBuf, uint8_t *const
   }  
 }
 
-void Packers::convertPGrouptoYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = mSrcWidth * 5 / 2;
-  uint32_t dstLumaPitchBytes = mSrcWidth * 2;
-  uint32_t dstChromaPitchBytes = mSrcWidth;
-  uint32_t dstLumaPlaneBytes = dstLumaPitchBytes * mSrcHeight;
-
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstYLine = dstBuf;
-  uint8_t *dstULine = dstBuf + dstLumaPlaneBytes;
-  uint8_t *dstVLine = dstBuf + dstLumaPlaneBytes + dstLumaPlaneBytes / 2;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint8_t *srcBytes = srcLine;
-    uint16_t *dstYShorts = (uint16_t *)dstYLine;
-    uint16_t *dstUShorts = (uint16_t *)dstULine;
-    uint16_t *dstVShorts = (uint16_t *)dstVLine;
+void Packers::convertPGrouptoYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcPitchBytes = fmtPGroup.pitchBytes(mSrcWidth);
+  uint32_t dstLumaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 0);
+  uint32_t dstChromaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 1);
+
+  const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  uint8_t *dstYLine = dstRow(dstBuf, 0, firstLine, firstLine);
+  uint8_t *dstULine = dstRow(dstBuf, 1, firstLine, firstLine);
+  uint8_t *dstVLine = dstRow(dstBuf, 2, firstLine, firstLine);
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    uint32_t x = 0;
+    if (mLineKernels.pgroupToYUV422P10)
+      x = mLineKernels.pgroupToYUV422P10(srcLine, (uint16_t *)dstYLine, (uint16_t *)dstULine, (uint16_t *)dstVLine, mSrcWidth);
+    const uint8_t *srcBytes = srcLine + x * 5 / 2;
+    uint16_t *dstYShorts = (uint16_t *)dstYLine + x;
+    uint16_t *dstUShorts = (uint16_t *)dstULine + x / 2;
+    uint16_t *dstVShorts = (uint16_t *)dstVLine + x / 2;
 
     // read 5 source bytes / 2 source pixels at a time
-    for (uint32_t x=0; x<mSrcWidth; x+=2) {
+    for (; x<mSrcWidth; x+=2) {
       uint8_t s0 = srcBytes[0];
       uint8_t s1 = srcBytes[1];
       uint8_t s2 = srcBytes[2];
@@ -300,7 +757,7 @@ void Packers::convertPGrouptoYUV422P10 (const uint8_t *const srcBuf, uint8_t *co
       dstUShorts[0] = (s0 << 2) | ((s1 & 0xc0) >> 6);
       dstUShorts += 1;
 
-      dstVShorts[0] = ((s2 & 0x0f) << 6) | ((s3 & 0xfc >> 2));
+      dstVShorts[0] = ((s2 & 0x0f) << 6) | ((s3 & 0xfc) >> 2);
       dstVShorts += 1;
     }
 
@@ -311,25 +768,28 @@ void Packers::convertPGrouptoYUV422P10 (const uint8_t *const srcBuf, uint8_t *co
   }
 }
 
-void Packers::convertV210toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = ((mSrcWidth + 47) / 48) * 48 * 8 / 3;
-  uint32_t dstLumaPitchBytes = mSrcWidth * 2;
-  uint32_t dstChromaPitchBytes = mSrcWidth;
-  uint32_t dstLumaPlaneBytes = dstLumaPitchBytes * mSrcHeight;
-
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstYLine = dstBuf;
-  uint8_t *dstULine = dstBuf + dstLumaPlaneBytes;
-  uint8_t *dstVLine = dstBuf + dstLumaPlaneBytes + dstLumaPlaneBytes / 2;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    uint32_t *srcInts = (uint32_t *)srcLine;
-    uint32_t *dstYInts = (uint32_t *)dstYLine;
-    uint16_t *dstUShorts = (uint16_t *)dstULine;
-    uint16_t *dstVShorts = (uint16_t *)dstVLine;
+void Packers::convertV210toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcPitchBytes = fmtV210.pitchBytes(mSrcWidth);
+  uint32_t dstLumaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 0);
+  uint32_t dstChromaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 1);
+
+  const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  uint8_t *dstYLine = dstRow(dstBuf, 0, firstLine, firstLine);
+  uint8_t *dstULine = dstRow(dstBuf, 1, firstLine, firstLine);
+  uint8_t *dstVLine = dstRow(dstBuf, 2, firstLine, firstLine);
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    // x counts blocks of 6 pixels
+    uint32_t x = 0;
+    if (mLineKernels.v210ToYUV422P10)
+      x = mLineKernels.v210ToYUV422P10(srcLine, (uint16_t *)dstYLine, (uint16_t *)dstULine, (uint16_t *)dstVLine, mSrcWidth) / 6;
+    uint32_t *srcInts = (uint32_t *)srcLine + x * 4;
+    uint32_t *dstYInts = (uint32_t *)dstYLine + x * 3;
+    uint16_t *dstUShorts = (uint16_t *)dstULine + x * 3;
+    uint16_t *dstVShorts = (uint16_t *)dstVLine + x * 3;
 
     // read 4 source 32-bit ints / 6 source pixels at a time
-    for (uint32_t x=0; x<mSrcWidth/6; ++x) {
+    for (; x<mSrcWidth/6; ++x) {
       uint32_t s0 = srcInts[0];
       uint32_t s1 = srcInts[1];
       uint32_t s2 = srcInts[2];
@@ -380,144 +840,21 @@ void Packers::convertV210toYUV422P10 (const uint8_t *const srcBuf, uint8_t *cons
   }
 }
 
-void Packers::convertPGroupto420P (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = mSrcWidth * 5 / 2;
-  uint32_t dstLumaPitchBytes = mSrcWidth;
-  uint32_t dstChromaPitchBytes = mSrcWidth / 2;
-  uint32_t dstLumaPlaneBytes = mSrcWidth * mSrcHeight;
-
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstYLine = dstBuf;
-  uint8_t *dstULine = dstBuf + dstLumaPlaneBytes;
-  uint8_t *dstVLine = dstBuf + dstLumaPlaneBytes + dstLumaPlaneBytes / 4;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint8_t *srcBytes = srcLine;
-    uint8_t *dstYBytes = dstYLine;
-    uint8_t *dstUBytes = dstULine;
-    uint8_t *dstVBytes = dstVLine;
-    bool evenLine = (y & 1) == 0;
-
-    // read 5 source bytes / 2 source pixels at a time
-    for (uint32_t x=0; x<mSrcWidth; x+=2) {
-      uint8_t s0 = srcBytes[0];
-      uint8_t s1 = srcBytes[1];
-      uint8_t s2 = srcBytes[2];
-      uint8_t s3 = srcBytes[3];
-      uint8_t s4 = srcBytes[4];
-      srcBytes += 5;
-
-      dstYBytes[0] = ((s1 & 0x3f) << 2) | ((s2 & 0xc0) >> 6);      
-      dstYBytes[1] = ((s3 & 0x03) << 6) | ((s4 & 0xfc) >> 2);      
-      dstYBytes += 2;
-
-      // chroma interp between lines
-      dstUBytes[0] = evenLine ? s0 : (s0 + dstUBytes[0]) >> 1;
-      dstUBytes += 1;
-      uint32_t v0 = ((s2 & 0x0f) << 4) | ((s3 & 0xf0) >> 4);
-      dstVBytes[0] = evenLine ? v0 : (v0 + dstVBytes[0]) >> 1;
-      dstVBytes += 1;
-    }
-
-    srcLine += srcPitchBytes;
-    dstYLine += dstLumaPitchBytes; 
-    if (!evenLine) {
-      dstULine += dstChromaPitchBytes;
-      dstVLine += dstChromaPitchBytes;
-    } 
-  }
-}
-
-void Packers::convertV210to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = ((mSrcWidth + 47) / 48) * 48 * 8 / 3;
-  uint32_t dstLumaPitchBytes = mSrcWidth;
-  uint32_t dstChromaPitchBytes = mSrcWidth / 2;
-  uint32_t dstLumaPlaneBytes = mSrcWidth * mSrcHeight;
-
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstYLine = dstBuf;
-  uint8_t *dstULine = dstBuf + dstLumaPlaneBytes;
-  uint8_t *dstVLine = dstBuf + dstLumaPlaneBytes + dstLumaPlaneBytes / 4;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    uint32_t *srcInts = (uint32_t *)srcLine;
-    uint8_t *dstYBytes = dstYLine;
-    uint8_t *dstUBytes = dstULine;
-    uint8_t *dstVBytes = dstVLine;
-    bool evenLine = (y & 1) == 0;
-
-    // read 4 source ints / 6 source pixels at a time
-    for (uint32_t x=0; x<mSrcWidth/6; ++x) {
-      uint32_t s0 = srcInts[0];
-      uint32_t s1 = srcInts[1];
-      uint32_t s2 = srcInts[2];
-      uint32_t s3 = srcInts[3];
-      srcInts += 4;
-
-      dstYBytes[0] = (s0 >> 12) & 0xff;
-      dstYBytes[1] = (s1 >>  2) & 0xff;
-      dstYBytes[2] = (s1 >> 22) & 0xff;
-      dstYBytes[3] = (s2 >> 12) & 0xff;
-      dstYBytes[4] = (s3 >>  2) & 0xff;
-      dstYBytes[5] = (s3 >> 22) & 0xff;
-      dstYBytes += 6;
-
-      dstUBytes[0] = evenLine ? ((s0 >>  2) & 0xff) : (((s0 >>  2) & 0xff) + dstUBytes[0]) >> 1;
-      dstUBytes[1] = evenLine ? ((s1 >> 12) & 0xff) : (((s1 >> 12) & 0xff) + dstUBytes[1]) >> 1;
-      dstUBytes[2] = evenLine ? ((s2 >> 22) & 0xff) : (((s2 >> 22) & 0xff) + dstUBytes[2]) >> 1;
-      dstUBytes += 3;
-
-      dstVBytes[0] = evenLine ? ((s0 >> 22) & 0xff) : (((s0 >> 22) & 0xff) + dstVBytes[0]) >> 1;
-      dstVBytes[1] = evenLine ? ((s2 >>  2) & 0xff) : (((s2 >>  2) & 0xff) + dstVBytes[1]) >> 1;
-      dstVBytes[2] = evenLine ? ((s3 >> 12) & 0xff) : (((s3 >> 12) & 0xff) + dstVBytes[2]) >> 1;
-      dstVBytes += 3;
-    }
-
-    uint32_t remain = mSrcWidth%6;
-    if (remain) {
-      uint32_t s0 = srcInts[0];
-      uint32_t s1 = srcInts[1];
-      uint32_t s2 = 0;
-      if (4==remain)
-        s2 = srcInts[2];
-
-      dstYBytes[0] = (s0 >> 12) & 0xff;
-      dstYBytes[1] = (s1 >>  2) & 0xff;
-      if (4==remain) {
-        dstYBytes[2] = (s1 >> 22) & 0xff;
-        dstYBytes[3] = (s2 >> 12) & 0xff;
-      }      
-
-      dstUBytes[0] = evenLine ? ((s0 >>  2) & 0xff) : (((s0 >>  2) & 0xff) + dstUBytes[0]) >> 1;
-      if (4==remain)
-        dstUBytes[1] = evenLine ? ((s1 >> 12) & 0xff) : (((s1 >> 12) & 0xff) + dstUBytes[1]) >> 1;
-
-      dstVBytes[0] = evenLine ? ((s0 >> 22) & 0xff) : (((s0 >> 22) & 0xff) + dstVBytes[0]) >> 1;
-      if (4==remain)
-        dstVBytes[1] = evenLine ? ((s2 >>  2) & 0xff) : (((s2 >>  2) & 0xff) + dstVBytes[1]) >> 1;
-    }
-
-    srcLine += srcPitchBytes;
-    dstYLine += dstLumaPitchBytes; 
-    if (!evenLine) {
-      dstULine += dstChromaPitchBytes;
-      dstVLine += dstChromaPitchBytes;
-    } 
-  }
-}
-
-void Packers::convertUYVY10toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = mSrcWidth * 4;
-  uint32_t dstPitchBytes = mSrcWidth * 5 / 2;
+void Packers::convertUYVY10toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcPitchBytes = fmtUYVY10.pitchBytes(mSrcWidth);
+  uint32_t dstPitchBytes = fmtPGroup.pitchBytes(mSrcWidth);
 
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstLine = dstBuf;
+  const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
 
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint32_t *srcInts = (uint32_t *)srcLine;
-    uint8_t *dstBytes = dstLine;
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    uint32_t x = 0;
+    if (mLineKernels.uyvy10ToPGroup)
+      x = mLineKernels.uyvy10ToPGroup(srcLine, dstLine, mSrcWidth);
+    const uint32_t *srcInts = (uint32_t *)srcLine + x;
+    uint8_t *dstBytes = dstLine + x * 5 / 2;
 
-    for (uint32_t x=0; x<mSrcWidth; x+=2) {
+    for (; x<mSrcWidth; x+=2) {
       uint32_t s0 = srcInts[0]; // u0 | y0
       uint32_t s1 = srcInts[1]; // v0 | y1
       srcInts += 2;
@@ -535,24 +872,24 @@ void Packers::convertUYVY10toPGroup (const uint8_t *const srcBuf, uint8_t *const
   }  
 }
 
-void Packers::convertUYVY10toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = mSrcWidth * 4;
-  uint32_t dstLumaPitchBytes = mSrcWidth * 2;
-  uint32_t dstChromaPitchBytes = mSrcWidth;
-  uint32_t dstLumaPlaneBytes = dstLumaPitchBytes * mSrcHeight;
+void Packers::convertUYVY10toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcPitchBytes = fmtUYVY10.pitchBytes(mSrcWidth);
+  uint32_t dstLumaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 0);
+  uint32_t dstChromaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 1);
 
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstYLine = dstBuf;
-  uint8_t *dstULine = dstBuf + dstLumaPlaneBytes;
-  uint8_t *dstVLine = dstBuf + dstLumaPlaneBytes + dstLumaPlaneBytes / 2;
+  const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  uint8_t *dstYLine = dstRow(dstBuf, 0, firstLine, firstLine);
+  uint8_t *dstULine = dstRow(dstBuf, 1, firstLine, firstLine);
+  uint8_t *dstVLine = dstRow(dstBuf, 2, firstLine, firstLine);
 
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
     const uint32_t *srcInts = (uint32_t *)srcLine;
     uint32_t *dstYInts = (uint32_t *)dstYLine;
     uint32_t *dstUInts = (uint32_t *)dstULine;
     uint32_t *dstVInts = (uint32_t *)dstVLine;
 
-    for (uint32_t x=0; x<mSrcWidth; x+=4) {
+    uint32_t x = 0;
+    for (; x+4<=mSrcWidth; x+=4) {
       uint32_t s0 = srcInts[0]; // u0 | y0
       uint32_t s1 = srcInts[1]; // v0 | y1
       uint32_t s2 = srcInts[2]; // u1 | y2
@@ -567,6 +904,14 @@ void Packers::convertUYVY10toYUV422P10 (const uint8_t *const srcBuf, uint8_t *co
       dstUInts += 1;
       dstVInts += 1;
     }
+    // a width of 2 mod 4 leaves a single pixel pair
+    if (x<mSrcWidth) {
+      uint32_t s0 = srcInts[0]; // u0 | y0
+      uint32_t s1 = srcInts[1]; // v0 | y1
+      dstYInts[0] = ((s0 & 0x3ff0000) >> 16) | (s1 & 0x3ff0000);
+      *(uint16_t *)dstUInts = s0 & 0x3ff;
+      *(uint16_t *)dstVInts = s1 & 0x3ff;
+    }
 
     srcLine += srcPitchBytes;
     dstYLine += dstLumaPitchBytes;
@@ -575,117 +920,168 @@ void Packers::convertUYVY10toYUV422P10 (const uint8_t *const srcBuf, uint8_t *co
   }  
 }
 
-void Packers::convertUYVY10to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = mSrcWidth * 4;
-  uint32_t dstLumaPitchBytes = mSrcWidth;
-  uint32_t dstChromaPitchBytes = mSrcWidth / 2;
-  uint32_t dstLumaPlaneBytes = dstLumaPitchBytes * mSrcHeight;
-
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstYLine = dstBuf;
-  uint8_t *dstULine = dstBuf + dstLumaPlaneBytes;
-  uint8_t *dstVLine = dstBuf + dstLumaPlaneBytes + dstLumaPlaneBytes / 4;
+// Bias added before the 10-bit to 8-bit shift, repeating every 8 samples. Rounding adds half of the step, and the
+// ordered dither spreads the bias across the step in a pattern that alternates from line to line.
+static const uint16_t roundBias10To8[2][8] = {
+  { 2, 2, 2, 2, 2, 2, 2, 2 }, // single line, >> 2
+  { 4, 4, 4, 4, 4, 4, 4, 4 }  // line pair, >> 3
+};
+static const uint16_t ditherBias10To8[2][2][8] = {
+  { { 0, 2, 0, 2, 0, 2, 0, 2 }, { 3, 1, 3, 1, 3, 1, 3, 1 } },
+  { { 0, 4, 2, 6, 1, 5, 3, 7 }, { 6, 2, 4, 0, 7, 3, 5, 1 } }
+};
+
+static inline void line10To8 (const PackerLineKernels &kernels, const uint16_t *src, uint8_t *dst, uint32_t width, const uint16_t *bias) {
+  uint32_t x = 0;
+  if (kernels.line10To8)
+    x = kernels.line10To8(src, dst, width, bias);
+  for (; x < width; ++x) {
+    uint32_t s = ((src[x] & 0x3ff) + bias[x & 7]) >> 2;
+    dst[x] = s > 0xff ? 0xff : s;
+  }
+}
 
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint32_t *srcInts = (uint32_t *)srcLine;
-    uint8_t *dstYBytes = dstYLine;
-    uint8_t *dstUBytes = dstULine;
-    uint8_t *dstVBytes = dstVLine;
-    bool evenLine = (y & 1) == 0;
+static inline void linePair10To8 (const PackerLineKernels &kernels, const uint16_t *srcA, const uint16_t *srcB, uint8_t *dst, uint32_t width, const uint16_t *bias) {
+  uint32_t x = 0;
+  if (kernels.linePair10To8)
+    x = kernels.linePair10To8(srcA, srcB, dst, width, bias);
+  for (; x < width; ++x) {
+    uint32_t s = ((srcA[x] & 0x3ff) + (srcB[x] & 0x3ff) + bias[x & 7]) >> 3;
+    dst[x] = s > 0xff ? 0xff : s;
+  }
+}
 
-    for (uint32_t x=0; x<mSrcWidth; x+=2) {
-      uint32_t s0 = srcInts[0]; // u0 | y0
-      uint32_t s1 = srcInts[1]; // v0 | y1
-      srcInts += 2;
+// The lines making each chroma line of the group of lines from y, returning the number of lines in the group.
+// With field chroma, each group of 4 lines makes a chroma line from each field - lines 0 and 2, then 1 and 3.
+// A last odd line makes its own chroma.
+static uint32_t chromaLineGroup(uint32_t y, uint32_t endLine, bool fieldChroma, uint32_t pairs[2][2], uint32_t &numPairs) {
+  if (fieldChroma && (y + 4 <= endLine)) {
+    pairs[0][0] = y; pairs[0][1] = y + 2;
+    pairs[1][0] = y + 1; pairs[1][1] = y + 3;
+    numPairs = 2;
+    return 4;
+  }
+  numPairs = 1;
+  pairs[0][0] = y;
+  pairs[0][1] = (y + 2 <= endLine) ? y + 1 : y;
+  return pairs[0][1] - y + 1;
+}
 
-      dstYBytes[0] = (s0 & 0x3fc0000) >> 18;
-      dstYBytes[1] = (s1 & 0x3fc0000) >> 18;
+// Works through the band a chroma line pair at a time, producing all three planes while the source lines are in
+// cache. Chroma lines are averaged with rounding, rather than each output line being read back to average the next.
+// With field chroma, each group of 4 lines makes a chroma line from each field - lines 0 and 2, then 1 and 3.
+void Packers::convertYUV422P10to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  // source pitches are in 16-bit samples
+  uint32_t srcLumaPitch = fmtYUV422P10.pitchBytes(mSrcWidth, 0) / 2;
+  uint32_t srcChromaPitch = fmtYUV422P10.pitchBytes(mSrcWidth, 1) / 2;
+  uint32_t dstLumaPitchBytes = fmt420P.pitchBytes(mSrcWidth, 0);
+  uint32_t dstChromaPitchBytes = fmt420P.pitchBytes(mSrcWidth, 1);
+
+  // the lines of the band, indexed from its first line
+  const uint16_t *srcY = (const uint16_t *)srcRow(srcBuf, 0, firstLine, firstLine);
+  const uint16_t *srcU = (const uint16_t *)srcRow(srcBuf, 1, firstLine, firstLine);
+  const uint16_t *srcV = (const uint16_t *)srcRow(srcBuf, 2, firstLine, firstLine);
+  uint8_t *dstY = dstRow(dstBuf, 0, firstLine, firstLine);
+  uint8_t *dstU = dstRow(dstBuf, 1, firstLine, firstLine);
+  uint8_t *dstV = dstRow(dstBuf, 2, firstLine, firstLine);
+
+  const bool fieldChroma = mInterlaced && mFieldChroma;
+  const uint32_t endLine = firstLine + numLines;
+  uint32_t y = firstLine;
+  while (y < endLine) {
+    uint32_t pairs[2][2];
+    uint32_t numPairs;
+    uint32_t groupLines = chromaLineGroup(y, endLine, fieldChroma, pairs, numPairs);
+
+    for (uint32_t l = y; l < y + groupLines; ++l) {
+      const uint16_t *lumaBias = mDither ? ditherBias10To8[0][l & 1] : roundBias10To8[0];
+      line10To8(mLineKernels, srcY + srcLumaPitch * (l - firstLine), dstY + dstLumaPitchBytes * (l - firstLine), mSrcWidth, lumaBias);
+      // the alpha plane is reduced like luma
+      if (mHasAlpha)
+        line10To8(mLineKernels, (const uint16_t *)srcRow(srcBuf, fmtYUV422P10.numPlanes, firstLine, l),
+                  dstRow(dstBuf, fmt420P.numPlanes, firstLine, l), mSrcWidth, lumaBias);
+    }
 
-      dstUBytes[0] = evenLine ? ((s0 & 0x3fc) >> 2) : (((s0 & 0x3fc) >> 2) + dstUBytes[0]) >> 1;
-      dstVBytes[0] = evenLine ? ((s1 & 0x3fc) >> 2) : (((s1 & 0x3fc) >> 2) + dstVBytes[0]) >> 1;
-      dstYBytes += 2;
-      dstUBytes += 1;
-      dstVBytes += 1;
+    for (uint32_t p = 0; p < numPairs; ++p) {
+      uint32_t a = pairs[p][0] - firstLine;
+      uint32_t b = pairs[p][1] - firstLine;
+      uint32_t c = (y / 2) + p;
+      const uint16_t *chromaBias = mDither ? ditherBias10To8[1][c & 1] : roundBias10To8[1];
+      c -= firstLine / 2;
+      linePair10To8(mLineKernels, srcU + srcChromaPitch * a, srcU + srcChromaPitch * b, 
+                    dstU + dstChromaPitchBytes * c, mSrcWidth / 2, chromaBias);
+      linePair10To8(mLineKernels, srcV + srcChromaPitch * a, srcV + srcChromaPitch * b, 
+                    dstV + dstChromaPitchBytes * c, mSrcWidth / 2, chromaBias);
     }
 
-    srcLine += srcPitchBytes;
-    dstYLine += dstLumaPitchBytes;
-    if (!evenLine) {
-      dstULine += dstChromaPitchBytes;
-      dstVLine += dstChromaPitchBytes;
-    } 
-  }  
+    y += groupLines;
+  }
 }
 
-void Packers::convertYUV422P10to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcLumaPitchBytes = mSrcWidth * 2;
-  uint32_t srcChromaPitchBytes = mSrcWidth;
-  uint32_t srcLumaPlaneBytes = srcLumaPitchBytes * mSrcHeight;
-  uint32_t srcChromaPlaneBytes = srcChromaPitchBytes * mSrcHeight;
-
-  uint32_t dstLumaPitchBytes = mSrcWidth;
-  uint32_t dstChromaPitchBytes = mSrcWidth / 2;
-  uint32_t dstLumaPlaneBytes = dstLumaPitchBytes * mSrcHeight;
-  uint32_t dstChromaPlaneBytes = dstChromaPitchBytes * mSrcHeight / 2;
-
-  const uint8_t *srcLine[3];
-  srcLine[0] = srcBuf;
-  srcLine[1] = srcBuf + srcLumaPlaneBytes;
-  srcLine[2] = srcBuf + srcLumaPlaneBytes + srcChromaPlaneBytes;
-
-  uint8_t *dstLine[3];
-  dstLine[0] = dstBuf;
-  dstLine[1] = dstBuf + dstLumaPlaneBytes;
-  dstLine[2] = dstBuf + dstLumaPlaneBytes + dstChromaPlaneBytes;
-
-  for (uint32_t p=0; p<3; ++p) {
-    for (uint32_t y=0; y<mSrcHeight; ++y) {
-      bool evenLine = (y & 1) == 0;
-      const uint32_t *srcL = (const uint32_t *)srcLine[p];
-      const uint16_t *srcC = (const uint16_t *)srcLine[p];
-      uint16_t *dstL = (uint16_t *)dstLine[p];
-      uint8_t *dstC = dstLine[p];
-      
-      if (0==p) {
-        for (uint32_t x=0; x < mSrcWidth / 2; ++x) {
-          uint32_t lum01 = *srcL++;
-          *dstL++ = ((lum01 & 0x3fc) >> 2) | ((lum01 & 0x3fc0000) >> 10);
-        }
-      } else if (evenLine) {
-        for (uint32_t x=0; x < mSrcWidth / 2; ++x)
-          *dstC++ = (*srcC++ & 0x3fc) >> 2;
-      } else {
-        for (uint32_t x=0; x < mSrcWidth / 2; ++x) {
-          uint8_t chr = *dstC;
-          *dstC++ = (((*srcC++ & 0x3fc) >> 2) + chr) >> 1;
-        }
+// Reduces a format with line access to 420P with the rounding, dither and field chroma of convertYUV422P10to420P,
+// unpacking a tile of each line of a chroma line group at a time. The tile is a whole number of blocks of the source
+// format and of the 8 sample bias pattern.
+template <class SrcLines>
+void Packers::convertLinesTo420P (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  const uint32_t tilePixels = 384;
+  uint16_t tileY[4][tilePixels];
+  uint16_t tileU[4][tilePixels / 2];
+  uint16_t tileV[4][tilePixels / 2];
+
+  const bool fieldChroma = mInterlaced && mFieldChroma;
+  const uint32_t endLine = firstLine + numLines;
+  uint32_t y = firstLine;
+  while (y < endLine) {
+    uint32_t pairs[2][2];
+    uint32_t numPairs;
+    uint32_t groupLines = chromaLineGroup(y, endLine, fieldChroma, pairs, numPairs);
+
+    for (uint32_t x=0; x<mSrcWidth; x+=tilePixels) {
+      uint32_t n = std::min(tilePixels, mSrcWidth - x);
+      for (uint32_t l = 0; l < groupLines; ++l) {
+        const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, y + l);
+        uint32_t done = SrcLines::unpackKernel(mLineKernels, &srcLine, x, n, tileY[l], tileU[l], tileV[l]);
+        if (done < n)
+          SrcLines::unpack(&srcLine, x + done, n - done, tileY[l] + done, tileU[l] + done / 2, tileV[l] + done / 2);
+
+        const uint16_t *lumaBias = mDither ? ditherBias10To8[0][(y + l) & 1] : roundBias10To8[0];
+        line10To8(mLineKernels, tileY[l], dstRow(dstBuf, 0, firstLine, y + l) + x, n, lumaBias);
       }
 
-      srcLine[p] += (0==p) ? srcLumaPitchBytes : srcChromaPitchBytes;
-      if ((0==p) || !evenLine)
-        dstLine[p] += (0==p) ? dstLumaPitchBytes : dstChromaPitchBytes;
+      for (uint32_t p = 0; p < numPairs; ++p) {
+        uint32_t a = pairs[p][0] - y;
+        uint32_t b = pairs[p][1] - y;
+        const uint16_t *chromaBias = mDither ? ditherBias10To8[1][((y / 2) + p) & 1] : roundBias10To8[1];
+        // the destination chroma line made by the pair, which is y / 2 + p whether or not the pair is split by field
+        linePair10To8(mLineKernels, tileU[a], tileU[b], dstRow(dstBuf, 1, firstLine, y + 2 * p) + x / 2, n / 2, chromaBias);
+        linePair10To8(mLineKernels, tileV[a], tileV[b], dstRow(dstBuf, 2, firstLine, y + 2 * p) + x / 2, n / 2, chromaBias);
+      }
     }
+
+    y += groupLines;
   }
 }
 
-void Packers::convertYUV422P10toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcLumaPitchBytes = mSrcWidth * 2;
-  uint32_t srcChromaPitchBytes = mSrcWidth;
-  uint32_t srcLumaPlaneBytes = srcLumaPitchBytes * mSrcHeight;
-  uint32_t dstPitchBytes = mSrcWidth * 5 / 2;
-
-  const uint8_t *srcYLine = srcBuf;
-  const uint8_t *srcULine = srcBuf + srcLumaPlaneBytes;
-  const uint8_t *srcVLine = srcBuf + srcLumaPlaneBytes + srcLumaPlaneBytes / 2;
-  uint8_t *dstLine = dstBuf;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint32_t *srcYInts = (uint32_t *)srcYLine;
-    const uint16_t *srcUShorts = (uint16_t *)srcULine;
-    const uint16_t *srcVShorts = (uint16_t *)srcVLine;
-    uint8_t *dstBytes = (uint8_t *)dstLine;
-
-    for (uint32_t x=0; x<mSrcWidth; x+=2) {
+void Packers::convertYUV422P10toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcLumaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 0);
+  uint32_t srcChromaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 1);
+  uint32_t dstPitchBytes = fmtPGroup.pitchBytes(mSrcWidth);
+
+  const uint8_t *srcYLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  const uint8_t *srcULine = srcRow(srcBuf, 1, firstLine, firstLine);
+  const uint8_t *srcVLine = srcRow(srcBuf, 2, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    uint32_t x = 0;
+    if (mLineKernels.yuv422P10ToPGroup)
+      x = mLineKernels.yuv422P10ToPGroup((const uint16_t *)srcYLine, (const uint16_t *)srcULine, (const uint16_t *)srcVLine, dstLine, mSrcWidth);
+    const uint32_t *srcYInts = (uint32_t *)srcYLine + x / 2;
+    const uint16_t *srcUShorts = (uint16_t *)srcULine + x / 2;
+    const uint16_t *srcVShorts = (uint16_t *)srcVLine + x / 2;
+    uint8_t *dstBytes = (uint8_t *)dstLine + x * 5 / 2;
+
+    for (; x<mSrcWidth; x+=2) {
       uint32_t y01 = srcYInts[0];
       uint16_t u0 = srcUShorts[0];
       uint16_t v0 = srcVShorts[0];
@@ -708,30 +1104,32 @@ void Packers::convertYUV422P10toPGroup (const uint8_t *const srcBuf, uint8_t *co
   }  
 }
 
-void Packers::convert420PtoPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcLumaPitchBytes = mSrcWidth;
-  uint32_t srcChromaPitchBytes = mSrcWidth / 2;
-  uint32_t srcLumaPlaneBytes = srcLumaPitchBytes * mSrcHeight;
-  uint32_t dstPitchBytes = mSrcWidth * 5 / 2;
-
-  const uint8_t *srcYLine = srcBuf;
-  const uint8_t *srcULine = srcBuf + srcLumaPlaneBytes;
-  const uint8_t *srcVLine = srcBuf + srcLumaPlaneBytes + srcLumaPlaneBytes / 4;
-  uint8_t *dstLine = dstBuf;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint8_t *srcYBytes = srcYLine;
-    const uint8_t *srcUBytes = srcULine;
-    const uint8_t *srcVBytes = srcVLine;
-    uint8_t *dstBytes = (uint8_t *)dstLine;
-    bool evenLine = (y & 1) == 0;
+void Packers::convert420PtoPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcLumaPitchBytes = fmt420P.pitchBytes(mSrcWidth, 0);
+  uint32_t srcChromaPitchBytes = fmt420P.pitchBytes(mSrcWidth, 1);
+  uint32_t dstPitchBytes = fmtPGroup.pitchBytes(mSrcWidth);
 
-    for (uint32_t x=0; x<mSrcWidth; x+=2) {
+  const uint8_t *srcYLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  const uint8_t *srcULine = srcRow(srcBuf, 1, firstLine, firstLine);
+  const uint8_t *srcVLine = srcRow(srcBuf, 2, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    bool evenLine = (y & 1) == 0;
+    uint32_t x = 0;
+    if (mLineKernels.yuv420PToPGroup)
+      x = mLineKernels.yuv420PToPGroup(srcYLine, srcULine, srcVLine, dstLine, mSrcWidth);
+    const uint8_t *srcYBytes = srcYLine + x;
+    const uint8_t *srcUBytes = srcULine + x / 2;
+    const uint8_t *srcVBytes = srcVLine + x / 2;
+    uint8_t *dstBytes = (uint8_t *)dstLine + x * 5 / 2;
+
+    for (; x<mSrcWidth; x+=2) {
       uint8_t y0 = srcYBytes[0];
       uint8_t y1 = srcYBytes[1];
       uint8_t u0 = srcUBytes[0];
       uint8_t v0 = srcVBytes[0];
-      srcYBytes++;
+      srcYBytes += 2;
       srcUBytes++;
       srcVBytes++;
 
@@ -752,24 +1150,27 @@ void Packers::convert420PtoPGroup (const uint8_t *const srcBuf, uint8_t *const d
   }  
 }
 
-void Packers::convertYUV422P10toV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcLumaPitchBytes = mSrcWidth * 2;
-  uint32_t srcChromaPitchBytes = mSrcWidth;
-  uint32_t srcLumaPlaneBytes = srcLumaPitchBytes * mSrcHeight;
-  uint32_t dstPitchBytes = ((mSrcWidth + 47) / 48) * 48 * 8 / 3;
-
-  const uint8_t *srcYLine = srcBuf;
-  const uint8_t *srcULine = srcBuf + srcLumaPlaneBytes;
-  const uint8_t *srcVLine = srcBuf + srcLumaPlaneBytes + srcLumaPlaneBytes / 2;
-  uint8_t *dstLine = dstBuf;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint32_t *srcYInts = (uint32_t *)srcYLine;
-    const uint16_t *srcUShorts = (uint16_t *)srcULine;
-    const uint16_t *srcVShorts = (uint16_t *)srcVLine;
-    uint32_t *dstInts = (uint32_t *)dstLine;
-
-    for (uint32_t x=0; x<mSrcWidth/6; ++x) {
+void Packers::convertYUV422P10toV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcLumaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 0);
+  uint32_t srcChromaPitchBytes = fmtYUV422P10.pitchBytes(mSrcWidth, 1);
+  uint32_t dstPitchBytes = fmtV210.pitchBytes(mSrcWidth);
+
+  const uint8_t *srcYLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  const uint8_t *srcULine = srcRow(srcBuf, 1, firstLine, firstLine);
+  const uint8_t *srcVLine = srcRow(srcBuf, 2, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    // x counts blocks of 6 pixels
+    uint32_t x = 0;
+    if (mLineKernels.yuv422P10ToV210)
+      x = mLineKernels.yuv422P10ToV210((const uint16_t *)srcYLine, (const uint16_t *)srcULine, (const uint16_t *)srcVLine, dstLine, mSrcWidth) / 6;
+    const uint32_t *srcYInts = (uint32_t *)srcYLine + x * 3;
+    const uint16_t *srcUShorts = (uint16_t *)srcULine + x * 3;
+    const uint16_t *srcVShorts = (uint16_t *)srcVLine + x * 3;
+    uint32_t *dstInts = (uint32_t *)dstLine + x * 4;
+
+    for (; x<mSrcWidth/6; ++x) {
       uint32_t y01 = srcYInts[0];
       uint32_t y23 = srcYInts[1];
       uint32_t y45 = srcYInts[2];
@@ -820,25 +1221,28 @@ void Packers::convertYUV422P10toV210 (const uint8_t *const srcBuf, uint8_t *cons
   }  
 }
 
-void Packers::convert420PtoV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcLumaPitchBytes = mSrcWidth;
-  uint32_t srcChromaPitchBytes = mSrcWidth / 2;
-  uint32_t srcLumaPlaneBytes = srcLumaPitchBytes * mSrcHeight;
-  uint32_t dstPitchBytes = ((mSrcWidth + 47) / 48) * 48 * 8 / 3;
-
-  const uint8_t *srcYLine = srcBuf;
-  const uint8_t *srcULine = srcBuf + srcLumaPlaneBytes;
-  const uint8_t *srcVLine = srcBuf + srcLumaPlaneBytes + srcLumaPlaneBytes / 4;
-  uint8_t *dstLine = dstBuf;
-
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint8_t *srcYBytes = srcYLine;
-    const uint8_t *srcUBytes = srcULine;
-    const uint8_t *srcVBytes = srcVLine;
-    uint32_t *dstInts = (uint32_t *)dstLine;
-    bool evenLine = (y & 1) == 0;
+void Packers::convert420PtoV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcLumaPitchBytes = fmt420P.pitchBytes(mSrcWidth, 0);
+  uint32_t srcChromaPitchBytes = fmt420P.pitchBytes(mSrcWidth, 1);
+  uint32_t dstPitchBytes = fmtV210.pitchBytes(mSrcWidth);
+
+  const uint8_t *srcYLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  const uint8_t *srcULine = srcRow(srcBuf, 1, firstLine, firstLine);
+  const uint8_t *srcVLine = srcRow(srcBuf, 2, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
 
-    for (uint32_t x=0; x<mSrcWidth/6; ++x) {
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    bool evenLine = (y & 1) == 0;
+    // x counts blocks of 6 pixels
+    uint32_t x = 0;
+    if (mLineKernels.yuv420PToV210)
+      x = mLineKernels.yuv420PToV210(srcYLine, srcULine, srcVLine, dstLine, mSrcWidth) / 6;
+    const uint8_t *srcYBytes = srcYLine + x * 6;
+    const uint8_t *srcUBytes = srcULine + x * 3;
+    const uint8_t *srcVBytes = srcVLine + x * 3;
+    uint32_t *dstInts = (uint32_t *)dstLine + x * 4;
+
+    for (; x<mSrcWidth/6; ++x) {
       uint8_t y0 = srcYBytes[0];
       uint8_t y1 = srcYBytes[1];
       uint8_t y2 = srcYBytes[2];
@@ -897,18 +1301,22 @@ void Packers::convert420PtoV210 (const uint8_t *const srcBuf, uint8_t *const dst
   }  
 }
 
-void Packers::convertPGrouptoV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = mSrcWidth * 5 / 2;
-  uint32_t dstPitchBytes = ((mSrcWidth + 47) / 48) * 48 * 8 / 3;
+void Packers::convertPGrouptoV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcPitchBytes = fmtPGroup.pitchBytes(mSrcWidth);
+  uint32_t dstPitchBytes = fmtV210.pitchBytes(mSrcWidth);
 
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstLine = dstBuf;
+  const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
 
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint8_t *srcBytes = srcLine;
-    uint32_t *dstInts = (uint32_t *)dstLine;
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    // x counts blocks of 6 pixels
+    uint32_t x = 0;
+    if (mLineKernels.pgroupToV210)
+      x = mLineKernels.pgroupToV210(srcLine, dstLine, mSrcWidth) / 6;
+    const uint8_t *srcBytes = srcLine + x * 15;
+    uint32_t *dstInts = (uint32_t *)dstLine + x * 4;
 
-    for (uint32_t x=0; x<mSrcWidth/6; ++x) {
+    for (; x<mSrcWidth/6; ++x) {
       uint8_t s0 = srcBytes[0];
       uint8_t s1 = srcBytes[1];
       uint8_t s2 = srcBytes[2];
@@ -971,18 +1379,22 @@ void Packers::convertPGrouptoV210 (const uint8_t *const srcBuf, uint8_t *const d
   }
 }
 
-void Packers::convertV210toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  uint32_t srcPitchBytes = ((mSrcWidth + 47) / 48) * 48 * 8 / 3;
-  uint32_t dstPitchBytes = mSrcWidth * 5 / 2;
+void Packers::convertV210toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  uint32_t srcPitchBytes = fmtV210.pitchBytes(mSrcWidth);
+  uint32_t dstPitchBytes = fmtPGroup.pitchBytes(mSrcWidth);
 
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstLine = dstBuf;
+  const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  uint8_t *dstLine = dstRow(dstBuf, 0, firstLine, firstLine);
 
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
-    const uint32_t *srcInts = (uint32_t *)srcLine;
-    uint8_t *dstBytes = dstLine;
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    // x counts blocks of 6 pixels
+    uint32_t x = 0;
+    if (mLineKernels.v210ToPGroup)
+      x = mLineKernels.v210ToPGroup(srcLine, dstLine, mSrcWidth) / 6;
+    const uint32_t *srcInts = (uint32_t *)srcLine + x * 4;
+    uint8_t *dstBytes = dstLine + x * 15;
 
-    for (uint32_t x=0; x<mSrcWidth/6; ++x) {
+    for (; x<mSrcWidth/6; ++x) {
       uint32_t s0 = srcInts[0]; // v0 | y0 | u0
       uint32_t s1 = srcInts[1]; // y2 | u1 | y1
       uint32_t s2 = srcInts[2]; // u2 | y3 | v1
@@ -1037,18 +1449,17 @@ void Packers::convertV210toPGroup (const uint8_t *const srcBuf, uint8_t *const d
   }
 }
 
-void Packers::convertBGR10AtoGBRP16 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {
-  bool doByteSwap = (mSrcFmtCode.find("BS") != std::string::npos);
-  uint32_t srcPitchBytes = mSrcWidth * 4;
-  uint32_t dstPitchBytes = mSrcWidth * 2;
-  uint32_t dstPlaneBytes = dstPitchBytes * mSrcHeight;
+void Packers::convertBGR10AtoGBRP16 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  bool doByteSwap = mSrcFmt->bigEndian;
+  uint32_t srcPitchBytes = fmtBGR10A.pitchBytes(mSrcWidth);
+  uint32_t dstPitchBytes = fmtGBRP16.pitchBytes(mSrcWidth);
   
-  const uint8_t *srcLine = srcBuf;
-  uint8_t *dstGLine = dstBuf;
-  uint8_t *dstBLine = dstBuf + dstPlaneBytes;
-  uint8_t *dstRLine = dstBuf + dstPlaneBytes * 2;
+  const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, firstLine);
+  uint8_t *dstGLine = dstRow(dstBuf, 0, firstLine, firstLine);
+  uint8_t *dstBLine = dstRow(dstBuf, 1, firstLine, firstLine);
+  uint8_t *dstRLine = dstRow(dstBuf, 2, firstLine, firstLine);
 
-  for (uint32_t y=0; y<mSrcHeight; ++y) {
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
     const uint32_t *srcInts = (uint32_t *)srcLine;
     uint16_t *dstGShorts = (uint16_t *)dstGLine;
     uint16_t *dstBShorts = (uint16_t *)dstBLine;
@@ -1077,4 +1488,252 @@ void Packers::convertBGR10AtoGBRP16 (const uint8_t *const srcBuf, uint8_t *const
   }
 }
 
+void Packers::convertYUV422P10toY210 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    const uint16_t *srcY = (const uint16_t *)srcRow(srcBuf, 0, firstLine, y);
+    const uint16_t *srcU = (const uint16_t *)srcRow(srcBuf, 1, firstLine, y);
+    const uint16_t *srcV = (const uint16_t *)srcRow(srcBuf, 2, firstLine, y);
+    uint16_t *dst = (uint16_t *)dstRow(dstBuf, 0, firstLine, y);
+
+    uint32_t x = 0;
+    if (mLineKernels.yuv422P10ToY210)
+      x = mLineKernels.yuv422P10ToY210(srcY, srcU, srcV, dst, mSrcWidth);
+    for (; x<mSrcWidth; x+=2) {
+      dst[x * 2] = srcY[x] << 6;
+      dst[x * 2 + 1] = srcU[x / 2] << 6;
+      dst[x * 2 + 2] = srcY[x + 1] << 6;
+      dst[x * 2 + 3] = srcV[x / 2] << 6;
+    }
+  }
+}
+
+void Packers::convertY210toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    const uint16_t *src = (const uint16_t *)srcRow(srcBuf, 0, firstLine, y);
+    uint16_t *dstY = (uint16_t *)dstRow(dstBuf, 0, firstLine, y);
+    uint16_t *dstU = (uint16_t *)dstRow(dstBuf, 1, firstLine, y);
+    uint16_t *dstV = (uint16_t *)dstRow(dstBuf, 2, firstLine, y);
+
+    uint32_t x = 0;
+    if (mLineKernels.y210ToYUV422P10)
+      x = mLineKernels.y210ToYUV422P10(src, dstY, dstU, dstV, mSrcWidth);
+    for (; x<mSrcWidth; x+=2) {
+      dstY[x] = src[x * 2] >> 6;
+      dstU[x / 2] = src[x * 2 + 1] >> 6;
+      dstY[x + 1] = src[x * 2 + 2] >> 6;
+      dstV[x / 2] = src[x * 2 + 3] >> 6;
+    }
+  }
+}
+
+// v410 is 4:4:4, so each chroma sample is repeated for the pixel pair it covers
+void Packers::convertYUV422P10toV410 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    const uint16_t *srcY = (const uint16_t *)srcRow(srcBuf, 0, firstLine, y);
+    const uint16_t *srcU = (const uint16_t *)srcRow(srcBuf, 1, firstLine, y);
+    const uint16_t *srcV = (const uint16_t *)srcRow(srcBuf, 2, firstLine, y);
+    uint32_t *dst = (uint32_t *)dstRow(dstBuf, 0, firstLine, y);
+
+    uint32_t x = 0;
+    if (mLineKernels.yuv422P10ToV410)
+      x = mLineKernels.yuv422P10ToV410(srcY, srcU, srcV, dst, mSrcWidth);
+    for (; x<mSrcWidth; ++x)
+      dst[x] = ((srcV[x / 2] & 0x3ff) << 22) | ((srcY[x] & 0x3ff) << 12) | ((srcU[x / 2] & 0x3ff) << 2);
+  }
+}
+
+// each pixel pair's chroma is averaged with rounding
+void Packers::convertV410toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    const uint32_t *src = (const uint32_t *)srcRow(srcBuf, 0, firstLine, y);
+    uint16_t *dstY = (uint16_t *)dstRow(dstBuf, 0, firstLine, y);
+    uint16_t *dstU = (uint16_t *)dstRow(dstBuf, 1, firstLine, y);
+    uint16_t *dstV = (uint16_t *)dstRow(dstBuf, 2, firstLine, y);
+
+    uint32_t x = 0;
+    if (mLineKernels.v410ToYUV422P10)
+      x = mLineKernels.v410ToYUV422P10(src, dstY, dstU, dstV, mSrcWidth);
+    for (; x<mSrcWidth; x+=2) {
+      uint32_t s0 = src[x];
+      uint32_t s1 = src[x + 1];
+      dstY[x] = (s0 >> 12) & 0x3ff;
+      dstY[x + 1] = (s1 >> 12) & 0x3ff;
+      dstU[x / 2] = (((s0 >> 2) & 0x3ff) + ((s1 >> 2) & 0x3ff) + 1) >> 1;
+      dstV[x / 2] = ((s0 >> 22) + (s1 >> 22) + 1) >> 1;
+    }
+  }
+}
+
+static inline void line10ToP010 (const PackerLineKernels &kernels, const uint16_t *src, uint16_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  if (kernels.line10ToP010)
+    x = kernels.line10ToP010(src, dst, width);
+  for (; x < width; ++x)
+    dst[x] = src[x] << 6;
+}
+
+// Works through the band a chroma line pair at a time like the 4:2:0 down-conversion, with the pairs of chroma lines
+// averaged with rounding into interleaved 10-bit chroma.
+void Packers::convertYUV422P10toP010 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  const bool fieldChroma = mInterlaced && mFieldChroma;
+  const uint32_t chromaWidth = mSrcWidth / 2;
+  const uint32_t endLine = firstLine + numLines;
+  uint32_t y = firstLine;
+  while (y < endLine) {
+    uint32_t pairs[2][2];
+    uint32_t numPairs;
+    uint32_t groupLines = chromaLineGroup(y, endLine, fieldChroma, pairs, numPairs);
+
+    for (uint32_t l = y; l < y + groupLines; ++l)
+      line10ToP010(mLineKernels, (const uint16_t *)srcRow(srcBuf, 0, firstLine, l), (uint16_t *)dstRow(dstBuf, 0, firstLine, l), mSrcWidth);
+
+    for (uint32_t p = 0; p < numPairs; ++p) {
+      const uint16_t *srcUA = (const uint16_t *)srcRow(srcBuf, 1, firstLine, pairs[p][0]);
+      const uint16_t *srcUB = (const uint16_t *)srcRow(srcBuf, 1, firstLine, pairs[p][1]);
+      const uint16_t *srcVA = (const uint16_t *)srcRow(srcBuf, 2, firstLine, pairs[p][0]);
+      const uint16_t *srcVB = (const uint16_t *)srcRow(srcBuf, 2, firstLine, pairs[p][1]);
+      // the destination chroma line made by the pair, which is y / 2 + p whether or not the pair is split by field
+      uint16_t *dstUV = (uint16_t *)dstRow(dstBuf, 1, firstLine, y + 2 * p);
+
+      uint32_t x = 0;
+      if (mLineKernels.linePairsToP010UV)
+        x = mLineKernels.linePairsToP010UV(srcUA, srcUB, srcVA, srcVB, dstUV, chromaWidth);
+      for (; x < chromaWidth; ++x) {
+        dstUV[x * 2] = (((srcUA[x] & 0x3ff) + (srcUB[x] & 0x3ff) + 1) >> 1) << 6;
+        dstUV[x * 2 + 1] = (((srcVA[x] & 0x3ff) + (srcVB[x] & 0x3ff) + 1) >> 1) << 6;
+      }
+    }
+
+    y += groupLines;
+  }
+}
+
+// each P010 chroma line is repeated for the pair of lines it covers, as for 420P
+void Packers::convertP010toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  const uint32_t chromaWidth = mSrcWidth / 2;
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    const uint16_t *srcY = (const uint16_t *)srcRow(srcBuf, 0, firstLine, y);
+    const uint16_t *srcUV = (const uint16_t *)srcRow(srcBuf, 1, firstLine, y);
+    uint16_t *dstY = (uint16_t *)dstRow(dstBuf, 0, firstLine, y);
+    uint16_t *dstU = (uint16_t *)dstRow(dstBuf, 1, firstLine, y);
+    uint16_t *dstV = (uint16_t *)dstRow(dstBuf, 2, firstLine, y);
+
+    uint32_t x = 0;
+    if (mLineKernels.lineP010To10)
+      x = mLineKernels.lineP010To10(srcY, dstY, mSrcWidth);
+    for (; x<mSrcWidth; ++x)
+      dstY[x] = srcY[x] >> 6;
+
+    x = 0;
+    if (mLineKernels.p010UVToLines)
+      x = mLineKernels.p010UVToLines(srcUV, dstU, dstV, chromaWidth);
+    for (; x<chromaWidth; ++x) {
+      dstU[x] = srcUV[x * 2] >> 6;
+      dstV[x] = srcUV[x * 2 + 1] >> 6;
+    }
+  }
+}
+
+// NV12 is 420P with the chroma planes interleaved, so each chroma line is moved once, by the first line of its pair
+void Packers::convert420PtoNV12 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  const uint32_t chromaWidth = mSrcWidth / 2;
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    memcpy(dstRow(dstBuf, 0, firstLine, y), srcRow(srcBuf, 0, firstLine, y), mSrcWidth);
+    if ((y & 1) && (y != firstLine))
+      continue;
+
+    const uint8_t *srcU = srcRow(srcBuf, 1, firstLine, y);
+    const uint8_t *srcV = srcRow(srcBuf, 2, firstLine, y);
+    uint8_t *dstUV = dstRow(dstBuf, 1, firstLine, y);
+    uint32_t x = 0;
+    if (mLineKernels.interleaveUV8)
+      x = mLineKernels.interleaveUV8(srcU, srcV, dstUV, chromaWidth);
+    for (; x<chromaWidth; ++x) {
+      dstUV[x * 2] = srcU[x];
+      dstUV[x * 2 + 1] = srcV[x];
+    }
+  }
+}
+
+void Packers::convertNV12to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  const uint32_t chromaWidth = mSrcWidth / 2;
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    memcpy(dstRow(dstBuf, 0, firstLine, y), srcRow(srcBuf, 0, firstLine, y), mSrcWidth);
+    if ((y & 1) && (y != firstLine))
+      continue;
+
+    const uint8_t *srcUV = srcRow(srcBuf, 1, firstLine, y);
+    uint8_t *dstU = dstRow(dstBuf, 1, firstLine, y);
+    uint8_t *dstV = dstRow(dstBuf, 2, firstLine, y);
+    uint32_t x = 0;
+    if (mLineKernels.deinterleaveUV8)
+      x = mLineKernels.deinterleaveUV8(srcUV, dstU, dstV, chromaWidth);
+    for (; x<chromaWidth; ++x) {
+      dstU[x] = srcUV[x * 2];
+      dstV[x] = srcUV[x * 2 + 1];
+    }
+  }
+}
+
+// The components of pixel x of an RGB line, and its alpha scaled to 10 bits.
+// BGR10-A words hold a 2-bit alpha in bits 0-1, then 10-bit blue, green and red.
+static inline void rgbPixel(const uint8_t *line, uint32_t x, bool tenBit, bool bgr, bool byteSwap,
+                            int32_t &r, int32_t &g, int32_t &b, uint16_t &a) {
+  if (tenBit) {
+    uint32_t s = ((const uint32_t *)line)[x];
+    if (byteSwap)
+      s = (s >> 24) | ((s >> 8) & 0xff00) | ((s << 8) & 0xff0000) | (s << 24);
+    b = (s >> 2) & 0x3ff;
+    g = (s >> 12) & 0x3ff;
+    r = s >> 22;
+    a = (s & 3) * 0x155;
+  } else {
+    const uint8_t *p = line + x * 4;
+    r = p[bgr ? 2 : 0];
+    g = p[1];
+    b = p[bgr ? 0 : 2];
+    a = (p[3] << 2) | (p[3] >> 6);
+  }
+}
+
+// Full range RGBA8, BGRA8 and BGR10-A to limited range YUV422P10, with the matrix chosen by the colorimetry
+// and the chroma of each pixel pair averaged. With alpha, the key goes to the alpha plane.
+void Packers::convertRGBtoYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {
+  const bool tenBit = (10 == mSrcFmt->bitDepth);
+  const bool bgr = (mSrcFmt == &fmtBGRA8);
+  const bool byteSwap = mSrcFmt->bigEndian;
+  const RgbToYuvCoeffs &k = mRgbCoeffs;
+  const int32_t lumaOffset = (64 << 13) + (1 << 12);
+  const int32_t chromaOffset = (512 << 13) + (1 << 12);
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
+    const uint8_t *srcLine = srcRow(srcBuf, 0, firstLine, y);
+    uint16_t *dstY = (uint16_t *)dstRow(dstBuf, 0, firstLine, y);
+    uint16_t *dstU = (uint16_t *)dstRow(dstBuf, 1, firstLine, y);
+    uint16_t *dstV = (uint16_t *)dstRow(dstBuf, 2, firstLine, y);
+    uint16_t *dstA = mHasAlpha ? (uint16_t *)dstRow(dstBuf, fmtYUV422P10.numPlanes, firstLine, y) : NULL;
+
+    uint32_t x = 0;
+    if (tenBit && mLineKernels.bgr10AToYUV422P10)
+      x = mLineKernels.bgr10AToYUV422P10(srcLine, dstY, dstU, dstV, dstA, mSrcWidth, k, byteSwap);
+    else if (!tenBit && mLineKernels.rgba8ToYUV422P10)
+      x = mLineKernels.rgba8ToYUV422P10(srcLine, dstY, dstU, dstV, dstA, mSrcWidth, k, bgr);
+
+    for (; x<mSrcWidth; x+=2) {
+      int32_t r0, g0, b0, r1, g1, b1;
+      uint16_t a0, a1;
+      rgbPixel(srcLine, x, tenBit, bgr, byteSwap, r0, g0, b0, a0);
+      rgbPixel(srcLine, x + 1, tenBit, bgr, byteSwap, r1, g1, b1, a1);
+      dstY[x] = (k.yR * r0 + k.yG * g0 + k.yB * b0 + lumaOffset) >> 13;
+      dstY[x + 1] = (k.yR * r1 + k.yG * g1 + k.yB * b1 + lumaOffset) >> 13;
+      dstU[x / 2] = (k.uR * (r0 + r1) + k.uG * (g0 + g1) + k.uB * (b0 + b1) + chromaOffset) >> 13;
+      dstV[x / 2] = (k.vR * (r0 + r1) + k.vG * (g0 + g1) + k.vB * (b0 + b1) + chromaOffset) >> 13;
+      if (dstA) {
+        dstA[x] = a0;
+        dstA[x + 1] = a1;
+      }
+    }
+  }
+}
+
 } // namespace streampunk
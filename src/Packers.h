@@ -17,48 +17,162 @@
 #define PACKERS_H
 
 #include <memory>
-#include <functional>
+#include <vector>
 #include "iProcess.h"
+#include "PackersSimd.h"
+#include "PackerFormats.h"
 
 namespace streampunk {
 
 class Memory;
 class Packers {
 public:
-  Packers(uint32_t srcWidth, uint32_t srcHeight, const std::string& srcFmtCode, const std::string& dstFmtCode);
+  // fieldChroma builds 4:2:0 chroma from line pairs within each field of an interlaced source, and dither replaces
+  // rounding with an ordered dither when reducing 10-bit sources to 8-bit 4:2:0. colorimetry chooses the matrix for
+  // RGB sources, and hasAlpha carries their alpha to the alpha plane of the destination.
+  Packers(uint32_t srcWidth, uint32_t srcHeight, const std::string& srcFmtCode, const std::string& dstFmtCode,
+          bool interlaced = false, uint32_t numThreads = 1, bool fieldChroma = false, bool dither = false,
+          const std::string& colorimetry = "BT709-2", bool hasAlpha = false);
 
   void convert(std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) const;
 
+  // Converts only the lines from firstLine, so that a frame can be converted a band at a time as its lines arrive.
+  // firstLine and numLines must be multiples of lineAlign(), except that a range may end at the bottom of the frame.
+  void convertRange(std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertRange(const uint8_t *srcBuf, uint8_t *dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  uint32_t lineAlign() const { return mLineAlign; }
+
+  // Converts a frame in place, in a buffer large enough for the source or the destination. Lines are converted a group
+  // at a time into a staging tile and then written back, top down or bottom up so that no source line is overwritten
+  // before it has been read. Destination planes that would overwrite unread source are staged whole and written at
+  // the end. Only direct conversions can be made in place, and they run on one thread to keep the order.
+  bool canConvertInPlace() const { return mInPlaceHop != NULL; }
+  void convertInPlace(std::shared_ptr<Memory> buf) const;
+
+  // A converter whose convertRange writes the lines from firstLine to a tile laid out as a frame of tileLines lines,
+  // so that a consumer can take the converted frame a band at a time without a full size destination. Returns NULL
+  // unless the conversion is direct. The converter runs on the calling thread.
+  std::shared_ptr<Packers> tileConverter(uint32_t tileLines) const;
+
 private:
-  typedef std::function<void(const Packers&, const uint8_t *const, uint8_t *const)> tConvertFn;
-  void convertNotSupported (const uint8_t *const srcBuf, uint8_t *const dstBuf) const {}
-
-  void convertPGrouptoUYVY10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertYUV422P10toUYVY10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertPGrouptoYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertV210toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertPGroupto420P (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertV210to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-
-  void convertUYVY10toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertUYVY10toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertUYVY10to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertYUV422P10to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertYUV422P10toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convert420PtoPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertYUV422P10toV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convert420PtoV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-
-  void convertPGrouptoV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-  void convertV210toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
-
-  void convertBGR10AtoGBRP16 (const uint8_t *const srcBuf, uint8_t *const dstBuf) const;
+  typedef void (Packers::*tConvertFn)(const uint8_t *const, uint8_t *const, uint32_t, uint32_t) const;
+  struct Conversion {
+    const FormatDesc *src;
+    const FormatDesc *dst;
+    tConvertFn fn;
+    uint32_t cost;
+    bool alpha; // carries the alpha through
+  };
+  static std::vector<Conversion> planConversion(const FormatDesc *srcFmt, const FormatDesc *dstFmt, const PackerLineKernels &kernels,
+                                                bool alpha);
+
+  // a hop of a planned conversion, with a source or destination that is a tile of lines rather than a whole frame
+  Packers(const Packers &parent, const Conversion &conversion, uint32_t srcTileLines, uint32_t dstTileLines);
+
+  void convertHops (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+
+  // the destination planes that must be staged whole to convert in place in the given direction
+  uint32_t inPlaceStagedPlanes(bool bottomUp) const;
+
+  // The start of line y of a plane of the source or destination, in a call converting lines from firstLine.
+  // A tile holds the lines from firstLine on, in a buffer laid out as a frame of the tile's height.
+  const uint8_t *srcRow(const uint8_t *buf, uint32_t plane, uint32_t firstLine, uint32_t y) const {
+    return mSrcTileLines ? mSrcFmt->line(buf, mSrcWidth, mSrcTileLines, plane, y - firstLine) : mSrcFmt->line(buf, mSrcWidth, mSrcHeight, plane, y);
+  }
+  uint8_t *dstRow(uint8_t *buf, uint32_t plane, uint32_t firstLine, uint32_t y) const {
+    return mDstTileLines ? mDstFmt->line(buf, mSrcWidth, mDstTileLines, plane, y - firstLine) : mDstFmt->line(buf, mSrcWidth, mSrcHeight, plane, y);
+  }
+
+  void convertNotSupported (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const {}
+
+  void convertPGrouptoUYVY10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertYUV422P10toUYVY10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertPGrouptoYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertV210toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+
+  void convertUYVY10toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertUYVY10toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertYUV422P10to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertYUV422P10toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convert420PtoPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertYUV422P10toV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convert420PtoV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+
+  void convertPGrouptoV210 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertV210toPGroup (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+
+  void convertYUV422P10toY210 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertY210toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertYUV422P10toV410 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertV410toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertYUV422P10toP010 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertP010toYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convert420PtoNV12 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertNV12to420P (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+
+  void convertBGR10AtoGBRP16 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  void convertRGBtoYUV422P10 (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+
+  // generated from the line access of a pair of formats, for the conversions with no function of their own
+  template <class SrcLines, class DstLines>
+  void convertLines (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
+  // and the reduction of those formats to 420P
+  template <class SrcLines>
+  void convertLinesTo420P (const uint8_t *const srcBuf, uint8_t *const dstBuf, uint32_t firstLine, uint32_t numLines) const;
 
   const uint32_t mSrcWidth;
   const uint32_t mSrcHeight;
   const std::string mSrcFmtCode;
   const std::string mDstFmtCode;
-  mutable tConvertFn mConvertFn;
+  const FormatDesc *const mSrcFmt;
+  const FormatDesc *const mDstFmt;
+  const bool mInterlaced;
+  const uint32_t mNumThreads;
+  const bool mFieldChroma;
+  const bool mDither;
+  const bool mHasAlpha;
+  const RgbToYuvCoeffs mRgbCoeffs;
+  tConvertFn mConvertFn;
+  const PackerLineKernels &mLineKernels;
+  const uint32_t mSrcTileLines;
+  const uint32_t mDstTileLines;
+  uint32_t mLineAlign;
+
+  // the hops of a conversion with no single function, run a tile of lines at a time so that the intermediate
+  // formats stay in cache
+  std::vector<std::shared_ptr<Packers> > mHops;
+  uint32_t mTileLines;
+  uint32_t mTileBytes;
+
+  // a direct conversion writing a staging tile of mLineAlign lines, for conversion in place
+  std::shared_ptr<Packers> mInPlaceHop;
+  bool mInPlaceBottomUp;
+  uint32_t mInPlaceStagedPlanes;
+  uint32_t mInPlaceStagedBytes;
+};
+
+// Converts a source frame to several destination formats at once. The frame is worked through a tile of lines at a
+// time, with each tile converted to every destination in turn, so the source is read from memory once and the later
+// conversions of each tile read it from cache.
+class MultiPackers {
+public:
+  MultiPackers(uint32_t srcWidth, uint32_t srcHeight, const std::string& srcFmtCode, const std::vector<std::string>& dstFmtCodes,
+               bool interlaced = false, uint32_t numThreads = 1, bool fieldChroma = false, bool dither = false,
+               const std::string& colorimetry = "BT709-2", bool hasAlpha = false);
+
+  void convert(std::shared_ptr<Memory> srcBuf, const std::vector<std::shared_ptr<Memory> >& dstBufs) const;
+
+  uint32_t numDsts() const { return (uint32_t)mPackers.size(); }
+
+private:
+  void convertTiles(std::shared_ptr<Memory> srcBuf, const std::vector<std::shared_ptr<Memory> >& dstBufs,
+                    uint32_t firstLine, uint32_t numLines) const;
+
+  const uint32_t mSrcHeight;
+  const uint32_t mNumThreads;
+  std::vector<std::shared_ptr<Packers> > mPackers;
+  uint32_t mLineAlign;
+  uint32_t mTileLines;
 };
 
 uint32_t getFormatBytes(const std::string& fmtCode, uint32_t width, uint32_t height, bool hasAlpha = false);
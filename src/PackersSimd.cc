@@ -0,0 +1,730 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include "PackersSimd.h"
+#include "CpuFeatures.h"
+
+#include <cstring>
+
+#ifdef CODECADON_X86
+#include <immintrin.h>
+#endif
+
+namespace streampunk {
+
+#ifdef CODECADON_X86
+
+// pgroup packs 2 pixels into 5 bytes as big-endian 10-bit u0, y0, v0, y1
+
+// Unpacks the 2 pgroups in the bottom 10 bytes of s to 16-bit u0, y0, v0, y1, u1, y2, v1, y3.
+// Each component is gathered into a big-endian word with the bytes it spans, multiplied so that the component
+// finishes at the top of the word, dropping the bits above it, and shifted down.
+CODECADON_TARGET("ssse3")
+static inline __m128i unpackPGroups(__m128i s) {
+  const __m128i gather = _mm_setr_epi8(1, 0, 2, 1, 3, 2, 4, 3, 6, 5, 7, 6, 8, 7, 9, 8);
+  const __m128i align = _mm_setr_epi16(1, 4, 16, 64, 1, 4, 16, 64);
+  return _mm_srli_epi16(_mm_mullo_epi16(_mm_shuffle_epi8(s, gather), align), 6);
+}
+
+// Packs 16-bit u0, y0, v0, y1, u1, y2, v1, y3 into 2 pgroups in the bottom 10 bytes of the result.
+CODECADON_TARGET("ssse3")
+static inline __m128i packPGroups(__m128i c) {
+  c = _mm_and_si128(c, _mm_set1_epi16(0x3ff));
+  // u0y0, v0y1, u1y2, v1y3 as 20-bit pairs
+  __m128i pairs = _mm_madd_epi16(c, _mm_setr_epi16(1024, 1, 1024, 1, 1024, 1, 1024, 1));
+  // u0y0v0y1 in the bottom 40 bits of each 64-bit lane
+  __m128i groups = _mm_or_si128(_mm_slli_epi64(pairs, 20), _mm_srli_epi64(pairs, 32));
+  const __m128i bigEndian = _mm_setr_epi8(4, 3, 2, 1, 0, 12, 11, 10, 9, 8, -1, -1, -1, -1, -1, -1);
+  return _mm_shuffle_epi8(groups, bigEndian);
+}
+
+// Stores the 10 bytes at the bottom of each of 4 registers as 40 contiguous bytes.
+CODECADON_TARGET("ssse3")
+static inline void storePGroups(uint8_t *dst, __m128i p0, __m128i p1, __m128i p2, __m128i p3) {
+  _mm_storeu_si128((__m128i *)dst, _mm_or_si128(p0, _mm_slli_si128(p1, 10)));
+  _mm_storeu_si128((__m128i *)(dst + 16),
+    _mm_or_si128(_mm_or_si128(_mm_srli_si128(p1, 6), _mm_slli_si128(p2, 4)), _mm_slli_si128(p3, 14)));
+  _mm_storel_epi64((__m128i *)(dst + 32), _mm_srli_si128(p3, 2));
+}
+
+// Interleaves 16 luma and 8 of each chroma into the component order of 8 pgroups.
+CODECADON_TARGET("ssse3")
+static inline void packPlanar(uint8_t *dst, __m128i y0, __m128i y1, __m128i u, __m128i v) {
+  __m128i uvLo = _mm_unpacklo_epi16(u, v);
+  __m128i uvHi = _mm_unpackhi_epi16(u, v);
+  storePGroups(dst, packPGroups(_mm_unpacklo_epi16(uvLo, y0)), packPGroups(_mm_unpackhi_epi16(uvLo, y0)),
+                    packPGroups(_mm_unpacklo_epi16(uvHi, y1)), packPGroups(_mm_unpackhi_epi16(uvHi, y1)));
+}
+
+// Separates unpacked pgroups a and b into 8 luma and chroma u0..u3 in the bottom half, v0..v3 in the top.
+CODECADON_TARGET("ssse3")
+static inline void splitPlanar(__m128i a, __m128i b, __m128i &y, __m128i &uv) {
+  const __m128i lumaLo = _mm_setr_epi8(2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 8, 9, 4, 5, 12, 13);
+  a = _mm_shuffle_epi8(a, lumaLo);
+  b = _mm_shuffle_epi8(b, lumaLo);
+  y = _mm_unpacklo_epi64(a, b);
+  uv = _mm_shuffle_epi32(_mm_unpackhi_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+CODECADON_TARGET("ssse3")
+static inline __m128i loadPGroups(const uint8_t *src) {
+  return unpackPGroups(_mm_loadu_si128((const __m128i *)src));
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t pgroupToUYVY10_SSSE3(const uint8_t *src, uint8_t *dst, uint32_t width) {
+  uint32_t srcBytes = width * 5 / 2;
+  uint32_t x = 0;
+  // 4 pixels from each 16 byte load of 10 pgroup bytes
+  for (; (x + 4 <= width) && (x * 5 / 2 + 16 <= srcBytes); x += 4)
+    _mm_storeu_si128((__m128i *)(dst + x * 4), loadPGroups(src + x * 5 / 2));
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t pgroupToYUV422P10_SSSE3(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width) {
+  uint32_t srcBytes = width * 5 / 2;
+  uint32_t x = 0;
+  for (; (x + 8 <= width) && (x * 5 / 2 + 26 <= srcBytes); x += 8) {
+    const uint8_t *s = src + x * 5 / 2;
+    __m128i y, uv;
+    splitPlanar(loadPGroups(s), loadPGroups(s + 10), y, uv);
+    _mm_storeu_si128((__m128i *)(dstY + x), y);
+    _mm_storel_epi64((__m128i *)(dstU + x / 2), uv);
+    _mm_storel_epi64((__m128i *)(dstV + x / 2), _mm_srli_si128(uv, 8));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t uyvy10ToPGroup_SSSE3(const uint8_t *src, uint8_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    const __m128i *s = (const __m128i *)(src + x * 4);
+    storePGroups(dst + x * 5 / 2, packPGroups(_mm_loadu_si128(s)), packPGroups(_mm_loadu_si128(s + 1)),
+                                  packPGroups(_mm_loadu_si128(s + 2)), packPGroups(_mm_loadu_si128(s + 3)));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t yuv422P10ToPGroup_SSSE3(const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV, uint8_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16)
+    packPlanar(dst + x * 5 / 2, _mm_loadu_si128((const __m128i *)(srcY + x)), _mm_loadu_si128((const __m128i *)(srcY + x + 8)),
+               _mm_loadu_si128((const __m128i *)(srcU + x / 2)), _mm_loadu_si128((const __m128i *)(srcV + x / 2)));
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t yuv420PToPGroup_SSSE3(const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV, uint8_t *dst, uint32_t width) {
+  const __m128i zero = _mm_setzero_si128();
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i y = _mm_loadu_si128((const __m128i *)(srcY + x));
+    __m128i u = _mm_loadl_epi64((const __m128i *)(srcU + x / 2));
+    __m128i v = _mm_loadl_epi64((const __m128i *)(srcV + x / 2));
+    packPlanar(dst + x * 5 / 2, _mm_slli_epi16(_mm_unpacklo_epi8(y, zero), 2), _mm_slli_epi16(_mm_unpackhi_epi8(y, zero), 2),
+               _mm_slli_epi16(_mm_unpacklo_epi8(u, zero), 2), _mm_slli_epi16(_mm_unpacklo_epi8(v, zero), 2));
+  }
+  return x;
+}
+
+// v210 packs 6 pixels into 4 little-endian words, each of 3 10-bit components from the bottom up -
+// cb0 y0 cr0, y1 cb1 y2, cr1 y3 cb2, y4 cr2 y5
+
+CODECADON_TARGET("ssse3")
+static inline __m128i load12(const uint8_t *src) {
+  int32_t top;
+  memcpy(&top, src + 8, 4);
+  return _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)src), _mm_cvtsi32_si128(top));
+}
+
+CODECADON_TARGET("ssse3")
+static inline void store12(uint8_t *dst, __m128i v) {
+  _mm_storel_epi64((__m128i *)dst, v);
+  int32_t top = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+  memcpy(dst + 8, &top, 4);
+}
+
+// Unpacks a v210 block to 16-bit luma in words 0-5 and chroma u0-u2 in words 0-2, v0-v2 in words 4-6.
+// Unused words are zero.
+CODECADON_TARGET("ssse3")
+static inline void unpackV210(__m128i d, __m128i &y, __m128i &uv) {
+  const __m128i mask = _mm_set1_epi32(0x3ff);
+  // the first two components of each word - cb0 y0, y1 cb1, cr1 y3, y4 cr2
+  __m128i ab = _mm_or_si128(_mm_and_si128(d, mask), _mm_and_si128(_mm_slli_epi32(d, 6), _mm_set1_epi32(0x3ff0000)));
+  // the third - cr0, y2, cb2, y5
+  __m128i c = _mm_and_si128(_mm_srli_epi32(d, 20), mask);
+  y = _mm_or_si128(_mm_shuffle_epi8(ab, _mm_setr_epi8(2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1)),
+                   _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1)));
+  uv = _mm_or_si128(_mm_shuffle_epi8(ab, _mm_setr_epi8(0, 1, 6, 7, -1, -1, -1, -1, -1, -1, 8, 9, 14, 15, -1, -1)),
+                    _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, 8, 9, -1, -1, 0, 1, -1, -1, -1, -1, -1, -1)));
+}
+
+// Packs luma in words 0-5 and chroma u0-u2 in words 0-2, v0-v2 in words 4-6 into a v210 block.
+CODECADON_TARGET("ssse3")
+static inline __m128i packV210(__m128i y, __m128i uv) {
+  const __m128i mask = _mm_set1_epi16(0x3ff);
+  y = _mm_and_si128(y, mask);
+  uv = _mm_and_si128(uv, mask);
+  __m128i ab = _mm_or_si128(_mm_shuffle_epi8(y, _mm_setr_epi8(-1, -1, 0, 1, 2, 3, -1, -1, -1, -1, 6, 7, 8, 9, -1, -1)),
+                            _mm_shuffle_epi8(uv, _mm_setr_epi8(0, 1, -1, -1, -1, -1, 2, 3, 10, 11, -1, -1, -1, -1, 12, 13)));
+  __m128i c = _mm_or_si128(_mm_shuffle_epi8(y, _mm_setr_epi8(-1, -1, -1, -1, 4, 5, -1, -1, -1, -1, -1, -1, 10, 11, -1, -1)),
+                           _mm_shuffle_epi8(uv, _mm_setr_epi8(8, 9, -1, -1, -1, -1, -1, -1, 4, 5, -1, -1, -1, -1, -1, -1)));
+  return _mm_or_si128(_mm_madd_epi16(ab, _mm_setr_epi16(1, 1024, 1, 1024, 1, 1024, 1, 1024)), _mm_slli_epi32(c, 20));
+}
+
+// Joins the components in words 0-2 of t0..t3, whose other words are zero, into 8 words in lo and 4 in hi.
+CODECADON_TARGET("ssse3")
+static inline void joinTriples(__m128i t0, __m128i t1, __m128i t2, __m128i t3, __m128i &lo, __m128i &hi) {
+  lo = _mm_or_si128(_mm_or_si128(t0, _mm_slli_si128(t1, 6)), _mm_slli_si128(t2, 12));
+  hi = _mm_or_si128(_mm_srli_si128(t2, 4), _mm_slli_si128(t3, 2));
+}
+
+// Unpacks the 24 pixels of 4 v210 blocks to luma in y0..y2, chroma in u0, v0 (8 each) and u1, v1 (4 each).
+CODECADON_TARGET("ssse3")
+static inline void unpackV210x4(const uint8_t *src, __m128i &y0, __m128i &y1, __m128i &y2,
+                                __m128i &u0, __m128i &u1, __m128i &v0, __m128i &v1) {
+  __m128i y[4], uv[4];
+  for (uint32_t i = 0; i < 4; ++i)
+    unpackV210(_mm_loadu_si128((const __m128i *)src + i), y[i], uv[i]);
+  y0 = _mm_or_si128(y[0], _mm_slli_si128(y[1], 12));
+  y1 = _mm_or_si128(_mm_srli_si128(y[1], 4), _mm_slli_si128(y[2], 8));
+  y2 = _mm_or_si128(_mm_srli_si128(y[2], 8), _mm_slli_si128(y[3], 4));
+  joinTriples(_mm_move_epi64(uv[0]), _mm_move_epi64(uv[1]), _mm_move_epi64(uv[2]), _mm_move_epi64(uv[3]), u0, u1);
+  joinTriples(_mm_srli_si128(uv[0], 8), _mm_srli_si128(uv[1], 8), _mm_srli_si128(uv[2], 8), _mm_srli_si128(uv[3], 8), v0, v1);
+}
+
+// Packs 24 pixels, laid out as unpackV210x4 leaves them, into 4 v210 blocks.
+CODECADON_TARGET("ssse3")
+static inline void packV210x4(uint8_t *dst, __m128i y0, __m128i y1, __m128i y2,
+                              __m128i u0, __m128i u1, __m128i v0, __m128i v1) {
+  __m128i *d = (__m128i *)dst;
+  _mm_storeu_si128(d, packV210(y0, _mm_unpacklo_epi64(u0, v0)));
+  _mm_storeu_si128(d + 1, packV210(_mm_or_si128(_mm_srli_si128(y0, 12), _mm_slli_si128(y1, 4)),
+                                   _mm_unpacklo_epi64(_mm_srli_si128(u0, 6), _mm_srli_si128(v0, 6))));
+  __m128i u2 = _mm_or_si128(_mm_srli_si128(u0, 12), _mm_slli_si128(u1, 4));
+  __m128i v2 = _mm_or_si128(_mm_srli_si128(v0, 12), _mm_slli_si128(v1, 4));
+  _mm_storeu_si128(d + 2, packV210(_mm_or_si128(_mm_srli_si128(y1, 8), _mm_slli_si128(y2, 8)), _mm_unpacklo_epi64(u2, v2)));
+  _mm_storeu_si128(d + 3, packV210(_mm_srli_si128(y2, 4), _mm_unpacklo_epi64(_mm_srli_si128(u1, 2), _mm_srli_si128(v1, 2))));
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t v210ToYUV422P10_SSSE3(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 24 <= width; x += 24) {
+    __m128i y0, y1, y2, u0, u1, v0, v1;
+    unpackV210x4(src + x / 6 * 16, y0, y1, y2, u0, u1, v0, v1);
+    _mm_storeu_si128((__m128i *)(dstY + x), y0);
+    _mm_storeu_si128((__m128i *)(dstY + x + 8), y1);
+    _mm_storeu_si128((__m128i *)(dstY + x + 16), y2);
+    _mm_storeu_si128((__m128i *)(dstU + x / 2), u0);
+    _mm_storel_epi64((__m128i *)(dstU + x / 2 + 8), u1);
+    _mm_storeu_si128((__m128i *)(dstV + x / 2), v0);
+    _mm_storel_epi64((__m128i *)(dstV + x / 2 + 8), v1);
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t v210ToPGroup_SSSE3(const uint8_t *src, uint8_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 24 <= width; x += 24) {
+    __m128i y0, y1, y2, u0, u1, v0, v1;
+    unpackV210x4(src + x / 6 * 16, y0, y1, y2, u0, u1, v0, v1);
+    uint8_t *d = dst + x * 5 / 2;
+    packPlanar(d, y0, y1, u0, v0);
+
+    // the last 8 pixels make 20 bytes
+    __m128i uv = _mm_unpacklo_epi16(u1, v1);
+    __m128i p0 = packPGroups(_mm_unpacklo_epi16(uv, y2));
+    __m128i p1 = packPGroups(_mm_unpackhi_epi16(uv, y2));
+    _mm_storeu_si128((__m128i *)(d + 40), _mm_or_si128(p0, _mm_slli_si128(p1, 10)));
+    int32_t top = _mm_cvtsi128_si32(_mm_srli_si128(p1, 6));
+    memcpy(d + 56, &top, 4);
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t yuv422P10ToV210_SSSE3(const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV, uint8_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 24 <= width; x += 24)
+    packV210x4(dst + x / 6 * 16,
+      _mm_loadu_si128((const __m128i *)(srcY + x)), _mm_loadu_si128((const __m128i *)(srcY + x + 8)),
+      _mm_loadu_si128((const __m128i *)(srcY + x + 16)),
+      _mm_loadu_si128((const __m128i *)(srcU + x / 2)), _mm_loadl_epi64((const __m128i *)(srcU + x / 2 + 8)),
+      _mm_loadu_si128((const __m128i *)(srcV + x / 2)), _mm_loadl_epi64((const __m128i *)(srcV + x / 2 + 8)));
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t yuv420PToV210_SSSE3(const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV, uint8_t *dst, uint32_t width) {
+  const __m128i zero = _mm_setzero_si128();
+  uint32_t x = 0;
+  for (; x + 24 <= width; x += 24) {
+    __m128i y = _mm_loadu_si128((const __m128i *)(srcY + x));
+    __m128i yTop = _mm_loadl_epi64((const __m128i *)(srcY + x + 16));
+    __m128i u = load12(srcU + x / 2);
+    __m128i v = load12(srcV + x / 2);
+    packV210x4(dst + x / 6 * 16,
+      _mm_slli_epi16(_mm_unpacklo_epi8(y, zero), 2), _mm_slli_epi16(_mm_unpackhi_epi8(y, zero), 2),
+      _mm_slli_epi16(_mm_unpacklo_epi8(yTop, zero), 2),
+      _mm_slli_epi16(_mm_unpacklo_epi8(u, zero), 2), _mm_slli_epi16(_mm_unpackhi_epi8(u, zero), 2),
+      _mm_slli_epi16(_mm_unpacklo_epi8(v, zero), 2), _mm_slli_epi16(_mm_unpackhi_epi8(v, zero), 2));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t pgroupToV210_SSSE3(const uint8_t *src, uint8_t *dst, uint32_t width) {
+  uint32_t srcBytes = width * 5 / 2;
+  uint32_t x = 0;
+  for (; (x + 24 <= width) && (x * 5 / 2 + 66 <= srcBytes); x += 24) {
+    const uint8_t *s = src + x * 5 / 2;
+    __m128i y0, uv0, y1, uv1, y2, uv2;
+    splitPlanar(loadPGroups(s), loadPGroups(s + 10), y0, uv0);
+    splitPlanar(loadPGroups(s + 20), loadPGroups(s + 30), y1, uv1);
+    splitPlanar(loadPGroups(s + 40), loadPGroups(s + 50), y2, uv2);
+    packV210x4(dst + x / 6 * 16, y0, y1, y2,
+      _mm_unpacklo_epi64(uv0, uv1), uv2, _mm_unpackhi_epi64(uv0, uv1), _mm_srli_si128(uv2, 8));
+  }
+  return x;
+}
+
+// 10-bit to 8-bit reduction, with a bias pattern that repeats every 8 samples
+
+CODECADON_TARGET("ssse3")
+static uint32_t line10To8_SSSE3(const uint16_t *src, uint8_t *dst, uint32_t width, const uint16_t *bias) {
+  const __m128i mask = _mm_set1_epi16(0x3ff);
+  const __m128i b = _mm_loadu_si128((const __m128i *)bias);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i s0 = _mm_add_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i *)(src + x)), mask), b);
+    __m128i s1 = _mm_add_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i *)(src + x + 8)), mask), b);
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(_mm_srli_epi16(s0, 2), _mm_srli_epi16(s1, 2)));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t linePair10To8_SSSE3(const uint16_t *srcA, const uint16_t *srcB, uint8_t *dst, uint32_t width, const uint16_t *bias) {
+  const __m128i mask = _mm_set1_epi16(0x3ff);
+  const __m128i b = _mm_loadu_si128((const __m128i *)bias);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i s0 = _mm_add_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i *)(srcA + x)), mask),
+                               _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcB + x)), mask));
+    __m128i s1 = _mm_add_epi16(_mm_and_si128(_mm_loadu_si128((const __m128i *)(srcA + x + 8)), mask),
+                               _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcB + x + 8)), mask));
+    s0 = _mm_srli_epi16(_mm_add_epi16(s0, b), 3);
+    s1 = _mm_srli_epi16(_mm_add_epi16(s1, b), 3);
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(s0, s1));
+  }
+  return x;
+}
+
+// RGB to YCbCr works on pixels expanded to 16-bit components, 2 pixels to a register, in the component order of
+// the coefficient vectors. madd gives the partial sums of each pixel in a pair of 32-bit lanes, and hadd adds them.
+
+// Y of the 8 pixels in p0..p3
+CODECADON_TARGET("ssse3")
+static inline __m128i rgbLuma(__m128i p0, __m128i p1, __m128i p2, __m128i p3, __m128i c) {
+  const __m128i offset = _mm_set1_epi32((64 << 13) + (1 << 12));
+  __m128i y0 = _mm_hadd_epi32(_mm_madd_epi16(p0, c), _mm_madd_epi16(p1, c));
+  __m128i y1 = _mm_hadd_epi32(_mm_madd_epi16(p2, c), _mm_madd_epi16(p3, c));
+  y0 = _mm_srai_epi32(_mm_add_epi32(y0, offset), 13);
+  y1 = _mm_srai_epi32(_mm_add_epi32(y1, offset), 13);
+  return _mm_packs_epi32(y0, y1);
+}
+
+// U or V of the 4 pixel pairs in p0..p3, as 32-bit values
+CODECADON_TARGET("ssse3")
+static inline __m128i rgbChroma(__m128i p0, __m128i p1, __m128i p2, __m128i p3, __m128i c) {
+  const __m128i offset = _mm_set1_epi32((512 << 13) + (1 << 12));
+  __m128i s0 = _mm_hadd_epi32(_mm_madd_epi16(p0, c), _mm_madd_epi16(p1, c));
+  __m128i s1 = _mm_hadd_epi32(_mm_madd_epi16(p2, c), _mm_madd_epi16(p3, c));
+  return _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(s0, s1), offset), 13);
+}
+
+// Converts 16 pixels expanded into p[0..7] and stores their luma and chroma.
+// c0, c1 and c2 are the coefficients of the first three components of each pixel.
+CODECADON_TARGET("ssse3")
+static inline void storeRgbToYUV(const __m128i *p, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, const __m128i *c) {
+  _mm_storeu_si128((__m128i *)dstY, rgbLuma(p[0], p[1], p[2], p[3], c[0]));
+  _mm_storeu_si128((__m128i *)(dstY + 8), rgbLuma(p[4], p[5], p[6], p[7], c[0]));
+  _mm_storeu_si128((__m128i *)dstU, _mm_packs_epi32(rgbChroma(p[0], p[1], p[2], p[3], c[1]), rgbChroma(p[4], p[5], p[6], p[7], c[1])));
+  _mm_storeu_si128((__m128i *)dstV, _mm_packs_epi32(rgbChroma(p[0], p[1], p[2], p[3], c[2]), rgbChroma(p[4], p[5], p[6], p[7], c[2])));
+}
+
+// the coefficient vectors for Y, U and V, for components in the order r, g, b or b, g, r followed by an ignored alpha
+static inline void rgbCoeffVectors(const RgbToYuvCoeffs &k, bool bgr, __m128i *c) {
+  c[0] = bgr ? _mm_setr_epi16(k.yB, k.yG, k.yR, 0, k.yB, k.yG, k.yR, 0) : _mm_setr_epi16(k.yR, k.yG, k.yB, 0, k.yR, k.yG, k.yB, 0);
+  c[1] = bgr ? _mm_setr_epi16(k.uB, k.uG, k.uR, 0, k.uB, k.uG, k.uR, 0) : _mm_setr_epi16(k.uR, k.uG, k.uB, 0, k.uR, k.uG, k.uB, 0);
+  c[2] = bgr ? _mm_setr_epi16(k.vB, k.vG, k.vR, 0, k.vB, k.vG, k.vR, 0) : _mm_setr_epi16(k.vR, k.vG, k.vB, 0, k.vR, k.vG, k.vB, 0);
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t rgba8ToYUV422P10_SSSE3(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint16_t *dstA,
+                                       uint32_t width, const RgbToYuvCoeffs &coeffs, bool bgra) {
+  __m128i c[3];
+  rgbCoeffVectors(coeffs, bgra, c);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha = _mm_setr_epi8(3, -1, 7, -1, 11, -1, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i s[4];
+    __m128i p[8];
+    for (uint32_t i = 0; i < 4; ++i) {
+      s[i] = _mm_loadu_si128((const __m128i *)(src + (x + i * 4) * 4));
+      p[i * 2] = _mm_unpacklo_epi8(s[i], zero);
+      p[i * 2 + 1] = _mm_unpackhi_epi8(s[i], zero);
+    }
+    storeRgbToYUV(p, dstY + x, dstU + x / 2, dstV + x / 2, c);
+    if (dstA) {
+      __m128i a0 = _mm_unpacklo_epi64(_mm_shuffle_epi8(s[0], alpha), _mm_shuffle_epi8(s[1], alpha));
+      __m128i a1 = _mm_unpacklo_epi64(_mm_shuffle_epi8(s[2], alpha), _mm_shuffle_epi8(s[3], alpha));
+      _mm_storeu_si128((__m128i *)(dstA + x), _mm_or_si128(_mm_slli_epi16(a0, 2), _mm_srli_epi16(a0, 6)));
+      _mm_storeu_si128((__m128i *)(dstA + x + 8), _mm_or_si128(_mm_slli_epi16(a1, 2), _mm_srli_epi16(a1, 6)));
+    }
+  }
+  return x;
+}
+
+// BGR10-A words hold a 2-bit alpha in bits 0-1, then 10-bit blue, green and red
+CODECADON_TARGET("ssse3")
+static uint32_t bgr10AToYUV422P10_SSSE3(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint16_t *dstA,
+                                        uint32_t width, const RgbToYuvCoeffs &coeffs, bool byteSwap) {
+  __m128i c[3];
+  rgbCoeffVectors(coeffs, true, c);
+  const __m128i mask = _mm_set1_epi32(0x3ff);
+  const __m128i swap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i a[4];
+    __m128i p[8];
+    for (uint32_t i = 0; i < 4; ++i) {
+      __m128i s = _mm_loadu_si128((const __m128i *)(src + (x + i * 4) * 4));
+      if (byteSwap)
+        s = _mm_shuffle_epi8(s, swap);
+      __m128i bg = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(s, 2), mask), _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(s, 12), mask), 16));
+      a[i] = _mm_and_si128(s, _mm_set1_epi32(3));
+      __m128i ra = _mm_or_si128(_mm_srli_epi32(s, 22), _mm_slli_epi32(a[i], 16));
+      p[i * 2] = _mm_unpacklo_epi32(bg, ra);
+      p[i * 2 + 1] = _mm_unpackhi_epi32(bg, ra);
+    }
+    storeRgbToYUV(p, dstY + x, dstU + x / 2, dstV + x / 2, c);
+    if (dstA) {
+      const __m128i scale = _mm_set1_epi16(0x155);
+      _mm_storeu_si128((__m128i *)(dstA + x), _mm_mullo_epi16(_mm_packs_epi32(a[0], a[1]), scale));
+      _mm_storeu_si128((__m128i *)(dstA + x + 8), _mm_mullo_epi16(_mm_packs_epi32(a[2], a[3]), scale));
+    }
+  }
+  return x;
+}
+
+// Y210 and P010 hold 10-bit samples in the top of 16-bit words
+
+CODECADON_TARGET("ssse3")
+static uint32_t yuv422P10ToY210_SSSE3(const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV, uint16_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i y0 = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcY + x)), 6);
+    __m128i y1 = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcY + x + 8)), 6);
+    __m128i u = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcU + x / 2)), 6);
+    __m128i v = _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(srcV + x / 2)), 6);
+    __m128i uvLo = _mm_unpacklo_epi16(u, v);
+    __m128i uvHi = _mm_unpackhi_epi16(u, v);
+    _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi16(y0, uvLo));
+    _mm_storeu_si128((__m128i *)(dst + x * 2 + 8), _mm_unpackhi_epi16(y0, uvLo));
+    _mm_storeu_si128((__m128i *)(dst + x * 2 + 16), _mm_unpacklo_epi16(y1, uvHi));
+    _mm_storeu_si128((__m128i *)(dst + x * 2 + 24), _mm_unpackhi_epi16(y1, uvHi));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t y210ToYUV422P10_SSSE3(const uint16_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width) {
+  // y0 y1 y2 y3 in the bottom half, u0 u1 v0 v1 in the top
+  const __m128i split = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 10, 11, 6, 7, 14, 15);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i s[4];
+    for (uint32_t i = 0; i < 4; ++i)
+      s[i] = _mm_shuffle_epi8(_mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + x * 2 + i * 8)), 6), split);
+    _mm_storeu_si128((__m128i *)(dstY + x), _mm_unpacklo_epi64(s[0], s[1]));
+    _mm_storeu_si128((__m128i *)(dstY + x + 8), _mm_unpacklo_epi64(s[2], s[3]));
+    // u0 u1 u2 u3 v0 v1 v2 v3 from each pair of registers
+    __m128i uv0 = _mm_shuffle_epi32(_mm_unpackhi_epi64(s[0], s[1]), _MM_SHUFFLE(3, 1, 2, 0));
+    __m128i uv1 = _mm_shuffle_epi32(_mm_unpackhi_epi64(s[2], s[3]), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i *)(dstU + x / 2), _mm_unpacklo_epi64(uv0, uv1));
+    _mm_storeu_si128((__m128i *)(dstV + x / 2), _mm_unpackhi_epi64(uv0, uv1));
+  }
+  return x;
+}
+
+// v410 words hold u in bits 2-11, y in bits 12-21 and v in bits 22-31
+
+CODECADON_TARGET("ssse3")
+static uint32_t yuv422P10ToV410_SSSE3(const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV, uint32_t *dst, uint32_t width) {
+  const __m128i mask = _mm_set1_epi16(0x3ff);
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i y = _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcY + x)), mask);
+    __m128i u = _mm_and_si128(_mm_loadl_epi64((const __m128i *)(srcU + x / 2)), mask);
+    __m128i v = _mm_and_si128(_mm_loadl_epi64((const __m128i *)(srcV + x / 2)), mask);
+    u = _mm_unpacklo_epi16(u, u);
+    v = _mm_unpacklo_epi16(v, v);
+    // u << 2 | y << 12 in the bottom word of each pair, y >> 4 | v << 6 in the top
+    __m128i lo = _mm_or_si128(_mm_slli_epi16(u, 2), _mm_slli_epi16(y, 12));
+    __m128i hi = _mm_or_si128(_mm_srli_epi16(y, 4), _mm_slli_epi16(v, 6));
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_unpacklo_epi16(lo, hi));
+    _mm_storeu_si128((__m128i *)(dst + x + 4), _mm_unpackhi_epi16(lo, hi));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t v410ToYUV422P10_SSSE3(const uint32_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width) {
+  const __m128i mask = _mm_set1_epi32(0x3ff);
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i even = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1);
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i s0 = _mm_loadu_si128((const __m128i *)(src + x));
+    __m128i s1 = _mm_loadu_si128((const __m128i *)(src + x + 4));
+    _mm_storeu_si128((__m128i *)(dstY + x), _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0, 12), mask),
+                                                            _mm_and_si128(_mm_srli_epi32(s1, 12), mask)));
+    // each pixel pair is summed in the lane of its even pixel
+    __m128i u0 = _mm_and_si128(_mm_srli_epi32(s0, 2), mask);
+    __m128i u1 = _mm_and_si128(_mm_srli_epi32(s1, 2), mask);
+    __m128i v0 = _mm_srli_epi32(s0, 22);
+    __m128i v1 = _mm_srli_epi32(s1, 22);
+    __m128i u = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(u0, _mm_srli_epi64(u0, 32)), one), 1);
+    __m128i uHi = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(u1, _mm_srli_epi64(u1, 32)), one), 1);
+    __m128i v = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(v0, _mm_srli_epi64(v0, 32)), one), 1);
+    __m128i vHi = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(v1, _mm_srli_epi64(v1, 32)), one), 1);
+    _mm_storel_epi64((__m128i *)(dstU + x / 2), _mm_shuffle_epi8(_mm_packs_epi32(u, uHi), even));
+    _mm_storel_epi64((__m128i *)(dstV + x / 2), _mm_shuffle_epi8(_mm_packs_epi32(v, vHi), even));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t interleaveUV8_SSSE3(const uint8_t *srcU, const uint8_t *srcV, uint8_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i u = _mm_loadu_si128((const __m128i *)(srcU + x));
+    __m128i v = _mm_loadu_si128((const __m128i *)(srcV + x));
+    _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi8(u, v));
+    _mm_storeu_si128((__m128i *)(dst + x * 2 + 16), _mm_unpackhi_epi8(u, v));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t deinterleaveUV8_SSSE3(const uint8_t *src, uint8_t *dstU, uint8_t *dstV, uint32_t width) {
+  const __m128i split = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m128i s0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 2)), split);
+    __m128i s1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x * 2 + 16)), split);
+    _mm_storeu_si128((__m128i *)(dstU + x), _mm_unpacklo_epi64(s0, s1));
+    _mm_storeu_si128((__m128i *)(dstV + x), _mm_unpackhi_epi64(s0, s1));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t line10ToP010_SSSE3(const uint16_t *src, uint16_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8)
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_slli_epi16(_mm_loadu_si128((const __m128i *)(src + x)), 6));
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t lineP010To10_SSSE3(const uint16_t *src, uint16_t *dst, uint32_t width) {
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8)
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + x)), 6));
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t linePairsToP010UV_SSSE3(const uint16_t *srcUA, const uint16_t *srcUB, const uint16_t *srcVA, const uint16_t *srcVB,
+                                        uint16_t *dst, uint32_t width) {
+  const __m128i mask = _mm_set1_epi16(0x3ff);
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    // the average of 10-bit samples with rounding, which avg_epu16 gives exactly
+    __m128i u = _mm_avg_epu16(_mm_and_si128(_mm_loadu_si128((const __m128i *)(srcUA + x)), mask),
+                              _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcUB + x)), mask));
+    __m128i v = _mm_avg_epu16(_mm_and_si128(_mm_loadu_si128((const __m128i *)(srcVA + x)), mask),
+                              _mm_and_si128(_mm_loadu_si128((const __m128i *)(srcVB + x)), mask));
+    u = _mm_slli_epi16(u, 6);
+    v = _mm_slli_epi16(v, 6);
+    _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi16(u, v));
+    _mm_storeu_si128((__m128i *)(dst + x * 2 + 8), _mm_unpackhi_epi16(u, v));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t p010UVToLines_SSSE3(const uint16_t *src, uint16_t *dstU, uint16_t *dstV, uint32_t width) {
+  const __m128i split = _mm_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m128i s0 = _mm_shuffle_epi8(_mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + x * 2)), 6), split);
+    __m128i s1 = _mm_shuffle_epi8(_mm_srli_epi16(_mm_loadu_si128((const __m128i *)(src + x * 2 + 8)), 6), split);
+    _mm_storeu_si128((__m128i *)(dstU + x), _mm_unpacklo_epi64(s0, s1));
+    _mm_storeu_si128((__m128i *)(dstV + x), _mm_unpackhi_epi64(s0, s1));
+  }
+  return x;
+}
+
+// AVX2 kernels for the unpacking direction, pgroup being the usual ingest format.
+// Each 128-bit lane unpacks its own pair of pgroups, as above.
+
+CODECADON_TARGET("avx2")
+static inline __m256i loadPGroups2(const uint8_t *lo, const uint8_t *hi) {
+  __m256i s = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)lo)),
+                                      _mm_loadu_si128((const __m128i *)hi), 1);
+  const __m256i gather = _mm256_setr_epi8(1, 0, 2, 1, 3, 2, 4, 3, 6, 5, 7, 6, 8, 7, 9, 8,
+                                          1, 0, 2, 1, 3, 2, 4, 3, 6, 5, 7, 6, 8, 7, 9, 8);
+  const __m256i align = _mm256_setr_epi16(1, 4, 16, 64, 1, 4, 16, 64, 1, 4, 16, 64, 1, 4, 16, 64);
+  return _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_shuffle_epi8(s, gather), align), 6);
+}
+
+// 16 pixels from the 40 pgroup bytes at s - 16 luma and chroma u0..u7 in the bottom half, v0..v7 in the top
+CODECADON_TARGET("avx2")
+static inline void splitPlanar2(const uint8_t *s, __m256i &y, __m256i &uv) {
+  const __m256i lumaLo = _mm256_setr_epi8(2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 8, 9, 4, 5, 12, 13,
+                                          2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 8, 9, 4, 5, 12, 13);
+  __m256i a = _mm256_shuffle_epi8(loadPGroups2(s, s + 20), lumaLo);
+  __m256i b = _mm256_shuffle_epi8(loadPGroups2(s + 10, s + 30), lumaLo);
+  y = _mm256_unpacklo_epi64(a, b);
+  uv = _mm256_permute4x64_epi64(_mm256_shuffle_epi32(_mm256_unpackhi_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0)),
+                                _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+CODECADON_TARGET("avx2")
+static uint32_t pgroupToUYVY10_AVX2(const uint8_t *src, uint8_t *dst, uint32_t width) {
+  uint32_t srcBytes = width * 5 / 2;
+  uint32_t x = 0;
+  for (; (x + 8 <= width) && (x * 5 / 2 + 26 <= srcBytes); x += 8) {
+    const uint8_t *s = src + x * 5 / 2;
+    _mm256_storeu_si256((__m256i *)(dst + x * 4), loadPGroups2(s, s + 10));
+  }
+  return x + pgroupToUYVY10_SSSE3(src + x * 5 / 2, dst + x * 4, width - x);
+}
+
+CODECADON_TARGET("avx2")
+static uint32_t pgroupToYUV422P10_AVX2(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width) {
+  uint32_t srcBytes = width * 5 / 2;
+  uint32_t x = 0;
+  for (; (x + 16 <= width) && (x * 5 / 2 + 46 <= srcBytes); x += 16) {
+    __m256i y, uv;
+    splitPlanar2(src + x * 5 / 2, y, uv);
+    _mm256_storeu_si256((__m256i *)(dstY + x), y);
+    _mm_storeu_si128((__m128i *)(dstU + x / 2), _mm256_castsi256_si128(uv));
+    _mm_storeu_si128((__m128i *)(dstV + x / 2), _mm256_extracti128_si256(uv, 1));
+  }
+  return x + pgroupToYUV422P10_SSSE3(src + x * 5 / 2, dstY + x, dstU + x / 2, dstV + x / 2, width - x);
+}
+
+// packus works within lanes, so the reductions permute their results back into order
+
+CODECADON_TARGET("avx2")
+static uint32_t line10To8_AVX2(const uint16_t *src, uint8_t *dst, uint32_t width, const uint16_t *bias) {
+  const __m256i mask = _mm256_set1_epi16(0x3ff);
+  const __m256i b = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)bias));
+  uint32_t x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i s0 = _mm256_add_epi16(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + x)), mask), b);
+    __m256i s1 = _mm256_add_epi16(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + x + 16)), mask), b);
+    __m256i d = _mm256_packus_epi16(_mm256_srli_epi16(s0, 2), _mm256_srli_epi16(s1, 2));
+    _mm256_storeu_si256((__m256i *)(dst + x), _mm256_permute4x64_epi64(d, _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+  return x + line10To8_SSSE3(src + x, dst + x, width - x, bias);
+}
+
+CODECADON_TARGET("avx2")
+static uint32_t linePair10To8_AVX2(const uint16_t *srcA, const uint16_t *srcB, uint8_t *dst, uint32_t width, const uint16_t *bias) {
+  const __m256i mask = _mm256_set1_epi16(0x3ff);
+  const __m256i b = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)bias));
+  uint32_t x = 0;
+  for (; x + 32 <= width; x += 32) {
+    __m256i s0 = _mm256_add_epi16(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(srcA + x)), mask),
+                                  _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(srcB + x)), mask));
+    __m256i s1 = _mm256_add_epi16(_mm256_and_si256(_mm256_loadu_si256((const __m256i *)(srcA + x + 16)), mask),
+                                  _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(srcB + x + 16)), mask));
+    s0 = _mm256_srli_epi16(_mm256_add_epi16(s0, b), 3);
+    s1 = _mm256_srli_epi16(_mm256_add_epi16(s1, b), 3);
+    _mm256_storeu_si256((__m256i *)(dst + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(s0, s1), _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+  return x + linePair10To8_SSSE3(srcA + x, srcB + x, dst + x, width - x, bias);
+}
+
+#endif
+
+static PackerLineKernels chooseKernels() {
+  PackerLineKernels kernels = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+                                NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+#ifdef CODECADON_X86
+  const CpuFeatures &cpu = CpuFeatures::instance();
+  if (cpu.ssse3()) {
+    kernels.pgroupToUYVY10 = &pgroupToUYVY10_SSSE3;
+    kernels.pgroupToYUV422P10 = &pgroupToYUV422P10_SSSE3;
+    kernels.uyvy10ToPGroup = &uyvy10ToPGroup_SSSE3;
+    kernels.yuv422P10ToPGroup = &yuv422P10ToPGroup_SSSE3;
+    kernels.yuv420PToPGroup = &yuv420PToPGroup_SSSE3;
+    kernels.v210ToYUV422P10 = &v210ToYUV422P10_SSSE3;
+    kernels.v210ToPGroup = &v210ToPGroup_SSSE3;
+    kernels.yuv422P10ToV210 = &yuv422P10ToV210_SSSE3;
+    kernels.yuv420PToV210 = &yuv420PToV210_SSSE3;
+    kernels.pgroupToV210 = &pgroupToV210_SSSE3;
+    kernels.line10To8 = &line10To8_SSSE3;
+    kernels.linePair10To8 = &linePair10To8_SSSE3;
+    kernels.yuv422P10ToY210 = &yuv422P10ToY210_SSSE3;
+    kernels.y210ToYUV422P10 = &y210ToYUV422P10_SSSE3;
+    kernels.yuv422P10ToV410 = &yuv422P10ToV410_SSSE3;
+    kernels.v410ToYUV422P10 = &v410ToYUV422P10_SSSE3;
+    kernels.interleaveUV8 = &interleaveUV8_SSSE3;
+    kernels.deinterleaveUV8 = &deinterleaveUV8_SSSE3;
+    kernels.line10ToP010 = &line10ToP010_SSSE3;
+    kernels.lineP010To10 = &lineP010To10_SSSE3;
+    kernels.linePairsToP010UV = &linePairsToP010UV_SSSE3;
+    kernels.p010UVToLines = &p010UVToLines_SSSE3;
+    kernels.rgba8ToYUV422P10 = &rgba8ToYUV422P10_SSSE3;
+    kernels.bgr10AToYUV422P10 = &bgr10AToYUV422P10_SSSE3;
+  }
+  if (cpu.ssse3() && cpu.avx2()) {
+    kernels.pgroupToUYVY10 = &pgroupToUYVY10_AVX2;
+    kernels.pgroupToYUV422P10 = &pgroupToYUV422P10_AVX2;
+    kernels.line10To8 = &line10To8_AVX2;
+    kernels.linePair10To8 = &linePair10To8_AVX2;
+  }
+#endif
+  return kernels;
+}
+
+const PackerLineKernels &packerLineKernels() {
+  static const PackerLineKernels kernels = chooseKernels();
+  return kernels;
+}
+
+} // namespace streampunk
@@ -0,0 +1,90 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef PACKERSSIMD_H
+#define PACKERSSIMD_H
+
+#include <stdint.h>
+
+namespace streampunk {
+
+// Fixed point coefficients for RGB to limited range 10-bit YCbCr, in units of 2^-13 of an output code value per input
+// code value. Luma is made from the R, G and B of each pixel, and 4:2:2 chroma from their sums over each pixel pair:
+// y = (yR * r + yG * g + yB * b + (64 << 13) + (1 << 12)) >> 13
+// u = (uR * (r0 + r1) + uG * (g0 + g1) + uB * (b0 + b1) + (512 << 13) + (1 << 12)) >> 13, and v to match
+struct RgbToYuvCoeffs {
+  int16_t yR, yG, yB;
+  int16_t uR, uG, uB;
+  int16_t vR, vG, vB;
+};
+
+// SIMD line kernels for the Packers conversions.
+// Each kernel converts as many whole blocks of pixels from the start of a line as it can without reading or writing
+// beyond the line and returns the number of pixels done, leaving the rest of the line to the scalar code.
+// Results are bit-exact with the scalar code, which remains the reference. Kernels not available for the
+// running CPU are NULL.
+struct PackerLineKernels {
+  uint32_t (*pgroupToUYVY10)(const uint8_t *src, uint8_t *dst, uint32_t width);
+  uint32_t (*pgroupToYUV422P10)(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width);
+
+  uint32_t (*uyvy10ToPGroup)(const uint8_t *src, uint8_t *dst, uint32_t width);
+  uint32_t (*yuv422P10ToPGroup)(const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV, uint8_t *dst, uint32_t width);
+  uint32_t (*yuv420PToPGroup)(const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV, uint8_t *dst, uint32_t width);
+
+  // v210 kernels work in whole 6 pixel blocks and never touch the padding at the end of a line
+  uint32_t (*v210ToYUV422P10)(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width);
+  uint32_t (*v210ToPGroup)(const uint8_t *src, uint8_t *dst, uint32_t width);
+  uint32_t (*yuv422P10ToV210)(const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV, uint8_t *dst, uint32_t width);
+  uint32_t (*yuv420PToV210)(const uint8_t *srcY, const uint8_t *srcU, const uint8_t *srcV, uint8_t *dst, uint32_t width);
+  uint32_t (*pgroupToV210)(const uint8_t *src, uint8_t *dst, uint32_t width);
+
+  // 10-bit to 8-bit reduction of a line of samples, adding bias[x & 7] before the shift and saturating -
+  // dst = ((src & 0x3ff) + bias) >> 2, and for a pair of lines dst = ((srcA & 0x3ff) + (srcB & 0x3ff) + bias) >> 3
+  uint32_t (*line10To8)(const uint16_t *src, uint8_t *dst, uint32_t width, const uint16_t *bias);
+  uint32_t (*linePair10To8)(const uint16_t *srcA, const uint16_t *srcB, uint8_t *dst, uint32_t width, const uint16_t *bias);
+
+  // 10-bit 4:2:2 planes to and from Y210, whose words hold each component in the top 10 bits, in the order y0 u y1 v
+  uint32_t (*yuv422P10ToY210)(const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV, uint16_t *dst, uint32_t width);
+  uint32_t (*y210ToYUV422P10)(const uint16_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width);
+
+  // 10-bit 4:2:2 planes to and from v410, 4:4:4 with u, y and v from bit 2 of each word - chroma is repeated for
+  // both pixels of a pair, and a pair is averaged with rounding on the way back
+  uint32_t (*yuv422P10ToV410)(const uint16_t *srcY, const uint16_t *srcU, const uint16_t *srcV, uint32_t *dst, uint32_t width);
+  uint32_t (*v410ToYUV422P10)(const uint32_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint32_t width);
+
+  // Semi-planar chroma, interleaving width samples of each of u and v. The P010 kernels move 10-bit samples to and
+  // from the top of each word, with a pair of 4:2:2 chroma lines averaged with rounding to make each P010 line.
+  uint32_t (*interleaveUV8)(const uint8_t *srcU, const uint8_t *srcV, uint8_t *dst, uint32_t width);
+  uint32_t (*deinterleaveUV8)(const uint8_t *src, uint8_t *dstU, uint8_t *dstV, uint32_t width);
+  uint32_t (*line10ToP010)(const uint16_t *src, uint16_t *dst, uint32_t width);
+  uint32_t (*lineP010To10)(const uint16_t *src, uint16_t *dst, uint32_t width);
+  uint32_t (*linePairsToP010UV)(const uint16_t *srcUA, const uint16_t *srcUB, const uint16_t *srcVA, const uint16_t *srcVB,
+                                uint16_t *dst, uint32_t width);
+  uint32_t (*p010UVToLines)(const uint16_t *src, uint16_t *dstU, uint16_t *dstV, uint32_t width);
+
+  // RGB to 10-bit 4:2:2 planes, with the alpha scaled to 10 bits when dstA is not NULL - RGBA8, or BGRA8 when bgra
+  // is set, and BGR10-A, byte swapped first when byteSwap is set
+  uint32_t (*rgba8ToYUV422P10)(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint16_t *dstA,
+                               uint32_t width, const RgbToYuvCoeffs &coeffs, bool bgra);
+  uint32_t (*bgr10AToYUV422P10)(const uint8_t *src, uint16_t *dstY, uint16_t *dstU, uint16_t *dstV, uint16_t *dstA,
+                                uint32_t width, const RgbToYuvCoeffs &coeffs, bool byteSwap);
+};
+
+// the best kernels for the running CPU, chosen once
+const PackerLineKernels &packerLineKernels();
+
+} // namespace streampunk
+
+#endif
@@ -22,10 +22,15 @@ namespace streampunk {
 
 class Persist {
 public:
+  Persist() {}
   Persist(Local<Object> object) 
     : mPersistObj(object) {}
   ~Persist() { mPersistObj.Reset(); }
 
+  // pooled process data holds on to a Persist and points it at the buffers of each new frame
+  void reset(Local<Object> object) { mPersistObj.Reset(object); }
+  void reset() { mPersistObj.Reset(); }
+
 private:
   Nan::Persistent<Object> mPersistObj;
 };
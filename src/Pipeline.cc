@@ -0,0 +1,263 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <nan.h>
+#include "Pipeline.h"
+#include "MyWorker.h"
+#include "Timer.h"
+#include "Memory.h"
+#include "Persist.h"
+#include "ProcessParams.h"
+
+#include <memory>
+
+using namespace v8;
+
+namespace streampunk {
+
+class PipelineProcessData : public iProcessData {
+public:
+  PipelineProcessData ()
+    : mSrcBuf(Memory::makeNew((uint8_t *)NULL, 0)), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0))
+  { }
+  ~PipelineProcessData() { }
+
+  void set(Local<Object> srcBufObj, Local<Object> dstBufObj, uint32_t numStages) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mPersistentDstBuf.reset(dstBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
+    // the descriptors are kept from frame to frame, like the source and destination ones
+    while (mStageBufs.size() < numStages)
+      mStageBufs.push_back(Memory::makeNew((uint8_t *)NULL, 0));
+    mStageOwners.resize(numStages);
+  }
+  void recycle() {
+    mPersistentSrcBuf.reset();
+    mPersistentDstBuf.reset();
+  }
+
+  std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
+
+  // the source for a stage is the valid part of the previous stage's result
+  std::shared_ptr<Memory> stageSrcBuf(uint32_t stage) const { 
+    return stage ? mStageBufs[stage - 1] : mSrcBuf; 
+  }
+
+  // the result buffer of a stage belongs to this frame and is kept for the next frame that uses it,
+  // only being replaced when the stage result size has changed
+  std::shared_ptr<Memory> stageDstBuf(uint32_t stage, uint32_t numBytes) {
+    if (!mStageOwners[stage] || (mStageOwners[stage]->numBytes() != numBytes))
+      mStageOwners[stage] = Memory::makeNew(numBytes);
+    return mStageOwners[stage];
+  }
+  void setStageResult(uint32_t stage, uint32_t resultBytes) {
+    mStageBufs[stage]->reset(mStageOwners[stage]->buf(), resultBytes);
+  }
+
+private:
+  Persist mPersistentSrcBuf;
+  Persist mPersistentDstBuf;
+  std::shared_ptr<Memory> mSrcBuf;
+  std::shared_ptr<Memory> mDstBuf;
+  std::vector<std::shared_ptr<Memory> > mStageBufs;
+  std::vector<std::shared_ptr<Memory> > mStageOwners;
+};
+
+Pipeline::Pipeline(Nan::Callback *callback) 
+  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mSrcBytesReq(0), mDstBytesReq(0) {}
+Pipeline::~Pipeline() {}
+
+// iProcess
+uint32_t Pipeline::processFrame (std::shared_ptr<iProcessData> processData) {
+  uint32_t resultBytes = 0;
+  for (uint32_t s = 0; s < mStages.size(); ++s)
+    resultBytes = processStage(s, processData);
+  return resultBytes;
+}
+
+uint32_t Pipeline::processStage (uint32_t stage, std::shared_ptr<iProcessData> processData) {
+  Timer t;
+  std::shared_ptr<PipelineProcessData> ppd = std::dynamic_pointer_cast<PipelineProcessData>(processData);
+
+  bool lastStage = (stage + 1 == mStages.size());
+  std::shared_ptr<Memory> dstBuf = lastStage ? ppd->dstBuf() : ppd->stageDstBuf(stage, mStages[stage]->stageDstBytes());
+  uint32_t resultBytes = mStages[stage]->processStageFrame(ppd->stageSrcBuf(stage), dstBuf);
+  if (!lastStage)
+    ppd->setStageResult(stage, resultBytes);
+
+  printDebug(eDebug, "pipeline stage %d: %.2fms\n", stage, t.delta());
+  return resultBytes;
+}
+
+void Pipeline::doSetInfo(Local<Array> stagesArray, Local<Object> paramTags) {
+  ProcessParams processParams(paramTags);
+  printDebug(eInfo, "Pipeline ProcessParams: %s\n", processParams.toString().c_str());
+  mWorker->setQueueDepth(processParams.queueDepth());
+  if (!mWorker->setDropPolicy(processParams.dropPolicy(), processParams.dropLimit())) {
+    std::string err = std::string("Unsupported drop policy \'") + processParams.dropPolicy() + "\'";
+    return Nan::ThrowError(err.c_str());
+  }
+
+  std::vector<iPipelineStage *> stages;
+  std::vector<std::shared_ptr<Persist> > persistentStages;
+
+  if ((0 == stagesArray->Length()) || (stagesArray->Length() > MyWorker::kMaxStages)) {
+    std::string err = std::string("Pipeline requires between 1 and ") + std::to_string(MyWorker::kMaxStages) + " stages";
+    return Nan::ThrowError(err.c_str());
+  }
+
+  for (uint32_t i=0; i<stagesArray->Length(); ++i) {
+    Local<Value> stageVal = stagesArray->Get(Nan::GetCurrentContext(), i).ToLocalChecked();
+    std::string stageName = std::string("Pipeline stage ") + std::to_string(i);
+    iPipelineStage *stage = NULL;
+    if (stageVal->IsObject()) {
+      Local<Object> stageObj = Local<Object>::Cast(stageVal);
+      std::string className = *Nan::Utf8String(stageObj->GetConstructorName());
+      if (!className.compare("Packer") || !className.compare("ScaleConverter") || !className.compare("Flipper") ||
+          !className.compare("Encoder") || !className.compare("Decoder"))
+        stage = dynamic_cast<iPipelineStage *>(Nan::ObjectWrap::Unwrap<Nan::ObjectWrap>(stageObj));
+      if (stage)
+        persistentStages.push_back(std::make_shared<Persist>(stageObj));
+      // as for a Decoder on its own, skipping compressed frames would corrupt the frames decoded after them
+      if (stage && !className.compare("Decoder") && processParams.dropPolicy().compare("process")) {
+        std::string err = stageName + " is a Decoder, so the pipeline cannot have a drop policy";
+        return Nan::ThrowError(err.c_str());
+      }
+    }
+    if (!stage) {
+      std::string err = stageName + " is not a supported processing object";
+      return Nan::ThrowError(err.c_str());
+    }
+    if (0 == stage->stageDstBytes()) {
+      std::string err = stageName + " has not been set up successfully";
+      return Nan::ThrowError(err.c_str());
+    }
+    if (i && (stage->stageSrcBytes() > stages.back()->stageDstBytes())) {
+      std::string err = stageName + " requires " + std::to_string(stage->stageSrcBytes()) + 
+        " source bytes, previous stage produces " + std::to_string(stages.back()->stageDstBytes());
+      return Nan::ThrowError(err.c_str());
+    }
+    stages.push_back(stage);
+  }
+
+  mStages = stages;
+  mPersistentStages = persistentStages;
+  mSrcBytesReq = mStages.front()->stageSrcBytes();
+  mDstBytesReq = mStages.back()->stageDstBytes();
+  mWorker->setNumStages(mStages.size());
+  printDebug(eInfo, "Pipeline with %d stages, source bytes %d, destination bytes %d\n", (uint32_t)mStages.size(), mSrcBytesReq, mDstBytesReq);
+}
+
+NAN_METHOD(Pipeline::SetInfo) {
+  if (info.Length() != 3)
+    return Nan::ThrowError("Pipeline SetInfo expects 3 arguments");
+  if (!info[0]->IsArray())
+    return Nan::ThrowError("Pipeline SetInfo requires a valid stages array as the first parameter");
+  if (!info[1]->IsObject())
+    return Nan::ThrowError("Pipeline SetInfo requires a valid processing parameters object as the second parameter");
+  if (!info[2]->IsNumber())
+    return Nan::ThrowError("Pipeline SetInfo requires a valid debug level as the third parameter");
+  Local<Array> stagesArray = Local<Array>::Cast(info[0]);
+  Local<Object> paramTags = Local<Object>::Cast(info[1]);
+
+  Pipeline* obj = Nan::ObjectWrap::Unwrap<Pipeline>(info.Holder());
+  obj->setDebug((eDebugLevel)Nan::To<uint32_t>(info[2]).FromJust());
+
+  if (obj->mWorker->numInFlight())
+    return Nan::ThrowError("Pipeline SetInfo called while frames are being processed");
+  
+  Nan::TryCatch try_catch;
+  obj->doSetInfo(stagesArray, paramTags);
+  if (try_catch.HasCaught()) {
+    obj->mSetInfoOK = false;
+    try_catch.ReThrow();
+    return;
+  }
+
+  obj->mSetInfoOK = true;
+  info.GetReturnValue().Set(Nan::New(obj->mDstBytesReq));
+}
+
+NAN_METHOD(Pipeline::Process) {
+  if ((info.Length() < 3) || (info.Length() > 4))
+    return Nan::ThrowError("Pipeline Process expects 3 or 4 arguments");
+  if (!info[0]->IsArray())
+    return Nan::ThrowError("Pipeline Process requires a valid source buffer array as the first parameter");
+  if (!info[1]->IsObject())
+    return Nan::ThrowError("Pipeline Process requires a valid destination buffer as the second parameter");
+  if (!info[2]->IsFunction())
+    return Nan::ThrowError("Pipeline Process requires a valid callback as the third parameter");
+
+  Local<Array> srcBufArray = Local<Array>::Cast(info[0]);
+  Local<Object> dstBufObj = Local<Object>::Cast(info[1]);
+  Local<Function> callback = Local<Function>::Cast(info[2]);
+
+  Pipeline* obj = Nan::ObjectWrap::Unwrap<Pipeline>(info.Holder());
+
+  if (!obj->mSetInfoOK)
+    return Nan::ThrowError("Pipeline Process called with incorrect setup parameters");
+
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
+  if (1 != srcBufArray->Length()) {
+    std::string err = std::string("Pipeline requires single source buffer - received ") + std::to_string(srcBufArray->Length());
+    return Nan::ThrowError(err.c_str());
+  }
+  Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(Nan::GetCurrentContext(), 0).ToLocalChecked());
+
+  if (obj->mSrcBytesReq > (uint32_t)node::Buffer::Length(srcBufObj))
+    return Nan::ThrowError("Insufficient source buffer for pipeline");
+
+  if (obj->mDstBytesReq > node::Buffer::Length(dstBufObj))
+    return Nan::ThrowError("Insufficient destination buffer for pipeline");
+
+  std::shared_ptr<PipelineProcessData> ppd = obj->mProcessDataPool.acquire();
+  ppd->set(srcBufObj, dstBufObj, obj->mStages.size());
+  obj->mWorker->doFrame(ppd, obj, callback, MyWorker::deadlineArg(info, 3));
+
+  info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
+}
+
+NAN_METHOD(Pipeline::Quit) {
+  if (info.Length() != 1)
+    return Nan::ThrowError("Pipeline quit expects 1 argument");
+  if (!info[0]->IsFunction())
+    return Nan::ThrowError("Pipeline quit requires a valid callback as the parameter");
+  Nan::Callback *callback = new Nan::Callback(Local<Function>::Cast(info[0]));
+  Pipeline* obj = Nan::ObjectWrap::Unwrap<Pipeline>(info.Holder());
+
+  if (obj->mWorker != NULL)
+    obj->mWorker->quit(callback);
+
+  info.GetReturnValue().SetUndefined();
+}
+
+NAN_MODULE_INIT(Pipeline::Init) {
+  Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+  tpl->SetClassName(Nan::New("Pipeline").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+
+  SetPrototypeMethod(tpl, "setInfo", SetInfo);
+  SetPrototypeMethod(tpl, "process", Process);
+  SetPrototypeMethod(tpl, "quit", Quit);
+
+  constructor().Reset(Nan::GetFunction(tpl).ToLocalChecked());
+  Nan::Set(target, Nan::New("Pipeline").ToLocalChecked(),
+    Nan::GetFunction(tpl).ToLocalChecked());
+}
+
+} // namespace streampunk
@@ -0,0 +1,83 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "iDebug.h"
+#include "iProcess.h"
+#include "ProcessDataPool.h"
+#include <memory>
+#include <vector>
+
+namespace streampunk {
+
+class MyWorker;
+class Persist;
+class PipelineProcessData;
+
+// Runs a sequence of processing objects as the stages of one worker, passing frames between
+// the stages as native memory so that only the final result is returned to JS.
+class Pipeline : public Nan::ObjectWrap, public iProcess, public iDebug {
+public:
+  static NAN_MODULE_INIT(Init);
+
+  // iProcess
+  uint32_t processFrame (std::shared_ptr<iProcessData> processData);
+  uint32_t processStage (uint32_t stage, std::shared_ptr<iProcessData> processData);
+  
+private:
+  explicit Pipeline(Nan::Callback *callback);
+  ~Pipeline();
+
+  void doSetInfo(v8::Local<v8::Array> stagesArray, v8::Local<v8::Object> paramTags);
+
+  static NAN_METHOD(New) {
+    if (info.IsConstructCall()) {
+      if (!((info.Length() == 1) && (info[0]->IsFunction())))
+        return Nan::ThrowError("Pipeline constructor requires a valid callback as the parameter");
+      Nan::Callback *callback = new Nan::Callback(v8::Local<v8::Function>::Cast(info[0]));
+      Pipeline *obj = new Pipeline(callback);
+      obj->Wrap(info.This());
+      info.GetReturnValue().Set(info.This());
+    } else {
+      const int argc = 1;
+      v8::Local<v8::Value> argv[] = { info[0] };
+      v8::Local<v8::Function> cons = Nan::New(constructor());
+      info.GetReturnValue().Set(cons->NewInstance(Nan::GetCurrentContext(), argc, argv).ToLocalChecked());
+    }
+  }
+
+  static inline Nan::Persistent<v8::Function> & constructor() {
+    static Nan::Persistent<v8::Function> my_constructor;
+    return my_constructor;
+  }
+
+  static NAN_METHOD(SetInfo);
+  static NAN_METHOD(Process);
+  static NAN_METHOD(Quit);
+
+  MyWorker *mWorker;
+  bool mSetInfoOK;
+  uint32_t mSrcBytesReq;
+  uint32_t mDstBytesReq;
+  std::vector<iPipelineStage *> mStages;
+  std::vector<std::shared_ptr<Persist> > mPersistentStages;
+  ProcessDataPool<PipelineProcessData> mProcessDataPool;
+};
+
+} // namespace streampunk
+
+#endif
@@ -0,0 +1,405 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include "PolyphaseScaler.h"
+#include "CpuFeatures.h"
+#include "WorkerPool.h"
+
+#include <cmath>
+#include <algorithm>
+
+#ifdef CODECADON_X86
+#include <immintrin.h>
+#endif
+
+namespace streampunk {
+
+// Coefficients sum to 1 << 14. The first of the two filter stages keeps 4 fractional bits in its 16-bit intermediate
+// samples, which the second rounds away: each stage makes clamp((sum((src & mask) * c) + (1 << (shift - 1))) >> shift)
+static const uint32_t coeffBits = 14;
+struct FilterStage {
+  uint16_t mask;
+  uint32_t shift;
+  uint16_t maxVal;
+};
+static const FilterStage firstStage = { 0x3ff, 10, 0x7fff };
+static const FilterStage lastStage = { 0xffff, 18, 0x3ff };
+
+// SIMD line kernels for the filter stages, bit-exact with the scalar code below.
+// Each returns the number of output samples done from the start of the line, leaving the rest to the scalar code.
+struct ScalerLineKernels {
+  // taps coefficients for each output sample, applied to the source samples from pos
+  uint32_t (*hFilter)(const uint16_t *src, uint16_t *dst, uint32_t width, const uint32_t *pos, const int16_t *coeffs,
+                      uint32_t taps, const FilterStage &stage);
+  // one coefficient for each of taps lines
+  uint32_t (*vFilter)(const uint16_t *const *lines, const int16_t *coeffs, uint32_t taps, uint16_t *dst, uint32_t width,
+                      const FilterStage &stage);
+};
+
+#ifdef CODECADON_X86
+
+// The kernels are instantiated for the common numbers of taps, so that the loops over the taps unroll, with
+// fixedTaps 0 for any other number
+
+// The horizontal kernel takes taps in groups of 4, with the groups for 2 output samples side by side in a register.
+// The stage is read into locals first, as the stores to dst could otherwise be taken to change it
+
+// the products of 4 taps for outputs at pos0 and pos1, with coefficients k for both
+CODECADON_TARGET("ssse3")
+static inline __m128i hTaps4_SSSE3(const uint16_t *src, uint32_t pos0, uint32_t pos1, __m128i k, __m128i mask) {
+  __m128i s = _mm_castpd_si128(_mm_loadh_pd(_mm_castsi128_pd(_mm_loadl_epi64((const __m128i *)(src + pos0))),
+                                            (const double *)(src + pos1)));
+  return _mm_madd_epi16(_mm_and_si128(s, mask), k);
+}
+
+template <uint32_t fixedTaps>
+CODECADON_TARGET("ssse3")
+static uint32_t hFilterTaps_SSSE3(const uint16_t *src, uint16_t *dst, uint32_t width, const uint32_t *pos, const int16_t *coeffs,
+                                  uint32_t tableTaps, const FilterStage &stage) {
+  const uint32_t taps = fixedTaps ? fixedTaps : tableTaps;
+  const __m128i mask = _mm_set1_epi16(stage.mask);
+  const __m128i round = _mm_set1_epi32(1 << (stage.shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(stage.shift);
+  const __m128i maxVal = _mm_set1_epi16(stage.maxVal);
+  uint32_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const uint32_t *p = pos + x;
+    const int16_t *c = coeffs + x * taps;
+    __m128i acc0, acc1, acc2, acc3;
+    if (4 == taps) {
+      // the coefficients for 2 output samples are together in memory
+      acc0 = hTaps4_SSSE3(src, p[0], p[1], _mm_loadu_si128((const __m128i *)(c + 0)), mask);
+      acc1 = hTaps4_SSSE3(src, p[2], p[3], _mm_loadu_si128((const __m128i *)(c + 8)), mask);
+      acc2 = hTaps4_SSSE3(src, p[4], p[5], _mm_loadu_si128((const __m128i *)(c + 16)), mask);
+      acc3 = hTaps4_SSSE3(src, p[6], p[7], _mm_loadu_si128((const __m128i *)(c + 24)), mask);
+    } else {
+      acc0 = acc1 = acc2 = acc3 = _mm_setzero_si128();
+      for (uint32_t t = 0; t < taps; t += 4) {
+#define CODECADON_HTAPS(i) hTaps4_SSSE3(src + t, p[i * 2], p[i * 2 + 1], \
+          _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(c + taps * i * 2 + t)), \
+                             _mm_loadl_epi64((const __m128i *)(c + taps * (i * 2 + 1) + t))), mask)
+        acc0 = _mm_add_epi32(acc0, CODECADON_HTAPS(0));
+        acc1 = _mm_add_epi32(acc1, CODECADON_HTAPS(1));
+        acc2 = _mm_add_epi32(acc2, CODECADON_HTAPS(2));
+        acc3 = _mm_add_epi32(acc3, CODECADON_HTAPS(3));
+#undef CODECADON_HTAPS
+      }
+    }
+    __m128i sum0 = _mm_sra_epi32(_mm_add_epi32(_mm_hadd_epi32(acc0, acc1), round), shift);
+    __m128i sum1 = _mm_sra_epi32(_mm_add_epi32(_mm_hadd_epi32(acc2, acc3), round), shift);
+    __m128i d = _mm_packs_epi32(sum0, sum1);
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_min_epi16(_mm_max_epi16(d, _mm_setzero_si128()), maxVal));
+  }
+  return x;
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t hFilter_SSSE3(const uint16_t *src, uint16_t *dst, uint32_t width, const uint32_t *pos, const int16_t *coeffs,
+                              uint32_t taps, const FilterStage &stage) {
+  switch (taps) {
+  case 4: return hFilterTaps_SSSE3<4>(src, dst, width, pos, coeffs, taps, stage);
+  case 8: return hFilterTaps_SSSE3<8>(src, dst, width, pos, coeffs, taps, stage);
+  default: return (taps & 3) ? 0 : hFilterTaps_SSSE3<0>(src, dst, width, pos, coeffs, taps, stage);
+  }
+}
+
+// The vertical kernels interleave the samples of pairs of lines to multiply them by a coefficient pair, with a zero
+// coefficient pairing the last line when there are an odd number of taps
+static const uint32_t maxVTaps = 64;
+
+// from sample x, which is also the tail of the AVX2 kernel
+template <uint32_t fixedTaps>
+CODECADON_TARGET("ssse3")
+static inline uint32_t vFilterTaps_SSSE3(const uint16_t *const *tableLines, const int16_t *coeffs, uint32_t tableTaps,
+                                         uint16_t *dst, uint32_t x, uint32_t width, const FilterStage &stage) {
+  const uint32_t taps = fixedTaps ? fixedTaps : tableTaps;
+  // local copies of the line pointers, which the stores cannot be taken to overwrite
+  const uint16_t *lines[maxVTaps];
+  __m128i pairs[maxVTaps / 2];
+  for (uint32_t t = 0; t < taps; ++t)
+    lines[t] = tableLines[t];
+  for (uint32_t t = 0; t < taps; t += 2)
+    pairs[t / 2] = _mm_set1_epi32((uint16_t)coeffs[t] | ((t + 1 < taps) ? (uint32_t)(uint16_t)coeffs[t + 1] << 16 : 0));
+  const __m128i mask = _mm_set1_epi16(stage.mask);
+  const __m128i round = _mm_set1_epi32(1 << (stage.shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(stage.shift);
+  const __m128i maxVal = _mm_set1_epi16(stage.maxVal);
+  for (; x + 8 <= width; x += 8) {
+    __m128i lo = round;
+    __m128i hi = round;
+    for (uint32_t t = 0; t < taps; t += 2) {
+      __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(lines[t] + x)), mask);
+      __m128i b = (t + 1 < taps) ? _mm_and_si128(_mm_loadu_si128((const __m128i *)(lines[t + 1] + x)), mask) : _mm_setzero_si128();
+      lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), pairs[t / 2]));
+      hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), pairs[t / 2]));
+    }
+    __m128i d = _mm_packs_epi32(_mm_sra_epi32(lo, shift), _mm_sra_epi32(hi, shift));
+    _mm_storeu_si128((__m128i *)(dst + x), _mm_min_epi16(_mm_max_epi16(d, _mm_setzero_si128()), maxVal));
+  }
+  return x;
+}
+
+template <uint32_t fixedTaps>
+CODECADON_TARGET("avx2")
+static uint32_t vFilterTaps_AVX2(const uint16_t *const *tableLines, const int16_t *coeffs, uint32_t tableTaps,
+                                 uint16_t *dst, uint32_t width, const FilterStage &stage) {
+  const uint32_t taps = fixedTaps ? fixedTaps : tableTaps;
+  const uint16_t *lines[maxVTaps];
+  __m256i pairs[maxVTaps / 2];
+  for (uint32_t t = 0; t < taps; ++t)
+    lines[t] = tableLines[t];
+  for (uint32_t t = 0; t < taps; t += 2)
+    pairs[t / 2] = _mm256_set1_epi32((uint16_t)coeffs[t] | ((t + 1 < taps) ? (uint32_t)(uint16_t)coeffs[t + 1] << 16 : 0));
+  const __m256i mask = _mm256_set1_epi16(stage.mask);
+  const __m256i round = _mm256_set1_epi32(1 << (stage.shift - 1));
+  const __m128i shift = _mm_cvtsi32_si128(stage.shift);
+  const __m256i maxVal = _mm256_set1_epi16(stage.maxVal);
+  uint32_t x = 0;
+  for (; x + 16 <= width; x += 16) {
+    __m256i lo = round;
+    __m256i hi = round;
+    for (uint32_t t = 0; t < taps; t += 2) {
+      __m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(lines[t] + x)), mask);
+      __m256i b = (t + 1 < taps) ? _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(lines[t + 1] + x)), mask)
+                                 : _mm256_setzero_si256();
+      lo = _mm256_add_epi32(lo, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), pairs[t / 2]));
+      hi = _mm256_add_epi32(hi, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), pairs[t / 2]));
+    }
+    // the unpacks work within each 128-bit lane, and so does the pack that puts the samples back in order
+    __m256i d = _mm256_packs_epi32(_mm256_sra_epi32(lo, shift), _mm256_sra_epi32(hi, shift));
+    _mm256_storeu_si256((__m256i *)(dst + x), _mm256_min_epi16(_mm256_max_epi16(d, _mm256_setzero_si256()), maxVal));
+  }
+  // no penalty for the SSE tail if it is not inlined
+  _mm256_zeroupper();
+  return vFilterTaps_SSSE3<fixedTaps>(lines, coeffs, taps, dst, x, width, stage);
+}
+
+CODECADON_TARGET("ssse3")
+static uint32_t vFilter_SSSE3(const uint16_t *const *lines, const int16_t *coeffs, uint32_t taps, uint16_t *dst, uint32_t width,
+                              const FilterStage &stage) {
+  switch (taps) {
+  case 2: return vFilterTaps_SSSE3<2>(lines, coeffs, taps, dst, 0, width, stage);
+  case 3: return vFilterTaps_SSSE3<3>(lines, coeffs, taps, dst, 0, width, stage);
+  case 4: return vFilterTaps_SSSE3<4>(lines, coeffs, taps, dst, 0, width, stage);
+  case 6: return vFilterTaps_SSSE3<6>(lines, coeffs, taps, dst, 0, width, stage);
+  case 8: return vFilterTaps_SSSE3<8>(lines, coeffs, taps, dst, 0, width, stage);
+  default: return (taps > maxVTaps) ? 0 : vFilterTaps_SSSE3<0>(lines, coeffs, taps, dst, 0, width, stage);
+  }
+}
+
+CODECADON_TARGET("avx2")
+static uint32_t vFilter_AVX2(const uint16_t *const *lines, const int16_t *coeffs, uint32_t taps, uint16_t *dst, uint32_t width,
+                             const FilterStage &stage) {
+  switch (taps) {
+  case 2: return vFilterTaps_AVX2<2>(lines, coeffs, taps, dst, width, stage);
+  case 3: return vFilterTaps_AVX2<3>(lines, coeffs, taps, dst, width, stage);
+  case 4: return vFilterTaps_AVX2<4>(lines, coeffs, taps, dst, width, stage);
+  case 6: return vFilterTaps_AVX2<6>(lines, coeffs, taps, dst, width, stage);
+  case 8: return vFilterTaps_AVX2<8>(lines, coeffs, taps, dst, width, stage);
+  default: return (taps > maxVTaps) ? 0 : vFilterTaps_AVX2<0>(lines, coeffs, taps, dst, width, stage);
+  }
+}
+
+#endif
+
+static ScalerLineKernels chooseKernels() {
+  ScalerLineKernels kernels = { NULL, NULL };
+#ifdef CODECADON_X86
+  const CpuFeatures &cpu = CpuFeatures::instance();
+  if (cpu.ssse3()) {
+    kernels.hFilter = &hFilter_SSSE3;
+    kernels.vFilter = &vFilter_SSSE3;
+  }
+  if (cpu.ssse3() && cpu.avx2())
+    kernels.vFilter = &vFilter_AVX2;
+#endif
+  return kernels;
+}
+
+static const ScalerLineKernels &scalerLineKernels() {
+  static const ScalerLineKernels kernels = chooseKernels();
+  return kernels;
+}
+
+static inline uint16_t filterResult(int32_t sum, const FilterStage &stage) {
+  return (uint16_t)std::min<int32_t>(std::max<int32_t>((sum + (1 << (stage.shift - 1))) >> stage.shift, 0), stage.maxVal);
+}
+
+static void hFilterLine(const uint16_t *src, uint16_t *dst, uint32_t width, const uint32_t *pos, const int16_t *coeffs,
+                        uint32_t taps, const FilterStage &stage) {
+  const ScalerLineKernels &kernels = scalerLineKernels();
+  uint32_t x = kernels.hFilter ? kernels.hFilter(src, dst, width, pos, coeffs, taps, stage) : 0;
+  for (; x < width; ++x) {
+    const uint16_t *s = src + pos[x];
+    const int16_t *c = coeffs + x * taps;
+    int32_t sum = 0;
+    for (uint32_t t = 0; t < taps; ++t)
+      sum += (s[t] & stage.mask) * c[t];
+    dst[x] = filterResult(sum, stage);
+  }
+}
+
+static void vFilterLine(const uint16_t *const *lines, const int16_t *coeffs, uint32_t taps, uint16_t *dst, uint32_t width,
+                        const FilterStage &stage) {
+  const ScalerLineKernels &kernels = scalerLineKernels();
+  uint32_t x = kernels.vFilter ? kernels.vFilter(lines, coeffs, taps, dst, width, stage) : 0;
+  for (; x < width; ++x) {
+    int32_t sum = 0;
+    for (uint32_t t = 0; t < taps; ++t)
+      sum += (lines[t][x] & stage.mask) * coeffs[t];
+    dst[x] = filterResult(sum, stage);
+  }
+}
+
+PolyphaseScaler::PolyphaseScaler(uint32_t srcWidth, uint32_t srcHeight, bool srcInterlaced, bool srcTff,
+                                 uint32_t dstWidth, uint32_t dstHeight, bool dstInterlaced, bool dstTff)
+  : mSrcWidth(srcWidth), mSrcHeight(srcHeight), mDstWidth(dstWidth), mDstHeight(dstHeight) {
+  // a luma sample at x is centred on the source position (x + 0.5) * xScale - 0.5, and a chroma sample sits with
+  // the luma sample at 2x
+  double xScale = (double)srcWidth / dstWidth;
+  mLumaFilter = makeFilter(srcWidth, dstWidth, xScale, (xScale - 1.0) / 2, std::max(1.0, xScale), 4);
+  mChromaFilter = makeFilter(srcWidth / 2, dstWidth / 2, xScale, (xScale - 1.0) / 4, std::max(1.0, xScale), 4);
+
+  if (!srcInterlaced) {
+    // the lines of both fields of an interlaced destination come from the whole frame in one pass, with a filter
+    // wide enough for the spacing of the lines in a field
+    mPasses.push_back(makePass({ 0, 1, srcHeight }, { 0, 1, dstHeight }, dstInterlaced ? 2 : 1));
+    return;
+  }
+  // the first field in time, then the second - a progressive destination has the lines that match each field
+  for (uint32_t field = 0; field < 2; ++field) {
+    uint32_t srcParity = (srcTff ? 0 : 1) ^ field;
+    uint32_t dstParity = dstInterlaced ? (dstTff ? 0 : 1) ^ field : srcParity;
+    mPasses.push_back(makePass({ srcParity, 2, (srcHeight + 1 - srcParity) / 2 },
+                               { dstParity, 2, (dstHeight + 1 - dstParity) / 2 }, 1));
+  }
+}
+
+PolyphaseScaler::FilterTable PolyphaseScaler::makeFilter(uint32_t srcSize, uint32_t dstSize, double scale, double offset,
+                                                         double radius, uint32_t tapAlign) {
+  std::vector<int32_t> firstTaps(dstSize);
+  std::vector<std::vector<double> > weights(dstSize);
+  uint32_t taps = 1;
+  for (uint32_t i = 0; i < dstSize; ++i) {
+    double centre = scale * i + offset;
+    int32_t lo = (int32_t)floor(centre - radius);
+    int32_t hi = (int32_t)ceil(centre + radius);
+    // taps beyond the edges of the picture repeat the edge sample
+    int32_t first = std::min(std::max(lo, 0), (int32_t)srcSize - 1);
+    int32_t last = std::min(std::max(hi, 0), (int32_t)srcSize - 1);
+    std::vector<double> &w = weights[i];
+    w.assign(last - first + 1, 0.0);
+    for (int32_t k = lo; k <= hi; ++k) {
+      double weight = 1.0 - fabs(k - centre) / radius;
+      if (weight > 0.0)
+        w[std::min(std::max(k, 0), (int32_t)srcSize - 1) - first] += weight;
+    }
+    while ((w.size() > 1) && (0.0 == w.back()))
+      w.pop_back();
+    while ((w.size() > 1) && (0.0 == w.front())) {
+      w.erase(w.begin());
+      ++first;
+    }
+    firstTaps[i] = first;
+    taps = std::max<uint32_t>(taps, (uint32_t)w.size());
+  }
+
+  FilterTable table;
+  table.taps = std::min((taps + tapAlign - 1) / tapAlign * tapAlign, srcSize);
+  table.pos.resize(dstSize);
+  table.coeffs.assign(dstSize * table.taps, 0);
+  for (uint32_t i = 0; i < dstSize; ++i) {
+    const std::vector<double> &w = weights[i];
+    table.pos[i] = std::min<uint32_t>(firstTaps[i], srcSize - table.taps);
+    int16_t *c = &table.coeffs[i * table.taps + firstTaps[i] - table.pos[i]];
+    double sum = 0.0;
+    for (size_t t = 0; t < w.size(); ++t)
+      sum += w[t];
+    // the rounding error goes to the largest coefficient, so that each set sums exactly to unity
+    int32_t total = 0;
+    size_t largest = 0;
+    for (size_t t = 0; t < w.size(); ++t) {
+      c[t] = (int16_t)lround(w[t] / sum * (1 << coeffBits));
+      total += c[t];
+      if (c[t] > c[largest])
+        largest = t;
+    }
+    c[largest] += (int16_t)((1 << coeffBits) - total);
+  }
+  return table;
+}
+
+PolyphaseScaler::Pass PolyphaseScaler::makePass(const LineView &src, const LineView &dst, uint32_t dstLineSpacing) const {
+  // a destination line at frame position y is centred on the source frame position (y + 0.5) * yScale - 0.5
+  double yScale = (double)mSrcHeight / mDstHeight;
+  double scale = yScale * dst.step / src.step;
+  Pass pass;
+  pass.src = src;
+  pass.dst = dst;
+  pass.vFilter = makeFilter(src.lines, dst.lines, scale, ((dst.first + 0.5) * yScale - 0.5 - src.first) / src.step,
+                            std::max(1.0, scale * dstLineSpacing), 1);
+  // the horizontal filter is the costlier, so it goes second when that leaves it fewer lines to filter
+  pass.verticalFirst = dst.lines < src.lines;
+  return pass;
+}
+
+void PolyphaseScaler::scale(uint8_t *const *srcData, const uint32_t *srcPitch, uint8_t *const *dstData, const uint32_t *dstPitch,
+                            uint32_t numThreads) const {
+  // each destination line depends only on the source, so bands of lines can be made in any order
+  for (const Pass &pass : mPasses)
+    WorkerPool::instance().runLines(pass.dst.lines, numThreads, 1, [&](uint32_t firstLine, uint32_t numLines) {
+      for (uint32_t p = 0; p < 3; ++p)
+        scalePlane((const uint16_t *)srcData[p], srcPitch[p], p ? mSrcWidth / 2 : mSrcWidth,
+                   (uint16_t *)dstData[p], dstPitch[p], p ? mDstWidth / 2 : mDstWidth, p ? mChromaFilter : mLumaFilter,
+                   pass, firstLine, numLines);
+    });
+}
+
+void PolyphaseScaler::scalePlane(const uint16_t *src, uint32_t srcPitch, uint32_t srcWidth, uint16_t *dst, uint32_t dstPitch, uint32_t dstWidth,
+                                 const FilterTable &hFilter, const Pass &pass, uint32_t firstLine, uint32_t numLines) const {
+  const FilterTable &vFilter = pass.vFilter;
+  uint32_t vTaps = vFilter.taps;
+  std::vector<const uint16_t *> lines(vTaps);
+  auto srcLine = [&](uint32_t y) { return (const uint16_t *)((const uint8_t *)src + (pass.src.first + y * pass.src.step) * srcPitch); };
+  auto dstLine = [&](uint32_t y) { return (uint16_t *)((uint8_t *)dst + (pass.dst.first + y * pass.dst.step) * dstPitch); };
+
+  if (pass.verticalFirst) {
+    // each output line is filtered down the source lines into a single line, then across it
+    std::vector<uint16_t> line(srcWidth);
+    for (uint32_t y = firstLine; y < firstLine + numLines; ++y) {
+      for (uint32_t t = 0; t < vTaps; ++t)
+        lines[t] = srcLine(vFilter.pos[y] + t);
+      vFilterLine(lines.data(), &vFilter.coeffs[y * vTaps], vTaps, line.data(), srcWidth, firstStage);
+      hFilterLine(line.data(), dstLine(y), dstWidth, hFilter.pos.data(), hFilter.coeffs.data(), hFilter.taps, lastStage);
+    }
+    return;
+  }
+
+  // source lines are filtered across into a ring of as many lines as the vertical filter has taps - the lines each
+  // output line needs only move down the picture, so each source line is filtered once
+  std::vector<uint16_t> ring(vTaps * dstWidth);
+  uint32_t nextLine = 0;
+  for (uint32_t y = firstLine; y < firstLine + numLines; ++y) {
+    uint32_t firstSrcLine = vFilter.pos[y];
+    for (nextLine = std::max(nextLine, firstSrcLine); nextLine < firstSrcLine + vTaps; ++nextLine)
+      hFilterLine(srcLine(nextLine), &ring[(nextLine % vTaps) * dstWidth], dstWidth,
+                  hFilter.pos.data(), hFilter.coeffs.data(), hFilter.taps, firstStage);
+    for (uint32_t t = 0; t < vTaps; ++t)
+      lines[t] = &ring[((firstSrcLine + t) % vTaps) * dstWidth];
+    vFilterLine(lines.data(), &vFilter.coeffs[y * vTaps], vTaps, dstLine(y), dstWidth, lastStage);
+  }
+}
+
+} // namespace streampunk
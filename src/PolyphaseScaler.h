@@ -0,0 +1,80 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef POLYPHASESCALER_H
+#define POLYPHASESCALER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace streampunk {
+
+// A separable polyphase scaler for 10-bit 4:2:2 planar pictures, the native alternative to swscale.
+// The filter is the triangle of swscale's bilinear mode, widened when scaling down, with fixed point coefficients
+// worked out at construction for every output position. Chroma is co-sited with the even luma samples.
+// Interlaced pictures are scaled a field at a time, with each field's lines at their true positions in the frame,
+// and a progressive source feeds each field of an interlaced destination from all of its lines.
+class PolyphaseScaler {
+public:
+  PolyphaseScaler(uint32_t srcWidth, uint32_t srcHeight, bool srcInterlaced, bool srcTff,
+                  uint32_t dstWidth, uint32_t dstHeight, bool dstInterlaced, bool dstTff);
+  ~PolyphaseScaler() {}
+
+  // scales the Y, U and V planes of a picture, with line pitches in bytes, into dstWidth x dstHeight samples - with
+  // numThreads above 1 the destination lines are split into bands across the worker pool, with the same result
+  void scale(uint8_t *const *srcData, const uint32_t *srcPitch, uint8_t *const *dstData, const uint32_t *dstPitch,
+             uint32_t numThreads = 1) const;
+
+private:
+  // the taps of each output sample - coefficients in units of 2^-14 applied to the source samples from pos
+  struct FilterTable {
+    uint32_t taps;
+    std::vector<uint32_t> pos;
+    std::vector<int16_t> coeffs;
+  };
+  // the lines of a picture taking part in a pass - every line from first, or every other line for a field
+  struct LineView {
+    uint32_t first;
+    uint32_t step;
+    uint32_t lines;
+  };
+  struct Pass {
+    LineView src;
+    LineView dst;
+    FilterTable vFilter;
+    bool verticalFirst;
+  };
+
+  // output i is centred on source sample scale * i + offset, with taps out to radius source samples either side
+  static FilterTable makeFilter(uint32_t srcSize, uint32_t dstSize, double scale, double offset, double radius, uint32_t tapAlign);
+  // dstLineSpacing is the distance in destination lines between the lines of a field, 2 for interlaced lines made from
+  // a progressive frame
+  Pass makePass(const LineView &src, const LineView &dst, uint32_t dstLineSpacing) const;
+  // makes numLines of the pass's destination lines from firstLine
+  void scalePlane(const uint16_t *src, uint32_t srcPitch, uint32_t srcWidth, uint16_t *dst, uint32_t dstPitch, uint32_t dstWidth,
+                  const FilterTable &hFilter, const Pass &pass, uint32_t firstLine, uint32_t numLines) const;
+
+  const uint32_t mSrcWidth;
+  const uint32_t mSrcHeight;
+  const uint32_t mDstWidth;
+  const uint32_t mDstHeight;
+  FilterTable mLumaFilter;
+  FilterTable mChromaFilter;
+  std::vector<Pass> mPasses;
+};
+
+} // namespace streampunk
+
+#endif
@@ -0,0 +1,52 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef PROCESSDATAPOOL_H
+#define PROCESSDATAPOOL_H
+
+#include <vector>
+#include <memory>
+
+namespace streampunk {
+
+// Keeps the process data objects of an object's frames for reuse, so that a steady stream of frames
+// makes no allocations. An entry is free once the pool holds its only reference - the worker drops
+// its reference on the main thread after the frame callback has run, so acquire must only be called there too.
+// Frames finish in the order they were started, so the entries are handed out round a ring and the next
+// one is normally free - a new entry is only made when it is not.
+template <class T>
+class ProcessDataPool {
+public:
+  ProcessDataPool() : mNext(0) {}
+  ~ProcessDataPool() {}
+
+  std::shared_ptr<T> acquire() {
+    if ((mNext == mPool.size()) || (1 != mPool[mNext].use_count()))
+      mPool.insert(mPool.begin() + mNext, std::make_shared<T>());
+    std::shared_ptr<T> entry = mPool[mNext];
+    mNext = (mNext + 1) % mPool.size();
+    return entry;
+  }
+
+private:
+  std::vector<std::shared_ptr<T> > mPool;
+  size_t mNext;
+
+  ProcessDataPool(const ProcessDataPool &);
+};
+
+} // namespace streampunk
+
+#endif
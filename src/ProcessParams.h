@@ -0,0 +1,101 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef PROCESSPARAMS_H
+#define PROCESSPARAMS_H
+
+#include <nan.h>
+#include <sstream>
+#include "Params.h"
+
+using namespace v8;
+
+namespace streampunk {
+
+class ProcessParams : public Params {
+public:
+  ProcessParams(Local<Object> tags)
+    : mThreads(unpackNum(tags, "threads", 1)),
+      mQueueDepth(unpackNum(tags, "queueDepth", 0)),
+      mParallelFrames(unpackNum(tags, "parallelFrames", 1)),
+      mDropPolicy(unpackStr(tags, "dropPolicy", "process")),
+      mDropLimit(unpackNum(tags, "dropLimit", 1)),
+      mPreTouch(unpackBool(tags, "preTouch", false)),
+      mFieldChroma(unpackBool(tags, "fieldChroma", false)),
+      mDither(unpackBool(tags, "dither", false)),
+      mInPlace(unpackBool(tags, "inPlace", false)),
+      mScaler(unpackStr(tags, "scaler", "swscale")),
+      mAnimate(unpackBool(tags, "animate", false)),
+      mCompose(unpackBool(tags, "compose", false))
+  {}
+  ~ProcessParams() {}
+
+  uint32_t threads() const  { return mThreads ? mThreads : 1; }
+  uint32_t queueDepth() const  { return mQueueDepth; }
+  uint32_t parallelFrames() const  { return mParallelFrames ? mParallelFrames : 1; }
+  std::string dropPolicy() const  { return mDropPolicy; }
+  uint32_t dropLimit() const  { return mDropLimit ? mDropLimit : 1; }
+  bool preTouch() const  { return mPreTouch; }
+  bool fieldChroma() const  { return mFieldChroma; }
+  bool dither() const  { return mDither; }
+  bool inPlace() const  { return mInPlace; }
+  std::string scaler() const  { return mScaler; }
+  bool animate() const  { return mAnimate; }
+  bool compose() const  { return mCompose; }
+
+  std::string toString() const  { 
+    std::stringstream ss;
+    ss << "Process threads " << threads();
+    if (mQueueDepth)
+      ss << ", queue depth " << mQueueDepth;
+    if (parallelFrames() > 1)
+      ss << ", parallel frames " << parallelFrames();
+    if (mDropPolicy.compare("process"))
+      ss << ", drop policy " << mDropPolicy << " (limit " << dropLimit() << ")";
+    if (mPreTouch)
+      ss << ", pre-touch";
+    if (mFieldChroma)
+      ss << ", field chroma";
+    if (mDither)
+      ss << ", dither";
+    if (mInPlace)
+      ss << ", in place";
+    if (mScaler.compare("swscale"))
+      ss << ", scaler " << mScaler;
+    if (mAnimate)
+      ss << ", animate";
+    if (mCompose)
+      ss << ", compose";
+    return ss.str();
+  }
+
+private:
+  uint32_t mThreads;
+  uint32_t mQueueDepth;
+  uint32_t mParallelFrames;
+  std::string mDropPolicy;
+  uint32_t mDropLimit;
+  bool mPreTouch;
+  bool mFieldChroma;
+  bool mDither;
+  bool mInPlace;
+  std::string mScaler;
+  bool mAnimate;
+  bool mCompose;
+};
+
+} // namespace streampunk
+
+#endif
@@ -18,7 +18,9 @@
 #include "MyWorker.h"
 #include "Timer.h"
 #include "Packers.h"
+#include "ProcessParams.h"
 #include "Memory.h"
+#include "FramePool.h"
 #include "Primitives.h"
 #include "ScaleConverterFF.h"
 #include "EssenceInfo.h"
@@ -32,44 +34,113 @@ namespace streampunk {
 
 class ScaleConvertProcessData : public iProcessData {
 public:
-  ScaleConvertProcessData (Local<Object> srcBufObj, Local<Object> dstBufObj, 
+  ScaleConvertProcessData ()
+    : mSrcBuf(Memory::makeNew((uint8_t *)NULL, 0)), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0)),
+      mScale(1.0f, 1.0f), mDstOffset(0.0f, 0.0f)
+  { }
+  ScaleConvertProcessData (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf, 
                            std::shared_ptr<Memory> convertDstBuf, std::shared_ptr<Memory> scaleSrcBuf)
-    : mPersistentSrcBuf(new Persist(srcBufObj)),
-      mPersistentDstBuf(new Persist(dstBufObj)),
-      mSrcBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj))),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj))),
-      mConvertDstBuf(convertDstBuf), mScaleSrcBuf(scaleSrcBuf)
+    : mSrcBuf(srcBuf), mDstBuf(dstBuf), mConvertDstBuf(convertDstBuf), mScaleSrcBuf(scaleSrcBuf),
+      mScale(1.0f, 1.0f), mDstOffset(0.0f, 0.0f)
   { }
   ~ScaleConvertProcessData() { }
+
+  // convertBytes is the size of the intermediate buffer needed between the packer and the scaler, 0 if none -
+  // the intermediate buffer is kept for the next frame
+  void set(Local<Object> srcBufObj, Local<Object> dstBufObj, uint32_t convertBytes) {
+    mPersistentDstBuf.reset(dstBufObj);
+    setBufs(srcBufObj, (uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj), convertBytes);
+  }
+  // native output mode - the result goes to a pool buffer that is handed to JS with the frame callback
+  void set(Local<Object> srcBufObj, std::shared_ptr<Memory> nativeDstBuf, uint32_t convertBytes) {
+    setBufs(srcBufObj, nativeDstBuf->buf(), nativeDstBuf->numBytes(), convertBytes);
+  }
+  void recycle() {
+    mPersistentSrcBuf.reset();
+    mPersistentDstBuf.reset();
+  }
   
   std::shared_ptr<Memory> srcBuf() const { return mSrcBuf; }
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
   std::shared_ptr<Memory> convertDstBuf() const { return mConvertDstBuf; }
   std::shared_ptr<Memory> scaleSrcBuf() const { return mScaleSrcBuf; }
 
+  // the scale and offset of this frame's picture
+  void setPlacement(const fXY &scale, const fXY &dstOffset) { mScale = scale; mDstOffset = dstOffset; }
+  fXY scale() const { return mScale; }
+  fXY dstOffset() const { return mDstOffset; }
+
 private:
-  std::unique_ptr<Persist> mPersistentSrcBuf;
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  void setBufs(Local<Object> srcBufObj, uint8_t *dstBuf, uint32_t dstBytes, uint32_t convertBytes) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset(dstBuf, dstBytes);
+    if (convertBytes) {
+      if (!mIntermediateBuf || (mIntermediateBuf->numBytes() != convertBytes))
+        mIntermediateBuf = Memory::makeNew(convertBytes);
+      mConvertDstBuf = mIntermediateBuf;
+      mScaleSrcBuf = mIntermediateBuf;
+    } else {
+      mConvertDstBuf = mDstBuf;
+      mScaleSrcBuf = mSrcBuf;
+    }
+  }
+
+  Persist mPersistentSrcBuf;
+  Persist mPersistentDstBuf;
   std::shared_ptr<Memory> mSrcBuf;
   std::shared_ptr<Memory> mDstBuf;
   std::shared_ptr<Memory> mConvertDstBuf;
   std::shared_ptr<Memory> mScaleSrcBuf;
+  std::shared_ptr<Memory> mIntermediateBuf;
+  fXY mScale;
+  fXY mDstOffset;
 };
 
-ScaleConverter::ScaleConverter(Nan::Callback *callback) 
-  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mUnityPacking(true), mUnityScale(true), mSrcFormatBytes(0), mDstBytesReq(0) {
-  AsyncQueueWorker(mWorker);
+// reads an optional [x, y] pair of numbers, leaving xy as it is if the tag is not given - false if the tag is not valid
+static bool unpackXY(Local<Object> tags, const char *name, fXY &xy) {
+  Local<Value> val = Nan::Get(tags, Nan::New<String>(name).ToLocalChecked()).ToLocalChecked();
+  if (val->IsUndefined())
+    return true;
+  if (!val->IsArray() || (Local<Array>::Cast(val)->Length() != 2))
+    return false;
+  Local<Array> valXY = Local<Array>::Cast(val);
+  Local<Value> x = Nan::Get(valXY, 0).ToLocalChecked();
+  Local<Value> y = Nan::Get(valXY, 1).ToLocalChecked();
+  if (!x->IsNumber() || !y->IsNumber())
+    return false;
+  xy = fXY(Nan::To<double>(x).FromJust(), Nan::To<double>(y).FromJust());
+  return true;
 }
+
+ScaleConverter::ScaleConverter(Nan::Callback *callback) 
+  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mUnityPacking(true), mUnityScale(true), mScale(1.0f, 1.0f), mDstOffset(0.0f, 0.0f),
+    mSrcFormatBytes(0), mDstBytesReq(0), mScalersGeneration(0), mBandLines(0) {}
 ScaleConverter::~ScaleConverter() {}
 
 // iProcess
 uint32_t ScaleConverter::processFrame (std::shared_ptr<iProcessData> processData) {
   Timer t;
-  std::shared_ptr<ScaleConvertProcessData> scpd = std::dynamic_pointer_cast<ScaleConvertProcessData>(processData);
+  ScaleConvertProcessData *scpd = static_cast<ScaleConvertProcessData *>(processData.get());
 
   if (mUnityPacking && mUnityScale) {
     memcpy (scpd->dstBuf()->buf(), scpd->srcBuf()->buf(), std::min<uint32_t>(scpd->dstBuf()->numBytes(), scpd->srcBuf()->numBytes()));
   }
+  else if (mBandPacker) {
+    // the source is unpacked a band at a time into a buffer that stays in cache, as the scaler works down the frame
+    uint32_t generation;
+    std::shared_ptr<ScaleConverterFF> scaler = takeScaler(generation);
+    const uint8_t *srcBuf = scpd->srcBuf()->buf();
+    bool scaled = scaler->scaleConvertBands([this, srcBuf](uint8_t *bandBuf, uint32_t firstLine, uint32_t numLines) {
+        mBandPacker->convertRange(srcBuf, bandBuf, firstLine, numLines);
+      }, mBandLines, scpd->dstBuf(), scpd->scale(), scpd->dstOffset());
+    giveScaler(scaler, generation);
+    if (!scaled) {
+      printDebug(eError, "Failed to create scale context for scale %1.2f:%1.2f\n", scpd->scale().x, scpd->scale().y);
+      return 0;
+    }
+    printDebug(eDebug, "convert and scale: %.2fms\n", t.delta());
+  }
   else {
     if (!mUnityPacking) {
       mPacker->convert(scpd->srcBuf(), scpd->convertDstBuf()); 
@@ -77,27 +148,89 @@ uint32_t ScaleConverter::processFrame (std::shared_ptr<iProcessData> processData
     }
 
     if (!mUnityScale) {
-      mScaleConverterFF->scaleConvertFrame (scpd->scaleSrcBuf(), scpd->dstBuf());
+      uint32_t generation;
+      std::shared_ptr<ScaleConverterFF> scaler = takeScaler(generation);
+      bool scaled = scaler->scaleConvertFrame (scpd->scaleSrcBuf(), scpd->dstBuf(), scpd->scale(), scpd->dstOffset());
+      giveScaler(scaler, generation);
+      if (!scaled) {
+        printDebug(eError, "Failed to create scale context for scale %1.2f:%1.2f\n", scpd->scale().x, scpd->scale().y);
+        return 0;
+      }
       printDebug(eDebug, "scale: %.2fms\n", t.delta());
     }
   }
   return mDstBytesReq;
 }
 
+// A scale context can only work on one frame at a time - frames processed in parallel each take one from the free list
+std::shared_ptr<ScaleConverterFF> ScaleConverter::takeScaler(uint32_t &generation) {
+  std::unique_lock<std::mutex> lk(mScalersMtx);
+  while (mFreeScalers.empty())
+    mScalersCv.wait(lk);
+  std::shared_ptr<ScaleConverterFF> scaler = mFreeScalers.back();
+  mFreeScalers.pop_back();
+  generation = mScalersGeneration;
+  return scaler;
+}
+
+// setInfo can replace the free list while frames are in flight - a scaler taken before then is for the old formats,
+// so it is dropped rather than given to a later frame
+void ScaleConverter::giveScaler(std::shared_ptr<ScaleConverterFF> scaler, uint32_t generation) {
+  std::lock_guard<std::mutex> lk(mScalersMtx);
+  if (generation != mScalersGeneration)
+    return;
+  mFreeScalers.push_back(scaler);
+  mScalersCv.notify_one();
+}
+
+// iPipelineStage
+uint32_t ScaleConverter::stageSrcBytes() const {
+  return mSetInfoOK ? getFormatBytes(mSrcVidInfo->packing(), mSrcVidInfo->width(), mSrcVidInfo->height()) : 0;
+}
+
+uint32_t ScaleConverter::stageDstBytes() const {
+  return mSetInfoOK ? mDstBytesReq : 0;
+}
+
+uint32_t ScaleConverter::processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) {
+  std::shared_ptr<Memory> convertDstBuf = dstBuf;
+  std::shared_ptr<Memory> scaleSrcBuf = srcBuf;
+  if (!mUnityPacking && !mUnityScale && !mBandPacker) {
+    convertDstBuf = Memory::makeNew(getFormatBytes(mScaleConverterFF->packingRequired(), mSrcVidInfo->width(), mSrcVidInfo->height()));
+    scaleSrcBuf = convertDstBuf;
+  }
+  std::shared_ptr<ScaleConvertProcessData> scpd = std::make_shared<ScaleConvertProcessData>(srcBuf, dstBuf, convertDstBuf, scaleSrcBuf);
+  scpd->setPlacement(mScale, mDstOffset);
+  return processFrame(scpd);
+}
+
 void ScaleConverter::doSetInfo(Local<Object> srcTags, Local<Object> dstTags, v8::Local<v8::Object> paramTags) {
   mSrcVidInfo = std::make_shared<EssenceInfo>(srcTags); 
   printDebug(eInfo, "Converter SrcVidInfo: %s\n", mSrcVidInfo->toString().c_str());
   mDstVidInfo = std::make_shared<EssenceInfo>(dstTags); 
   printDebug(eInfo, "Converter DstVidInfo: %s\n", mDstVidInfo->toString().c_str());
+  mProcessParams = std::make_shared<ProcessParams>(paramTags);
+  printDebug(eInfo, "Converter ProcessParams: %s\n", mProcessParams->toString().c_str());
+  mWorker->setQueueDepth(mProcessParams->queueDepth());
+  mWorker->setParallelFrames(mProcessParams->parallelFrames());
+  if (!mWorker->setDropPolicy(mProcessParams->dropPolicy(), mProcessParams->dropLimit())) {
+    std::string err = std::string("Unsupported drop policy \'") + mProcessParams->dropPolicy() + "\'";
+    return Nan::ThrowError(err.c_str());
+  }
 
   if (mSrcVidInfo->packing().compare("pgroup") && mSrcVidInfo->packing().compare("v210") && 
       mSrcVidInfo->packing().compare("YUV422P10") && mSrcVidInfo->packing().compare("UYVY10") && mSrcVidInfo->packing().compare("420P") && 
+      mSrcVidInfo->packing().compare("NV12") && mSrcVidInfo->packing().compare("P010") &&
+      mSrcVidInfo->packing().compare("Y210") && mSrcVidInfo->packing().compare("v410") &&
       mSrcVidInfo->packing().compare("RGBA8") && mSrcVidInfo->packing().compare("BGRA8") && 
       mSrcVidInfo->packing().compare("BGR10-A") && mSrcVidInfo->packing().compare("BGR10-A-BS")) {
     std::string err = std::string("Unsupported source format \'") + mSrcVidInfo->packing() + "\'";
     return Nan::ThrowError(err.c_str());
   }
-  if (mDstVidInfo->packing().compare("420P") && mDstVidInfo->packing().compare("YUV422P10")) {
+  // the scaler writes 420P or YUV422P10 - the other formats are only reached by conversion without scaling, below
+  bool scalerDst = (0==mDstVidInfo->packing().compare("420P")) || (0==mDstVidInfo->packing().compare("YUV422P10"));
+  if (!scalerDst && mDstVidInfo->packing().compare("NV12") && mDstVidInfo->packing().compare("P010") &&
+      mDstVidInfo->packing().compare("Y210") && mDstVidInfo->packing().compare("v410")) {
     std::string err = std::string("Unsupported destination packing type \'") + mDstVidInfo->packing() + "\'";
     return Nan::ThrowError(err.c_str());
   }
@@ -112,7 +245,7 @@ void ScaleConverter::doSetInfo(Local<Object> srcTags, Local<Object> dstTags, v8:
     return Nan::ThrowError("Scale parameter invalid");
 
   fXY scale(Nan::To<double>(scaleXY->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked()).FromJust(), Nan::To<double>(scaleXY->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 1).ToLocalChecked()).FromJust());
-  if ((scale.x > 10.0f) || (scale.y > 10.0f)) {
+  if ((scale.x <= 0.0f) || (scale.y <= 0.0f) || (scale.x > 10.0f) || (scale.y > 10.0f)) {
     std::string err = std::string("Unsupported Scale values X:") + std::to_string(scale.x).c_str() + ", Y:" + std::to_string(scale.y).c_str();
     return Nan::ThrowError(err.c_str());
   }
@@ -128,18 +261,76 @@ void ScaleConverter::doSetInfo(Local<Object> srcTags, Local<Object> dstTags, v8:
     return Nan::ThrowError(err.c_str());
   }
 
-  mScaleConverterFF = std::make_shared<ScaleConverterFF>(mSrcVidInfo, mDstVidInfo, scale, dstOffset, mDebugLevel);
+  if (mProcessParams->scaler().compare("swscale") && mProcessParams->scaler().compare("native")) {
+    std::string err = std::string("Unsupported scaler \'") + mProcessParams->scaler() + "\'";
+    return Nan::ThrowError(err.c_str());
+  }
+  bool nativeScaler = (0==mProcessParams->scaler().compare("native"));
+
+  mScale = scale;
+  mDstOffset = dstOffset;
+
+  mScaleConverterFF = std::make_shared<ScaleConverterFF>(mSrcVidInfo, mDstVidInfo, scale, dstOffset, nativeScaler,
+                                                         mProcessParams->threads(), mProcessParams->compose(), mDebugLevel);
+  if (nativeScaler && !mScaleConverterFF->nativeScaling()) {
+    std::string err = std::string("Native scaler does not support '") + mSrcVidInfo->packing() + "' to '" + mDstVidInfo->packing() + "' - only 10-bit YUV to YUV422P10 without alpha";
+    return Nan::ThrowError(err.c_str());
+  }
+  {
+    std::lock_guard<std::mutex> lk(mScalersMtx);
+    ++mScalersGeneration;
+    mFreeScalers.clear();
+    mFreeScalers.push_back(mScaleConverterFF);
+    for (uint32_t i = 1; i < mProcessParams->parallelFrames(); ++i)
+      mFreeScalers.push_back(std::make_shared<ScaleConverterFF>(mSrcVidInfo, mDstVidInfo, scale, dstOffset, nativeScaler,
+                                                                mProcessParams->threads(), mProcessParams->compose(), mDebugLevel));
+  }
   mUnityPacking = (0==mSrcVidInfo->packing().compare(mScaleConverterFF->packingRequired()));
 
-  mUnityScale = ((mSrcVidInfo->width() == mDstVidInfo->width()) &&
-                 (mSrcVidInfo->height() == mDstVidInfo->height()) &&
-                 (0==mSrcVidInfo->interlace().compare(mDstVidInfo->interlace())) &&
+  // the picture fills the destination unless it is scaled or moved, now or by later frames with animate set
+  bool fullFrame = (scale == fXY(1.0f, 1.0f)) && (dstOffset == fXY(0.0f, 0.0f)) && !mProcessParams->animate();
+  bool sameGeometry = (mSrcVidInfo->width() == mDstVidInfo->width()) &&
+                      (mSrcVidInfo->height() == mDstVidInfo->height()) &&
+                      (0==mSrcVidInfo->interlace().compare(mDstVidInfo->interlace())) && fullFrame;
+  mUnityScale = (sameGeometry &&
                  (0==mDstVidInfo->packing().compare(mUnityPacking?mSrcVidInfo->packing():mScaleConverterFF->packingRequired()))); // Use scaler to do format/colourspace conversion
 
+  // RGB sources that need no scaling are converted to YUV directly, rather than through GBRP16 and the scaler, as are
+  // destinations the scaler cannot write
+  bool rgbSrc = (0==mSrcVidInfo->packing().compare("RGBA8")) || (0==mSrcVidInfo->packing().compare("BGRA8")) ||
+                (0==mSrcVidInfo->packing().compare("BGR10-A")) || (0==mSrcVidInfo->packing().compare("BGR10-A-BS"));
+  if (!scalerDst && !sameGeometry) {
+    std::string err = std::string("Scaling to \'") + mDstVidInfo->packing() + "\' is not supported - only conversion at the same size";
+    return Nan::ThrowError(err.c_str());
+  }
+  bool rgbDirect = rgbSrc && sameGeometry;
+  if (rgbDirect || !scalerDst) {
+    mUnityPacking = (0==mSrcVidInfo->packing().compare(mDstVidInfo->packing()));
+    mUnityScale = true;
+  }
+
   if (!mUnityPacking)
     mPacker = std::make_shared<Packers>(mSrcVidInfo->width(), mSrcVidInfo->height(),
-                                        mSrcVidInfo->packing(), mUnityScale?mDstVidInfo->packing():mScaleConverterFF->packingRequired());
+                                        mSrcVidInfo->packing(), mUnityScale?mDstVidInfo->packing():mScaleConverterFF->packingRequired(),
+                                        0 != mSrcVidInfo->interlace().compare("prog"), mProcessParams->threads(), false, false,
+                                        mSrcVidInfo->colorimetry(), rgbDirect && mDstVidInfo->hasAlpha());
+
+  // a direct conversion feeding the scaler can be made a band at a time, sized like the Packers tiles to stay in cache
+  mBandPacker.reset();
+  mBandLines = 0;
+  if (!mUnityPacking && !mUnityScale && mScaleConverterFF->canScaleBands()) {
+    bool fieldScale = mSrcVidInfo->interlace().compare("prog") || mDstVidInfo->interlace().compare("prog");
+    uint32_t bandAlign = std::max<uint32_t>(mPacker->lineAlign(), fieldScale ? 4 : 2);
+    uint32_t alignBytes = getFormatBytes(mScaleConverterFF->packingRequired(), mSrcVidInfo->width(), bandAlign);
+    mBandLines = std::max<uint32_t>(1, 256 * 1024 / alignBytes) * bandAlign;
+    mBandPacker = mPacker->tileConverter(mBandLines);
+  }
   mDstBytesReq = getFormatBytes(mDstVidInfo->packing(), mDstVidInfo->width(), mDstVidInfo->height(), mDstVidInfo->hasAlpha());
+
+  // intermediate buffers come from the frame pool - with preTouch they are faulted in now rather than by the first frames
+  if (!mUnityPacking && !mUnityScale && !mBandPacker && mProcessParams->preTouch())
+    FramePool::instance().reserve(getFormatBytes(mScaleConverterFF->packingRequired(), mSrcVidInfo->width(), mSrcVidInfo->height()),
+                                  mWorker->queueDepth(), true);
 }
 
 NAN_METHOD(ScaleConverter::SetInfo) {
@@ -173,18 +364,21 @@ NAN_METHOD(ScaleConverter::SetInfo) {
 }
 
 NAN_METHOD(ScaleConverter::ScaleConvert) {
-  if (info.Length() != 3)
-    return Nan::ThrowError("ScaleConverter ScaleConvert expects 3 arguments");
+  // the frame's own scale and offset may be given in an optional parameter object before the callback
+  uint32_t cbArg = ((info.Length() > 2) && info[2]->IsObject() && !info[2]->IsFunction()) ? 3 : 2;
+  if ((info.Length() < cbArg + 1) || (info.Length() > cbArg + 2))
+    return Nan::ThrowError("ScaleConverter ScaleConvert expects 3 to 5 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("ScaleConverter ScaleConvert requires a valid source buffer array as the first parameter");
-  if (!info[1]->IsObject())
-    return Nan::ThrowError("ScaleConverter ScaleConvert requires a valid destination buffer as the second parameter");
-  if (!info[2]->IsFunction())
-    return Nan::ThrowError("ScaleConverter ScaleConvert requires a valid callback as the third parameter");
+  if (!info[1]->IsObject() && !info[1]->IsNull())
+    return Nan::ThrowError("ScaleConverter ScaleConvert requires a valid destination buffer, or null for a pooled output buffer, as the second parameter");
+  if (!info[cbArg]->IsFunction())
+    return Nan::ThrowError("ScaleConverter ScaleConvert requires a valid callback after the destination buffer and optional parameters");
 
   Local<Array> srcBufArray = Local<Array>::Cast(info[0]);
-  Local<Object> dstBufObj = Local<Object>::Cast(info[1]);
-  Local<Function> callback = Local<Function>::Cast(info[2]);
+  // a null destination asks for the result in a pooled buffer, passed to the callback as an external Buffer
+  Local<Object> dstBufObj = MyWorker::dstBufArg(info, 1);
+  Local<Function> callback = Local<Function>::Cast(info[cbArg]);
   
   Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked());
 
@@ -193,27 +387,48 @@ NAN_METHOD(ScaleConverter::ScaleConvert) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("ScaleConvert called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   obj->mSrcFormatBytes = getFormatBytes(obj->mSrcVidInfo->packing(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height());
   if (obj->mSrcFormatBytes > (uint32_t)node::Buffer::Length(srcBufObj))
     return Nan::ThrowError("Insufficient source buffer for conversion");
 
-  if (obj->mDstBytesReq > node::Buffer::Length(dstBufObj))
+  if (!dstBufObj.IsEmpty() && (obj->mDstBytesReq > node::Buffer::Length(dstBufObj)))
     return Nan::ThrowError("Insufficient destination buffer for specified format");
-
-  std::shared_ptr<Memory> srcBuf = Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
-  std::shared_ptr<Memory> dstBuf = Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
-  std::shared_ptr<Memory> convertDstBuf = dstBuf;
-  std::shared_ptr<Memory> scaleSrcBuf = srcBuf;
-  if (!obj->mUnityPacking && !obj->mUnityScale) {
-    convertDstBuf = Memory::makeNew(getFormatBytes(obj->mScaleConverterFF->packingRequired(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height()));
-    scaleSrcBuf = convertDstBuf;
-    if (!convertDstBuf->buf())
-      return Nan::ThrowError("Failed to allocate buffer for packer result");
+  if (dstBufObj.IsEmpty() && obj->mProcessParams->compose())
+    return Nan::ThrowError("ScaleConvert with compose set needs a destination buffer holding the canvas");
+
+  // a frame's scale and offset pick the scaler for its size from those the converter keeps, so moving the picture does
+  // not make new scalers
+  fXY scale = obj->mScale;
+  fXY dstOffset = obj->mDstOffset;
+  if (3 == cbArg) {
+    Local<Object> paramTags = Local<Object>::Cast(info[2]);
+    if (!unpackXY(paramTags, "scale", scale))
+      return Nan::ThrowError("Scale parameter invalid");
+    if ((scale.x <= 0.0f) || (scale.y <= 0.0f) || (scale.x > 10.0f) || (scale.y > 10.0f)) {
+      std::string err = std::string("Unsupported Scale values X:") + std::to_string(scale.x).c_str() + ", Y:" + std::to_string(scale.y).c_str();
+      return Nan::ThrowError(err.c_str());
+    }
+    if (!unpackXY(paramTags, "dstOffset", dstOffset))
+      return Nan::ThrowError("DstOffset parameter invalid");
+    if ((dstOffset.x > obj->mDstVidInfo->width() / 2) || (dstOffset.y > obj->mDstVidInfo->height() / 2)) {
+      std::string err = std::string("Unsupported DstOffset values X:") + std::to_string(dstOffset.x).c_str() + ", Y:" + std::to_string(dstOffset.y).c_str();
+      return Nan::ThrowError(err.c_str());
+    }
+    if (obj->mUnityScale && ((scale != obj->mScale) || (dstOffset != obj->mDstOffset)))
+      return Nan::ThrowError("ScaleConvert scale and offset need the converter set up with animate: true");
   }
 
-  std::shared_ptr<iProcessData> scpd = 
-    std::make_shared<ScaleConvertProcessData>(srcBufObj, dstBufObj, convertDstBuf, scaleSrcBuf);
-  obj->mWorker->doFrame(scpd, obj, new Nan::Callback(callback));
+  uint32_t convertBytes = 0;
+  if (!obj->mUnityPacking && !obj->mUnityScale && !obj->mBandPacker)
+    convertBytes = getFormatBytes(obj->mScaleConverterFF->packingRequired(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height());
+
+  std::shared_ptr<ScaleConvertProcessData> scpd = obj->mProcessDataPool.acquire();
+  std::shared_ptr<Memory> outputBuf = MyWorker::setFrameBufs(*scpd, srcBufObj, dstBufObj, obj->mDstBytesReq, convertBytes);
+  scpd->setPlacement(scale, dstOffset);
+  obj->mWorker->doFrame(scpd, obj, callback, MyWorker::deadlineArg(info, cbArg + 1), outputBuf);
   
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
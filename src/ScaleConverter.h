@@ -18,27 +18,41 @@
 
 #include "iDebug.h"
 #include "iProcess.h"
+#include "ProcessDataPool.h"
+#include "Primitives.h"
 #include <memory>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
 
 namespace streampunk {
 
 class MyWorker;
 class ScaleConverterFF;
 class Packers;
+class ProcessParams;
 class EssenceInfo;
+class ScaleConvertProcessData;
 
-class ScaleConverter : public Nan::ObjectWrap, public iProcess, public iDebug {
+class ScaleConverter : public Nan::ObjectWrap, public iProcess, public iPipelineStage, public iDebug {
 public:
   static NAN_MODULE_INIT(Init);
 
   // iProcess
   uint32_t processFrame (std::shared_ptr<iProcessData> processData);
+
+  // iPipelineStage
+  uint32_t stageSrcBytes() const;
+  uint32_t stageDstBytes() const;
+  uint32_t processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf);
   
 private:
   explicit ScaleConverter(Nan::Callback *callback);
   ~ScaleConverter();
 
   void doSetInfo(v8::Local<v8::Object> srcTags, v8::Local<v8::Object> dstTags, v8::Local<v8::Object> paramTags);
+  std::shared_ptr<ScaleConverterFF> takeScaler(uint32_t &generation);
+  void giveScaler(std::shared_ptr<ScaleConverterFF> scaler, uint32_t generation);
 
   static NAN_METHOD(New) {
     if (info.IsConstructCall()) {
@@ -69,12 +83,25 @@ private:
   bool mSetInfoOK;
   bool mUnityPacking;
   bool mUnityScale;
+  // the scale and offset from setInfo, used for frames that do not give their own
+  fXY mScale;
+  fXY mDstOffset;
   uint32_t mSrcFormatBytes;
   uint32_t mDstBytesReq;
   std::shared_ptr<EssenceInfo> mSrcVidInfo;
   std::shared_ptr<EssenceInfo> mDstVidInfo;
   std::shared_ptr<ScaleConverterFF> mScaleConverterFF;
+  std::vector<std::shared_ptr<ScaleConverterFF> > mFreeScalers;
+  // counts the free lists made by setInfo, to tell scalers given back from an earlier one
+  uint32_t mScalersGeneration;
+  std::mutex mScalersMtx;
+  std::condition_variable mScalersCv;
   std::shared_ptr<Packers> mPacker;
+  // unpacks the source a band of mBandLines lines at a time as the scaler takes it, in place of a full intermediate frame
+  std::shared_ptr<Packers> mBandPacker;
+  uint32_t mBandLines;
+  std::shared_ptr<ProcessParams> mProcessParams;
+  ProcessDataPool<ScaleConvertProcessData> mProcessDataPool;
 };
 
 } // namespace streampunk
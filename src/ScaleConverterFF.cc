@@ -17,6 +17,12 @@
 #include "ScaleConverterFF.h"
 #include "Memory.h"
 #include "EssenceInfo.h"
+#include "FramePool.h"
+#include "PolyphaseScaler.h"
+#include "WorkerPool.h"
+
+#include <cmath>
+#include <algorithm>
 
 extern "C" {
   #include <libavutil/imgutils.h>
@@ -26,8 +32,9 @@ extern "C" {
 namespace streampunk {
 
 ScaleConverterFF::ScaleConverterFF(std::shared_ptr<EssenceInfo> srcVidInfo, std::shared_ptr<EssenceInfo> dstVidInfo,
-                                   const fXY &userScale, const fXY &userDstOffset, eDebugLevel debugLevel)
-  : iDebug(debugLevel), mSwsContext(NULL),
+                                   const fXY &userScale, const fXY &userDstOffset, bool nativeScaler, uint32_t numThreads,
+                                   bool compose, eDebugLevel debugLevel)
+  : iDebug(debugLevel),
     mSrcWidth(srcVidInfo->width()), mSrcHeight(srcVidInfo->height()), mSrcIlace(srcVidInfo->interlace()),
     mSrcPixFmt((0==srcVidInfo->packing().compare("RGBA8"))?AV_PIX_FMT_RGBA
                :(0==srcVidInfo->packing().compare("BGRA8"))?AV_PIX_FMT_BGRA
@@ -36,56 +43,11 @@ ScaleConverterFF::ScaleConverterFF(std::shared_ptr<EssenceInfo> srcVidInfo, std:
     mDstWidth(dstVidInfo->width()), mDstHeight(dstVidInfo->height()), mDstIlace(dstVidInfo->interlace()),
     mDstPixFmt((8==dstVidInfo->depth())?dstVidInfo->hasAlpha()?AV_PIX_FMT_YUVA420P:AV_PIX_FMT_YUV420P
                                        :dstVidInfo->hasAlpha()?AV_PIX_FMT_YUVA422P10LE:AV_PIX_FMT_YUV422P10LE),
-    mUserScale(userScale), mUserDstOffset(userDstOffset),
-    mScale(fXY(1.0f, 1.0f)), mDstOffset(fXY(0.0f, 0.0f)), mDoWipe(false) {
+    mUserScale(userScale), mUserDstOffset(userDstOffset), mNativeScaler(nativeScaler), mNumThreads(numThreads ? numThreads : 1),
+    mCompose(compose),
+    mColourTable(sws_getCoefficients((0==srcVidInfo->colorimetry().compare("BT709-2"))?SWS_CS_ITU709:SWS_CS_ITU601)) {
 
   printDebug(eDebug, "FFmpeg swscale %x, %s\n", swscale_version(), swscale_license());
-  // !!! need pixel aspect ratios - assumed 1:1 !!!
-  fXY fitScale((double)mDstWidth / mSrcWidth, (double)mDstHeight / mSrcHeight);
-  fXY boxScale(fitScale.x < fitScale.y ? fXY(fitScale.x, fitScale.x) : fXY(fitScale.y, fitScale.y));
-  // Calculate scaling required to undo swscale's fit algorithm so that circles stay as circles!
-  mScale = fXY(fitScale.x == boxScale.x ? 1.0f : boxScale.y / fitScale.x,
-               fitScale.y == boxScale.y ? 1.0f : boxScale.x / fitScale.y);
-  fXY limUserScale = mUserScale;
-  if ((float)mSrcWidth * boxScale.x * limUserScale.x > (float)mDstWidth)
-    limUserScale.x = (float)mDstWidth / ((float)mSrcWidth * boxScale.x);
-  if ((float)mSrcHeight * boxScale.y * limUserScale.y > (float)mDstHeight)
-    limUserScale.y = (float)mDstHeight / ((float)mSrcHeight * boxScale.y);
-  if (limUserScale != mUserScale)
-    printDebug(eWarn, "User scaling limited to full frame %1.2f:%1.2f -> %1.2f:%1.2f\n",
-      mUserScale.x, mUserScale.y, limUserScale.x, limUserScale.y);
-  mScale *= limUserScale;
-
-  fXY scaledXY(mSrcWidth * boxScale.x * limUserScale.x, mSrcHeight * boxScale.y * limUserScale.y);
-  fXY scaledCentre((scaledXY.x - 1) / 2, (scaledXY.y - 1) / 2);
-  fXY dstCentre(((float)mDstWidth - 1) / 2, ((float)mDstHeight - 1) / 2);
-  mDstOffset = dstCentre - scaledCentre + mUserDstOffset;
-  mDoWipe = !((mScale == fXY(1.0, 1.0)) && (mDstOffset == fXY(0.0, 0.0)));
-
-  printDebug(eInfo, "ScaleConverter fitScale: %1.2f:%1.2f, boxScale: %1.2f:%1.2f, mScale: %1.2f:%1.2f\n",
-    fitScale.x, fitScale.y, boxScale.x, boxScale.y, mScale.x, mScale.y);
-  printDebug(eInfo, "ScaleConverter dstOffset: %1.2f:%1.2f, wipe %s\n", mDstOffset.x, mDstOffset.y, mDoWipe?"true":"false");
-
-  uint32_t dstWidth = (mScale.x < 1.0f) ? uint32_t(mDstWidth * mScale.x) : mDstWidth;
-  uint32_t dstHeight = (mScale.y < 1.0f) ? uint32_t(mDstHeight * mScale.y) : mDstHeight;
-
-  uint32_t srcIshift = mSrcIlace.compare("prog")?1:0;
-  uint32_t dstIshift = mDstIlace.compare("prog")?1:0;
-  mSwsContext = sws_getContext(mSrcWidth, mSrcHeight>>srcIshift, (AVPixelFormat)mSrcPixFmt,
-                               dstWidth, dstHeight>>dstIshift, (AVPixelFormat)mDstPixFmt,
-                               SWS_BILINEAR, NULL, NULL, NULL);
-  if (!mSwsContext) {
-    fprintf(stderr,
-      "Impossible to create scale context for the conversion "
-      "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
-      av_get_pix_fmt_name((AVPixelFormat)mSrcPixFmt), mSrcWidth, mSrcHeight,
-      av_get_pix_fmt_name((AVPixelFormat)mDstPixFmt), mDstWidth, mDstHeight);
-    Nan::ThrowError("Failed to create scale context");
-    return;
-  }
-
-  const int *hdTable = sws_getCoefficients((0==srcVidInfo->colorimetry().compare("BT709-2"))?SWS_CS_ITU709:SWS_CS_ITU601);
-  sws_setColorspaceDetails(mSwsContext, hdTable, 0, hdTable, 0, 0, 1 << 16, 1 << 16);
 
   if ((AV_PIX_FMT_RGBA==mSrcPixFmt) || (AV_PIX_FMT_BGRA==mSrcPixFmt)) {
     mSrcLinesize[0] = mSrcWidth * 4;
@@ -109,10 +71,192 @@ ScaleConverterFF::ScaleConverterFF(std::shared_ptr<EssenceInfo> srcVidInfo, std:
   mDstLinesize[1] = dstChromaPitch;
   mDstLinesize[2] = dstChromaPitch;
   mDstLinesize[3] = ((AV_PIX_FMT_YUVA420P==mDstPixFmt) || (AV_PIX_FMT_YUVA422P10LE==mDstPixFmt))?dstLumaPitch:0;
+
+  mPlacement = place(mUserScale, mUserDstOffset);
+  printDebug(eInfo, "ScaleConverter scaled %dx%d, dstOffset: %d:%d, fill border %s\n",
+    mPlacement.width, mPlacement.height, mPlacement.x, mPlacement.y, mPlacement.fillBorder?"true":"false");
+  mScalers = scalers(mPlacement);
+  if (!mScalers)
+    Nan::ThrowError("Failed to create scale context");
+}
+
+ScaleConverterFF::~ScaleConverterFF() {}
+
+ScaleConverterFF::Scalers::~Scalers() {
+  sws_freeContext(swsContext);
+  sws_freeContext(secondFieldSwsContext);
+  for (auto& slice : slices)
+    sws_freeContext(slice.swsContext);
 }
 
-ScaleConverterFF::~ScaleConverterFF() {
-  sws_freeContext(mSwsContext);
+// Works out the size and position of the scaled picture. The picture is fitted to the destination keeping its aspect
+// ratio, then scaled by the user scale and moved from the centre by the user offset. The picture is kept inside the
+// destination and placed on whole samples, on an even column for the 4:2:2 and 4:2:0 chroma and an even line where
+// chroma or field lines pair up. The filters have no sub-sample phase, so a moving picture steps by column pairs and,
+// where lines pair up, by line pairs.
+ScaleConverterFF::Placement ScaleConverterFF::place(const fXY &userScale, const fXY &userDstOffset) {
+  // !!! need pixel aspect ratios - assumed 1:1 !!!
+  fXY fitScale((double)mDstWidth / mSrcWidth, (double)mDstHeight / mSrcHeight);
+  fXY boxScale(fitScale.x < fitScale.y ? fXY(fitScale.x, fitScale.x) : fXY(fitScale.y, fitScale.y));
+  fXY limUserScale = userScale;
+  if ((float)mSrcWidth * boxScale.x * limUserScale.x > (float)mDstWidth)
+    limUserScale.x = (float)mDstWidth / ((float)mSrcWidth * boxScale.x);
+  if ((float)mSrcHeight * boxScale.y * limUserScale.y > (float)mDstHeight)
+    limUserScale.y = (float)mDstHeight / ((float)mSrcHeight * boxScale.y);
+  if (limUserScale != userScale)
+    printDebug(eWarn, "User scaling limited to full frame %1.2f:%1.2f -> %1.2f:%1.2f\n",
+      userScale.x, userScale.y, limUserScale.x, limUserScale.y);
+
+  bool evenLines = (AV_PIX_FMT_YUV420P==mDstPixFmt) || (AV_PIX_FMT_YUVA420P==mDstPixFmt) ||
+                   mSrcIlace.compare("prog") || mDstIlace.compare("prog");
+  Placement placement;
+  placement.width = std::min(mDstWidth, (uint32_t)(mSrcWidth * boxScale.x * limUserScale.x));
+  placement.width = std::max(2U, placement.width & ~1U);
+  placement.height = std::min(mDstHeight, (uint32_t)(mSrcHeight * boxScale.y * limUserScale.y));
+  placement.height = evenLines ? std::max(2U, placement.height & ~1U) : std::max(1U, placement.height);
+
+  fXY dstOffset(((double)mDstWidth - placement.width) / 2 + userDstOffset.x,
+                ((double)mDstHeight - placement.height) / 2 + userDstOffset.y);
+  placement.x = (uint32_t)std::min<double>(mDstWidth - placement.width, std::max(0.0, dstOffset.x)) & ~1U;
+  placement.y = (uint32_t)std::min<double>(mDstHeight - placement.height, std::max(0.0, dstOffset.y));
+  if (evenLines)
+    placement.y &= ~1U;
+  // a canvas to compose into keeps what is around the picture
+  placement.fillBorder = !mCompose && ((placement.width != mDstWidth) || (placement.height != mDstHeight));
+
+  return placement;
+}
+
+// the scalers for the placement's size, made if they are not among those used recently
+std::shared_ptr<ScaleConverterFF::Scalers> ScaleConverterFF::scalers(const Placement &placement) {
+  const uint32_t maxCachedScalers = 8;
+  for (auto it = mScalersCache.begin(); it != mScalersCache.end(); ++it) {
+    if (((*it)->width == placement.width) && ((*it)->height == placement.height)) {
+      std::shared_ptr<Scalers> found = *it;
+      mScalersCache.erase(it);
+      mScalersCache.insert(mScalersCache.begin(), found);
+      return found;
+    }
+  }
+
+  std::shared_ptr<Scalers> made = makeScalers(placement.width, placement.height);
+  if (made) {
+    mScalersCache.insert(mScalersCache.begin(), made);
+    if (mScalersCache.size() > maxCachedScalers)
+      mScalersCache.pop_back();
+  }
+  return made;
+}
+
+std::shared_ptr<ScaleConverterFF::Scalers> ScaleConverterFF::makeScalers(uint32_t width, uint32_t height) {
+  std::shared_ptr<Scalers> made = std::make_shared<Scalers>(width, height);
+  uint32_t srcIshift = mSrcIlace.compare("prog")?1:0;
+  uint32_t dstIshift = mDstIlace.compare("prog")?1:0;
+  // either picture being interlaced means scaling a field at a time, from a field of the source to a field of the destination
+  uint32_t fieldShift = (srcIshift || dstIshift)?1:0;
+  // the native scaler works on 10-bit 4:2:2 without alpha, and any other formats are left to swscale
+  if (mNativeScaler && (AV_PIX_FMT_YUV422P10LE==mSrcPixFmt) && (AV_PIX_FMT_YUV422P10LE==mDstPixFmt)) {
+    made->polyphaseScaler = std::make_shared<PolyphaseScaler>(mSrcWidth, mSrcHeight, srcIshift, 0==mSrcIlace.compare("tff"),
+                                                              width, height, dstIshift, 0==mDstIlace.compare("tff"));
+    printDebug(eInfo, "ScaleConverter native scaler %dx%d -> %dx%d\n", mSrcWidth, mSrcHeight, width, height);
+    return made;
+  }
+
+  made->swsContext = sws_getContext(mSrcWidth, mSrcHeight>>fieldShift, (AVPixelFormat)mSrcPixFmt,
+                                    width, height>>fieldShift, (AVPixelFormat)mDstPixFmt,
+                                    SWS_BILINEAR, NULL, NULL, NULL);
+  if (!made->swsContext) {
+    fprintf(stderr,
+      "Impossible to create scale context for the conversion "
+      "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
+      av_get_pix_fmt_name((AVPixelFormat)mSrcPixFmt), mSrcWidth, mSrcHeight,
+      av_get_pix_fmt_name((AVPixelFormat)mDstPixFmt), width, height);
+    return std::shared_ptr<Scalers>();
+  }
+
+  sws_setColorspaceDetails(made->swsContext, mColourTable, 0, mColourTable, 0, 0, 1 << 16, 1 << 16);
+
+  // slices are made for the formats whose output does not depend on where the source slices break
+  if ((mNumThreads > 1) && ((AV_PIX_FMT_YUV422P10LE==mDstPixFmt) || (AV_PIX_FMT_YUVA422P10LE==mDstPixFmt)))
+    makeSlices(*made);
+  return made;
+}
+
+// the scalers for the placement's size with the context for the second field that the band path needs for interlaced
+// material, made on first use as the whole frame path scales each field in turn with the one context
+std::shared_ptr<ScaleConverterFF::Scalers> ScaleConverterFF::bandScalers(const Placement &placement) {
+  std::shared_ptr<Scalers> found = scalers(placement);
+  bool fieldScale = mSrcIlace.compare("prog") || mDstIlace.compare("prog");
+  if (!found || found->polyphaseScaler || !fieldScale || found->secondFieldSwsContext)
+    return found;
+
+  found->secondFieldSwsContext = sws_getContext(mSrcWidth, mSrcHeight>>1, (AVPixelFormat)mSrcPixFmt,
+                                                found->width, found->height>>1, (AVPixelFormat)mDstPixFmt,
+                                                SWS_BILINEAR, NULL, NULL, NULL);
+  if (!found->secondFieldSwsContext) {
+    fprintf(stderr,
+      "Impossible to create second field scale context for the conversion "
+      "fmt:%s s:%dx%d -> fmt:%s s:%dx%d\n",
+      av_get_pix_fmt_name((AVPixelFormat)mSrcPixFmt), mSrcWidth, mSrcHeight,
+      av_get_pix_fmt_name((AVPixelFormat)mDstPixFmt), found->width, found->height);
+    return std::shared_ptr<Scalers>();
+  }
+  sws_setColorspaceDetails(found->secondFieldSwsContext, mColourTable, 0, mColourTable, 0, 0, 1 << 16, 1 << 16);
+  return found;
+}
+
+// A slice gives the same result as scaling the whole picture when its context steps through the source lines exactly as
+// the whole picture context does. swscale's vertical step is a 16.16 fixed point ratio, so it must be exact, and each
+// slice context must start on a destination line that falls on a source line - the lines of the two pictures line up
+// every dstStep destination lines. Otherwise the picture is scaled whole.
+void ScaleConverterFF::makeSlices(Scalers &scalers) {
+  uint32_t fieldShift = (mSrcIlace.compare("prog") || mDstIlace.compare("prog"))?1:0;
+  uint32_t srcFieldLines = mSrcHeight>>fieldShift;
+  uint32_t dstFieldLines = scalers.height>>fieldShift;
+  if (((uint64_t)srcFieldLines << 16) % dstFieldLines)
+    return;
+  uint32_t numSteps = srcFieldLines;
+  for (uint32_t b = dstFieldLines; b; ) {
+    uint32_t t = numSteps % b;
+    numSteps = b;
+    b = t;
+  }
+  uint32_t srcStep = srcFieldLines / numSteps;
+  uint32_t dstStep = dstFieldLines / numSteps;
+  uint32_t numSlices = std::min(mNumThreads, numSteps);
+  if (numSlices < 2)
+    return;
+
+  // the bilinear filter reaches no more than a line either side when scaling up and a destination line's worth of
+  // source lines when scaling down - swscale pads its filters, so the margin allows for more than that
+  uint32_t srcMargin = 2 * (uint32_t)ceil(std::max(1.0, (double)srcFieldLines / dstFieldLines)) + 8;
+  uint32_t marginSteps = (srcMargin + srcStep - 1) / srcStep;
+  for (uint32_t i = 0; i < numSlices; ++i) {
+    uint32_t outStep = numSteps * i / numSlices;
+    uint32_t outEndStep = numSteps * (i + 1) / numSlices;
+    uint32_t firstStep = (outStep > marginSteps) ? outStep - marginSteps : 0;
+    uint32_t endStep = std::min(numSteps, outEndStep + marginSteps);
+    ScaleSlice slice;
+    slice.srcFirst = firstStep * srcStep;
+    slice.srcLines = (endStep - firstStep) * srcStep;
+    slice.dstFirst = firstStep * dstStep;
+    slice.dstLines = (endStep - firstStep) * dstStep;
+    slice.outFirst = outStep * dstStep;
+    slice.outLines = (outEndStep - outStep) * dstStep;
+    slice.swsContext = sws_getContext(mSrcWidth, slice.srcLines, (AVPixelFormat)mSrcPixFmt,
+                                      scalers.width, slice.dstLines, (AVPixelFormat)mDstPixFmt,
+                                      SWS_BILINEAR, NULL, NULL, NULL);
+    if (!slice.swsContext) {
+      printDebug(eWarn, "Failed to create slice scale context - scaling whole frames\n");
+      for (auto& s : scalers.slices)
+        sws_freeContext(s.swsContext);
+      scalers.slices.clear();
+      return;
+    }
+    sws_setColorspaceDetails(slice.swsContext, mColourTable, 0, mColourTable, 0, 0, 1 << 16, 1 << 16);
+    scalers.slices.push_back(slice);
+  }
+  printDebug(eInfo, "ScaleConverter %d slices, margin %d source lines\n", numSlices, marginSteps * srcStep);
 }
 
 std::string ScaleConverterFF::packingRequired() const {
@@ -123,94 +267,324 @@ std::string ScaleConverterFF::packingRequired() const {
       : "YUV422P10";
 }
 
-void ScaleConverterFF::scaleConvertField (uint8_t **srcData, uint8_t **dstData, uint32_t srcField, uint32_t dstField) {
+// swscale's 8-bit output depends on where the source slices break, but its 10-bit output does not - the native
+// scaler and the threaded slices work on whole frames
+bool ScaleConverterFF::canScaleBands() const {
+  return mScalers && !mScalers->polyphaseScaler && mScalers->slices.empty() && ((AV_PIX_FMT_YUV422P10LE==mDstPixFmt) || (AV_PIX_FMT_YUVA422P10LE==mDstPixFmt));
+}
+
+bool ScaleConverterFF::nativeScaling() const {
+  return mScalers && mScalers->polyphaseScaler;
+}
+
+void ScaleConverterFF::scaleConvertField (SwsContext *swsContext, uint8_t **srcData, uint8_t **dstData, const uint32_t *dstLinesize,
+                                          uint32_t srcField, uint32_t dstField, uint32_t firstFieldLine, uint32_t numFieldLines) {
   const uint8_t *srcBuf[4];
   uint8_t *dstBuf[4];
   uint32_t srcStride[4], dstStride[4];
 
   for (uint32_t i = 0; i < 4; ++i) {
     srcStride[i] = mSrcLinesize[i] * 2;
-    dstStride[i] = mDstLinesize[i] * 2;
+    dstStride[i] = dstLinesize[i] * 2;
     srcBuf[i] = srcData[i] + srcField * mSrcLinesize[i];
-    dstBuf[i] = dstData[i] + dstField * mDstLinesize[i];
+    dstBuf[i] = dstData[i] ? dstData[i] + dstField * dstLinesize[i] : NULL;
   }
 
-  sws_scale(mSwsContext, srcBuf, (const int *)srcStride, 0, mSrcHeight/2, dstBuf, (const int *)dstStride);
+  sws_scale(swsContext, srcBuf, (const int *)srcStride, firstFieldLine, numFieldLines, dstBuf, (const int *)dstStride);
 }
 
-void ScaleConverterFF::scaleConvertFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) {
-  uint8_t *srcData[4];
-  uint32_t srcLumaBytes = mSrcLinesize[0] * mSrcHeight;
-  uint32_t srcChromaBytes = mSrcLinesize[1] * mSrcHeight;
+// the size of a source buffer of the given number of lines
+uint32_t ScaleConverterFF::srcBytes(uint32_t height) const {
+  if ((AV_PIX_FMT_RGBA==mSrcPixFmt) || (AV_PIX_FMT_BGRA==mSrcPixFmt))
+    return mSrcLinesize[0] * height;
+  else if (AV_PIX_FMT_GBRP16==mSrcPixFmt)
+    return mSrcLinesize[0] * height * 3;
+  uint32_t srcChromaBytes = mSrcLinesize[1] * height;
+  if (AV_PIX_FMT_YUV420P==mSrcPixFmt)
+    srcChromaBytes /= 2;
+  return mSrcLinesize[0] * height + srcChromaBytes * 2;
+}
+
+// the planes of a source buffer of the given number of lines
+void ScaleConverterFF::srcPlanes(uint8_t *buf, uint32_t height, uint8_t **srcData) const {
+  uint32_t srcLumaBytes = mSrcLinesize[0] * height;
+  uint32_t srcChromaBytes = mSrcLinesize[1] * height;
   if (AV_PIX_FMT_YUV420P==mSrcPixFmt)
     srcChromaBytes /= 2;
-  srcData[0] = (uint8_t *)srcBuf->buf();
+  srcData[0] = buf;
   if ((AV_PIX_FMT_RGBA==mSrcPixFmt) || (AV_PIX_FMT_BGRA==mSrcPixFmt)) {
     srcData[1] = NULL;
     srcData[2] = NULL;
     srcData[3] = NULL;
   } else if (AV_PIX_FMT_GBRP16==mSrcPixFmt) {
-    srcData[1] = (uint8_t *)(srcBuf->buf() + srcLumaBytes);;
-    srcData[2] = (uint8_t *)(srcBuf->buf() + srcLumaBytes * 2);;
+    srcData[1] = buf + srcLumaBytes;
+    srcData[2] = buf + srcLumaBytes * 2;
     srcData[3] = NULL;
   } else {
-    srcData[1] = (uint8_t *)(srcBuf->buf() + srcLumaBytes);
-    srcData[2] = (uint8_t *)(srcBuf->buf() + srcLumaBytes + srcChromaBytes);
+    srcData[1] = buf + srcLumaBytes;
+    srcData[2] = buf + srcLumaBytes + srcChromaBytes;
     srcData[3] = NULL;
   }
+}
 
-  uint8_t *dstData[4];
+// fills the samples of a plane around a rectangle, leaving the rectangle as it is - sizes and positions are in samples
+template <typename T>
+static void fillAround(uint8_t *plane, uint32_t pitchBytes, uint32_t width, uint32_t height,
+                       uint32_t x, uint32_t y, uint32_t rectWidth, uint32_t rectHeight, T value) {
+  for (uint32_t line = 0; line < height; ++line) {
+    T *row = (T *)(plane + line * pitchBytes);
+    if ((line < y) || (line >= y + rectHeight))
+      std::fill_n(row, width, value);
+    else {
+      std::fill_n(row, x, value);
+      std::fill_n(row + x + rectWidth, width - x - rectWidth, value);
+    }
+  }
+}
+
+// the planes of the destination at the scaled picture offset, filling the border around the picture with black unless
+// the destination is a canvas to compose into
+void ScaleConverterFF::dstPlanes(std::shared_ptr<Memory> dstBuf, const Placement &placement, uint8_t **dstData) const {
+  bool is420 = (AV_PIX_FMT_YUVA420P==mDstPixFmt) || (AV_PIX_FMT_YUV420P==mDstPixFmt);
+  bool hasAlpha = (AV_PIX_FMT_YUVA420P==mDstPixFmt) || (AV_PIX_FMT_YUVA422P10LE==mDstPixFmt);
+  uint32_t sampleBytes = mDstLinesize[0] / mDstWidth;
+  uint32_t chromaHeight = is420 ? mDstHeight / 2 : mDstHeight;
+  uint32_t chromaY = is420 ? placement.y / 2 : placement.y;
   uint32_t dstLumaBytes = mDstLinesize[0] * mDstHeight;
-  uint32_t dstChromaBytes = mDstLinesize[1] * mDstHeight;
-  uint32_t dstLumaOffsetBytes = (uint32_t)mDstOffset.x * (mDstLinesize[0] / mDstWidth) + (uint32_t)mDstOffset.y * mDstLinesize[0];
-  uint32_t dstChromaOffsetBytes = (uint32_t)mDstOffset.x + (uint32_t)mDstOffset.y * mDstLinesize[1];
-  if ((AV_PIX_FMT_YUVA420P==mDstPixFmt) || (AV_PIX_FMT_YUV420P==mDstPixFmt)) {
-    dstChromaBytes /= 2;
-    dstChromaOffsetBytes /= 2;
-  }
-
-  if (mDoWipe) {
-    if ((AV_PIX_FMT_YUVA420P==mDstPixFmt) || (AV_PIX_FMT_YUV420P==mDstPixFmt)) {
-        // 8-bit fill
-      memset (dstBuf->buf(), 0x10, dstLumaBytes);
-      memset (dstBuf->buf() + dstLumaBytes, 0x80, dstChromaBytes);
-      memset (dstBuf->buf() + dstLumaBytes + dstChromaBytes, 0x80, dstChromaBytes);
-      if (AV_PIX_FMT_YUVA420P==mDstPixFmt)
-        memset (dstBuf->buf() + dstLumaBytes + dstChromaBytes * 2, 0x0, dstLumaBytes);
+  uint32_t dstChromaBytes = mDstLinesize[1] * chromaHeight;
+  uint32_t dstLumaOffsetBytes = placement.x * sampleBytes + placement.y * mDstLinesize[0];
+  uint32_t dstChromaOffsetBytes = placement.x / 2 * sampleBytes + chromaY * mDstLinesize[1];
+
+  uint8_t *planes[4];
+  planes[0] = dstBuf->buf();
+  planes[1] = dstBuf->buf() + dstLumaBytes;
+  planes[2] = dstBuf->buf() + dstLumaBytes + dstChromaBytes;
+  planes[3] = hasAlpha ? dstBuf->buf() + dstLumaBytes + dstChromaBytes * 2 : NULL;
+
+  // only the strips around the picture are filled, as the picture is written over the rest
+  if (placement.fillBorder) {
+    uint32_t chromaX = placement.x / 2;
+    uint32_t chromaPicWidth = placement.width / 2;
+    uint32_t chromaPicHeight = is420 ? placement.height / 2 : placement.height;
+    if (is420) {
+      // 8-bit fill
+      fillAround<uint8_t>(planes[0], mDstLinesize[0], mDstWidth, mDstHeight, placement.x, placement.y, placement.width, placement.height, 0x10);
+      fillAround<uint8_t>(planes[1], mDstLinesize[1], mDstWidth / 2, chromaHeight, chromaX, chromaY, chromaPicWidth, chromaPicHeight, 0x80);
+      fillAround<uint8_t>(planes[2], mDstLinesize[2], mDstWidth / 2, chromaHeight, chromaX, chromaY, chromaPicWidth, chromaPicHeight, 0x80);
+      if (hasAlpha)
+        fillAround<uint8_t>(planes[3], mDstLinesize[3], mDstWidth, mDstHeight, placement.x, placement.y, placement.width, placement.height, 0x0);
     } else {
       // 10-bit fill
-      uint16_t *buf;
-      buf = (uint16_t *)dstBuf->buf();
-      for (uint32_t i=0; i < dstLumaBytes / 2; ++i) { buf[i] = 0x40; } 
-      buf = (uint16_t *)dstBuf->buf() + dstLumaBytes;
-      for (uint32_t i=0; i < dstChromaBytes / 2; ++i) { buf[i] = 0x200; } 
-      buf = (uint16_t *)dstBuf->buf() + dstLumaBytes + dstChromaBytes;
-      for (uint32_t i=0; i < dstChromaBytes / 2; ++i) { buf[i] = 0x200; } 
-      if (AV_PIX_FMT_YUVA422P10LE==mDstPixFmt) {
-        buf = (uint16_t *)dstBuf->buf() + dstLumaBytes + dstChromaBytes * 2;
-        for (uint32_t i=0; i < dstLumaBytes / 2; ++i) { buf[i] = 0x0; } 
-      }
+      fillAround<uint16_t>(planes[0], mDstLinesize[0], mDstWidth, mDstHeight, placement.x, placement.y, placement.width, placement.height, 0x40);
+      fillAround<uint16_t>(planes[1], mDstLinesize[1], mDstWidth / 2, chromaHeight, chromaX, chromaY, chromaPicWidth, chromaPicHeight, 0x200);
+      fillAround<uint16_t>(planes[2], mDstLinesize[2], mDstWidth / 2, chromaHeight, chromaX, chromaY, chromaPicWidth, chromaPicHeight, 0x200);
+      if (hasAlpha)
+        fillAround<uint16_t>(planes[3], mDstLinesize[3], mDstWidth, mDstHeight, placement.x, placement.y, placement.width, placement.height, 0x0);
     }
   }
 
-  dstData[0] = (uint8_t *)dstBuf->buf() + dstLumaOffsetBytes;
-  dstData[1] = (uint8_t *)(dstBuf->buf() + dstLumaBytes) + dstChromaOffsetBytes;
-  dstData[2] = (uint8_t *)(dstBuf->buf() + dstLumaBytes + dstChromaBytes) + dstChromaOffsetBytes;
-  dstData[3] = ((AV_PIX_FMT_YUVA420P==mDstPixFmt) || (AV_PIX_FMT_YUVA422P10LE==mDstPixFmt))?(uint8_t *)dstBuf->buf() + dstLumaBytes + dstChromaBytes * 2 + dstLumaOffsetBytes:NULL;
-  
+  dstData[0] = planes[0] + dstLumaOffsetBytes;
+  dstData[1] = planes[1] + dstChromaOffsetBytes;
+  dstData[2] = planes[2] + dstChromaOffsetBytes;
+  dstData[3] = hasAlpha ? planes[3] + dstLumaOffsetBytes : NULL;
+}
+
+// swscale writes each line of its output in whole blocks of 16 bytes, past the end of the picture's lines unless they
+// are a multiple of that, which would overwrite the destination beside the picture
+bool ScaleConverterFF::swsOverwrites(uint32_t width) const {
+  uint32_t chromaRowBytes = (uint32_t)((uint64_t)mDstLinesize[1] * width / mDstWidth);
+  return 0 != chromaRowBytes % 16;
+}
+
+// a scratch picture of the given size for swscale to write, with room on each line for swscale's whole blocks
+uint8_t *ScaleConverterFF::acquireScratch(uint32_t width, uint32_t lines, uint8_t **scratchData, uint32_t *scratchLinesize,
+                                          uint32_t &scratchBytes) const {
+  scratchBytes = 0;
+  for (uint32_t i = 0; i < 4; ++i) {
+    uint32_t rowBytes = (uint32_t)((uint64_t)mDstLinesize[i] * width / mDstWidth);
+    scratchLinesize[i] = mDstLinesize[i] ? (rowBytes + 63) & ~63U : 0;
+    scratchBytes += scratchLinesize[i] * lines;
+  }
+  uint8_t *scratchBuf = FramePool::instance().acquire(scratchBytes);
+  for (uint32_t i = 0, planeOffset = 0; i < 4; ++i) {
+    scratchData[i] = scratchLinesize[i] ? scratchBuf + planeOffset : NULL;
+    planeOffset += scratchLinesize[i] * lines;
+  }
+  return scratchBuf;
+}
+
+// copies the samples of a scaled picture of the given size, and nothing beside it, to the destination
+void ScaleConverterFF::copyPicture(uint8_t *const *fromData, const uint32_t *fromLinesize, uint8_t *const *dstData,
+                                   uint32_t width, uint32_t height) const {
+  bool is420 = (AV_PIX_FMT_YUVA420P==mDstPixFmt) || (AV_PIX_FMT_YUV420P==mDstPixFmt);
+  for (uint32_t i = 0; i < 4; ++i) {
+    if (!fromData[i] || !dstData[i])
+      continue;
+    uint32_t rowBytes = (uint32_t)((uint64_t)mDstLinesize[i] * width / mDstWidth);
+    uint32_t lines = (is420 && ((1 == i) || (2 == i))) ? height / 2 : height;
+    for (uint32_t y = 0; y < lines; ++y)
+      memcpy(dstData[i] + y * mDstLinesize[i], fromData[i] + y * fromLinesize[i], rowBytes);
+  }
+}
+
+bool ScaleConverterFF::scaleConvertFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) {
+  return scaleConvertFrame(srcBuf, dstBuf, mUserScale, mUserDstOffset);
+}
+
+bool ScaleConverterFF::scaleConvertFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf,
+                                          const fXY &userScale, const fXY &userDstOffset) {
+  Placement placement = ((userScale == mUserScale) && (userDstOffset == mUserDstOffset)) ? mPlacement : place(userScale, userDstOffset);
+  std::shared_ptr<Scalers> frameScalers = scalers(placement);
+  if (!frameScalers)
+    return false;
+
+  uint8_t *srcData[4];
+  srcPlanes(srcBuf->buf(), mSrcHeight, srcData);
+  uint8_t *dstData[4];
+  dstPlanes(dstBuf, placement, dstData);
+
+  if (frameScalers->polyphaseScaler) {
+    frameScalers->polyphaseScaler->scale(srcData, mSrcLinesize, dstData, mDstLinesize, mNumThreads);
+    return true;
+  }
+
+  if (!frameScalers->slices.empty()) {
+    const std::vector<ScaleSlice> &slices = frameScalers->slices;
+    uint32_t width = frameScalers->width;
+    WorkerPool::instance().runLines((uint32_t)slices.size(), (uint32_t)slices.size(), 1,
+      [this, &slices, width, &srcData, &dstData](uint32_t firstSlice, uint32_t numSlices) {
+        for (uint32_t i = firstSlice; i < firstSlice + numSlices; ++i)
+          scaleConvertSlice(slices[i], width, srcData, dstData);
+      });
+    return true;
+  }
+
+  // a picture whose lines swscale would write past goes through a scratch picture
+  uint8_t *scaleData[4];
+  uint32_t scaleLinesize[4];
+  uint32_t scratchBytes = 0;
+  uint8_t *scratchBuf = NULL;
+  if (swsOverwrites(frameScalers->width))
+    scratchBuf = acquireScratch(frameScalers->width, frameScalers->height, scaleData, scaleLinesize, scratchBytes);
+  else {
+    std::copy(dstData, dstData + 4, scaleData);
+    std::copy(mDstLinesize, mDstLinesize + 4, scaleLinesize);
+  }
+
   bool srcProgressive = (0 == mSrcIlace.compare("prog"));
   bool dstProgressive = (0 == mDstIlace.compare("prog"));
   if (srcProgressive && dstProgressive) {
-    sws_scale(mSwsContext, (const uint8_t * const*)srcData,
-              (const int *)mSrcLinesize, 0, mSrcHeight, dstData, (const int *)mDstLinesize);
+    sws_scale(frameScalers->swsContext, (const uint8_t * const*)srcData,
+              (const int *)mSrcLinesize, 0, mSrcHeight, scaleData, (const int *)scaleLinesize);
   } else {
     bool srcTff = (0 == mSrcIlace.compare("tff"));
     bool dstTff = (0 == mDstIlace.compare("tff"));
     // first field
-    scaleConvertField (srcData, dstData, srcTff?0:1, dstTff?0:1);
+    scaleConvertField (frameScalers->swsContext, srcData, scaleData, scaleLinesize, srcTff?0:1, dstTff?0:1, 0, mSrcHeight/2);
     // second field
-    scaleConvertField (srcData, dstData, srcTff?1:0, dstTff?1:0);
+    scaleConvertField (frameScalers->swsContext, srcData, scaleData, scaleLinesize, srcTff?1:0, dstTff?1:0, 0, mSrcHeight/2);
+  }
+
+  if (scratchBuf) {
+    copyPicture(scaleData, scaleLinesize, dstData, frameScalers->width, frameScalers->height);
+    FramePool::instance().release(scratchBuf, scratchBytes);
+  }
+  return true;
+}
+
+// Scales the lines of a slice, a field at a time for interlaced material, into a scratch band and copies the lines the
+// slice owns to the destination
+void ScaleConverterFF::scaleConvertSlice(const ScaleSlice &slice, uint32_t width, uint8_t **srcData, uint8_t **dstData) {
+  uint8_t *scratchData[4];
+  uint32_t scratchLinesize[4];
+  uint32_t scratchBytes;
+  uint8_t *scratchBuf = acquireScratch(width, slice.dstLines, scratchData, scratchLinesize, scratchBytes);
+  uint32_t rowBytes[4];
+  for (uint32_t i = 0; i < 4; ++i) {
+    // the scaled picture may be narrower than the destination, whose sides are left as they are
+    rowBytes[i] = (uint32_t)((uint64_t)mDstLinesize[i] * width / mDstWidth);
+  }
+
+  bool fields = mSrcIlace.compare("prog") || mDstIlace.compare("prog");
+  bool srcTff = (0 == mSrcIlace.compare("tff"));
+  bool dstTff = (0 == mDstIlace.compare("tff"));
+  uint32_t lineStep = fields ? 2 : 1;
+  for (uint32_t field = 0; field < lineStep; ++field) {
+    uint32_t srcField = fields ? (srcTff?0:1) ^ field : 0;
+    uint32_t dstField = fields ? (dstTff?0:1) ^ field : 0;
+    const uint8_t *srcBuf[4];
+    uint32_t srcStride[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+      srcStride[i] = mSrcLinesize[i] * lineStep;
+      srcBuf[i] = srcData[i] ? srcData[i] + (srcField + slice.srcFirst * lineStep) * mSrcLinesize[i] : NULL;
+    }
+    sws_scale(slice.swsContext, srcBuf, (const int *)srcStride, 0, slice.srcLines, scratchData, (const int *)scratchLinesize);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+      if (!scratchData[i] || !dstData[i])
+        continue;
+      for (uint32_t y = 0; y < slice.outLines; ++y)
+        memcpy(dstData[i] + (dstField + (slice.outFirst + y) * lineStep) * mDstLinesize[i],
+               scratchData[i] + (slice.outFirst - slice.dstFirst + y) * scratchLinesize[i], rowBytes[i]);
+    }
+  }
+
+  FramePool::instance().release(scratchBuf, scratchBytes);
+}
+
+bool ScaleConverterFF::scaleConvertBands (tFillBandFn fillBand, uint32_t bandLines, std::shared_ptr<Memory> dstBuf) {
+  return scaleConvertBands(fillBand, bandLines, dstBuf, mUserScale, mUserDstOffset);
+}
+
+bool ScaleConverterFF::scaleConvertBands (tFillBandFn fillBand, uint32_t bandLines, std::shared_ptr<Memory> dstBuf,
+                                          const fXY &userScale, const fXY &userDstOffset) {
+  Placement placement = ((userScale == mUserScale) && (userDstOffset == mUserDstOffset)) ? mPlacement : place(userScale, userDstOffset);
+  std::shared_ptr<Scalers> frameScalers = bandScalers(placement);
+  if (!frameScalers || frameScalers->polyphaseScaler)
+    return false;
+
+  uint8_t *dstData[4];
+  dstPlanes(dstBuf, placement, dstData);
+
+  uint8_t *scaleData[4];
+  uint32_t scaleLinesize[4];
+  uint32_t scratchBytes = 0;
+  uint8_t *scratchBuf = NULL;
+  if (swsOverwrites(frameScalers->width))
+    scratchBuf = acquireScratch(frameScalers->width, frameScalers->height, scaleData, scaleLinesize, scratchBytes);
+  else {
+    std::copy(dstData, dstData + 4, scaleData);
+    std::copy(mDstLinesize, mDstLinesize + 4, scaleLinesize);
+  }
+
+  uint32_t bandBytes = srcBytes(bandLines);
+  uint8_t *bandBuf = FramePool::instance().acquire(bandBytes);
+  uint8_t *srcData[4];
+  srcPlanes(bandBuf, bandLines, srcData);
+
+  bool srcProgressive = (0 == mSrcIlace.compare("prog"));
+  bool dstProgressive = (0 == mDstIlace.compare("prog"));
+  bool srcTff = (0 == mSrcIlace.compare("tff"));
+  bool dstTff = (0 == mDstIlace.compare("tff"));
+  // the scaler takes the bands as successive slices of its source, from the top down
+  for (uint32_t firstLine = 0; firstLine < mSrcHeight; firstLine += bandLines) {
+    uint32_t numLines = std::min(bandLines, mSrcHeight - firstLine);
+    fillBand(bandBuf, firstLine, numLines);
+    if (srcProgressive && dstProgressive) {
+      sws_scale(frameScalers->swsContext, (const uint8_t * const*)srcData,
+                (const int *)mSrcLinesize, firstLine, numLines, scaleData, (const int *)scaleLinesize);
+    } else {
+      scaleConvertField (frameScalers->swsContext, srcData, scaleData, scaleLinesize, srcTff?0:1, dstTff?0:1, firstLine/2, numLines/2);
+      scaleConvertField (frameScalers->secondFieldSwsContext, srcData, scaleData, scaleLinesize, srcTff?1:0, dstTff?1:0, firstLine/2, numLines/2);
+    }
+  }
+
+  FramePool::instance().release(bandBuf, bandBytes);
+  if (scratchBuf) {
+    copyPicture(scaleData, scaleLinesize, dstData, frameScalers->width, frameScalers->height);
+    FramePool::instance().release(scratchBuf, scratchBytes);
   }
+  return true;
 }
 
 } // namespace streampunk
@@ -17,6 +17,8 @@
 #define SCALECONVERTERFF_H
 
 #include <memory>
+#include <functional>
+#include <vector>
 #include "iDebug.h"
 #include "iProcess.h"
 #include "Primitives.h"
@@ -26,17 +28,70 @@ namespace streampunk {
 
 class Memory;
 class EssenceInfo;
+class PolyphaseScaler;
 class ScaleConverterFF : public iDebug {
 public:
   ScaleConverterFF(std::shared_ptr<EssenceInfo> srcVidInfo, std::shared_ptr<EssenceInfo> dstVidInfo,
-                   const fXY &userScale, const fXY &userDstOffset, eDebugLevel debugLevel);
+                   const fXY &userScale, const fXY &userDstOffset, bool nativeScaler, uint32_t numThreads,
+                   bool compose, eDebugLevel debugLevel);
   ~ScaleConverterFF();
 
   std::string packingRequired() const;
-  void scaleConvertFrame(std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf); 
+  // the scale and offset given at construction are used unless others are given for the frame - false if no scaler
+  // could be made for the size of the picture
+  bool scaleConvertFrame(std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf);
+  bool scaleConvertFrame(std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf, const fXY &userScale, const fXY &userDstOffset);
+
+  // Scales a frame whose source is produced a band of lines at a time, by fillBand writing the lines from firstLine
+  // into a band buffer laid out as a frame of bandLines lines in packingRequired(). The scaler keeps the source lines
+  // it still needs, so the one band buffer is reused and no full size source frame is made. bandLines must keep
+  // chroma line pairs and interlaced field pairs together.
+  typedef std::function<void(uint8_t *bandBuf, uint32_t firstLine, uint32_t numLines)> tFillBandFn;
+  bool scaleConvertBands(tFillBandFn fillBand, uint32_t bandLines, std::shared_ptr<Memory> dstBuf);
+  bool scaleConvertBands(tFillBandFn fillBand, uint32_t bandLines, std::shared_ptr<Memory> dstBuf,
+                         const fXY &userScale, const fXY &userDstOffset);
+  // whether scaling a band at a time gives the same result as scaling the whole frame
+  bool canScaleBands() const;
+  // whether the native scaler was requested and can take the formats in place of swscale
+  bool nativeScaling() const;
 
 private:
-  SwsContext *mSwsContext;
+  // A horizontal slice of the picture, scaled on a pool thread by its own context. The context is fed the source lines
+  // for its output lines and enough either side that its edges do not change them, so it makes the lines above and
+  // below as well, which go to a scratch band. Lines are counted within a field for interlaced material.
+  struct ScaleSlice {
+    SwsContext *swsContext;
+    uint32_t srcFirst;
+    uint32_t srcLines;
+    uint32_t dstFirst;
+    uint32_t dstLines;
+    uint32_t outFirst;
+    uint32_t outLines;
+  };
+  // The scalers for one size of scaled picture. The source size and format are fixed for the converter, so the size
+  // is the key for reusing them from frame to frame.
+  struct Scalers {
+    Scalers(uint32_t width, uint32_t height) : width(width), height(height), swsContext(NULL), secondFieldSwsContext(NULL) {}
+    ~Scalers();
+    const uint32_t width;
+    const uint32_t height;
+    SwsContext *swsContext;
+    // interlaced material fed a band at a time has lines of both fields in each band, so each field has its own context -
+    // made only when the band path first uses these scalers
+    SwsContext *secondFieldSwsContext;
+    std::shared_ptr<PolyphaseScaler> polyphaseScaler;
+    std::vector<ScaleSlice> slices;
+  };
+  // the scaled picture's size and its position in whole samples from the top left of the destination, and whether the
+  // rest of the destination is filled with black
+  struct Placement {
+    uint32_t width;
+    uint32_t height;
+    uint32_t x;
+    uint32_t y;
+    bool fillBorder;
+  };
+
   const uint32_t mSrcWidth;
   const uint32_t mSrcHeight;
   const std::string mSrcIlace;
@@ -47,12 +102,31 @@ private:
   const uint32_t mDstPixFmt;
   const fXY mUserScale;
   const fXY mUserDstOffset;
-  fXY mScale;
-  fXY mDstOffset;
-  bool mDoWipe;
+  const bool mNativeScaler;
+  const uint32_t mNumThreads;
+  // the destination is a canvas whose samples outside the picture are left as they are
+  const bool mCompose;
+  const int *mColourTable;
   uint32_t mSrcLinesize[4], mDstLinesize[4];
+  Placement mPlacement;
+  std::shared_ptr<Scalers> mScalers;
+  // the scalers for the sizes used most recently, most recent first
+  std::vector<std::shared_ptr<Scalers> > mScalersCache;
 
-  void scaleConvertField (uint8_t **srcData, uint8_t **dstData, uint32_t srcField, uint32_t dstField);
+  Placement place(const fXY &userScale, const fXY &userDstOffset);
+  std::shared_ptr<Scalers> scalers(const Placement &placement);
+  std::shared_ptr<Scalers> makeScalers(uint32_t width, uint32_t height);
+  std::shared_ptr<Scalers> bandScalers(const Placement &placement);
+  void makeSlices(Scalers &scalers);
+  uint32_t srcBytes(uint32_t height) const;
+  void srcPlanes(uint8_t *buf, uint32_t height, uint8_t **srcData) const;
+  void dstPlanes(std::shared_ptr<Memory> dstBuf, const Placement &placement, uint8_t **dstData) const;
+  bool swsOverwrites(uint32_t width) const;
+  uint8_t *acquireScratch(uint32_t width, uint32_t lines, uint8_t **scratchData, uint32_t *scratchLinesize, uint32_t &scratchBytes) const;
+  void copyPicture(uint8_t *const *fromData, const uint32_t *fromLinesize, uint8_t *const *dstData, uint32_t width, uint32_t height) const;
+  void scaleConvertField (SwsContext *swsContext, uint8_t **srcData, uint8_t **dstData, const uint32_t *dstLinesize,
+                          uint32_t srcField, uint32_t dstField, uint32_t firstFieldLine, uint32_t numFieldLines);
+  void scaleConvertSlice(const ScaleSlice &slice, uint32_t width, uint8_t **srcData, uint8_t **dstData);
 };
 
 } // namespace streampunk
@@ -22,6 +22,8 @@
 #include "Packers.h"
 #include "Primitives.h"
 #include "Persist.h"
+#include "ProcessParams.h"
+#include "WorkerPool.h"
 
 #include <memory>
 
@@ -29,132 +31,196 @@ using namespace v8;
 
 namespace streampunk {
 
-class WipeProcessData : public iProcessData {
+// the four stamper operations share one process data type tag so that processFrame can dispatch without RTTI
+class StamperProcessData : public iProcessData {
 public:
-  WipeProcessData (Local<Object> dstBufObj, const iRect &wipeRect, const fCol &wipeCol)
-    : mPersistentDstBuf(new Persist(dstBufObj)),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj))),
-      mWipeRect(wipeRect), mWipeCol(wipeCol)
+  enum eStampOp { eWipe, eCopy, eMix, eStamp };
+  StamperProcessData (eStampOp op) : mOp(op) { }
+  virtual ~StamperProcessData() { }
+
+  eStampOp op() const { return mOp; }
+
+private:
+  const eStampOp mOp;
+};
+
+class WipeProcessData : public StamperProcessData {
+public:
+  WipeProcessData ()
+    : StamperProcessData(eWipe), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0)),
+      mWipeRect(iXY(0, 0), iXY(0, 0)), mWipeCol(0.0, 0.0, 0.0)
   { }
   ~WipeProcessData() { }
+
+  void set(Local<Object> dstBufObj, const iRect &wipeRect, const fCol &wipeCol) {
+    mPersistentDstBuf.reset(dstBufObj);
+    mDstBuf->reset((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
+    mWipeRect = wipeRect;
+    mWipeCol = wipeCol;
+  }
+  void recycle() {
+    mPersistentDstBuf.reset();
+  }
   
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
   iRect wipeRect() const { return mWipeRect; }
   fCol wipeCol() const { return mWipeCol; }
 
 private:
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  Persist mPersistentDstBuf;
   std::shared_ptr<Memory> mDstBuf;
   iRect mWipeRect;
   fCol mWipeCol;
 };
 
-class CopyProcessData : public iProcessData {
+class CopyProcessData : public StamperProcessData {
 public:
-  CopyProcessData (Local<Object> srcBufObj, Local<Object> dstBufObj, const iXY &dstOrg)
-    : mPersistentSrcBuf(new Persist(srcBufObj)),
-      mPersistentDstBuf(new Persist(dstBufObj)),
-      mSrcBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj))),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj))),
-      mDstOrg(dstOrg)
+  CopyProcessData ()
+    : StamperProcessData(eCopy),
+      mSrcBuf(Memory::makeNew((uint8_t *)NULL, 0)), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0)),
+      mDstOrg(0, 0)
   { }
   ~CopyProcessData() { }
+
+  void set(Local<Object> srcBufObj, Local<Object> dstBufObj, const iXY &dstOrg) {
+    mPersistentSrcBuf.reset(srcBufObj);
+    mPersistentDstBuf.reset(dstBufObj);
+    mSrcBuf->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
+    mDstBuf->reset((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
+    mDstOrg = dstOrg;
+  }
+  void recycle() {
+    mPersistentSrcBuf.reset();
+    mPersistentDstBuf.reset();
+  }
   
   std::shared_ptr<Memory> srcBuf() const { return mSrcBuf; }
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
   iXY dstOrg() const { return mDstOrg; }
 
 private:
-  std::unique_ptr<Persist> mPersistentSrcBuf;
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  Persist mPersistentSrcBuf;
+  Persist mPersistentDstBuf;
   std::shared_ptr<Memory> mSrcBuf;
   std::shared_ptr<Memory> mDstBuf;
   iXY mDstOrg;
 };
 
-class MixProcessData : public iProcessData {
+// source buffer descriptors are only ever added, so a recycled entry makes no allocations for the same number of sources
+class MultiSrcProcessData : public StamperProcessData {
 public:
-  MixProcessData (Local<Array> srcBufArray, Local<Object> dstBufObj, float pressure)
-    : mPersistentDstBuf(new Persist(dstBufObj)),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj))),
-      mPressure(pressure)
-  { 
-    for (uint32_t i=0; i<srcBufArray->Length(); ++i) {
+  MultiSrcProcessData (eStampOp op)
+    : StamperProcessData(op), mNumSrcs(0), mDstBuf(Memory::makeNew((uint8_t *)NULL, 0))
+  { }
+  virtual ~MultiSrcProcessData() { }
+
+  void setBufs(Local<Array> srcBufArray, Local<Object> dstBufObj) {
+    mNumSrcs = srcBufArray->Length();
+    while (mSrcBufs.size() < mNumSrcs) {
+      mPersistentSrcBufs.push_back(std::unique_ptr<Persist>(new Persist));
+      mSrcBufs.push_back(Memory::makeNew((uint8_t *)NULL, 0));
+    }
+    for (uint32_t i=0; i<mNumSrcs; ++i) {
       Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
-      mPersistentSrcBufs.push_back(std::shared_ptr<Persist>(new Persist(srcBufObj)));
-      mSrcBufs.push_back(Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj)));
+      mPersistentSrcBufs[i]->reset(srcBufObj);
+      mSrcBufs[i]->reset((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj));
     }
+    mPersistentDstBuf.reset(dstBufObj);
+    mDstBuf->reset((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj));
   }
-  ~MixProcessData() { }
-  
-  std::vector<std::shared_ptr<Memory> > srcBufs() const { return mSrcBufs; }
+  void recycle() {
+    for (uint32_t i=0; i<mNumSrcs; ++i)
+      mPersistentSrcBufs[i]->reset();
+    mPersistentDstBuf.reset();
+  }
+
+  uint32_t numSrcs() const { return mNumSrcs; }
+  const std::vector<std::shared_ptr<Memory> > &srcBufs() const { return mSrcBufs; }
   std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
-  float pressure() const { return mPressure; }
 
 private:
-  std::vector<std::shared_ptr<Persist> > mPersistentSrcBufs;
-  std::unique_ptr<Persist> mPersistentDstBuf;
+  uint32_t mNumSrcs;
+  std::vector<std::unique_ptr<Persist> > mPersistentSrcBufs;
+  Persist mPersistentDstBuf;
   std::vector<std::shared_ptr<Memory> > mSrcBufs;
   std::shared_ptr<Memory> mDstBuf;
-  float mPressure;
 };
 
-class StampProcessData : public iProcessData {
+class MixProcessData : public MultiSrcProcessData {
 public:
-  StampProcessData (Local<Array> srcBufArray, Local<Object> dstBufObj)
-    : mPersistentDstBuf(new Persist(dstBufObj)),
-      mDstBuf(Memory::makeNew((uint8_t *)node::Buffer::Data(dstBufObj), (uint32_t)node::Buffer::Length(dstBufObj)))
-  { 
-    for (uint32_t i=0; i<srcBufArray->Length(); ++i) {
-      Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
-      mPersistentSrcBufs.push_back(std::shared_ptr<Persist>(new Persist(srcBufObj)));
-      mSrcBufs.push_back(Memory::makeNew((uint8_t *)node::Buffer::Data(srcBufObj), (uint32_t)node::Buffer::Length(srcBufObj)));
-    }
+  MixProcessData () : MultiSrcProcessData(eMix), mPressure(0.0f) { }
+  ~MixProcessData() { }
+
+  void set(Local<Array> srcBufArray, Local<Object> dstBufObj, float pressure) {
+    setBufs(srcBufArray, dstBufObj);
+    mPressure = pressure;
   }
-  ~StampProcessData() { }
   
-  std::vector<std::shared_ptr<Memory> > srcBufs() const { return mSrcBufs; }
-  std::shared_ptr<Memory> dstBuf() const { return mDstBuf; }
+  float pressure() const { return mPressure; }
 
 private:
-  std::vector<std::shared_ptr<Persist> > mPersistentSrcBufs;
-  std::unique_ptr<Persist> mPersistentDstBuf;
-  std::vector<std::shared_ptr<Memory> > mSrcBufs;
-  std::shared_ptr<Memory> mDstBuf;
+  float mPressure;
+};
+
+class StampProcessData : public MultiSrcProcessData {
+public:
+  StampProcessData () : MultiSrcProcessData(eStamp) { }
+  ~StampProcessData() { }
+
+  void set(Local<Array> srcBufArray, Local<Object> dstBufObj) {
+    setBufs(srcBufArray, dstBufObj);
+  }
 };
 
 Stamper::Stamper(Nan::Callback *callback) 
-  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mDstBytesReq(0) {
-  AsyncQueueWorker(mWorker);
-}
+  : mWorker(new MyWorker(callback)), mSetInfoOK(false), mDstBytesReq(0) {}
 Stamper::~Stamper() {}
 
 // iProcess
 uint32_t Stamper::processFrame (std::shared_ptr<iProcessData> processData) {
   Timer t;
   std::string func("null");
-  std::shared_ptr<WipeProcessData> wpd = std::dynamic_pointer_cast<WipeProcessData>(processData);
-  if (wpd) {
+  WorkerPool::tLinesFn linesFn;
+  uint32_t numLines = mSrcVidInfo->height();
+  const StamperProcessData *pd = static_cast<const StamperProcessData *>(processData.get());
+  switch (pd->op()) {
+  case StamperProcessData::eWipe: {
+    const WipeProcessData *wpd = static_cast<const WipeProcessData *>(pd);
     func = "wipe";
-    doWipe(wpd);
+    numLines = wpd->wipeRect().len.y;
+    linesFn = [this, wpd](uint32_t firstLine, uint32_t numLines) { doWipe(wpd, firstLine, numLines); };
+    break;
   }
-
-  std::shared_ptr<CopyProcessData> cpd = std::dynamic_pointer_cast<CopyProcessData>(processData);
-  if (cpd) {
+  case StamperProcessData::eCopy: {
+    const CopyProcessData *cpd = static_cast<const CopyProcessData *>(pd);
     func = "copy";
-    doCopy(cpd);
+    linesFn = [this, cpd](uint32_t firstLine, uint32_t numLines) { doCopy(cpd, firstLine, numLines); };
+    break;
   }
-
-  std::shared_ptr<MixProcessData> mpd = std::dynamic_pointer_cast<MixProcessData>(processData);
-  if (mpd) {
+  case StamperProcessData::eMix: {
+    const MixProcessData *mpd = static_cast<const MixProcessData *>(pd);
     func = "mix";
-    doMix(mpd);
+    linesFn = [this, mpd](uint32_t firstLine, uint32_t numLines) { doMix(mpd, firstLine, numLines); };
+    break;
   }
-
-  std::shared_ptr<StampProcessData> spd = std::dynamic_pointer_cast<StampProcessData>(processData);
-  if (spd) {
+  case StamperProcessData::eStamp: {
+    const StampProcessData *spd = static_cast<const StampProcessData *>(pd);
     func = "stamp";
-    doStamp(spd);
+    linesFn = [this, spd](uint32_t firstLine, uint32_t numLines) { doStamp(spd, firstLine, numLines); };
+    break;
+  }
+  }
+
+  if (linesFn) {
+    if (mProcessParams->threads() < 2)
+      linesFn(0, numLines);
+    else {
+      // bands must start on a chroma line for 420P, and on a frame line pair for interlaced material
+      uint32_t lineAlign = (0 == mSrcVidInfo->packing().compare("420P")) ? 2 : 1;
+      if (mSrcVidInfo->interlace().compare("prog"))
+        lineAlign *= 2;
+      WorkerPool::instance().runLines(numLines, mProcessParams->threads(), lineAlign, linesFn);
+    }
   }
 
   printDebug(eDebug, "%s: %.2fms\n", func.c_str(), t.delta());
@@ -168,6 +234,13 @@ void Stamper::doSetInfo(Local<Array> srcTagsArray, Local<Object> dstTags) {
   printDebug(eInfo, "Stamper SrcVidInfo: %s\n", mSrcVidInfo->toString().c_str());
   mDstVidInfo = std::make_shared<EssenceInfo>(dstTags); 
   printDebug(eInfo, "Stamper DstVidInfo: %s\n", mDstVidInfo->toString().c_str());
+  mProcessParams = std::make_shared<ProcessParams>(dstTags);
+  printDebug(eInfo, "Stamper ProcessParams: %s\n", mProcessParams->toString().c_str());
+  mWorker->setQueueDepth(mProcessParams->queueDepth());
+  if (!mWorker->setDropPolicy(mProcessParams->dropPolicy(), mProcessParams->dropLimit())) {
+    std::string err = std::string("Unsupported drop policy \'") + mProcessParams->dropPolicy() + "\'";
+    return Nan::ThrowError(err.c_str());
+  }
 
   if (mSrcVidInfo->packing().compare(mDstVidInfo->packing())) {
     std::string err = std::string("Source and destination format must be identical \'") + mSrcVidInfo->packing() + "\', \'" + mDstVidInfo->packing() + "\'";
@@ -179,17 +252,24 @@ void Stamper::doSetInfo(Local<Array> srcTagsArray, Local<Object> dstTags) {
   }
   if (mDstVidInfo->packing().compare("420P") && mDstVidInfo->packing().compare("YUV422P10")) { 
     std::string err = std::string("Unsupported destination packing type \'") + mDstVidInfo->packing() + "\'";
-    Nan::ThrowError(err.c_str());
+    return Nan::ThrowError(err.c_str());
   }
   if ((mSrcVidInfo->width() % 2) || (mDstVidInfo->width() % 2)) {
     std::string err = std::string("Width must be divisible by 2 - src ") + std::to_string(mSrcVidInfo->width()) + ", dst " + std::to_string(mDstVidInfo->width());
-    Nan::ThrowError(err.c_str());
+    return Nan::ThrowError(err.c_str());
+  }
+  // in place, the destination is one of the sources, so they must share a layout
+  if (mProcessParams->inPlace() && ((mSrcVidInfo->width() != mDstVidInfo->width()) || (mSrcVidInfo->height() != mDstVidInfo->height()))) {
+    std::string err = std::string("In-place processing requires the source and destination sizes to match - src ") + 
+                      std::to_string(mSrcVidInfo->width()) + "x" + std::to_string(mSrcVidInfo->height()) + ", dst " + 
+                      std::to_string(mDstVidInfo->width()) + "x" + std::to_string(mDstVidInfo->height());
+    return Nan::ThrowError(err.c_str());
   }
 
   mDstBytesReq = getFormatBytes(mDstVidInfo->packing(), mDstVidInfo->width(), mDstVidInfo->height());
 }
 
-void Stamper::doWipe(std::shared_ptr<WipeProcessData> wpd) {
+void Stamper::doWipe(const WipeProcessData *wpd, uint32_t firstLine, uint32_t numLines) {
   uint32_t blackLevel = 64;
   uint32_t lumaRange = 940 - blackLevel;
   uint32_t chromaRange = 960 - blackLevel;
@@ -222,7 +302,11 @@ void Stamper::doWipe(std::shared_ptr<WipeProcessData> wpd) {
   dstULine += wpd->wipeRect().org.x * bytesPerPixel / 2 + dstChromaPitchBytes * wpd->wipeRect().org.y / lumaLinesPerChromaLine;
   dstVLine += wpd->wipeRect().org.x * bytesPerPixel / 2 + dstChromaPitchBytes * wpd->wipeRect().org.y / lumaLinesPerChromaLine;
 
-  for (int32_t y=0; y<wpd->wipeRect().len.y; ++y) {
+  dstYLine += dstLumaPitchBytes * firstLine;
+  dstULine += dstChromaPitchBytes * firstLine / lumaLinesPerChromaLine;
+  dstVLine += dstChromaPitchBytes * firstLine / lumaLinesPerChromaLine;
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
     bool evenLine = (y & 1) == 0;
 
     if (1==bytesPerPixel) {
@@ -251,7 +335,7 @@ void Stamper::doWipe(std::shared_ptr<WipeProcessData> wpd) {
   }
 }
 
-void Stamper::doCopy(std::shared_ptr<CopyProcessData> cpd) {
+void Stamper::doCopy(const CopyProcessData *cpd, uint32_t firstLine, uint32_t numLines) {
   uint32_t bytesPerPixel = 2;
   uint32_t lumaLinesPerChromaLine = 1;
   if (0 == mSrcVidInfo->packing().compare("420P")) {
@@ -281,7 +365,14 @@ void Stamper::doCopy(std::shared_ptr<CopyProcessData> cpd) {
   dstULine += cpd->dstOrg().x * bytesPerPixel / 2 + dstChromaPitchBytes * cpd->dstOrg().y / lumaLinesPerChromaLine;
   dstVLine += cpd->dstOrg().x * bytesPerPixel / 2 + dstChromaPitchBytes * cpd->dstOrg().y / lumaLinesPerChromaLine;
 
-  for (uint32_t y=0; y<mSrcVidInfo->height(); ++y) {
+  srcYLine += srcLumaPitchBytes * firstLine;
+  srcULine += srcChromaPitchBytes * firstLine / lumaLinesPerChromaLine;
+  srcVLine += srcChromaPitchBytes * firstLine / lumaLinesPerChromaLine;
+  dstYLine += dstLumaPitchBytes * firstLine;
+  dstULine += dstChromaPitchBytes * firstLine / lumaLinesPerChromaLine;
+  dstVLine += dstChromaPitchBytes * firstLine / lumaLinesPerChromaLine;
+
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
     bool evenLine = (y & 1) == 0;
 
     memcpy(dstYLine, srcYLine, srcLumaPitchBytes);
@@ -299,7 +390,7 @@ void Stamper::doCopy(std::shared_ptr<CopyProcessData> cpd) {
   }
 }
 
-void Stamper::doMix(std::shared_ptr<MixProcessData> mpd) {
+void Stamper::doMix(const MixProcessData *mpd, uint32_t firstLine, uint32_t numLines) {
   uint32_t bytesPerPixel = 2;
   uint32_t lumaLinesPerChromaLine = 1;
   if (0 == mSrcVidInfo->packing().compare("420P")) {
@@ -317,23 +408,28 @@ void Stamper::doMix(std::shared_ptr<MixProcessData> mpd) {
   uint32_t dstLumaPlaneBytes = dstLumaPitchBytes * mDstVidInfo->height();
   uint32_t dstChromaPlaneBytes = dstChromaPitchBytes * mDstVidInfo->height() / lumaLinesPerChromaLine;
 
+  uint32_t firstChromaLine = firstLine / lumaLinesPerChromaLine;
   const uint8_t *srcLine[2][3];
   for (uint32_t s=0; s<2; ++s) { 
     srcLine[s][0] = mpd->srcBufs()[s]->buf();
-    srcLine[s][1] = srcLine[s][0] + srcLumaPlaneBytes;
-    srcLine[s][2] = srcLine[s][1] + srcChromaPlaneBytes;
+    srcLine[s][1] = srcLine[s][0] + srcLumaPlaneBytes + srcChromaPitchBytes * firstChromaLine;
+    srcLine[s][2] = srcLine[s][0] + srcLumaPlaneBytes + srcChromaPlaneBytes + srcChromaPitchBytes * firstChromaLine;
+    srcLine[s][0] += srcLumaPitchBytes * firstLine;
   }
 
   uint8_t *dstLine[3];
   dstLine[0] = mpd->dstBuf()->buf();
-  dstLine[1] = dstLine[0] + dstLumaPlaneBytes;
-  dstLine[2] = dstLine[1] + dstChromaPlaneBytes;
+  dstLine[1] = dstLine[0] + dstLumaPlaneBytes + dstChromaPitchBytes * firstChromaLine;
+  dstLine[2] = dstLine[0] + dstLumaPlaneBytes + dstChromaPlaneBytes + dstChromaPitchBytes * firstChromaLine;
+  dstLine[0] += dstLumaPitchBytes * firstLine;
   
   float pressure = mpd->pressure();
-        
+
+  // each destination sample depends only on the source samples at the same position, which are read before it is written,
+  // so the destination may be one of the sources when mixing in place
   for (uint32_t p=0; p<3; ++p) {
     uint32_t numPixels = (0==p) ? mSrcVidInfo->width() : mSrcVidInfo->width() / 2;
-    for (uint32_t y=0; y<mSrcVidInfo->height(); ++y) {
+    for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
       bool evenLine = (y & 1) == 0;
       if (1==bytesPerPixel) {
         const uint8_t *srcA = srcLine[0][p];
@@ -362,7 +458,7 @@ void Stamper::doMix(std::shared_ptr<MixProcessData> mpd) {
   }
 }
 
-void Stamper::doStamp(std::shared_ptr<StampProcessData> spd) {
+void Stamper::doStamp(const StampProcessData *spd, uint32_t firstLine, uint32_t numLines) {
   uint32_t bytesPerPixel = 2;
   uint32_t lumaLinesPerChromaLine = 1;
   if (0 == mSrcVidInfo->packing().compare("420P")) {
@@ -380,20 +476,23 @@ void Stamper::doStamp(std::shared_ptr<StampProcessData> spd) {
   uint32_t dstLumaPlaneBytes = dstLumaPitchBytes * mDstVidInfo->height();
   uint32_t dstChromaPlaneBytes = dstChromaPitchBytes * mDstVidInfo->height() / lumaLinesPerChromaLine;
 
+  uint32_t firstChromaLine = firstLine / lumaLinesPerChromaLine;
   const uint8_t *srcLine[2][4];
   for (uint32_t s=0; s<2; ++s) { 
     srcLine[s][0] = spd->srcBufs()[s]->buf();
-    srcLine[s][1] = srcLine[s][0] + srcLumaPlaneBytes;
-    srcLine[s][2] = srcLine[s][1] + srcChromaPlaneBytes;
-    srcLine[s][3] = srcLine[s][2] + srcChromaPlaneBytes;
+    srcLine[s][1] = srcLine[s][0] + srcLumaPlaneBytes + srcChromaPitchBytes * firstChromaLine;
+    srcLine[s][2] = srcLine[s][0] + srcLumaPlaneBytes + srcChromaPlaneBytes + srcChromaPitchBytes * firstChromaLine;
+    srcLine[s][3] = srcLine[s][0] + srcLumaPlaneBytes + srcChromaPlaneBytes * 2 + srcLumaPitchBytes * firstLine;
+    srcLine[s][0] += srcLumaPitchBytes * firstLine;
   }
 
   uint8_t *dstLine[3];
   dstLine[0] = spd->dstBuf()->buf();
-  dstLine[1] = dstLine[0] + dstLumaPlaneBytes;
-  dstLine[2] = dstLine[1] + dstChromaPlaneBytes;
+  dstLine[1] = dstLine[0] + dstLumaPlaneBytes + dstChromaPitchBytes * firstChromaLine;
+  dstLine[2] = dstLine[0] + dstLumaPlaneBytes + dstChromaPlaneBytes + dstChromaPitchBytes * firstChromaLine;
+  dstLine[0] += dstLumaPitchBytes * firstLine;
   
-  for (uint32_t y=0; y<mSrcVidInfo->height(); ++y) {
+  for (uint32_t y=firstLine; y<firstLine+numLines; ++y) {
     bool evenLine = (y & 1) == 0;
     if (1==bytesPerPixel) {
       const uint8_t *srcAY = srcLine[0][0];
@@ -494,8 +593,8 @@ NAN_METHOD(Stamper::SetInfo) {
 }
 
 NAN_METHOD(Stamper::Wipe) {
-  if (info.Length() != 3)
-    return Nan::ThrowError("Stamper Wipe expects 3 arguments");
+  if ((info.Length() < 3) || (info.Length() > 4))
+    return Nan::ThrowError("Stamper Wipe expects 3 or 4 arguments");
   if (!info[0]->IsObject())
     return Nan::ThrowError("Stamper Wipe requires a valid destination buffer as the first parameter");
   if (!info[1]->IsObject())
@@ -512,6 +611,9 @@ NAN_METHOD(Stamper::Wipe) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Wipe called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   if (obj->mDstBytesReq > node::Buffer::Length(dstBufObj))
     return Nan::ThrowError("Insufficient destination buffer for specified format");
 
@@ -531,16 +633,16 @@ NAN_METHOD(Stamper::Wipe) {
                Nan::To<double>(wipeColArr->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 1).ToLocalChecked()).FromJust(),
                Nan::To<double>(wipeColArr->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 2).ToLocalChecked()).FromJust());
 
-  std::shared_ptr<iProcessData> wpd = 
-    std::make_shared<WipeProcessData>(dstBufObj, wipeRect, wipeCol);
-  obj->mWorker->doFrame(wpd, obj, new Nan::Callback(callback));
+  std::shared_ptr<WipeProcessData> wpd = obj->mWipeProcessDataPool.acquire();
+  wpd->set(dstBufObj, wipeRect, wipeCol);
+  obj->mWorker->doFrame(wpd, obj, callback, MyWorker::deadlineArg(info, 3));
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
 
 NAN_METHOD(Stamper::Copy) {
-  if (info.Length() != 4)
-    return Nan::ThrowError("Stamper Copy expects 4 arguments");
+  if ((info.Length() < 4) || (info.Length() > 5))
+    return Nan::ThrowError("Stamper Copy expects 4 or 5 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("Stamper Copy requires a valid source buffer array as the first parameter");
   if (!info[1]->IsObject())
@@ -562,9 +664,12 @@ NAN_METHOD(Stamper::Copy) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Copy called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   uint32_t srcFormatBytes = getFormatBytes(obj->mSrcVidInfo->packing(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height());
   if (srcFormatBytes > (uint32_t)node::Buffer::Length(srcBufObj))
-    Nan::ThrowError("Insufficient source buffer for Copy\n");
+    return Nan::ThrowError("Insufficient source buffer for Copy");
 
   if (obj->mDstBytesReq > node::Buffer::Length(dstBufObj))
     return Nan::ThrowError("Insufficient destination buffer for specified format");
@@ -575,16 +680,16 @@ NAN_METHOD(Stamper::Copy) {
     return Nan::ThrowError("dstOrg parameter invalid");
   iXY dstOrg(Nan::To<uint32_t>(dstOrgXY->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 0).ToLocalChecked()).FromJust(), Nan::To<uint32_t>(dstOrgXY->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), 1).ToLocalChecked()).FromJust());
 
-  std::shared_ptr<iProcessData> cpd = 
-    std::make_shared<CopyProcessData>(srcBufObj, dstBufObj, dstOrg);
-  obj->mWorker->doFrame(cpd, obj, new Nan::Callback(callback));
+  std::shared_ptr<CopyProcessData> cpd = obj->mCopyProcessDataPool.acquire();
+  cpd->set(srcBufObj, dstBufObj, dstOrg);
+  obj->mWorker->doFrame(cpd, obj, callback, MyWorker::deadlineArg(info, 4));
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
 
 NAN_METHOD(Stamper::Mix) {
-  if (info.Length() != 4)
-    return Nan::ThrowError("Stamper Mix expects 4 arguments");
+  if ((info.Length() < 4) || (info.Length() > 5))
+    return Nan::ThrowError("Stamper Mix expects 4 or 5 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("Stamper Mix requires a valid source buffer array as the first parameter");
   if (!info[1]->IsObject())
@@ -604,11 +709,17 @@ NAN_METHOD(Stamper::Mix) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Mix called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   uint32_t srcFormatBytes = getFormatBytes(obj->mSrcVidInfo->packing(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height());
   for (uint32_t i=0; i<srcBufArray->Length(); ++i) {
     Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
     if (srcFormatBytes > (uint32_t)node::Buffer::Length(srcBufObj))
-      Nan::ThrowError("Insufficient source buffer for Mix\n");
+      return Nan::ThrowError("Insufficient source buffer for Mix");
+    // a source buffer as the destination mixes in place, which must be asked for when setting up
+    if ((node::Buffer::Data(srcBufObj) == node::Buffer::Data(dstBufObj)) && !obj->mProcessParams->inPlace())
+      return Nan::ThrowError("Mix requires a destination buffer separate from the sources unless set up with inPlace");
   }
 
   if (obj->mDstBytesReq > node::Buffer::Length(dstBufObj))
@@ -620,16 +731,16 @@ NAN_METHOD(Stamper::Mix) {
     return Nan::ThrowError("pressure parameter invalid");
   float pressure = (float)Nan::To<double>(pressureObj).FromJust();
 
-  std::shared_ptr<iProcessData> mpd = 
-    std::make_shared<MixProcessData>(srcBufArray, dstBufObj, pressure);
-  obj->mWorker->doFrame(mpd, obj, new Nan::Callback(callback));
+  std::shared_ptr<MixProcessData> mpd = obj->mMixProcessDataPool.acquire();
+  mpd->set(srcBufArray, dstBufObj, pressure);
+  obj->mWorker->doFrame(mpd, obj, callback, MyWorker::deadlineArg(info, 4));
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
 
 NAN_METHOD(Stamper::Stamp) {
-  if (info.Length() != 4)
-    return Nan::ThrowError("Stamper Stamp expects 4 arguments");
+  if ((info.Length() < 4) || (info.Length() > 5))
+    return Nan::ThrowError("Stamper Stamp expects 4 or 5 arguments");
   if (!info[0]->IsArray())
     return Nan::ThrowError("Stamper Stamp requires a valid source buffer array as the first parameter");
   if (!info[1]->IsObject())
@@ -649,6 +760,9 @@ NAN_METHOD(Stamper::Stamp) {
   if (!obj->mSetInfoOK)
     return Nan::ThrowError("Stamp called with incorrect setup parameters");
 
+  if (obj->mWorker->isFull())
+    return info.GetReturnValue().Set(Nan::False());
+
   if (!obj->mSrcVidInfo->hasAlpha())
     return Nan::ThrowError("Stamp called with source buffer having no alpha channel");
 
@@ -656,15 +770,15 @@ NAN_METHOD(Stamper::Stamp) {
     uint32_t srcFormatBytes = getFormatBytes(obj->mSrcVidInfo->packing(), obj->mSrcVidInfo->width(), obj->mSrcVidInfo->height(), 0==i);
     Local<Object> srcBufObj = Local<Object>::Cast(srcBufArray->Get(v8::Isolate::GetCurrent()->GetCurrentContext(), i).ToLocalChecked());
     if (srcFormatBytes > (uint32_t)node::Buffer::Length(srcBufObj))
-      Nan::ThrowError("Insufficient source buffer for Stamp\n");
+      return Nan::ThrowError("Insufficient source buffer for Stamp");
   }
 
   if (obj->mDstBytesReq > node::Buffer::Length(dstBufObj))
     return Nan::ThrowError("Insufficient destination buffer for specified format");
 
-  std::shared_ptr<iProcessData> spd = 
-    std::make_shared<StampProcessData>(srcBufArray, dstBufObj);
-  obj->mWorker->doFrame(spd, obj, new Nan::Callback(callback));
+  std::shared_ptr<StampProcessData> spd = obj->mStampProcessDataPool.acquire();
+  spd->set(srcBufArray, dstBufObj);
+  obj->mWorker->doFrame(spd, obj, callback, MyWorker::deadlineArg(info, 4));
 
   info.GetReturnValue().Set(Nan::New(obj->mWorker->numQueued()));
 }
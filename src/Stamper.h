@@ -18,12 +18,14 @@
 
 #include "iDebug.h"
 #include "iProcess.h"
+#include "ProcessDataPool.h"
 #include <memory>
 
 namespace streampunk {
 
 class MyWorker;
 class EssenceInfo;
+class ProcessParams;
 class WipeProcessData;
 class CopyProcessData;
 class MixProcessData;
@@ -41,10 +43,10 @@ private:
   ~Stamper();
 
   void doSetInfo(v8::Local<v8::Array> srcTags, v8::Local<v8::Object> dstTags);
-  void doWipe(std::shared_ptr<WipeProcessData> wpd);
-  void doCopy(std::shared_ptr<CopyProcessData> cpd);
-  void doMix(std::shared_ptr<MixProcessData> mpd);
-  void doStamp(std::shared_ptr<StampProcessData> spd);
+  void doWipe(const WipeProcessData *wpd, uint32_t firstLine, uint32_t numLines);
+  void doCopy(const CopyProcessData *cpd, uint32_t firstLine, uint32_t numLines);
+  void doMix(const MixProcessData *mpd, uint32_t firstLine, uint32_t numLines);
+  void doStamp(const StampProcessData *spd, uint32_t firstLine, uint32_t numLines);
   
   static NAN_METHOD(New) {
     if (info.IsConstructCall()) {
@@ -79,6 +81,11 @@ private:
   uint32_t mDstBytesReq;
   std::shared_ptr<EssenceInfo> mSrcVidInfo;
   std::shared_ptr<EssenceInfo> mDstVidInfo;
+  std::shared_ptr<ProcessParams> mProcessParams;
+  ProcessDataPool<WipeProcessData> mWipeProcessDataPool;
+  ProcessDataPool<CopyProcessData> mCopyProcessDataPool;
+  ProcessDataPool<MixProcessData> mMixProcessDataPool;
+  ProcessDataPool<StampProcessData> mStampProcessDataPool;
 };
 
 } // namespace streampunk
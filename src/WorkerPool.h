@@ -0,0 +1,228 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+
+namespace streampunk {
+
+// Process-wide pool of native threads shared by all processing objects.
+// Sized from CODECADON_THREADPOOL_SIZE if set, otherwise the number of cores.
+class WorkerPool {
+public:
+  typedef std::function<void()> tTask;
+  typedef std::function<void(uint32_t firstLine, uint32_t numLines)> tLinesFn;
+
+  static WorkerPool &instance() {
+    // never destroyed - pool threads may still be running when static destructors are called at exit
+    static WorkerPool *pool = new WorkerPool(defaultSize());
+    return *pool;
+  }
+
+  uint32_t size() {
+    std::lock_guard<std::mutex> lk(mMtx);
+    return mTargetSize;
+  }
+
+  void resize(uint32_t numThreads) {
+    std::lock_guard<std::mutex> lk(mMtx);
+    mTargetSize = numThreads ? numThreads : 1;
+    while (mNumThreads < mTargetSize) {
+      std::thread(&WorkerPool::run, this).detach();
+      ++mNumThreads;
+    }
+    mCv.notify_all();
+  }
+
+  void post(tTask task) {
+    std::lock_guard<std::mutex> lk(mMtx);
+    if (mNumTasks == mTasks.size())
+      growTasks();
+    mTasks[(mTaskHead + mNumTasks) % mTasks.size()] = std::move(task);
+    ++mNumTasks;
+    mCv.notify_one();
+  }
+
+  // Splits numLines into up to numBands bands, each a whole number of lineAlign lines,
+  // and runs fn on each band across the pool, returning when all bands are complete.
+  // The calling thread works on bands as well, so this is safe to call from a pool thread.
+  // fn is called in place rather than copied, and the job is taken from a free list, so that this does not allocate.
+  template <typename Fn>
+  void runLines(uint32_t numLines, uint32_t numBands, uint32_t lineAlign, const Fn &fn) {
+    uint32_t numUnits = (numLines + lineAlign - 1) / lineAlign;
+    uint32_t unitsPerBand = (numUnits + numBands - 1) / (numBands ? numBands : 1);
+    if (!unitsPerBand || (unitsPerBand >= numUnits)) {
+      fn(0, numLines);
+      return;
+    }
+
+    LinesJob *job = acquireJob();
+    job->start(numLines, unitsPerBand * lineAlign, &callLines<Fn>, &fn);
+    // the job is released by each pool task and by this thread once it has seen all bands complete
+    for (uint32_t i = 1; i < job->mNumBands; ++i)
+      post([job]() { job->work(); WorkerPool::instance().releaseJob(job); });
+    job->work();
+    job->wait();
+    releaseJob(job);
+  }
+
+private:
+  typedef void (*tCallLines)(const void *fn, uint32_t firstLine, uint32_t numLines);
+
+  template <typename Fn>
+  static void callLines(const void *fn, uint32_t firstLine, uint32_t numLines) {
+    (*static_cast<const Fn *>(fn))(firstLine, numLines);
+  }
+
+  // The function is only called for bands that are still to be done, and runLines does not return
+  // until all of them are, so a pool task that starts late finds no bands and does not touch it.
+  class LinesJob {
+  public:
+    LinesJob() : mNumBands(0), mNumLines(0), mBandLines(0), mCall(NULL), mFn(NULL), mNextBand(0), mBandsDone(0), mRefs(0) {}
+
+    void start(uint32_t numLines, uint32_t bandLines, tCallLines call, const void *fn) {
+      mNumBands = (numLines + bandLines - 1) / bandLines;
+      mNumLines = numLines;
+      mBandLines = bandLines;
+      mCall = call;
+      mFn = fn;
+      mNextBand = 0;
+      mBandsDone = 0;
+      mRefs = mNumBands;
+    }
+
+    void work() {
+      uint32_t bandsDone = 0;
+      uint32_t band;
+      while ((band = mNextBand++) < mNumBands) {
+        uint32_t firstLine = band * mBandLines;
+        mCall(mFn, firstLine, std::min(mBandLines, mNumLines - firstLine));
+        ++bandsDone;
+      }
+      if (bandsDone) {
+        std::lock_guard<std::mutex> lk(mMtx);
+        mBandsDone += bandsDone;
+        if (mBandsDone == mNumBands)
+          mCv.notify_all();
+      }
+    }
+
+    void wait() {
+      std::unique_lock<std::mutex> lk(mMtx);
+      while (mBandsDone < mNumBands)
+        mCv.wait(lk);
+    }
+
+    // true when the last reference has gone and the job can be used again
+    bool release() { return 1 == mRefs--; }
+
+    uint32_t mNumBands;
+
+  private:
+    uint32_t mNumLines;
+    uint32_t mBandLines;
+    tCallLines mCall;
+    const void *mFn;
+    std::atomic<uint32_t> mNextBand;
+    uint32_t mBandsDone;
+    std::atomic<uint32_t> mRefs;
+    std::mutex mMtx;
+    std::condition_variable mCv;
+  };
+
+  // jobs are never freed, as there are only ever as many as are running at once
+  LinesJob *acquireJob() {
+    std::lock_guard<std::mutex> lk(mMtx);
+    if (mFreeJobs.empty())
+      return new LinesJob;
+    LinesJob *job = mFreeJobs.back();
+    mFreeJobs.pop_back();
+    return job;
+  }
+
+  void releaseJob(LinesJob *job) {
+    if (job->release()) {
+      std::lock_guard<std::mutex> lk(mMtx);
+      mFreeJobs.push_back(job);
+    }
+  }
+
+  WorkerPool(uint32_t numThreads) : mTasks(64), mTaskHead(0), mNumTasks(0), mNumThreads(0), mTargetSize(0) {
+    resize(numThreads);
+  }
+  ~WorkerPool() {}
+
+  static uint32_t defaultSize() {
+    const char *sizeStr = getenv("CODECADON_THREADPOOL_SIZE");
+    uint32_t numThreads = sizeStr ? (uint32_t)atoi(sizeStr) : 0;
+    if (!numThreads)
+      numThreads = std::thread::hardware_concurrency();
+    return numThreads ? numThreads : 4;
+  }
+
+  void run() {
+    while (true) {
+      tTask task;
+      {
+        std::unique_lock<std::mutex> lk(mMtx);
+        while (!mNumTasks && (mNumThreads <= mTargetSize))
+          mCv.wait(lk);
+        if (mNumThreads > mTargetSize) {
+          --mNumThreads;
+          return;
+        }
+        task = std::move(mTasks[mTaskHead]);
+        mTaskHead = (mTaskHead + 1) % mTasks.size();
+        --mNumTasks;
+      }
+      task();
+    }
+  }
+
+  // Tasks are held in a ring that only grows, so that posting in a steady state does not allocate.
+  // Called with mMtx held.
+  void growTasks() {
+    std::vector<tTask> tasks(mTasks.size() * 2);
+    for (uint32_t i = 0; i < mNumTasks; ++i)
+      tasks[i] = std::move(mTasks[(mTaskHead + i) % mTasks.size()]);
+    mTasks.swap(tasks);
+    mTaskHead = 0;
+  }
+
+  std::mutex mMtx;
+  std::condition_variable mCv;
+  std::vector<tTask> mTasks;
+  uint32_t mTaskHead;
+  uint32_t mNumTasks;
+  uint32_t mNumThreads;
+  uint32_t mTargetSize;
+  std::vector<LinesJob *> mFreeJobs;
+
+  WorkerPool(const WorkerPool &);
+};
+
+} // namespace streampunk
+
+#endif
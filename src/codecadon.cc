@@ -21,9 +21,34 @@
 #include "Decoder.h"
 #include "Encoder.h"
 #include "Stamper.h"
+#include "Pipeline.h"
+#include "WorkerPool.h"
+#include "FramePool.h"
 
 using namespace v8;
 
+NAN_METHOD(ThreadPoolSize) {
+  if (info.Length() > 1)
+    return Nan::ThrowError("threadPoolSize expects 0 or 1 arguments");
+  if (info.Length() == 1) {
+    if (!info[0]->IsNumber() || (Nan::To<uint32_t>(info[0]).FromJust() == 0))
+      return Nan::ThrowError("threadPoolSize requires a valid number of threads as the parameter");
+    streampunk::WorkerPool::instance().resize(Nan::To<uint32_t>(info[0]).FromJust());
+  }
+  info.GetReturnValue().Set(Nan::New(streampunk::WorkerPool::instance().size()));
+}
+
+NAN_METHOD(FramePoolStats) {
+  if ((info.Length() != 1) || !info[0]->IsNumber())
+    return Nan::ThrowError("framePoolStats requires a valid number of bytes as the parameter");
+  streampunk::FramePool::Stats stats = streampunk::FramePool::instance().stats(Nan::To<uint32_t>(info[0]).FromJust());
+  Local<Object> result = Nan::New<Object>();
+  Nan::Set(result, Nan::New("allocated").ToLocalChecked(), Nan::New<Number>((double)stats.numAllocated));
+  Nan::Set(result, Nan::New("reused").ToLocalChecked(), Nan::New<Number>((double)stats.numReused));
+  Nan::Set(result, Nan::New("free").ToLocalChecked(), Nan::New(stats.numFree));
+  info.GetReturnValue().Set(result);
+}
+
 NAN_MODULE_INIT(Init) {
   streampunk::Concater::Init(target);
   streampunk::Flipper::Init(target);
@@ -32,6 +57,9 @@ NAN_MODULE_INIT(Init) {
   streampunk::Decoder::Init(target);
   streampunk::Encoder::Init(target);
   streampunk::Stamper::Init(target);
+  streampunk::Pipeline::Init(target);
+  Nan::SetMethod(target, "threadPoolSize", ThreadPoolSize);
+  Nan::SetMethod(target, "framePoolStats", FramePoolStats);
 }
 
 NODE_MODULE(codecadon, Init)
@@ -22,15 +22,34 @@ namespace streampunk {
 
 typedef std::vector<std::pair<const uint8_t*, uint32_t> > tBufVec;
 
+class Memory;
+
 class iProcessData {
 public:
   virtual ~iProcessData() {}
+  // called on the main thread once the frame callback has run, to let go of the frame's JavaScript buffers
+  virtual void recycle() {}
 };
 
 class iProcess {
 public:
   virtual ~iProcess() {}  
   virtual uint32_t processFrame (std::shared_ptr<iProcessData> processData) = 0;
+
+  // processes split into stages are run by the worker with successive frames in different stages at the same time
+  virtual uint32_t processStage (uint32_t stage, std::shared_ptr<iProcessData> processData) {
+    return processFrame(processData);
+  }
+};
+
+// implemented by processing objects that can run as a stage of a Pipeline, passing frames between stages as native memory
+class iPipelineStage {
+public:
+  virtual ~iPipelineStage() {}
+  // buffer sizes required once setInfo has succeeded, otherwise dstBytes is 0
+  virtual uint32_t stageSrcBytes() const = 0;
+  virtual uint32_t stageDstBytes() const = 0;
+  virtual uint32_t processStageFrame (std::shared_ptr<Memory> srcBuf, std::shared_ptr<Memory> dstBuf) = 0;
 };
 
 } // namespace streampunk
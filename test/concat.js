@@ -56,7 +56,7 @@ function concatTest(description, numTests, onErr, fn) {
   });
 }
 
-tap.plan(4, 'Concatenator addon tests');
+tap.plan(5, 'Concatenator addon tests');
 
 concatTest('Performing concatenation', 2,
   (t, err) => t.notOk(err, 'no error expected'),
@@ -123,3 +123,27 @@ concatTest('Handling source buffer array bytes being greater than destination by
     });
   });
 
+
+concatTest('Performing batched concatenation', 5,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, concater, done) => {
+    var width = 256;
+    var height = 64;
+    var numBuffers = 16;
+    var numFrames = 3;
+    var tags = makeTags(width, height);
+    var numBytes = concater.setInfo(tags, logLevel);
+    var srcBufArrays = [];
+    var dstBufs = [];
+    for (var f=0; f<numFrames; ++f) {
+      srcBufArrays.push(makeBufArray(numBytes / numBuffers, numBuffers));
+      dstBufs.push(Buffer.alloc(numBytes));
+    }
+    concater.concatBatch(srcBufArrays, dstBufs, (err, results) => {
+      t.notOk(err, 'no error expected');
+      t.equal(results.length, numFrames, 'one result per frame');
+      var testDstBuf = makeBufArray(numBytes, 1)[0];
+      results.forEach((result, f) => t.deepEquals(result, testDstBuf, `frame ${f} matches the expected concatenation result`));
+      done();
+    });
+  });
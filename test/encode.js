@@ -141,7 +141,7 @@ function encodeTest(description, numTests, onErr, fn) {
   });
 }
 
-tap.plan(7, 'Encoder addon tests');
+tap.plan(10, 'Encoder addon tests');
 
 encodeTest('Handling bad image dimensions', 1,
   (t, err) => t.ok(err, 'emits error'), 
@@ -223,6 +223,31 @@ encodeTest('Performing h264 encoding from a V210 source', 1,
     });
   });
 
+encodeTest('Performing h264 encoding and decoding into pooled destinations', 4,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, encoder, done) => {
+    var width = 1920;
+    var height = 1080;
+    encoder.setInfo(makeTags(width, height, '420P', 'raw', 0), makeTags(width, height, 'h264', 'h264', 0), duration, {}, logLevel);
+    encoder.encode([make420PBuf(width, height)], null, (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.ok(Buffer.isBuffer(result) && (result.length > 0), 'returns the bitstream in a pooled buffer');
+
+      var decoder = new codecadon.Decoder(() => {});
+      decoder.on('error', err => t.fail(err));
+      var decodeBytes = decoder.setInfo(makeTags(width, height, 'h264', 'h264', 0), makeTags(width, height, '420P', 'raw', 0), logLevel);
+      // the same picture is decoded twice, in case the decoder holds the first back
+      decoder.decode([result], null, (err1, picture1) => {
+        decoder.decode([result], null, (err2, picture2) => {
+          t.notOk(err1 || err2, 'no error expected');
+          t.ok([picture1, picture2].some(p => Buffer.isBuffer(p) && (p.length === decodeBytes)),
+            'returns the decoded picture in a pooled buffer');
+          decoder.quit(() => done());
+        });
+      });
+    });
+  });
+
 /*
 encodeTest('Performing AVCi encoding', 1,
   function (t, err) t.notOk(err, 'no error expected'), 
@@ -289,3 +314,39 @@ encodeTest('Handling an undefined destination buffer', 1,
       done();
     });
   });
+
+encodeTest('Performing batched h264 encoding', 3,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, encoder, done) => {
+    var width = 1920;
+    var height = 1080;
+    var numFrames = 3;
+    var dstBufLen = encoder.setInfo(makeTags(width, height, '420P', 'raw', 0), makeTags(width, height, 'h264', 'h264', 0), duration, {}, logLevel);
+
+    var srcBufArrays = [];
+    var dstBufs = [];
+    for (var f=0; f<numFrames; ++f) {
+      srcBufArrays.push([make420PBuf(width, height)]);
+      dstBufs.push(Buffer.alloc(dstBufLen));
+    }
+    encoder.encodeBatch(srcBufArrays, dstBufs, (err, results) => {
+      t.notOk(err, 'no error expected');
+      t.equal(results.length, numFrames, 'one result per frame');
+      // the encoder may hold frames back, so not every frame has a result yet
+      t.ok(results.some((result, f) => result && (result.length > 0) && (result.buffer === dstBufs[f].buffer)),
+        'returns the bitstream in the destination buffers');
+      done();
+    });
+  });
+
+encodeTest('Handling a batch with a missing source buffer', 1,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, encoder, done) => {
+    var width = 1920;
+    var height = 1080;
+    var dstBufLen = encoder.setInfo(makeTags(width, height, '420P', 'raw', 0), makeTags(width, height, 'h264', 'h264', 0), duration, {}, logLevel);
+    encoder.encodeBatch([[make420PBuf(width, height)], []], [Buffer.alloc(dstBufLen), Buffer.alloc(dstBufLen)], err => {
+      t.match(err && err.message, /^Encoder encodeBatch requires single source buffer for each frame - frame 1/, 'refuses the whole batch');
+      done();
+    });
+  });
@@ -0,0 +1,83 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+var tap = require('tap');
+var codecadon = require('../../codecadon');
+const logLevel = 2;
+
+// each line of the picture holds its own line number in every byte, so reversing the bytes reverses the lines
+function makeLinesBuf(width, height) {
+  var pitchBytes = width * 5 / 2;
+  var buf = Buffer.alloc(pitchBytes * height);
+  for (var y=0; y<height; ++y)
+    buf.fill(y, y * pitchBytes, (y + 1) * pitchBytes);
+  return buf;
+}
+
+function makeTags(width, height, packing, interlace) {
+  let tags = {};
+  tags.format = 'video';
+  tags.width = width;
+  tags.height = height;
+  tags.packing = packing;
+  tags.depth = 10;
+  tags.interlace = interlace;
+  return tags;
+}
+
+function flipTest(description, numTests, onErr, fn) {
+  tap.test(description, (t) => {
+    t.plan(numTests + 1);
+    var flipper = new codecadon.Flipper(() => {});
+    flipper.on('error', err => {
+      onErr(t, err);
+    });
+
+    fn(t, flipper, () => {
+      flipper.quit(() => {
+        t.pass(`${description} exited`);
+        t.end();
+      });
+    });
+  });
+}
+
+tap.plan(2, 'Flipper addon tests');
+
+flipTest('Performing a vertical flip', 2,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, flipper, done) => {
+    var width = 64;
+    var height = 16;
+    var dstBufLen = flipper.setInfo(makeTags(width, height, 'pgroup', 'prog'), { v: true }, logLevel);
+    flipper.flip([makeLinesBuf(width, height)], Buffer.alloc(dstBufLen), (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, makeLinesBuf(width, height).reverse(), 'matches the expected flip result');
+      done();
+    });
+  });
+
+flipTest('Performing a vertical flip into a pooled destination', 2,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, flipper, done) => {
+    var width = 64;
+    var height = 16;
+    flipper.setInfo(makeTags(width, height, 'pgroup', 'prog'), { v: true }, logLevel);
+    flipper.flip([makeLinesBuf(width, height)], null, (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, makeLinesBuf(width, height).reverse(), 'matches the expected flip result');
+      done();
+    });
+  });
@@ -0,0 +1,114 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+var tap = require('tap');
+var codecadon = require('../../codecadon');
+const logLevel = 2;
+
+function makeV210Buf(width, height) {
+  var pitchBytes = (width + (47 - (width - 1) % 48)) * 8 / 3;
+  var buf = Buffer.alloc(pitchBytes * height);
+  buf.fill(0);
+  var yOff = 0;
+  for (var y=0; y<height; ++y) {
+    var xOff = 0;
+    for (var x=0; x<(width-width%6)/6; ++x) {
+      buf.writeUInt32LE((0x200<<20) | (0x040<<10) | 0x200, yOff + xOff);
+      buf.writeUInt32LE((0x040<<20) | (0x200<<10) | 0x040, yOff + xOff + 4);
+      buf.writeUInt32LE((0x200<<20) | (0x040<<10) | 0x200, yOff + xOff + 8);
+      buf.writeUInt32LE((0x040<<20) | (0x200<<10) | 0x040, yOff + xOff + 12);
+      xOff += 16;
+    }
+
+    var remain = width%6;
+    if (remain) {
+      buf.writeUInt32LE((0x200<<20) | (0x040<<10) | 0x200, yOff + xOff);
+      if (2 === remain) {
+        buf.writeUInt32LE(0x040, yOff + xOff + 4);
+      } else if (4 === remain) {      
+        buf.writeUInt32LE((0x040<<20) | (0x200<<10) | 0x040, yOff + xOff + 4);
+        buf.writeUInt32LE((0x040<<10) | 0x200, yOff + xOff + 8);
+      }
+    }
+    yOff += pitchBytes;
+  }   
+  return buf;
+}
+
+function makeTags(width, height, packing, encodingName) {
+  let tags = {};
+  tags.format = 'video';
+  tags.width = width;
+  tags.height = height;
+  tags.packing = packing;
+  tags.encodingName = encodingName;
+  tags.interlace = 0;
+  return tags;
+}
+
+var duration = Buffer.alloc(8);
+duration.writeUIntBE(1, 0, 4);
+duration.writeUIntBE(25, 4, 4);
+
+// a V210 source is repacked to 420P for the encoder, in a buffer from the frame pool
+var width = 1920;
+var height = 1080;
+var srcTags = makeTags(width, height, 'v210', 'raw');
+var dstTags = makeTags(width, height, 'h264', 'h264');
+var repackBytes = width * height * 3 / 2;
+
+tap.plan(3, 'Frame pool tests');
+
+tap.test('Leaving small buffers out of the pool', t => {
+  t.deepEquals(codecadon.framePoolStats(4096), { allocated: 0, reused: 0, free: 0 }, 'small buffers are not counted');
+  t.end();
+});
+
+tap.test('Filling the pool at setup with preTouch', t => {
+  var encoder = new codecadon.Encoder(() => {});
+  encoder.on('error', err => t.fail(err));
+  var before = codecadon.framePoolStats(repackBytes);
+  var dstBufLen = encoder.setInfo(srcTags, dstTags, duration, { preTouch: true, queueDepth: 2 }, logLevel);
+  var ready = codecadon.framePoolStats(repackBytes);
+  t.equal(ready.free - before.free, 2, 'a buffer is ready for each frame that can be queued');
+
+  encoder.encode([makeV210Buf(width, height)], Buffer.alloc(dstBufLen), err => {
+    t.notOk(err, 'no error expected');
+    var after = codecadon.framePoolStats(repackBytes);
+    t.equal(after.allocated, ready.allocated, 'the frame allocates no new buffer');
+    t.equal(after.reused - ready.reused, 1, 'the frame takes one of the ready buffers');
+    encoder.quit(() => t.end());
+  });
+});
+
+tap.test('Reusing released buffers from frame to frame', t => {
+  var pipeline = new codecadon.Pipeline(() => {});
+  pipeline.on('error', err => t.fail(err));
+  // as a pipeline stage, the encoder takes its repacking buffer for each frame and gives it back when done
+  var dstBufLen = pipeline.setInfo([ { type: 'encode', srcTags: srcTags, dstTags: dstTags, duration: duration, encodeTags: {} } ], logLevel);
+  var srcBuf = makeV210Buf(width, height);
+
+  pipeline.process([srcBuf], Buffer.alloc(dstBufLen), err1 => {
+    var first = codecadon.framePoolStats(repackBytes);
+    pipeline.process([srcBuf], Buffer.alloc(dstBufLen), err2 => {
+      var second = codecadon.framePoolStats(repackBytes);
+      t.notOk(err1 || err2, 'no error expected');
+      t.equal(second.allocated, first.allocated, 'the second frame allocates no new buffer');
+      t.equal(second.reused - first.reused, 1, 'the second frame reuses the buffer released by the first');
+      t.equal(second.free, first.free, 'the buffer is released again');
+      pipeline.quit(() => t.end());
+    });
+  });
+});
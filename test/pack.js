@@ -140,6 +140,97 @@ function makeV210Buf(width, height) {
   return buf;
 }
 
+function makeRandom4175Buf(width, height) {
+  var buf = Buffer.alloc(width * 5 / 2 * height);
+  for (var i=0; i<buf.length; ++i)
+    buf[i] = Math.floor(Math.random() * 256);
+  return buf;
+}
+
+// reference unpacking of every bit of a 4175 buffer, for checking the optimised conversions
+function unpack4175ToYUV422P10(srcBuf, width, height) {
+  var lumaPitchBytes = width * 2;
+  var chromaPitchBytes = lumaPitchBytes / 2;
+  var buf = Buffer.alloc(lumaPitchBytes * height * 2);
+  var lOff = 0;
+  var uOff = lumaPitchBytes * height;
+  var vOff = uOff + chromaPitchBytes * height;
+  var sOff = 0;
+
+  for (var y=0; y<height; ++y) {
+    for (var x=0; x<width; x+=2) {
+      var s = srcBuf.readUIntBE(sOff, 5);
+      sOff += 5;
+      buf.writeUInt16LE(Math.floor(s / 0x100000) & 0x3ff, lOff + x * 2);
+      buf.writeUInt16LE(s & 0x3ff, lOff + x * 2 + 2);
+      buf.writeUInt16LE(Math.floor(s / 0x40000000) & 0x3ff, uOff + x);
+      buf.writeUInt16LE(Math.floor(s / 0x400) & 0x3ff, vOff + x);
+    }
+    lOff += lumaPitchBytes;
+    uOff += chromaPitchBytes;
+    vOff += chromaPitchBytes;
+  }
+  return buf;
+}
+
+// reference unpacking of the components of a v210 buffer, ignoring the line padding
+function unpackV210ToYUV422P10(srcBuf, width, height) {
+  var srcPitchBytes = Math.floor((width + 47) / 48) * 48 * 8 / 3;
+  var lumaPitchBytes = width * 2;
+  var chromaPitchBytes = lumaPitchBytes / 2;
+  var buf = Buffer.alloc(lumaPitchBytes * height * 2);
+  var lOff = 0;
+  var uOff = lumaPitchBytes * height;
+  var vOff = uOff + chromaPitchBytes * height;
+
+  for (var y=0; y<height; ++y) {
+    for (var x=0; x<width; x+=2) {
+      // u, y, v, y for each pair of pixels, 3 components to a word
+      var c = [];
+      var blockOff = y * srcPitchBytes + Math.floor(x / 6) * 16;
+      var pair = (x % 6) / 2;
+      for (var i=pair*4; i<pair*4+4; ++i)
+        c.push((srcBuf.readUInt32LE(blockOff + Math.floor(i / 3) * 4) >>> ((i % 3) * 10)) & 0x3ff);
+      buf.writeUInt16LE(c[1], lOff + x * 2);
+      buf.writeUInt16LE(c[3], lOff + x * 2 + 2);
+      buf.writeUInt16LE(c[0], uOff + x);
+      buf.writeUInt16LE(c[2], vOff + x);
+    }
+    lOff += lumaPitchBytes;
+    uOff += chromaPitchBytes;
+    vOff += chromaPitchBytes;
+  }
+  return buf;
+}
+
+// reference rounded down-conversion of a YUV422P10 buffer to 420P, with chroma from field line pairs if requested
+function downConvertYUV422P10To420P(srcBuf, width, height, fieldChroma) {
+  var lumaPitchBytes = width * 2;
+  var chromaPitchBytes = lumaPitchBytes / 2;
+  var buf = Buffer.alloc(width * height * 3 / 2);
+  var uOff = width * height;
+  var vOff = uOff + width * height / 4;
+
+  for (var i=0; i<width*height; ++i)
+    buf[i] = Math.min(((srcBuf.readUInt16LE(i * 2) & 0x3ff) + 2) >> 2, 255);
+  for (var c=0; c<height/2; ++c) {
+    var a = 2 * c;
+    var b = a + 1;
+    if (fieldChroma && (Math.floor(c / 2) * 4 + 4 <= height)) {
+      a = Math.floor(c / 2) * 4 + (c & 1);
+      b = a + 2;
+    }
+    for (var x=0; x<width/2; ++x) {
+      [uOff, vOff].forEach((dOff, p) => {
+        var sOff = lumaPitchBytes * height + chromaPitchBytes * height * p + x * 2;
+        var sum = (srcBuf.readUInt16LE(sOff + a * chromaPitchBytes) & 0x3ff) + (srcBuf.readUInt16LE(sOff + b * chromaPitchBytes) & 0x3ff);
+        buf[dOff + c * width / 2 + x] = Math.min((sum + 4) >> 3, 255);
+      });
+    }
+  }
+  return buf;
+}
+
 function makeTags(width, height, packing, interlace) {
   let tags = {};
   tags.format = 'video';
@@ -167,7 +258,7 @@ function packTest(description, numTests, onErr, fn) {
   });
 }
 
-tap.plan(22, 'Packer addon tests');
+tap.plan(47, 'Packer addon tests');
 
 packTest('Handling bad image dimensions', 1,
   (t, err) => t.ok(err, 'emits error'), 
@@ -243,6 +334,131 @@ packTest('Performing packing V210 to 420P', 2,
     });
   });
 
+packTest('Performing banded packing V210 to 420P', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1920;
+    var height = 1080;
+    var srcTags = makeTags(width, height, 'v210', 1);
+    var dstTags = makeTags(width, height, '420P', 1);
+    dstTags.threads = 4;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var bufArray = new Array(1);
+    var srcBuf = makeV210Buf(width, height);
+    bufArray[0] = srcBuf;
+    var dstBuf = Buffer.alloc(dstBufLen);
+    packer.pack(bufArray, dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      var testDstBuf = make420PBuf(width, height);
+      t.deepEquals(result, testDstBuf, 'matches the expected packing result');   
+      done();
+    });
+  });
+
+packTest('Performing frame-parallel packing V210 to 420P', 9,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1920;
+    var height = 1080;
+    var numFrames = 8;
+    var srcTags = makeTags(width, height, 'v210', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    dstTags.parallelFrames = 4;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBuf = makeV210Buf(width, height);
+    var nextFrame = 0;
+    for (var f=0; f<numFrames; ++f) {
+      let frame = f;
+      packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+        t.equal(frame, nextFrame++, `frame ${frame} completes in submission order`);
+        if (frame === numFrames - 1) {
+          t.deepEquals(result, make420PBuf(width, height), 'matches the expected packing result');   
+          done();
+        }
+      });
+    }
+  });
+
+packTest('Performing packing pgroup to 420P and YUV422P10 together', 3,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1920;
+    var height = 1080;
+    var srcTags = makeTags(width, height, 'pgroup', 0);
+    var dstTags = [ makeTags(width, height, '420P', 0), makeTags(width, height, 'YUV422P10', 0) ];
+    dstTags[0].threads = 4;
+    var dstBufLens = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var dstBufs = dstBufLens.map(len => Buffer.alloc(len));
+    packer.pack([make4175Buf(width, height)], dstBufs, (err, results) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(results[0], make420PBuf(width, height), 'matches the expected 420P result');   
+      t.deepEquals(results[1], makeYUV422P10Buf(width, height), 'matches the expected YUV422P10 result');   
+      done();
+    });
+  });
+
+packTest('Handling an unsupported format in a destination array', 2,
+  (t, err) => t.match(err && err.message, /^Unsupported destination packing type 'RGBA8'/, 'emits error'),
+  (t, packer, done) => {
+    var width = 1920;
+    var height = 1080;
+    var srcTags = makeTags(width, height, 'pgroup', 0);
+    var dstTags = [ makeTags(width, height, '420P', 0), makeTags(width, height, 'RGBA8', 0) ];
+    packer.setInfo(srcTags, dstTags, logLevel);
+    packer.pack([make4175Buf(width, height)], [Buffer.alloc(width * height * 2), Buffer.alloc(width * height * 4)], err => {
+      t.ok(err, 'refuses to pack after the failed setup');
+      done();
+    });
+  });
+
+packTest('Performing line range packing V210 to 420P', 6,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1920;
+    var height = 1080;
+    var srcTags = makeTags(width, height, 'v210', 1);
+    var dstTags = makeTags(width, height, '420P', 1);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBuf = makeV210Buf(width, height);
+    var dstBuf = Buffer.alloc(dstBufLen);
+    var ranges = [ [0, 400], [400, 400], [800, 280] ];
+    ranges.forEach(r => {
+      packer.packLines([srcBuf], dstBuf, r[0], r[1], (err, linesReady) => {
+        t.equal(linesReady, r[0] + r[1], `lines to ${r[0] + r[1]} are ready`);
+        if (linesReady === height) {
+          t.deepEquals(dstBuf, make420PBuf(width, height), 'matches the expected packing result');   
+          done();
+        }
+      });
+    });
+    packer.packLines([srcBuf], dstBuf, 2, 400, err => {
+      t.ok(err, 'unaligned range refused');
+    });
+    packer.packLines([srcBuf], dstBuf, 800, 400, err => {
+      t.ok(err, 'range beyond the frame refused');
+    });
+  });
+
+packTest('Performing packing V210 to 420P into a pooled destination', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1920;
+    var height = 1080;
+    var srcTags = makeTags(width, height, 'v210', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    packer.setInfo(srcTags, dstTags, logLevel);
+
+    packer.pack([makeV210Buf(width, height)], null, (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, make420PBuf(width, height), 'matches the expected packing result');   
+      done();
+    });
+  });
+
 packTest('Performing packing pgroup to YUV422P10', 2,
   (t, err) => t.notOk(err, 'no error expected'), 
   (t, packer, done) => {
@@ -264,6 +480,100 @@ packTest('Performing packing pgroup to YUV422P10', 2,
     });
   });
 
+packTest('Performing packing YUV422P10 to Y210', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'YUV422P10', 0);
+    var dstTags = makeTags(width, height, 'Y210', 0);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBuf = makeYUV422P10Buf(width, height);
+    // y0 u y1 v, with the 10 bits at the top of each word
+    var testDstBuf = Buffer.alloc(width * height * 4);
+    for (var i=0; i<width * height; i+=2) {
+      testDstBuf.writeUInt16LE(0x040 << 6, i * 4);
+      testDstBuf.writeUInt16LE(0x200 << 6, i * 4 + 2);
+      testDstBuf.writeUInt16LE(0x040 << 6, i * 4 + 4);
+      testDstBuf.writeUInt16LE(0x200 << 6, i * 4 + 6);
+    }
+    packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, testDstBuf, 'matches the expected packing result');   
+      done();
+    });
+  });
+
+packTest('Performing packing 420P to NV12', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, '420P', 0);
+    var dstTags = makeTags(width, height, 'NV12', 0);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBuf = make420PBuf(width, height);
+    var testDstBuf = Buffer.alloc(width * height * 3 / 2);
+    testDstBuf.fill(0x10, 0, width * height);
+    testDstBuf.fill(0x80, width * height);
+    packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, testDstBuf, 'matches the expected packing result');   
+      done();
+    });
+  });
+
+packTest('Performing packing RGBA8 to YUV422P10 with alpha', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'RGBA8', 0);
+    var dstTags = makeTags(width, height, 'YUV422P10', 0);
+    dstTags.hasAlpha = true;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    // mid grey, opaque - greys have no chroma whatever the matrix
+    var srcBuf = Buffer.alloc(width * height * 4);
+    for (var i=0; i<width * height; ++i) {
+      srcBuf.writeUInt32BE(0x808080ff, i * 4);
+    }
+    var testDstBuf = Buffer.alloc(width * height * 6);
+    for (var l=0; l<width * height; ++l) {
+      testDstBuf.writeUInt16LE(504, l * 2);
+      testDstBuf.writeUInt16LE(512, width * height * 2 + l * 2);
+      testDstBuf.writeUInt16LE(1023, width * height * 4 + l * 2);
+    }
+    packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, testDstBuf, 'matches the expected packing result');   
+      done();
+    });
+  });
+
+packTest('Performing packing random pgroup to YUV422P10', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    // a width that leaves a remainder after the vectorised blocks
+    var width = 1918;
+    var height = 4;
+    var srcTags = makeTags(width, height, 'pgroup', 0);
+    var dstTags = makeTags(width, height, 'YUV422P10', 0);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var bufArray = new Array(1);
+    var srcBuf = makeRandom4175Buf(width, height);
+    bufArray[0] = srcBuf;
+    var dstBuf = Buffer.alloc(dstBufLen);
+    packer.pack(bufArray, dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, unpack4175ToYUV422P10(srcBuf, width, height), 'matches the reference unpacking');   
+      done();
+    });
+  });
+
 packTest('Performing packing pgroup to UYVY10', 2,
   (t, err) => t.notOk(err, 'no error expected'), 
   (t, packer, done) => {
@@ -306,6 +616,29 @@ packTest('Performing packing YUV422P10 to UYVY10', 2,
     });
   });
 
+packTest('Performing packing random V210 to YUV422P10', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    // a width with part of a 6 pixel block at the end of each line, as well as line padding
+    var width = 1916;
+    var height = 4;
+    var srcTags = makeTags(width, height, 'v210', 0);
+    var dstTags = makeTags(width, height, 'YUV422P10', 0);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var bufArray = new Array(1);
+    var srcBuf = Buffer.alloc(Math.floor((width + 47) / 48) * 48 * 8 / 3 * height);
+    for (var i=0; i<srcBuf.length; ++i)
+      srcBuf[i] = Math.floor(Math.random() * 256);
+    bufArray[0] = srcBuf;
+    var dstBuf = Buffer.alloc(dstBufLen);
+    packer.pack(bufArray, dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, unpackV210ToYUV422P10(srcBuf, width, height), 'matches the reference unpacking');   
+      done();
+    });
+  });
+
 packTest('Performing packing V210 to YUV422P10', 2,
   (t, err) => t.notOk(err, 'no error expected'), 
   (t, packer, done) => {
@@ -411,6 +744,170 @@ packTest('Performing packing YUV422P10 to 420P', 2,
     });
   });
 
+packTest('Performing packing random YUV422P10 to 420P with field chroma', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    // a height that leaves a frame line pair at the end of the last band after the field line pairs
+    var width = 1918;
+    var height = 10;
+    var srcTags = makeTags(width, height, 'YUV422P10', 1);
+    var dstTags = makeTags(width, height, '420P', 1);
+    dstTags.fieldChroma = true;
+    dstTags.threads = 2;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var bufArray = new Array(1);
+    var srcBuf = Buffer.alloc(width * height * 4);
+    for (var i=0; i<srcBuf.length; ++i)
+      srcBuf[i] = Math.floor(Math.random() * 256);
+    bufArray[0] = srcBuf;
+    var dstBuf = Buffer.alloc(dstBufLen);
+    packer.pack(bufArray, dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, downConvertYUV422P10To420P(srcBuf, width, height, true), 'matches the expected packing result');   
+      done();
+    });
+  });
+
+packTest('Performing packing random pgroup to 420P with field chroma', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    // chroma is averaged from the 10-bit samples with rounding, as from YUV422P10
+    var width = 1918;
+    var height = 10;
+    var srcTags = makeTags(width, height, 'pgroup', 1);
+    var dstTags = makeTags(width, height, '420P', 1);
+    dstTags.fieldChroma = true;
+    dstTags.threads = 2;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBuf = makeRandom4175Buf(width, height);
+    packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, downConvertYUV422P10To420P(unpack4175ToYUV422P10(srcBuf, width, height), width, height, true),
+        'matches the expected packing result');
+      done();
+    });
+  });
+
+packTest('Performing packing random V210 to 420P', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1916;
+    var height = 6;
+    var srcTags = makeTags(width, height, 'v210', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBuf = Buffer.alloc(Math.floor((width + 47) / 48) * 48 * 8 / 3 * height);
+    for (var i=0; i<srcBuf.length; ++i)
+      srcBuf[i] = Math.floor(Math.random() * 256);
+    packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, downConvertYUV422P10To420P(unpackV210ToYUV422P10(srcBuf, width, height), width, height, false),
+        'matches the expected packing result');
+      done();
+    });
+  });
+
+packTest('Performing in-place packing random YUV422P10 to 420P', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1920;
+    var height = 1080;
+    var srcTags = makeTags(width, height, 'YUV422P10', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    dstTags.inPlace = true;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var buf = Buffer.alloc(width * height * 4);
+    for (var i=0; i<buf.length; ++i)
+      buf[i] = Math.floor(Math.random() * 256);
+    var testDstBuf = downConvertYUV422P10To420P(buf, width, height, false);
+    packer.pack([buf], buf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, testDstBuf.slice(0, dstBufLen), 'matches the expected packing result');   
+      done();
+    });
+  });
+
+packTest('Handling the same source and destination without inPlace', 1,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'YUV422P10', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    packer.setInfo(srcTags, dstTags, logLevel);
+    var buf = makeYUV422P10Buf(width, height);
+    packer.pack([buf], buf, (err/*, result*/) => {
+      t.ok(err, 'should return error');
+      done();
+    });
+  });
+
+packTest('Performing packing 420P to YUV422P10', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, '420P', 0);
+    var dstTags = makeTags(width, height, 'YUV422P10', 0);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var bufArray = new Array(1);
+    var srcBuf = make420PBuf(width, height);
+    bufArray[0] = srcBuf;
+    var dstBuf = Buffer.alloc(dstBufLen);
+    packer.pack(bufArray, dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      var testDstBuf = makeYUV422P10Buf(width, height);
+      t.deepEquals(result, testDstBuf, 'matches the expected packing result');   
+      done();
+    });
+  });
+
+packTest('Performing banded multi-step packing V210 to UYVY10', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1920;
+    var height = 1080;
+    var srcTags = makeTags(width, height, 'v210', 1);
+    var dstTags = makeTags(width, height, 'UYVY10', 1);
+    dstTags.threads = 4;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var bufArray = new Array(1);
+    var srcBuf = makeV210Buf(width, height);
+    bufArray[0] = srcBuf;
+    var dstBuf = Buffer.alloc(dstBufLen);
+    packer.pack(bufArray, dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      var testDstBuf = makeUYVY10Buf(width, height);
+      t.deepEquals(result, testDstBuf, 'matches the expected packing result');   
+      done();
+    });
+  });
+
+packTest('Performing packing random YUV422P10 to UYVY10 and back at a width of 2 mod 4', 3,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    // the UYVY10 conversions step 4 pixels at a time, leaving a single pixel pair here
+    var width = 1918;
+    var height = 4;
+    var planarBuf = unpack4175ToYUV422P10(makeRandom4175Buf(width, height), width, height);
+    var uyvyBufLen = packer.setInfo(makeTags(width, height, 'YUV422P10', 0), makeTags(width, height, 'UYVY10', 0), logLevel);
+    packer.pack([planarBuf], Buffer.alloc(uyvyBufLen), (err, uyvyBuf) => {
+      t.notOk(err, 'no error expected');
+      var dstBufLen = packer.setInfo(makeTags(width, height, 'UYVY10', 0), makeTags(width, height, 'YUV422P10', 0), logLevel);
+      packer.pack([uyvyBuf], Buffer.alloc(dstBufLen), (err, result) => {
+        t.notOk(err, 'no error expected');
+        t.deepEquals(result, planarBuf, 'matches the original after the round trip');
+        done();
+      });
+    });
+  });
+
 packTest('Performing packing YUV422P10 to pgroup', 2,
   (t, err) => t.notOk(err, 'no error expected'), 
   (t, packer, done) => {
@@ -592,3 +1089,128 @@ packTest('Handling insufficient destination bytes', 1,
       done();
     });
   });
+
+packTest('Handling a full queue', 4,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'pgroup', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    dstTags.queueDepth = 1;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+    var srcBuf = make4175Buf(width, height);
+
+    packer.on('drain', () => {
+      t.pass('emits drain when a frame completes');
+      done();
+    });
+    packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err) => {
+      t.notOk(err, 'first frame is accepted');
+    });
+    var numQueued = packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err) => {
+      t.equal(err.code, 'QUEUE_FULL', 'second frame is rejected');
+    });
+    t.equal(numQueued, false, 'returns false when the queue is full');
+  });
+
+packTest('Dropping late frames', 3,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'pgroup', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    dstTags.dropPolicy = 'dropLate';
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+    var srcBuf = make4175Buf(width, height);
+    var now = Number(process.hrtime.bigint());
+
+    packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      t.equal(err && err.code, 'FRAME_DROPPED', 'frame past its deadline is dropped');
+      t.notOk(result, 'dropped frame has no result');
+    }, now - 1000000);
+    packer.pack([srcBuf], Buffer.alloc(dstBufLen), (err) => {
+      t.notOk(err, 'frame within its deadline is processed');
+      done();
+    }, now + 10000000000);
+  });
+
+packTest('Handling quit called twice', 1,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, packer, done) => {
+    // the second quit is answered when the first completes, after its callback
+    var firstDone = false;
+    packer.quit(() => {
+      firstDone = true;
+    });
+    packer.quit(() => {
+      t.ok(firstDone, 'second quit is answered after the first');
+    });
+    done();
+  });
+
+packTest('Performing batched packing V210 to 420P', 4,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var numFrames = 3;
+    var srcTags = makeTags(width, height, 'v210', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBufArrays = [];
+    var dstBufs = [];
+    for (var f=0; f<numFrames; ++f) {
+      srcBufArrays.push([makeV210Buf(width, height)]);
+      dstBufs.push(Buffer.alloc(dstBufLen));
+    }
+    packer.packBatch(srcBufArrays, dstBufs, (err, results) => {
+      t.notOk(err, 'no error expected');
+      t.equal(results.length, numFrames, 'one result per frame');
+      var testDstBuf = make420PBuf(width, height);
+      t.ok(results.every(result => result.equals(testDstBuf)), 'every frame matches the expected packing result');
+      t.ok(dstBufs.every((dstBuf, f) => results[f].buffer === dstBuf.buffer), 'every result is in its destination buffer');
+      done();
+    });
+  });
+
+packTest('Handling an insufficient source buffer', 1,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'v210', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBuf = makeV210Buf(width, height);
+    packer.pack([srcBuf.slice(0, srcBuf.length - 1)], Buffer.alloc(dstBufLen), err => {
+      t.match(err && err.message, /^Insufficient source buffer for conversion/, 'refuses a short source');
+      done();
+    });
+  });
+
+packTest('Handling batches that cannot be queued', 3,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, packer, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'v210', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    dstTags.queueDepth = 2;
+    var dstBufLen = packer.setInfo(srcTags, dstTags, logLevel);
+
+    var srcBufArray = [makeV210Buf(width, height)];
+    packer.packBatch([srcBufArray, srcBufArray, srcBufArray], [1, 2, 3].map(() => Buffer.alloc(dstBufLen)), err => {
+      t.match(err && err.message, /^Packer packBatch of 3 frames exceeds the queue depth of 2/, 'refuses a batch deeper than the queue');
+    });
+    packer.packBatch([srcBufArray], [], err => {
+      t.match(err && err.message, /^Packer packBatch requires matching, non-empty/, 'refuses mismatched arrays');
+    });
+    packer.packBatch([srcBufArray], [Buffer.alloc(dstBufLen - 1)], err => {
+      t.match(err && err.message, /^Packer packBatch has insufficient destination buffer/, 'refuses a short destination');
+      done();
+    });
+  });
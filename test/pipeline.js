@@ -0,0 +1,179 @@
+/* Copyright 2017 Streampunk Media Ltd.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+var tap = require('tap');
+var codecadon = require('../../codecadon');
+const logLevel = 2;
+
+function make4175Buf(width, height) {
+  var pitchBytes = width * 5 / 2;
+  var buf = Buffer.alloc(pitchBytes * height);  
+  var yOff = 0;
+  for (var y=0; y<height; ++y) {
+    var xOff = 0;
+    for (var x=0; x<width; ++x) {
+      // uyvy, big-endian 10 bits each in 5 bytes
+      buf[yOff + xOff++] = 0x80;       
+      buf[yOff + xOff++] = 0x04;       
+      buf[yOff + xOff++] = 0x08;       
+      buf[yOff + xOff++] = 0x00;       
+      buf[yOff + xOff++] = 0x40;       
+    }
+    yOff += pitchBytes;
+  }   
+  return buf;
+}
+
+function make420PBuf(width, height) {
+  var lumaPitchBytes = width;
+  var chromaPitchBytes = lumaPitchBytes / 2;
+  var buf = Buffer.alloc(lumaPitchBytes * height * 3 / 2);
+  var lOff = 0;
+  var uOff = lumaPitchBytes * height;
+  var vOff = uOff + chromaPitchBytes * height / 2;
+
+  for (var y=0; y<height; ++y) {
+    var xlOff = 0;
+    var xcOff = 0;
+    var evenLine = (y & 1) === 0;
+    for (var x=0; x<width; x+=2) {
+      buf[lOff + xlOff + 0] = 0x10;
+      buf[lOff + xlOff + 1] = 0x10;
+      buf[uOff + xcOff] = 0x80;    
+      buf[vOff + xcOff] = 0x80;
+      xlOff += 2;
+      xcOff += 1;
+    }
+    lOff += lumaPitchBytes;
+    if (!evenLine) {
+      uOff += chromaPitchBytes;
+      vOff += chromaPitchBytes;
+    }
+  }
+  return buf;
+}
+
+function makeTags(width, height, packing, interlace) {
+  let tags = {};
+  tags.format = 'video';
+  tags.width = width;
+  tags.height = height;
+  tags.packing = packing;
+  tags.interlace = interlace;
+  return tags;
+}
+
+function pipelineTest(description, numTests, onErr, fn) {
+  tap.test(description, (t) => {
+    t.plan(numTests + 1);
+    var pipeline = new codecadon.Pipeline(() => {});
+    pipeline.on('error', err => {
+      onErr(t, err);
+    });
+
+    fn(t, pipeline, () => {
+      pipeline.quit(() => {
+        t.pass(`${description} exited`);
+        t.end();
+      });
+    });
+  });
+}
+
+tap.plan(5, 'Pipeline addon tests');
+
+pipelineTest('Handling unsupported stage type', 1,
+  (t, err) => t.ok(err, 'emits error'), 
+  (t, pipeline, done) => {
+    var srcTags = makeTags(1280, 720, 'pgroup', 0);
+    var dstTags = makeTags(1280, 720, '420P', 0);
+    pipeline.setInfo([ { type: 'unknown', srcTags: srcTags, dstTags: dstTags } ], logLevel);
+    done();
+  });
+
+pipelineTest('Handling mismatched stages', 1,
+  (t, err) => t.ok(err, 'emits error'), 
+  (t, pipeline, done) => {
+    var srcTags = makeTags(1280, 720, 'pgroup', 0);
+    var midTags = makeTags(1280, 720, '420P', 0);
+    var dstTags = makeTags(1920, 1080, 'YUV422P10', 0);
+    pipeline.setInfo([ 
+      { type: 'pack', srcTags: srcTags, dstTags: midTags },
+      { type: 'pack', srcTags: dstTags, dstTags: dstTags } ], logLevel);
+    done();
+  });
+
+pipelineTest('Performing packing pgroup to YUV422P10 to 420P', 3,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, pipeline, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'pgroup', 0);
+    var midTags = makeTags(width, height, 'YUV422P10', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    var dstBufLen = pipeline.setInfo([ 
+      { type: 'pack', srcTags: srcTags, dstTags: midTags },
+      { type: 'pack', srcTags: midTags, dstTags: dstTags } ], logLevel);
+    t.equal(dstBufLen, width * height * 3/2, 'buffer size calculation matches the expected value');
+
+    var bufArray = new Array(1);
+    var srcBuf = make4175Buf(width, height);
+    bufArray[0] = srcBuf;
+    var dstBuf = Buffer.alloc(dstBufLen);
+    pipeline.process(bufArray, dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      var testDstBuf = make420PBuf(width, height);
+      t.deepEquals(result, testDstBuf, 'matches the expected packing result');   
+      done();
+    });
+  });
+
+pipelineTest('Handling an unsupported drop policy', 1,
+  (t, err) => t.ok(err, 'emits error'),
+  (t, pipeline, done) => {
+    var srcTags = makeTags(1280, 720, 'pgroup', 0);
+    var dstTags = makeTags(1280, 720, '420P', 0);
+    pipeline.setInfo([ { type: 'pack', srcTags: srcTags, dstTags: dstTags } ], { dropPolicy: 'sometimes' }, logLevel);
+    done();
+  });
+
+pipelineTest('Dropping late frames with exact deadlines', 5,
+  (t, err) => t.notOk(err, 'no error expected'),
+  (t, pipeline, done) => {
+    var width = 1280;
+    var height = 720;
+    var srcTags = makeTags(width, height, 'pgroup', 0);
+    var midTags = makeTags(width, height, 'YUV422P10', 0);
+    var dstTags = makeTags(width, height, '420P', 0);
+    var dstBufLen = pipeline.setInfo([
+      { type: 'pack', srcTags: srcTags, dstTags: midTags },
+      { type: 'pack', srcTags: midTags, dstTags: dstTags } ], { dropPolicy: 'dropLate' }, logLevel);
+
+    var srcBuf = make4175Buf(width, height);
+    var now = process.hrtime.bigint();
+    // a BigInt deadline one nanosecond in the past, which a Number of the same value may not be able to tell apart
+    pipeline.process([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      t.equal(err && err.code, 'FRAME_DROPPED', 'drops the frame that is already late');
+      t.equal(result, null, 'no result for the dropped frame');
+    }, now - BigInt(1));
+    pipeline.process([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      t.notOk(err, 'processes the frame with a BigInt deadline a minute away');
+      t.deepEquals(result, make420PBuf(width, height), 'matches the expected packing result');
+    }, now + BigInt(60e9));
+    pipeline.process([srcBuf], Buffer.alloc(dstBufLen), (err) => {
+      t.notOk(err, 'processes the frame with a decimal string deadline a minute away');
+      done();
+    }, (now + BigInt(60e9)).toString());
+  });
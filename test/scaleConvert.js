@@ -125,7 +125,7 @@ function scaleConvertTest(description, numTests, onErr, fn) {
   });
 }
 
-tap.plan(7, 'ScaleConverter addon tests');
+tap.plan(17, 'ScaleConverter addon tests');
 const paramTags = { scale:[1.0, 1.0], dstOffset:[0.0, 0.0] };
 
 scaleConvertTest('Handling bad image dimensions', 1,
@@ -146,6 +146,15 @@ scaleConvertTest('Handling bad image format', 1,
     done();
   });
 
+scaleConvertTest('Handling a zero scale', 1,
+  (t, err) => t.match(err && err.message, /^Unsupported Scale values/, 'emits error'), 
+  (t, scaleConverter, done) => {
+    var srcTags = makeTags(1920, 1080, 'pgroup', 0);
+    var dstTags = makeTags(1280, 720, 'YUV422P10', 0);
+    scaleConverter.setInfo(srcTags, dstTags, { scale:[0.0, 1.0], dstOffset:[0.0, 0.0] }, logLevel);
+    done();
+  });
+
 scaleConvertTest('Starting up a scaleConverter', 1,
   (t, err) => t.notOk(err, 'no error expected'), 
   (t, scaleConverter, done) => {
@@ -184,6 +193,287 @@ scaleConvertTest('Performing scaling pgroup to YUV422P10', 2,
     });
   });
 
+scaleConvertTest('Performing scaling pgroup to YUV422P10 into a pooled destination', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, scaleConverter, done) => {
+    var srcTags = makeTags(1920, 1080, 'pgroup', 1);
+    var dstTags = makeTags(1280, 720, 'YUV422P10', 1);
+    scaleConverter.setInfo(srcTags, dstTags, paramTags, logLevel);
+    scaleConverter.scaleConvert([make4175Buf(1920, 1080)], null, (err, result) => {
+      t.notOk(err, 'no error expected');
+      t.deepEquals(result, makeYUV422P10Buf(1280, 720), 'matches the expected scaling result');
+      done();
+    });
+  });
+
+scaleConvertTest('Performing native scaling pgroup to YUV422P10', 2,
+  (t, err) => t.notOk(err, 'no error expected'), 
+  (t, scaleConverter, done) => {
+    var srcWidth = 1920;
+    var srcHeight = 1080;
+    var srcFormat = 'pgroup';
+    var dstWidth = 1280;
+    var dstHeight = 720;
+    var dstFormat = 'YUV422P10';
+    var srcTags = makeTags(srcWidth, srcHeight, srcFormat, 1);
+    var dstTags = makeTags(dstWidth, dstHeight, dstFormat, 1);
+    var nativeTags = { scale:[1.0, 1.0], dstOffset:[0.0, 0.0], scaler:'native' };
+    var dstBufLen = scaleConverter.setInfo(srcTags, dstTags, nativeTags, logLevel);
+    var bufArray = new Array(1);
+    var srcBuf = make4175Buf(srcWidth, srcHeight);
+    bufArray[0] = srcBuf;
+    var dstBuf = Buffer.alloc(dstBufLen);
+    scaleConverter.scaleConvert(bufArray, dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      var testDstBuf = makeYUV422P10Buf(dstWidth, dstHeight);
+      t.deepEquals(result, testDstBuf, 'matches the expected scaling result');
+      done();
+    });
+  });
+
+tap.test('Performing native scaling keeps the lines of each field in that field', (t) => {
+  t.plan(3);
+  var srcWidth = 1920;
+  var srcHeight = 1080;
+  var dstWidth = 720;
+  var dstHeight = 576;
+  // the first field of the tff source is on the even lines and the first field of the bff destination on the odd lines
+  var srcTags = makeTags(srcWidth, srcHeight, 'YUV422P10', 'tff');
+  var dstTags = makeTags(dstWidth, dstHeight, 'YUV422P10', 'bff');
+  var srcBuf = Buffer.alloc(srcWidth * srcHeight * 4);
+  for (var y = 0; y < srcHeight; ++y)
+    for (var x = 0; x < srcWidth; ++x)
+      srcBuf.writeUInt16LE((y & 1) ? 0x300 : 0x100, (y * srcWidth + x) * 2);
+  for (var i = srcWidth * srcHeight; i < srcBuf.length / 2; ++i)
+    srcBuf.writeUInt16LE(0x200, i * 2);
+
+  var scaleConverter = new codecadon.ScaleConverter(() => {});
+  scaleConverter.on('error', err => t.fail(err));
+  var nativeTags = { scale:[1.0, 1.0], dstOffset:[0.0, 0.0], scaler:'native' };
+  var dstBuf = Buffer.alloc(scaleConverter.setInfo(srcTags, dstTags, nativeTags, logLevel));
+  scaleConverter.scaleConvert([srcBuf], dstBuf, (err, result) => {
+    t.notOk(err, 'no error expected');
+    var mixedLines = 0;
+    for (var y = 0; y < dstHeight; ++y)
+      for (var x = 0; x < dstWidth; ++x)
+        if (result.readUInt16LE((y * dstWidth + x) * 2) !== ((y & 1) ? 0x100 : 0x300)) {
+          ++mixedLines;
+          break;
+        }
+    t.equal(mixedLines, 0, 'makes each destination field from the matching source field');
+    scaleConverter.quit(() => {
+      t.pass('native field scaling exited');
+      t.end();
+    });
+  });
+});
+
+tap.test('Performing native scaling gives the same result with each instruction set', (t) => {
+  t.plan(3);
+  // each run is a separate process, as the instructions are chosen when the module loads
+  var script = `
+    const codecadon = require(${JSON.stringify(require.resolve('../../codecadon'))});
+    const crypto = require('crypto');
+    const conversions = [[1920, 1080, 'tff', 720, 576, 'bff'], [720, 576, 'bff', 1920, 1080, 'tff'], [1920, 1080, 'prog', 1280, 720, 'prog']];
+    var tags = (w, h, il) => ({ format: 'video', width: w, height: h, packing: 'YUV422P10', depth: 10, interlace: il });
+    var hashes = [];
+    var next = () => {
+      var c = conversions[hashes.length];
+      if (!c)
+        return console.log(JSON.stringify(hashes));
+      var scaleConverter = new codecadon.ScaleConverter(() => {});
+      var dstBuf = Buffer.alloc(scaleConverter.setInfo(tags(c[0], c[1], c[2]), tags(c[3], c[4], c[5]),
+        { scale: [1.0, 1.0], dstOffset: [0.0, 0.0], scaler: 'native' }, 1));
+      var srcBuf = Buffer.alloc(c[0] * c[1] * 4);
+      for (var i = 0; i < srcBuf.length / 2; ++i)
+        srcBuf.writeUInt16LE(0x40 + (i * 7919) % 0x380, i * 2);
+      scaleConverter.scaleConvert([srcBuf], dstBuf, (err, result) => {
+        hashes.push(err ? err.message : crypto.createHash('sha1').update(result).digest('hex'));
+        scaleConverter.quit(next);
+      });
+    };
+    next();`;
+  var results = ['none', 'ssse3', 'avx2'].map(simd => {
+    var env = Object.assign({}, process.env, { CODECADON_SIMD: simd });
+    return JSON.parse(require('child_process').execFileSync(process.execPath, ['-e', script], { env: env }).toString());
+  });
+  t.equal(results[0].length, 3, 'scales each conversion');
+  t.deepEqual(results[1], results[0], 'matches the portable code with SSSE3');
+  t.deepEqual(results[2], results[0], 'matches the portable code with AVX2');
+  t.end();
+});
+
+tap.test('Performing threaded scaling matches single threaded', (t) => {
+  t.plan(3);
+  var srcWidth = 3840;
+  var srcHeight = 2160;
+  var dstWidth = 1920;
+  var dstHeight = 1080;
+  var srcTags = makeTags(srcWidth, srcHeight, 'YUV422P10', 'prog');
+  var dstTags = makeTags(dstWidth, dstHeight, 'YUV422P10', 'prog');
+  var srcBuf = Buffer.alloc(srcWidth * srcHeight * 4);
+  for (var i = 0; i < srcBuf.length / 2; ++i)
+    srcBuf.writeUInt16LE(0x40 + (i * 7919) % 0x380, i * 2);
+
+  var scaleFrame = (threads, cb) => {
+    var scaleConverter = new codecadon.ScaleConverter(() => {});
+    scaleConverter.on('error', err => t.fail(err));
+    var threadTags = { scale:[1.0, 1.0], dstOffset:[0.0, 0.0], threads:threads };
+    var dstBuf = Buffer.alloc(scaleConverter.setInfo(srcTags, dstTags, threadTags, logLevel));
+    scaleConverter.scaleConvert([srcBuf], dstBuf, (err, result) => {
+      t.notOk(err, 'no error expected');
+      scaleConverter.quit(() => cb(result));
+    });
+  };
+  scaleFrame(1, (singleResult) => {
+    scaleFrame(4, (threadedResult) => {
+      t.ok(singleResult.equals(threadedResult), 'matches the single threaded result');
+      t.end();
+    });
+  });
+});
+
+tap.test('Performing per-frame scale and offset matches setInfo', (t) => {
+  t.plan(4);
+  var width = 1920;
+  var height = 1080;
+  var srcTags = makeTags(width, height, 'YUV422P10', 'prog');
+  var dstTags = makeTags(width, height, 'YUV422P10', 'prog');
+  var srcBuf = Buffer.alloc(width * height * 4);
+  for (var i = 0; i < srcBuf.length / 2; ++i)
+    srcBuf.writeUInt16LE(0x40 + (i * 7919) % 0x380, i * 2);
+  var moveTags = { scale:[0.5, 0.5], dstOffset:[300.0, -100.0] };
+
+  var animator = new codecadon.ScaleConverter(() => {});
+  animator.on('error', err => t.fail(err));
+  var animateTags = { scale:[1.0, 1.0], dstOffset:[0.0, 0.0], animate:true };
+  var dstBuf = Buffer.alloc(animator.setInfo(srcTags, dstTags, animateTags, logLevel));
+  animator.scaleConvert([srcBuf], dstBuf, { scale:[0.5, 0.5], dstOffset:[-400.0, 200.0] }, (err) => {
+    t.notOk(err, 'no error expected');
+    animator.scaleConvert([srcBuf], dstBuf, moveTags, (err, movedResult) => {
+      t.notOk(err, 'no error expected');
+      animator.quit(() => {
+        var fixed = new codecadon.ScaleConverter(() => {});
+        fixed.on('error', err => t.fail(err));
+        var fixedBuf = Buffer.alloc(fixed.setInfo(srcTags, dstTags, moveTags, logLevel));
+        fixed.scaleConvert([srcBuf], fixedBuf, (err, fixedResult) => {
+          t.notOk(err, 'no error expected');
+          t.ok(movedResult.equals(fixedResult), 'matches the result of the same scale and offset given to setInfo');
+          fixed.quit(() => t.end());
+        });
+      });
+    });
+  });
+});
+
+tap.test('Performing compose scaling leaves the canvas around the picture', (t) => {
+  t.plan(4);
+  var width = 1920;
+  var height = 1080;
+  var srcTags = makeTags(width, height, 'YUV422P10', 'prog');
+  var dstTags = makeTags(width, height, 'YUV422P10', 'prog');
+  var srcBuf = Buffer.alloc(width * height * 4);
+  for (var i = 0; i < width * height; ++i)
+    srcBuf.writeUInt16LE(0x300, i * 2);
+  for (i = width * height; i < srcBuf.length / 2; ++i)
+    srcBuf.writeUInt16LE(0x100, i * 2);
+
+  var scaleConverter = new codecadon.ScaleConverter(() => {});
+  scaleConverter.on('error', err => t.fail(err));
+  var composeTags = { scale:[0.5, 0.5], dstOffset:[0.0, 0.0], compose:true };
+  var canvasBuf = Buffer.alloc(scaleConverter.setInfo(srcTags, dstTags, composeTags, logLevel));
+  for (i = 0; i < canvasBuf.length / 2; ++i)
+    canvasBuf.writeUInt16LE(0x155, i * 2);
+  scaleConverter.scaleConvert([srcBuf], canvasBuf, (err, result) => {
+    t.notOk(err, 'no error expected');
+    t.equal(result.readUInt16LE(0), 0x155, 'keeps the canvas outside the picture');
+    t.equal(result.readUInt16LE((height / 2 * width + width / 2) * 2), 0x300, 'writes the picture into its region');
+    scaleConverter.quit(() => {
+      t.pass('compose scaling exited');
+      t.end();
+    });
+  });
+});
+
+tap.test('Performing compose scaling to an unaligned width leaves the canvas beside the picture', (t) => {
+  t.plan(7);
+  var width = 1920;
+  var height = 1080;
+  var srcTags = makeTags(width, height, 'YUV422P10', 'prog');
+  var dstTags = makeTags(width, height, 'YUV422P10', 'prog');
+  var srcBuf = Buffer.alloc(width * height * 4);
+  for (var i = 0; i < width * height; ++i)
+    srcBuf.writeUInt16LE(0x300, i * 2);
+  for (i = width * height; i < srcBuf.length / 2; ++i)
+    srcBuf.writeUInt16LE(0x100, i * 2);
+
+  var scaleConverter = new codecadon.ScaleConverter(() => {});
+  scaleConverter.on('error', err => t.fail(err));
+  // 0.37 scales to 710 x 399, placed centrally at 604..1313 across, 340..738 down
+  var composeTags = { scale:[0.37, 0.37], dstOffset:[0.0, 0.0], compose:true };
+  var canvasBuf = Buffer.alloc(scaleConverter.setInfo(srcTags, dstTags, composeTags, logLevel));
+  for (i = 0; i < canvasBuf.length / 2; ++i)
+    canvasBuf.writeUInt16LE(0x155, i * 2);
+  var lumaBytes = width * height * 2;
+  var line = 540;
+  scaleConverter.scaleConvert([srcBuf], canvasBuf, { dstOffset:[0.0, 0.0] }, (err, result) => {
+    t.notOk(err, 'no error expected');
+    t.equal(result.readUInt16LE((line * width + 1313) * 2), 0x300, 'writes the last column of the picture');
+    t.equal(result.readUInt16LE((line * width + 1314) * 2), 0x155, 'keeps the luma column beside the picture');
+    t.equal(result.readUInt16LE(lumaBytes + (line * width / 2 + 657) * 2), 0x155, 'keeps the chroma column beside the picture');
+    // at the right edge, writing past the picture lines would run on into the start of the next line
+    scaleConverter.scaleConvert([srcBuf], canvasBuf, { dstOffset:[2000.0, 0.0] }, (err, result) => {
+      var nextLine = [];
+      for (var x = 0; x < 8; ++x)
+        nextLine.push(result.readUInt16LE(((line + 1) * width + x) * 2));
+      t.notOk(err, 'no error expected');
+      t.deepEqual(nextLine, [0x155, 0x155, 0x155, 0x155, 0x155, 0x155, 0x155, 0x155], 'keeps the start of the next line');
+      scaleConverter.quit(() => {
+        t.pass('compose scaling exited');
+        t.end();
+      });
+    });
+  });
+});
+
+tap.test('Changing the format with frames in flight scales later frames to the new format', (t) => {
+  t.plan(5);
+  var width = 1920;
+  var height = 1080;
+  var srcTags = makeTags(width, height, 'YUV422P10', 'prog');
+  var srcBuf = Buffer.alloc(width * height * 4);
+  for (var i = 0; i < width * height; ++i)
+    srcBuf.writeUInt16LE(0x300, i * 2);
+  for (i = width * height; i < srcBuf.length / 2; ++i)
+    srcBuf.writeUInt16LE(0x100, i * 2);
+
+  var scaleConverter = new codecadon.ScaleConverter(() => {});
+  scaleConverter.on('error', err => t.fail(err));
+  var parallelTags = { scale:[1.0, 1.0], dstOffset:[0.0, 0.0], parallelFrames:2 };
+  var smallBuf = Buffer.alloc(scaleConverter.setInfo(srcTags, makeTags(720, 576, 'YUV422P10', 'prog'), parallelTags, logLevel));
+  scaleConverter.scaleConvert([srcBuf], smallBuf, err => t.notOk(err, 'no error expected'));
+  scaleConverter.scaleConvert([srcBuf], Buffer.alloc(smallBuf.length), err => t.notOk(err, 'no error expected'));
+
+  // a scaler for 720x576 given back after this would leave the bottom of the larger frames unwritten
+  var dstTags = makeTags(1280, 720, 'YUV422P10', 'prog');
+  var dstBufLen = scaleConverter.setInfo(srcTags, dstTags, parallelTags, logLevel);
+  var lastLuma = (1280 * 720 - 1) * 2;
+  var results = [];
+  var numFrames = 4;
+  for (i = 0; i < numFrames; ++i)
+    scaleConverter.scaleConvert([srcBuf], Buffer.alloc(dstBufLen), (err, result) => {
+      results.push(err ? 0 : result.readUInt16LE(lastLuma));
+      if (results.length < numFrames)
+        return;
+      t.deepEqual(results, [0x300, 0x300, 0x300, 0x300], 'writes the whole of each frame');
+      t.equal(dstBufLen, 1280 * 720 * 4, 'sizes the destination for the new format');
+      scaleConverter.quit(() => {
+        t.pass('format change exited');
+        t.end();
+      });
+    });
+});
+
 scaleConvertTest('Handling undefined source', 1,
   (t, err) => t.notOk(err, 'no error expected'), 
   (t, scaleConverter, done) => {